@@ -32,6 +32,12 @@ KERNEL_STACK_BOTTOM:
 resb 32768
 KERNEL_STACK_TOP:
 
+; The Time Stamp Counter value on entry to _start, used by the boot profiler
+global boot_tsc_start
+alignb 8
+boot_tsc_start:
+resq 1
+
 section .text
 global initial_page_directory
 align 4096
@@ -40,11 +46,32 @@ times 4096 dw 0
 page_table:
 times 4096 dw 0
 
+%ifdef KCONF_X86_PAE
+; With PAE, the PDPT selects a page directory for each 1GB of the address space. Only the first
+; (identity mapping) and last (kernel mapping) are needed during boot, and they use 2MB pages
+align 4096
+pae_page_directory_low:
+times 4096 db 0
+pae_page_directory_kernel:
+times 4096 db 0
+align 32
+pae_pdpt:
+times 32 db 0
+%endif
+
 ; Define our hand-off point for Multiboot, from which we can begin OS initialisation, enable
 ; paging, and then finally hand off to the C kernel
 global _start
 extern kernel_main
 _start:
+    ; Record the TSC as early as possible so the boot profiler can account for
+    ; time spent before kernel_main, preserving the Multiboot magic in EAX
+    mov     ecx, eax
+    rdtsc
+    mov     [boot_tsc_start], eax
+    mov     [boot_tsc_start + 4], edx
+    mov     eax, ecx
+
     ; Configure our stack pointer
     mov esp,    KERNEL_STACK_TOP
 
@@ -58,6 +85,28 @@ _start:
     ;   - Identity map the lowest 4MB of phys. memory, which is where this code is running
     ;   - Map 0x00000000 -> 0x003FFFFF    to    virtual 0xC0000000 -> 0xC03FFFFF
 
+%ifdef KCONF_X86_PAE
+    ; Two 2MB pages cover the lowest 4MB, in both the identity and kernel mappings. PAE entries are
+    ; 64 bits wide, so the upper half of each is left zero
+    mov dword [pae_page_directory_low + (0 * 8)], 0x00000000 | 0x83     ; Present, writable, 2MB
+    mov dword [pae_page_directory_low + (1 * 8)], 0x00200000 | 0x83
+    mov dword [pae_page_directory_kernel + (0 * 8)], 0x00000000 | 0x83
+    mov dword [pae_page_directory_kernel + (1 * 8)], 0x00200000 | 0x83
+
+    ; PDPT entries only have a present bit, any others are reserved
+    mov dword [pae_pdpt + (0 * 8)], pae_page_directory_low + 0x001
+    mov dword [pae_pdpt + (3 * 8)], pae_page_directory_kernel + 0x001
+
+    ; Configure CR3 to point to our initial PDPT
+    mov     eax, pae_pdpt
+    mov     cr3, eax
+
+    ; Configure CR4 to enable Page Size Extensions, Physical Address Extension and Page Global
+    ; Enable. PAE must be enabled before paging is
+    mov     eax, cr4
+    or      eax, 0xB0
+    mov     cr4, eax
+%else
     mov eax, 0x0 ; Our index
     mov ebx, 0x0 ; Our kernel address
     .fill_table:
@@ -85,6 +134,7 @@ _start:
     mov     eax, cr4
     or      eax, 0x90
     mov     cr4, eax
+%endif
 
     ; Enable paging
     mov     eax, cr0
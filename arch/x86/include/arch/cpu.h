@@ -10,6 +10,7 @@
 #include <arch/tss.h>
 #include <arch/gdt.h>
 #include <arch/msr.h>
+#include <rotary/mm/quicklist.h>
 
 /* ------------------------------------------------------------------------- */
 
@@ -33,6 +34,9 @@ struct cpu_info {
     __attribute__((aligned(8))) gdt_descriptor_t gdt_desc;
     __attribute__((aligned(8))) gdt_entry_t gdt_entries[GDT_ENTRY_COUNT];
     struct cpu_info * self;
+    struct quicklist quicklists[QUICKLIST_COUNT];
+    uint32_t kmap_atomic_depth;  /* kmap_atomic() slots in use */
+    uint32_t kmap_atomic_eflags; /* EFLAGS before the first was taken */
 };
 
 /* ------------------------------------------------------------------------- */
@@ -45,4 +49,22 @@ struct  cpu_info * cpu_get_local();
 
 /* ------------------------------------------------------------------------- */
 
+/* Disable interrupts, returning the previous EFLAGS for cpu_irq_restore() */
+static inline uint32_t cpu_irq_save() {
+    uint32_t eflags;
+    asm volatile("pushf\n\t"
+                 "pop %0\n\t"
+                 "cli" : "=r" (eflags) : : "memory");
+    return eflags;
+}
+
+/* Re-enable interrupts, if they were enabled when cpu_irq_save() was called */
+static inline void cpu_irq_restore(uint32_t eflags) {
+    if(eflags & EFLAGS_INTERRUPTS_ON) {
+        asm volatile("sti" : : : "memory");
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
 #endif
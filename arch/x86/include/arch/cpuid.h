@@ -117,6 +117,13 @@ enum {
     CPUID_FEAT_EDX_PBE          = 1 << 31
 };
 
+/* Extended features, from leaf 0x80000001 */
+enum {
+    CPUID_FEAT_EXT_EDX_SYSCALL  = 1 << 11,
+    CPUID_FEAT_EXT_EDX_NX       = 1 << 20,
+    CPUID_FEAT_EXT_EDX_LM       = 1 << 29
+};
+
 /* ------------------------------------------------------------------------- */
 /* Functions                                                                 */
 /* ------------------------------------------------------------------------- */
@@ -125,10 +132,15 @@ int32_t cpuid_init();
 int32_t cpuid_get_cpu_name(char * dest_buf);
 int32_t cpuid_check_pse();
 int32_t cpuid_check_pge();
+int32_t cpuid_check_nx();
+int32_t cpuid_check_pat();
+int32_t cpuid_check_tsc();
 int32_t cpuid_check_apic();
 int32_t cpuid_check_x2apic();
 int32_t x86_paging_pse_enabled();
 int32_t x86_paging_pge_enabled();
+int32_t x86_paging_pae_enabled();
+int32_t x86_paging_huge_enabled();
 
 /* ------------------------------------------------------------------------- */
 
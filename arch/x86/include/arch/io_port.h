@@ -22,6 +22,7 @@
 #define IO_PORT_PIT_CHAN_1      0x41
 #define IO_PORT_PIT_CHAN_2      0x42
 #define IO_PORT_PIT_CMD         0x43
+#define IO_PORT_PIT_CHAN_2_GATE 0x61
 
 // Serial Ports
 #define IO_PORT_SERIAL_COM1     0x3F8
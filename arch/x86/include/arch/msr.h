@@ -8,6 +8,37 @@
 
 /* ------------------------------------------------------------------------- */
 
+/* Extended Feature Enable Register */
+#define MSR_EFER 0xC0000080
+#define EFER_NXE (1 << 11)  /* Honour the no-execute bit in PAE entries */
+
+/* Page Attribute Table, eight memory types selected by the PAT, PCD and PWT
+ * bits of a page table entry */
+#define MSR_PAT           0x277
+#define PAT_TYPE_UC       0x00 /* Uncached */
+#define PAT_TYPE_WC       0x01 /* Write-combining */
+#define PAT_TYPE_WT       0x04 /* Write-through */
+#define PAT_TYPE_WP       0x05 /* Write-protected */
+#define PAT_TYPE_WB       0x06 /* Write-back */
+#define PAT_TYPE_UC_MINUS 0x07 /* Uncached, unless overridden by an MTRR */
+
+#define PAT_ENTRY(idx, type) ((uint64_t)(type) << ((idx) * 8))
+
+/* ------------------------------------------------------------------------- */
+
+static inline uint64_t msr_read(uint32_t reg) {
+    uint32_t low, high;
+
+    asm volatile("rdmsr"
+                 : "=a"(low), "=d"(high)
+                 : "c"(reg)
+    );
+
+    return ((uint64_t)high << 32) | low;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static inline void msr_write(uint32_t reg, uint64_t value) {
     uint32_t low  = value & 0xFFFFFFFF;
     uint32_t high = value >> 32;
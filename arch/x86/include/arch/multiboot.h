@@ -240,6 +240,8 @@ typedef struct multiboot_drive_info {
  /* FSF header ends here, my own stuff starts now */
 
 #include <rotary/logging.h>
+#include <rotary/util/math.h>
 #include <rotary/mm/bootmem.h>
+#include <rotary/fs/initrd/initrd.h>
 
 uint32_t multiboot_parse(uint32_t mboot_magic, multiboot_info_t * info);
@@ -13,13 +13,29 @@
 
 #define KERNEL_START_VIRT 0xC0000000
 #define KMAP_START_VIRT   0xF0000000
-#define LOWMEM_PLIMIT     0x40000000
+
+/* Physical memory below this limit is directly mapped from KERNEL_START_VIRT
+ * up to the kmap() area, anything above it is highmem */
+#define LOWMEM_PLIMIT     (KMAP_START_VIRT - KERNEL_START_VIRT)
+
+/* With PAE, CR3 holds the address of the PDPT, which is kept in the last 32
+ * bytes of a PGD's page, rather than the address of the PGD itself */
+#ifdef KCONF_X86_PAE
+#define PGD_CR3_OFFSET    (PAGE_SIZE - 32)
+#else
+#define PGD_CR3_OFFSET    0
+#endif
 
 /* ------------------------------------------------------------------------- */
 
 #define VIR_TO_PHY(addr) ((void *)((uintptr_t)(addr) - KERNEL_START_VIRT))
 #define PHY_TO_VIR(addr) ((void *)((uintptr_t)(addr) + KERNEL_START_VIRT))
 
+/* Page fault error code bits */
+#define PF_ERR_PRESENT 0x01 /* Access to a present page was denied */
+#define PF_ERR_WRITE   0x02
+#define PF_ERR_USER    0x04
+
 /* ------------------------------------------------------------------------- */
 
 #include <rotary/core.h>
@@ -27,6 +43,7 @@
 #include <rotary/sched/task.h>
 #include <arch/cpuid.h>
 #include <arch/interrupts.h>
+#include <arch/msr.h>
 #include <arch/ptable.h>
 
 /* ------------------------------------------------------------------------- */
@@ -35,6 +52,27 @@ static inline void paging_inval_tlb_entry(void * addr) {
     asm volatile("invlpg (%0)" : : "r" (addr) : "memory");
 }
 
+/* Physical address of the PGD currently loaded by the CPU */
+static inline void * paging_current_pgd() {
+    uint32_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r" (cr3));
+    return (void*)(cr3 - PGD_CR3_OFFSET);
+}
+
+/* Load a PGD, given its physical address, without any checks or logging, for
+ * use on the task switch path */
+static inline void paging_load_pgd(void * pgd) {
+    asm volatile("mov %0, %%cr3" ::
+                 "r"((uint32_t)pgd + PGD_CR3_OFFSET) : "memory");
+}
+
+/* Invalidate all non-global TLB entries by reloading CR3 */
+static inline void paging_flush_tlb() {
+    uint32_t cr3;
+    asm volatile("mov %%cr3, %0\n\t"
+                 "mov %0, %%cr3" : "=r" (cr3) : : "memory");
+}
+
 /* ------------------------------------------------------------------------- */
 
 struct isr_registers;
@@ -44,8 +82,14 @@ struct pgd;
 
 int32_t paging_init();
 void    paging_setup_kernel_pgd();
+void    paging_init_pat();
+int32_t paging_pat_enabled();
 int32_t paging_switch_pgd(struct pgd * pgd);
 struct pgd * paging_kernel_pgd();
+#ifdef KCONF_X86_PAE
+void    paging_enable_nx();
+#endif
+int32_t paging_nx_enabled();
 void    paging_handle_page_fault(struct isr_registers * registers);
 
 /* ------------------------------------------------------------------------- */
@@ -12,9 +12,31 @@
 
 /* ------------------------------------------------------------------------- */
 
+#ifdef KCONF_X86_PAE
+
+/* With PAE, a page directory pointer table (PDPT) selects one of four page
+ * directories, each covering 1GB. They're treated as one directory of
+ * PAGE_DIR_SIZE entries by the code using them, see PGD_ENTRY() */
+#define PDPT_SIZE        4
+#define PAGE_DIR_ENTRIES 512
+#define PAGE_DIR_SIZE    (PDPT_SIZE * PAGE_DIR_ENTRIES)
+#define PAGE_TABLE_SIZE  512
+
+/* A single PDE can map a 2MB huge page in place of a page table */
+#define HUGE_PAGE_ORDER  9
+
+#else
+
 #define PAGE_DIR_SIZE   1024
 #define PAGE_TABLE_SIZE 1024
 
+/* With PSE, a single PDE can map a 4MB huge page in place of a page table */
+#define HUGE_PAGE_ORDER 10
+
+#endif
+
+#define HUGE_PAGE_SIZE  (PAGE_SIZE * PAGE_TABLE_SIZE)
+
 /* Bit field flags for page directory entries (top level) */
 #define PDE_PRESENT       0x01
 #define PDE_WRITABLE      0x02
@@ -22,7 +44,8 @@
 #define PDE_WRITETHROUGH  0x08
 #define PDE_CACHE_DISABLE 0x10
 #define PDE_ACCESSED      0x20
-#define PDE_PAGE_SIZE_4M  0x80
+#define PDE_DIRTY         0x40  /* Huge pages only */
+#define PDE_PAGE_SIZE_4M  0x80  /* 2MB with PAE */
 #define PDE_GLOBAL        0x100
 
 /* Bit field flags for page table entries */
@@ -35,13 +58,44 @@
 #define PTE_DIRTY         0x40
 #define PTE_PAT           0x80
 #define PTE_GLOBAL        0x100
+#define PTE_COW           0x200 /* Ignored by the CPU, see ptable_cow_fault() */
+
+/* PAT, PCD and PWT bits selecting each memory type, see paging_init_pat() */
+#define PTE_CACHE_WB      0
+#define PTE_CACHE_WT      PTE_WRITETHROUGH
+#define PTE_CACHE_UC      (PTE_CACHE_DISABLE | PTE_WRITETHROUGH)
+#define PTE_CACHE_WC      PTE_PAT
+#define PTE_CACHE_MASK    (PTE_PAT | PTE_CACHE_DISABLE | PTE_WRITETHROUGH)
+
+#ifdef KCONF_X86_PAE
+
+/* Entries are 64 bits wide, with room for physical addresses above 4GB and
+ * the no-execute bit, which is honoured once EFER.NXE is set */
+typedef uint64_t ptable_entry_t;
+
+#define PTE_NX            (1ULL << 63)
+#define PTE_ADDR_MASK     0x000FFFFFFFFFF000ULL
+#define PTE_FLAGS_MASK    (PTE_NX | 0xFFF)
+
+/* Page directory pointer table entries only have a present bit */
+#define PDPTE_PRESENT     0x01
+
+#else
+
+typedef uint32_t ptable_entry_t;
+
+#define PTE_NX            0
+#define PTE_ADDR_MASK     0xFFFFF000
+#define PTE_FLAGS_MASK    0xFFF
+
+#endif
 
 /* Return the page frame start address for a PA */
 #define PAGE_FRAME(addr) (((uint32_t)addr) & 0xFFFFF000)
 
 /* Macros to ensure general alignment */
-#define ALIGN(addr, alignment) ((uintptr_t)(addr) + ((alignment) - 1)) & \
-                               ~((uintptr_t)(alignment) - 1)
+#define ALIGN(addr, alignment) (((uintptr_t)(addr) + ((alignment) - 1)) & \
+                                ~((uintptr_t)(alignment) - 1))
 #define ALIGN_DOWN(addr, alignment) ((uintptr_t)(addr) & \
                                     ~((uintptr_t)(alignment) - 1))
 
@@ -49,29 +103,73 @@
 #define PAGE_ALIGN(addr) ALIGN((addr), PAGE_SIZE)
 #define PAGE_ALIGN_DOWN(addr) ALIGN_DOWN((addr), PAGE_SIZE)
 #define IS_PAGE_ALIGNED(addr) (((uintptr_t)(addr) & (PAGE_SIZE - 1)) == 0)
+#define IS_HUGE_ALIGNED(addr) (((uintptr_t)(addr) & (HUGE_PAGE_SIZE - 1)) == 0)
 
 /* Macros to derive page table indexes for an address */
+#ifdef KCONF_X86_PAE
+#define PAGE_DIRECTORY_INDEX(addr) (((uint32_t)(addr) >> 21) & 0x7FF)
+#define PAGE_TABLE_INDEX(addr) (((uint32_t)(addr) >> 12) & 0x1FF)
+#else
 #define PAGE_DIRECTORY_INDEX(addr) (((uint32_t)(addr) >> 22) & 0x3FF)
 #define PAGE_TABLE_INDEX(addr) (((uint32_t)(addr) >> 12) & 0x3FF)
+#endif
 
 /* Macros to derive an address from a directory or table index */
+#ifdef KCONF_X86_PAE
+#define PDE_IDX_TO_ADDR(idx) ((uint32_t)(idx) << 21)
+#else
 #define PDE_IDX_TO_ADDR(idx) ((idx) << 22)
+#endif
 #define PTE_IDX_TO_ADDR(idx) ((idx) << 12)
 
 /* Macros to create page table entries with address and flags */
 #define MAKE_PDE(addr, flags) ((struct pde){ \
-    .entry = ((uintptr_t)(addr) & 0xFFFFF000) | ((flags) & 0xFFF) \
+    .entry = ((uintptr_t)(addr) & PTE_ADDR_MASK) | ((flags) & PTE_FLAGS_MASK) \
 })
 #define MAKE_PTE(addr, flags) ((struct pte){ \
-    .entry = ((uintptr_t)(addr) & 0xFFFFF000) | ((flags) & 0xFFF) \
+    .entry = ((uintptr_t)(addr) & PTE_ADDR_MASK) | ((flags) & PTE_FLAGS_MASK) \
+})
+
+/* Create a page table entry from a page frame number, which unlike a pointer
+ * can refer to memory above 4GB */
+#define MAKE_PDE_PFN(pfn, flags) ((struct pde){ \
+    .entry = ((ptable_entry_t)(pfn) << PAGE_SHIFT) | \
+             ((flags) & PTE_FLAGS_MASK) \
+})
+#define MAKE_PTE_PFN(pfn, flags) ((struct pte){ \
+    .entry = ((ptable_entry_t)(pfn) << PAGE_SHIFT) | \
+             ((flags) & PTE_FLAGS_MASK) \
+})
+
+#ifdef KCONF_X86_PAE
+#define MAKE_PDPTE(addr) ((struct pdpte){ \
+    .entry = ((uintptr_t)(addr) & PTE_ADDR_MASK) | PDPTE_PRESENT \
 })
+#endif
 
 /* Macros to check for existence of PDEs and PTEs */
 #define PDE_EXISTS(pde) (((pde)->entry & PDE_PRESENT) != 0)
 #define PTE_EXISTS(pte) (((pte)->entry & PTE_PRESENT) != 0)
 
+/* A swapped out page leaves behind an entry that isn't present, holding its
+ * swap slot in place of the frame. Slot 0 is never used, so that a cleared
+ * entry is never mistaken for one */
+#define MAKE_SWAP_PTE(slot) ((struct pte){ \
+    .entry = (ptable_entry_t)(slot) << PAGE_SHIFT \
+})
+#define PTE_SWAP_SLOT(pte) ((uint32_t)((pte)->entry >> PAGE_SHIFT))
+#define PTE_IS_SWAP(pte)   (!PTE_EXISTS(pte) && PTE_SWAP_SLOT(pte) != 0)
+
+/* Get a directory entry by its index, from 0 to PAGE_DIR_SIZE */
+#ifdef KCONF_X86_PAE
+#define PGD_ENTRY(pgd, idx) (&((struct pde*)PHY_TO_VIR(PAGE_FRAME( \
+    (pgd)->pdpt[(idx) / PAGE_DIR_ENTRIES].entry)))[(idx) % PAGE_DIR_ENTRIES])
+#else
+#define PGD_ENTRY(pgd, idx) (&(pgd)->entries[(idx)])
+#endif
+
 /* Get the relevant PDE or PTE for a virtual address */
-#define GET_PDE(pgd, va) (&(pgd)->entries[PAGE_DIRECTORY_INDEX(va)])
+#define GET_PDE(pgd, va) PGD_ENTRY((pgd), PAGE_DIRECTORY_INDEX(va))
 #define GET_PTE(pgt, va) (&(pgt)->entries[PAGE_TABLE_INDEX(va)])
 
 /* Get a pointer to the actual page table from a directory entry */
@@ -83,6 +181,13 @@
 #define PDE_VA(pde) (PHY_TO_VIR(PAGE_FRAME((pde)->entry)))
 #define PTE_VA(pte) (PHY_TO_VIR(PAGE_FRAME((pte)->entry)))
 
+/* Page frame numbers mapped by an entry, valid even above 4GB */
+#define PDE_PFN(pde) ((uint32_t)(((pde)->entry & PTE_ADDR_MASK) >> PAGE_SHIFT))
+#define PTE_PFN(pte) ((uint32_t)(((pte)->entry & PTE_ADDR_MASK) >> PAGE_SHIFT))
+
+#define PDE_PAGE(pde) (page_from_pfn(PDE_PFN((pde))))
+#define PTE_PAGE(pte) (page_from_pfn(PTE_PFN((pte))))
+
 #define PDE_IS_WRITABLE(pde) ((pde)->writable)
 #define PDE_IS_USER(pde) ((pde)->user)
 
@@ -110,8 +215,86 @@
 /* the top-level page table.                                                 */
 /*                                                                           */
 /* Bits 21-12 provide the index into the second-level page table.            */
+/*                                                                           */
+/* With PAE, bits 31-30 select one of four page directories through the     */
+/* PDPT, bits 29-21 index the directory and bits 20-12 index the table.      */
 /* ------------------------------------------------------------------------- */
 
+#ifdef KCONF_X86_PAE
+
+struct pdpte {
+    union {
+        uint64_t entry;
+        struct {
+            uint64_t present       : 1;
+            uint64_t reserved      : 2;
+            uint64_t writethrough  : 1;
+            uint64_t cache_disable : 1;
+            uint64_t reserved2     : 4;
+            uint64_t ignored       : 3;
+            uint64_t address       : 40;
+            uint64_t reserved3     : 12;
+        };
+    };
+};
+
+struct pde {
+    union {
+        uint64_t entry;
+        struct {
+            uint64_t present       : 1;
+            uint64_t writable      : 1;
+            uint64_t user          : 1;
+            uint64_t writethrough  : 1;
+            uint64_t cache_disable : 1;
+            uint64_t accessed      : 1;
+            uint64_t ignored       : 1;
+            uint64_t page_size     : 1;
+            uint64_t ignored2      : 4;
+            uint64_t address       : 40;
+            uint64_t reserved      : 11;
+            uint64_t nx            : 1;
+        };
+    };
+};
+
+struct pte {
+    union {
+        uint64_t entry;
+        struct {
+            uint64_t present       : 1;
+            uint64_t writable      : 1;
+            uint64_t user          : 1;
+            uint64_t writethrough  : 1;
+            uint64_t cache_disable : 1;
+            uint64_t accessed      : 1;
+            uint64_t dirty         : 1;
+            uint64_t pat           : 1;
+            uint64_t global        : 1;
+            uint64_t ignored       : 3;
+            uint64_t address       : 40;
+            uint64_t reserved      : 11;
+            uint64_t nx            : 1;
+        };
+    };
+};
+
+struct pgt {
+    struct pte entries[PAGE_TABLE_SIZE];
+};
+
+/* The PDPT only needs 32 bytes, but a PGD still occupies a page of its own,
+ * so that it's allocated and cached in the same way as without PAE. The PDPT
+ * is kept at the end, clear of the word used to link quicklists. The
+ * directories themselves are separate pages, with the kernel's shared by
+ * every PGD */
+struct pgd {
+    uint8_t      unused[PAGE_SIZE - PDPT_SIZE * sizeof(struct pdpte)];
+    struct pdpte pdpt[PDPT_SIZE];
+};
+
+#else
+
 struct pde {
     union {
         uint32_t entry;
@@ -157,6 +340,8 @@ struct pgd {
     struct pde entries[PAGE_DIR_SIZE];
 };
 
+#endif
+
 /* ------------------------------------------------------------------------- */
 
 void ptable_print_pte(struct pte * pte);
@@ -164,6 +349,11 @@ void ptable_print_pde(struct pde * pde);
 void ptable_print_pgd(struct pgd * pgd);
 void ptable_print_pgt(struct pgt * pgt);
 
+int32_t ptable_pgd_init(struct pgd * pgd);
+void    ptable_pgd_fini(struct pgd * pgd);
+
+ptable_entry_t ptable_cache_flags(flags_t flags);
+
 /* ------------------------------------------------------------------------- */
 
 #endif
@@ -24,7 +24,7 @@ struct syscall_regs {
 
 /* ------------------------------------------------------------------------- */
 
-void syscall_handler(struct syscall_regs * regs);
+int32_t syscall_handler(struct syscall_regs * regs);
 
 /* ------------------------------------------------------------------------- */
 
@@ -17,6 +17,7 @@
 
 int32_t timer_init();
 int32_t timer_tick();
+uint64_t timer_get_ticks();
 
 /* ------------------------------------------------------------------------- */
 
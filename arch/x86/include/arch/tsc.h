@@ -0,0 +1,35 @@
+/*
+ * arch/x86/include/arch/tsc.h
+ * x86 Time Stamp Counter
+ */
+
+#ifndef INC_ARCH_TSC_H
+#define INC_ARCH_TSC_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/util/math.h>
+#include <arch/cpuid.h>
+#include <arch/io_port.h>
+#include <arch/paging.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define PIT_FREQUENCY_HZ      1193182
+#define TSC_CALIBRATE_MS      10
+
+/* ------------------------------------------------------------------------- */
+
+static inline uint64_t tsc_read() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+/* ------------------------------------------------------------------------- */
+
+uint32_t tsc_calibrate();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -16,7 +16,6 @@ extern tss
 
 %define TASK_OFFSET_KSTACK_TOP 20
 %define TASK_OFFSET_KSTACK_BOT 24
-%define TASK_OFFSET_VM_SPACE   32
 
 %define TSS_OFFSET_ESP0        4
 
@@ -46,19 +45,9 @@ task_context_switch:
     ; Now we need to load the stack pointer of the next task
     mov     esp, [edx + TASK_OFFSET_KSTACK_TOP]
 
-    ; Retrieve a pointer to the page table within the task's vm_space struct
-    mov     ebx, [edx + TASK_OFFSET_VM_SPACE]
-    mov     ebx, [ebx]
+    ; The page directory has already been loaded, if necessary, by
+    ; task_switch_vm_space()
 
-    ; Check whether the task uses a different page directory
-    mov     ecx, cr3
-    cmp     ecx, ebx
-    je      .end_task_context_switch
-
-    ; Task uses a diff. PD, update CR3 to point to the new page directory
-    mov     cr3, ebx
-
-.end_task_context_switch:
     ; Restore registers that aren't preserved by cdecl
     pop     edi
     pop     esi
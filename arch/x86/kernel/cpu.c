@@ -20,7 +20,7 @@ struct cpu_info cpu0;
  *
  * Return: E_SUCCESS
  */
-int32_t cpu_init() {
+int32_t __init cpu_init() {
     klog("cpu_init() - Initialising CPU..\n");
 
     /* Initialise the CPU info struct */
@@ -45,7 +45,7 @@ int32_t cpu_init() {
  * maximum 4GB memory range available on 32-bit x86, as paging is used later
  * on to provide more fine-grained control over memory regions.
  */
-void cpu_init_gdt(struct cpu_info * cpu) {
+void __init cpu_init_gdt(struct cpu_info * cpu) {
     klog("cpu_init_gdt() - Initialising GDT..\n");
 
     uint16_t gdt_size = (sizeof(gdt_entry_t) * GDT_ENTRY_COUNT) - 1;
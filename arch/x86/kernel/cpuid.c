@@ -15,6 +15,7 @@ uint32_t leaf0_eax, leaf0_ebx, leaf0_ecx, leaf0_edx;
 uint32_t leaf1_eax, leaf1_ebx, leaf1_ecx, leaf1_edx;
 uint32_t leaf2_eax, leaf2_ebx, leaf2_ecx, leaf2_edx;
 uint32_t leaf3_eax, leaf3_ebx, leaf3_ecx, leaf3_edx;
+uint32_t ext1_eax, ext1_ebx, ext1_ecx, ext1_edx;
 
 /* ------------------------------------------------------------------------- */
 
@@ -27,12 +28,13 @@ uint32_t leaf3_eax, leaf3_ebx, leaf3_ecx, leaf3_edx;
  *
  * Return: E_SUCCESS
  */
-int32_t cpuid_init() {
+int32_t __init cpuid_init() {
     klog("cpuid_init(): Retrieving CPUID values..\n");
     __get_cpuid(0, &leaf0_eax, &leaf0_ebx, &leaf0_ecx, &leaf0_edx);
     __get_cpuid(1, &leaf1_eax, &leaf1_ebx, &leaf1_ecx, &leaf1_edx);
     __get_cpuid(2, &leaf2_eax, &leaf2_ebx, &leaf2_ecx, &leaf2_edx);
     __get_cpuid(3, &leaf3_eax, &leaf3_ebx, &leaf3_ecx, &leaf3_edx);
+    __get_cpuid(0x80000001, &ext1_eax, &ext1_ebx, &ext1_ecx, &ext1_edx);
     char cpu_name[24];
     cpuid_get_cpu_name(cpu_name);
     klog("CPU: %s\n", cpu_name);
@@ -90,6 +92,39 @@ int32_t cpuid_check_pge() {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * cpuid_check_nx() - Returns whether the no-execute page bit is supported.
+ *
+ * Return: 1 if the NX bit is supported, 0 if it isn't.
+ */
+int32_t cpuid_check_nx() {
+    return (ext1_edx & CPUID_FEAT_EXT_EDX_NX) != 0 ? 1 : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * cpuid_check_pat() - Returns whether the Page Attribute Table is supported.
+ *
+ * Return: 1 if the PAT is supported, 0 if it isn't.
+ */
+int32_t cpuid_check_pat() {
+    return (leaf1_edx & CPUID_FEAT_EDX_PAT) != 0 ? 1 : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * cpuid_check_tsc() - Returns whether the Time Stamp Counter is supported.
+ *
+ * Return: 1 if the TSC is supported, 0 if it isn't.
+ */
+int32_t cpuid_check_tsc() {
+    return (leaf1_edx & CPUID_FEAT_EDX_TSC) != 0 ? 1 : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * cpuid_check_apic() - Returns whether the Intel APIC is present.
  *
@@ -152,3 +187,33 @@ int32_t x86_paging_pge_enabled() {
 }
 
 /* ------------------------------------------------------------------------- */
+
+/**
+ * x86_paging_pae_enabled() - Check whether Physical Address Extension is on.
+ *
+ * PAE is enabled by the boot code when the kernel is built with
+ * KCONF_X86_PAE, so this checks the relevant bit in the CR4 control register.
+ *
+ * Return: 0 if disabled, 1 if enabled.
+ */
+int32_t x86_paging_pae_enabled() {
+    uint32_t cr4;
+    __asm__ volatile ("mov %%cr4, %0" : "=r" (cr4));
+    return (cr4 & 0x20) ? 1 : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * x86_paging_huge_enabled() - Check whether a PDE can map a huge page.
+ *
+ * Without PAE, 4MB pages require PSE. With PAE, 2MB pages are always
+ * available, whether or not PSE is enabled.
+ *
+ * Return: 0 if unavailable, 1 if available.
+ */
+int32_t x86_paging_huge_enabled() {
+    return x86_paging_pae_enabled() || x86_paging_pse_enabled();
+}
+
+/* ------------------------------------------------------------------------- */
@@ -7,6 +7,8 @@
 #include <rotary/mm/slab.h>
 #include <rotary/fs/vfs/root.h>
 #include <rotary/core/shell.h>
+#include <rotary/core/bootprof.h>
+#include <rotary/core/initcall.h>
 
 /* ------------------------------------------------------------------------- */
 
@@ -31,6 +33,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     vga_set_cursor(0, 23);
 
     // Initialise serial as early as we can for the sake of debug output
+    boot_stage_begin("serial");
     printk(LOG_INFO, "Initialising serial ports..            ");
     if(!SUCCESS(serial_init())) {
         printk(LOG_INFO, FAIL_STR);
@@ -50,6 +53,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     "                                           \n"
     "\n");
 
+    boot_stage_begin("multiboot");
     printk(LOG_INFO, "Parsing Multiboot structs..            ");
     if(!multiboot_parse(mboot_magic, (multiboot_info_t*)mboot_info)) {
         printk(LOG_INFO, FAIL_STR);
@@ -57,6 +61,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("cpuid");
     printk(LOG_INFO, "Retrieving CPUID..                     ");
     if(!SUCCESS(cpuid_init())) {
         printk(LOG_INFO, FAIL_STR);
@@ -64,6 +69,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("paging");
     printk(LOG_INFO, "Initialising paging..                  ");
     if(!SUCCESS(paging_init())) {
         printk(LOG_INFO, FAIL_STR);
@@ -71,6 +77,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("buddy");
     printk(LOG_INFO, "Initialising buddy allocator..         ");
     if(!SUCCESS(buddy_init(bootmem_highest_pfn()))) {
         printk(LOG_INFO, FAIL_STR);
@@ -79,6 +86,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     printk(LOG_INFO, OK_STR);
 
 
+    boot_stage_begin("bootmem");
     printk(LOG_INFO, "Initialising bootmem..                 ");
     if(!SUCCESS(bootmem_mark_free())) {
         printk(LOG_INFO, FAIL_STR);
@@ -86,6 +94,15 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
+    printk(LOG_INFO, "Running early/core initcalls..         ");
+    if(!SUCCESS(initcall_run_level(INITCALL_EARLY)) ||
+       !SUCCESS(initcall_run_level(INITCALL_CORE))) {
+        printk(LOG_INFO, FAIL_STR);
+        return E_ERROR;
+    }
+    printk(LOG_INFO, OK_STR);
+
+    boot_stage_begin("cpu");
     printk(LOG_INFO, "Setting up CPU..                       ");
     if(!SUCCESS(cpu_init())) {
         printk(LOG_INFO, FAIL_STR);
@@ -93,6 +110,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("idt");
     printk(LOG_INFO, "Assigning IDT gates..                  ");
     if(!SUCCESS(idt_init())) {
         printk(LOG_INFO, FAIL_STR);
@@ -100,6 +118,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("idt_load");
     printk(LOG_INFO, "Loading IDT..                          ");
     if(!SUCCESS(idt_load())) {
         printk(LOG_INFO, FAIL_STR);
@@ -107,6 +126,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("pic");
     printk(LOG_INFO, "Configuring legacy PIC..               ");
     if(!SUCCESS(pic_init(PIC_MASTER_OFFSET, PIC_SLAVE_OFFSET))) {
         printk(LOG_INFO, FAIL_STR);
@@ -114,6 +134,7 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("timer");
     printk(LOG_INFO, "Initialising timer..                   ");
     if(!SUCCESS(timer_init())) {
         printk(LOG_INFO, FAIL_STR);
@@ -121,17 +142,19 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
-    printk(LOG_INFO, "Initialising keyboard driver..         ");
-    if(!SUCCESS(keyboard_init())) {
+    printk(LOG_INFO, "Running arch initcalls..               ");
+    if(!SUCCESS(initcall_run_level(INITCALL_ARCH))) {
         printk(LOG_INFO, FAIL_STR);
         return E_ERROR;
     }
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("interrupts");
     printk(LOG_INFO, "Enabling interrupts..                  ");
     enable_hardware_interrupts();
     printk(LOG_INFO, OK_STR);
 
+    boot_stage_begin("task");
     printk(LOG_INFO, "Initialising task scheduler..          ");
     if(!SUCCESS(task_init())) {
         printk(LOG_INFO, FAIL_STR);
@@ -139,20 +162,36 @@ int32_t arch_init(uint32_t arg1, uint32_t arg2) {
     }
     printk(LOG_INFO, OK_STR);
 
-    printk(LOG_INFO, "Initialising default TTYs..            ");
-    if(!SUCCESS(tty_init())) {
+    /* Remaining subsystems and drivers, any failures are not fatal */
+    printk(LOG_INFO, "Running initcalls..                    ");
+    int32_t rv = E_SUCCESS;
+    for(uint32_t lvl = INITCALL_SUBSYS; lvl <= INITCALL_LEVEL_MAX; lvl++) {
+        if(!SUCCESS(initcall_run_level(lvl))) {
+            rv = E_ERROR;
+        }
+    }
+    printk(LOG_INFO, SUCCESS(rv) ? OK_STR : FAIL_STR);
+
+    /* Slow initcalls, such as mounting the root filesystem, continue to run
+     * in a kernel task now that the scheduler is running */
+    printk(LOG_INFO, "Starting async initcalls..             ");
+    if(!SUCCESS(initcall_start_async())) {
         printk(LOG_INFO, FAIL_STR);
         return E_ERROR;
     }
     printk(LOG_INFO, OK_STR);
 
-    printk(LOG_INFO, "Mounting root filesystem..             ");
-    mount_root_testing();
+    boot_stage_end();
+    boot_timeline_print();
 
 
     task_create("shell", TASK_KERNEL, &shell_init, TASK_PRIORITY_MIN,
                 TASK_STATE_WAITING);
 
+    /* No further __init code will run, so init. memory can be released once
+     * the async initcalls have finished */
+    initcall_boot_complete();
+
     return 0;
 }
 
@@ -220,7 +220,7 @@ void set_idt_gate(uint32_t int_num, uint32_t handle_addr, uint32_t dpl) {
  *
  * Return: E_SUCCESS
  */
-int32_t idt_load() {
+int32_t __init idt_load() {
     klog("IDT addr: 0x%x, descriptor 0x%x\n", &idt, &idt_ptr);
     idt_ptr.base = (uint32_t)&idt;
     idt_ptr.limit = 256 * sizeof(idt_gate_t) - 1;
@@ -243,7 +243,7 @@ int32_t idt_load() {
  *
  * Return: E_SUCCESS
  */
-int32_t idt_init() {
+int32_t __init idt_init() {
     /* CPU Exceptions and Interrupts */
     set_idt_gate(0, (uint32_t)isr0, IDT_DPL_KERNEL);
     set_idt_gate(1, (uint32_t)isr1, IDT_DPL_KERNEL);
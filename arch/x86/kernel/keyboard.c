@@ -17,7 +17,7 @@
  *
  * Return: E_SUCCESS
  */
-int32_t arch_keyboard_init() {
+int32_t __init arch_keyboard_init() {
     register_interrupt_handler(INT_KEYBOARD, &x86_driver_keyboard_isr);
     return E_SUCCESS;
 }
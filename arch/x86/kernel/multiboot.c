@@ -2,54 +2,7 @@
 
 extern uint32_t KERNEL_PHYS_END;
 
-void udivmod64(uint64_t dividend, uint64_t divisor, uint64_t *quotient, uint64_t *remainder) {
-    uint64_t q = 0;
-    uint64_t r = 0;
-    int i;
-
-    for (i = 63; i >= 0; i--) {
-        r <<= 1;
-        r |= (dividend >> i) & 1;
-
-        if (r >= divisor) {
-            r -= divisor;
-            q |= (uint64_t)1 << i;
-        }
-    }
-
-    if (quotient) {
-        *quotient = q;
-    }
-
-    if (remainder) {
-        *remainder = r;
-    }
-}
-
-void uint64_to_str(uint64_t value, char *str, int base) {
-    char *ptr = str, *ptr1 = str, tmp_char;
-    uint64_t quotient, remainder;
-
-    // Calculate the string representation of the number in the given base
-    do {
-        udivmod64(value, base, &quotient, &remainder);
-        value = quotient;
-        *ptr++ = "0123456789abcdef"[remainder];
-    } while (value);
-
-    // Null-terminate the string
-    *ptr-- = '\0';
-
-    // Reverse the string
-    while (ptr1 < ptr) {
-        tmp_char = *ptr;
-        *ptr-- = *ptr1;
-        *ptr1++ = tmp_char;
-    }
-}
-
-
-uint32_t multiboot_parse(uint32_t mboot_magic, multiboot_info_t * info) {
+uint32_t __init multiboot_parse(uint32_t mboot_magic, multiboot_info_t * info) {
 
     if(mboot_magic != MULTIBOOT_BOOTLOADER_MAGIC) {
         klog("Invalid Multiboot magic bytes! Got 0x%x, expected 0x%x\n", mboot_magic, 
@@ -91,6 +44,10 @@ uint32_t multiboot_parse(uint32_t mboot_magic, multiboot_info_t * info) {
             klog("Module %d start: 0x%x\n", i, mod->mod_start);
             klog("Module %d end: 0x%x\n", i, mod->mod_end);
             klog("Module %d command line: %s\n", i, (char *)mod->cmdline);
+
+            /* Reserve the module so that the initrd can use it in place */
+            initrd_add_module(mod->mod_start, mod->mod_end,
+                              (char *)mod->cmdline);
         }
     }
 
@@ -127,23 +84,37 @@ uint32_t multiboot_parse(uint32_t mboot_magic, multiboot_info_t * info) {
                    end_addr,
                    type);
 
-            if(mmap->addr <= (uint32_t)&KERNEL_PHYS_END && (mmap->addr + mmap->len) >= (uint32_t)&KERNEL_PHYS_END && mmap->type == MULTIBOOT_MEMORY_AVAILABLE) {
-
-                /*
-                uint32_t aligned_end_addr = PAGE_ALIGN((uint32)&KERNEL_PHYS_END);
-                uint32_t final_addr = mmap->addr + mmap->len;
-                */
-
-                klog("Found appropriate mem. region, start: 0x%x, end: 0x%x\n", mmap->addr, (mmap->addr + mmap->len));
-
-                uintptr_t start_addr  = (uintptr_t)mmap->addr;
-                uintptr_t end_addr    = (uintptr_t)(mmap->addr + mmap->len);
-                uint32_t  region_type = (mmap->type == MULTIBOOT_MEMORY_AVAILABLE) ? MEM_REGION_AVAILABLE : MEM_REGION_RESERVED;
-                bootmem_add_mem_region(start_addr, end_addr, region_type);
+            /* Register every region, so that memory either side of holes
+             * in a fragmented map is not lost. Memory above 4GB can't be
+             * addressed without PAE, so it's clipped. With PAE, available
+             * memory above 4GB is registered by page frame number instead */
+            uint64_t  mmap_end     = mmap->addr + mmap->len;
+#ifdef KCONF_X86_PAE
+            if(mmap_end > 0x100000000ULL &&
+               mmap->type == MULTIBOOT_MEMORY_AVAILABLE) {
+                uint64_t high_start = (mmap->addr > 0x100000000ULL) ?
+                                      mmap->addr : 0x100000000ULL;
+                bootmem_add_pfn_range(
+                    (uint32_t)((high_start + PAGE_SIZE - 1) >> PAGE_SHIFT),
+                    (uint32_t)(mmap_end >> PAGE_SHIFT));
             }
+#endif
+            if(mmap->addr >= 0x100000000ULL)
+                continue;
+
+            uintptr_t region_start = (uintptr_t)mmap->addr;
+            uintptr_t region_end   = (mmap_end > 0xFFFFF000ULL) ?
+                                     0xFFFFF000 : (uintptr_t)mmap_end;
+            uint32_t  region_type  = (mmap->type == MULTIBOOT_MEMORY_AVAILABLE) ?
+                                     MEM_REGION_AVAILABLE : MEM_REGION_RESERVED;
+            bootmem_add_mem_region(region_start, region_end, region_type);
         }
     }
 
+    /* Never hand out the first page, so that physical address 0 can't be
+     * mistaken for a failed allocation */
+    bootmem_reserve(0, PAGE_SIZE);
+
     // Print boot loader name
     if (info->flags & MULTIBOOT_INFO_BOOT_LOADER_NAME) {
         klog("Boot loader name: %s\n", (char *)info->boot_loader_name);
@@ -12,9 +12,22 @@
 extern uintptr_t KERNEL_PHYS_START;
 extern uintptr_t KERNEL_PHYS_END;
 
+/* Whether the PAT has been programmed with the layout in paging_init_pat() */
+uint32_t pat_enabled = 0;
+
+/* Whether EFER.NXE is set, so that PTE_NX is honoured */
+uint32_t nx_enabled = 0;
+
 /* Page global directory for kernel tasks */
 struct pgd kernel_pgd __attribute__((aligned(PAGE_SIZE)));
 
+#ifdef KCONF_X86_PAE
+/* Page directories selected by the kernel PGD's PDPT. The last, covering
+ * kernel space, is shared with every other PGD */
+struct pde kernel_pds[PDPT_SIZE][PAGE_DIR_ENTRIES]
+    __attribute__((aligned(PAGE_SIZE)));
+#endif
+
 /* ------------------------------------------------------------------------- */
 
 /**
@@ -22,8 +35,9 @@ struct pgd kernel_pgd __attribute__((aligned(PAGE_SIZE)));
  *
  * Return: E_SUCCESS
  */
-int32_t paging_init() {
+int32_t __init paging_init() {
     klog("Initialising paging..\n");
+    paging_init_pat();
     paging_setup_kernel_pgd();
     return E_SUCCESS;
 }
@@ -36,7 +50,7 @@ int32_t paging_init() {
  * Populates the kernel page global directory with the kernel address space
  * mappings, then updates the current system page table.
  */
-void paging_setup_kernel_pgd() {
+void __init paging_setup_kernel_pgd() {
     klog("Setting up kernel page table..\n");
 
     int table_cur;
@@ -45,15 +59,24 @@ void paging_setup_kernel_pgd() {
     int pde_global  = (x86_paging_pge_enabled() ? PDE_GLOBAL : 0);
     int pte_global  = (x86_paging_pge_enabled() ? PTE_GLOBAL : 0);
 
-    if(x86_paging_pse_enabled()) {
-        klog("PSE available and enabled, using 4MB pages for kernel PGD\n");
-        /* PSE available, we can use 4MB pages and avoid making page tables */
+#ifdef KCONF_X86_PAE
+    klog("PAE enabled, linking %d page directories\n", PDPT_SIZE);
+    for(int i = 0; i < PDPT_SIZE; i++) {
+        kernel_pgd.pdpt[i] = MAKE_PDPTE(VIR_TO_PHY(kernel_pds[i]));
+    }
+    paging_enable_nx();
+#endif
+
+    if(x86_paging_huge_enabled()) {
+        klog("Huge pages available, using them for kernel PGD\n");
+        /* Huge pages available, so we can avoid making page tables */
         for(table_cur = table_start; table_cur < table_kmap; table_cur++) {
             uint32_t phys_addr = PDE_IDX_TO_ADDR(table_cur - table_start);
-            kernel_pgd.entries[table_cur] = MAKE_PDE(phys_addr, PDE_PRESENT |
-                                                        PDE_WRITABLE |
-                                                        PDE_PAGE_SIZE_4M |
-                                                        pde_global);
+            *PGD_ENTRY(&kernel_pgd, table_cur) = MAKE_PDE(phys_addr,
+                                                    PDE_PRESENT |
+                                                    PDE_WRITABLE |
+                                                    PDE_PAGE_SIZE_4M |
+                                                    pde_global);
         }
     } else {
         /* PSE is NOT available, use 4KB pages and create page tables */
@@ -73,9 +96,9 @@ void paging_setup_kernel_pgd() {
                                                     pte_global);
             }
 
-            kernel_pgd.entries[table_cur] = MAKE_PDE((uint32_t)VIR_TO_PHY(pte),
-                                             PDE_PRESENT | PDE_WRITABLE |
-                                             pde_global);
+            *PGD_ENTRY(&kernel_pgd, table_cur) = MAKE_PDE(VIR_TO_PHY(pte),
+                                                 PDE_PRESENT | PDE_WRITABLE |
+                                                 pde_global);
         }
     }
 
@@ -90,14 +113,17 @@ void paging_setup_kernel_pgd() {
 
         memset(pte, 0, PAGE_SIZE);
 
-        kernel_pgd.entries[table_cur] = MAKE_PDE((uint32_t)VIR_TO_PHY(pte),
-                                         PDE_PRESENT | PDE_WRITABLE |
-                                         pde_global);
+        *PGD_ENTRY(&kernel_pgd, table_cur) = MAKE_PDE(VIR_TO_PHY(pte),
+                                             PDE_PRESENT | PDE_WRITABLE |
+                                             pde_global);
     }
 
     klog("Switching to new kernel page directory at 0x%x\n",
          VIR_TO_PHY(&kernel_pgd));
     paging_switch_pgd(VIR_TO_PHY(&kernel_pgd));
+
+    /* All of low memory is now mapped, so bootmem may allocate from it */
+    bootmem_set_limits(BOOTMEM_LIMIT_LOW, KMAP_START_VIRT - KERNEL_START_VIRT);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -108,8 +134,8 @@ void paging_setup_kernel_pgd() {
  *
  * Changes the current PGD in use by the CPU, used when loading the initial
  * kernel page directory, can be used to change to any other page table.
- * Not used during task switching, as the PGD is saved and restored in the
- * task_context_switch() assembly routine.
+ * Not used during task switching, which uses paging_load_pgd() from
+ * task_switch_vm_space() instead.
  *
  * Return: E_SUCCESS on success E_ERROR if the PGD is not aligned
  */
@@ -122,12 +148,83 @@ int32_t paging_switch_pgd(struct pgd * pgd) {
 
     klog("paging_switch_pgd(): Switching to PGD at 0x%x\n", pgd);
 
-    asm volatile("mov %0, %%cr3" :: "r"((uint32_t)pgd) : "memory");
+    paging_load_pgd(pgd);
     return E_SUCCESS;
 }
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * paging_init_pat() - Program the Page Attribute Table.
+ *
+ * The first four entries keep their power-on types, so that PWT and PCD keep
+ * their usual meaning in entries without the PAT bit set. Write-combining
+ * takes the first entry with the PAT bit set, see PTE_CACHE_WC.
+ */
+void __init paging_init_pat() {
+    if(!cpuid_check_pat()) {
+        klog("PAT not supported, write-combining will be unavailable\n");
+        return;
+    }
+
+    msr_write(MSR_PAT, PAT_ENTRY(0, PAT_TYPE_WB) |
+                       PAT_ENTRY(1, PAT_TYPE_WT) |
+                       PAT_ENTRY(2, PAT_TYPE_UC_MINUS) |
+                       PAT_ENTRY(3, PAT_TYPE_UC) |
+                       PAT_ENTRY(4, PAT_TYPE_WC) |
+                       PAT_ENTRY(5, PAT_TYPE_WT) |
+                       PAT_ENTRY(6, PAT_TYPE_UC_MINUS) |
+                       PAT_ENTRY(7, PAT_TYPE_UC));
+    pat_enabled = 1;
+
+    klog("PAT supported and programmed\n");
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * paging_pat_enabled() - Returns whether write-combining can be used.
+ *
+ * Return: 1 if the PAT has been programmed, 0 if it hasn't.
+ */
+int32_t paging_pat_enabled() {
+    return pat_enabled;
+}
+
+/* ------------------------------------------------------------------------- */
+
+#ifdef KCONF_X86_PAE
+/**
+ * paging_enable_nx() - Enable the no-execute bit, if the CPU supports it.
+ *
+ * PTE_NX is reserved, and faults if set, until EFER.NXE is enabled.
+ */
+void __init paging_enable_nx() {
+    if(!cpuid_check_nx()) {
+        klog("NX not supported, pages will remain executable\n");
+        return;
+    }
+
+    msr_write(MSR_EFER, msr_read(MSR_EFER) | EFER_NXE);
+    nx_enabled = 1;
+
+    klog("NX supported and enabled\n");
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * paging_nx_enabled() - Returns whether pages can be made non-executable.
+ *
+ * Return: 1 if PTE_NX is honoured, 0 if every page is executable.
+ */
+int32_t paging_nx_enabled() {
+    return nx_enabled;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * paging_kernel_pgd() - Retrieve a pointer to the kernel page directory.
  *
@@ -146,7 +243,8 @@ struct pgd * paging_kernel_pgd() {
  * This function is called when a page fault occurs. It retrieves the address
  * that caused the fault using the CR2 register and determines if the fault
  * can be resolved by the virtual memory subsystem. If the fault can be handled,
- * the necessary page table entry is created or updated.
+ * the necessary page table entry is created or updated. Otherwise, a user
+ * task is killed, while a fault in kernel code is a bug.
  */
 void paging_handle_page_fault(struct isr_registers * registers) {
     /* Get the task currently executing at the time */
@@ -156,15 +254,37 @@ void paging_handle_page_fault(struct isr_registers * registers) {
     void * fault_addr;
     __asm__ volatile("mov %%cr2, %0" : "=r" (fault_addr));
 
+    /* Translate the cause of the fault from the error code */
+    flags_t fault_flags = 0;
+    if(TEST_BIT(registers->error_code, PF_ERR_PRESENT)) {
+        SET_BIT(fault_flags, VM_FAULT_PRESENT);
+    }
+    if(TEST_BIT(registers->error_code, PF_ERR_WRITE)) {
+        SET_BIT(fault_flags, VM_FAULT_WRITE);
+    }
+
     /* Invoke arch-independent fault handler that will check if the fault
      * address is mapped and add it to the page table */
-    if(SUCCESS(vm_space_page_fault(curr->vm_space, fault_addr))) {
-        klog("paging_handle_page_fault(): VM subsystem resolved page fault\n");
+    if(curr->vm_space &&
+       SUCCESS(vm_space_page_fault(curr->vm_space, fault_addr,
+                                   fault_flags))) {
         return;
     }
 
-    /* TODO: Handle failure scenarios where the fault is not expected */
     klog("paging_handle_page_fault(): VM subsystem could NOT resolve!\n");
+
+    /* A user task that touched memory it hasn't mapped, or that can't be
+     * backed now that memory and swap have run out, is killed rather than
+     * stopping the system. Returning would only fault again, so it waits
+     * for the scheduler to switch away, which never returns to it */
+    if(TEST_BIT(registers->error_code, PF_ERR_USER)) {
+        printk(LOG_INFO, "Task '%s' killed: unresolvable page fault at "
+               "0x%x\n", curr->name, fault_addr);
+        task_exit_current();
+        enable_hardware_interrupts();
+        while(true) { }
+    }
+
     debug_break();
 }
 
@@ -41,7 +41,7 @@ int32_t pic_send_eoi(uint8_t irq) {
  *
  * Return: E_SUCCESS
  */
-int32_t pic_init(uint8_t master_offset, uint8_t slave_offset) {
+int32_t __init pic_init(uint8_t master_offset, uint8_t slave_offset) {
     /* Begin PIC initialisation - set bit 4 to indicate this is ICW1, set bit
      * 0 to indicate an ICW4 will be sent later */
     klog("Sending ICW1_INIT to PIC1\n");
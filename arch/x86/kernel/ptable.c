@@ -3,6 +3,7 @@
  */
 
 #include <arch/ptable.h>
+#include <rotary/mm/palloc.h>
 
 /* ------------------------------------------------------------------------- */
 
@@ -35,11 +36,14 @@ void ptable_print_pte(struct pte * pte) {
         strcat(flag_str, "PAT, ");
     if(TEST_BIT(pte->entry, PTE_GLOBAL))
         strcat(flag_str, "Global, ");
+    if(PTE_NX && TEST_BIT(pte->entry, PTE_NX))
+        strcat(flag_str, "No Execute, ");
 
     flag_str[strlen(flag_str)] = 0;
     flag_str[strlen(flag_str) - 1] = 0;
 
-    klog("PTE[VA: 0x%x, Raw: 0x%x, Flags: %s]\n", pte, pte->entry, flag_str);
+    klog("PTE[VA: 0x%x, Raw: 0x%x, Flags: %s]\n", pte, (uint32_t)pte->entry,
+         flag_str);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -72,14 +76,15 @@ void ptable_print_pde(struct pde * pde) {
     if(TEST_BIT(pde->entry, PDE_GLOBAL))
         strcat(flag_str, "Global, ");
 
-    klog("PDE[VA: 0x%x, Raw: 0x%x, Flags: %s]\n", pde, pde->entry, flag_str);
+    klog("PDE[VA: 0x%x, Raw: 0x%x, Flags: %s]\n", pde, (uint32_t)pde->entry,
+         flag_str);
 }
 
 /* ------------------------------------------------------------------------- */
 
 void ptable_print_pgd(struct pgd * pgd) {
     for(int pde_idx = 0; pde_idx < PAGE_DIR_SIZE; pde_idx++) {
-        struct pde * pde = &pgd->entries[pde_idx];
+        struct pde * pde = PGD_ENTRY(pgd, pde_idx);
         if(!PDE_EXISTS(pde))
             continue;
 
@@ -106,3 +111,118 @@ void ptable_print_pgt(struct pgt * pgt) {
 }
 
 /* ------------------------------------------------------------------------- */
+
+#ifdef KCONF_X86_PAE
+
+/**
+ * ptable_pgd_init() - Prepare a page to be used as a PGD.
+ * @pgd: The virtual address of the page.
+ *
+ * Allocates an empty page directory for each gigabyte of user space, and
+ * points the last PDPT entry at the kernel's page directory, which is shared
+ * rather than copied. The directories stay with the PGD until it is released
+ * with ptable_pgd_fini(), as the CPU only reads the PDPT when CR3 is loaded.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if a directory couldn't be allocated.
+ */
+int32_t ptable_pgd_init(struct pgd * pgd) {
+    int user_dirs = PAGE_DIRECTORY_INDEX(KERNEL_START_VIRT) / PAGE_DIR_ENTRIES;
+
+    for(int i = 0; i < user_dirs; i++) {
+        void * dir = page_alloc_va(0, PR_KERNEL);
+        if(!dir) {
+            while(--i >= 0) {
+                page_free_va(PHY_TO_VIR(PAGE_FRAME(pgd->pdpt[i].entry)), 0);
+            }
+            return E_ERROR;
+        }
+
+        memset(dir, 0, PAGE_SIZE);
+        pgd->pdpt[i] = MAKE_PDPTE(VIR_TO_PHY(dir));
+    }
+
+    for(int i = user_dirs; i < PDPT_SIZE; i++) {
+        pgd->pdpt[i] = paging_kernel_pgd()->pdpt[i];
+    }
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_pgd_fini() - Release the user page directories of a PGD.
+ * @pgd: The virtual address of the PGD, whose user mappings must be clear.
+ */
+void ptable_pgd_fini(struct pgd * pgd) {
+    int user_dirs = PAGE_DIRECTORY_INDEX(KERNEL_START_VIRT) / PAGE_DIR_ENTRIES;
+
+    for(int i = 0; i < user_dirs; i++) {
+        page_free_va(PHY_TO_VIR(PAGE_FRAME(pgd->pdpt[i].entry)), 0);
+        pgd->pdpt[i].entry = 0;
+    }
+}
+
+#else
+
+/* Size of the user half of a PGD, below the kernel's mappings */
+#define PGD_USER_SIZE \
+    (PAGE_DIRECTORY_INDEX(KERNEL_START_VIRT) * sizeof(struct pde))
+
+/**
+ * ptable_pgd_init() - Prepare a page to be used as a PGD.
+ * @pgd: The virtual address of the page.
+ *
+ * Clears the user half and copies the kernel page directory into the kernel
+ * half. The kernel half of the kernel PGD doesn't change after boot, as even
+ * the kmap() page tables are allocated up front, so PGDs prepared in advance
+ * remain valid.
+ *
+ * Return: E_SUCCESS
+ */
+int32_t ptable_pgd_init(struct pgd * pgd) {
+    memset(pgd, 0, PGD_USER_SIZE);
+    memcpy((void*)pgd + PGD_USER_SIZE,
+           (void*)paging_kernel_pgd() + PGD_USER_SIZE,
+           PAGE_SIZE - PGD_USER_SIZE);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_pgd_fini() - Release anything held by a PGD besides its own page.
+ * @pgd: The virtual address of the PGD.
+ *
+ * Without PAE, a PGD is a single page, so there's nothing to release.
+ */
+void ptable_pgd_fini(struct pgd * pgd) {
+}
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_cache_flags() - Select the memory type bits for a page table entry.
+ * @flags: VM_MAP_* flags, of which the VM_MAP_CACHE bits are used.
+ *
+ * Without the PAT, write-combining isn't available, so uncached is used
+ * instead, which is slower but still correct for device memory.
+ *
+ * Return: The PAT, PCD and PWT bits to set in the entry.
+ */
+ptable_entry_t ptable_cache_flags(flags_t flags) {
+    switch(flags & VM_MAP_CACHE) {
+        case VM_MAP_WC:
+            return paging_pat_enabled() ? PTE_CACHE_WC : PTE_CACHE_UC;
+        case VM_MAP_WT:
+            return PTE_CACHE_WT;
+        case VM_MAP_UC:
+            return PTE_CACHE_UC;
+        default:
+            return PTE_CACHE_WB;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
@@ -21,7 +21,7 @@
  *
  * Return: E_SUCCESS on success, E_ERROR on failure.
  */
-int32_t arch_serial_init() {
+int32_t __init arch_serial_init() {
     serial_set_debug_port(IO_PORT_SERIAL_COM2);
     if(!SUCCESS(x86_serial_init_port(IO_PORT_SERIAL_COM1)) ||
        !SUCCESS(x86_serial_init_port(IO_PORT_SERIAL_COM2))) {
@@ -68,7 +68,7 @@ int32_t arch_serial_write_line(uint32_t port, char * line) {
  *
  * Return: E_SUCCESS
  */
-int32_t x86_serial_init_port(uint32_t port) {
+int32_t __init x86_serial_init_port(uint32_t port) {
     // The Interrupt Enable Register is used to enable or disable various
     // serial interrupts.
     // We set the register to zero to disable all interrupts.
@@ -13,9 +13,12 @@
  *
  * Handles syscalls from user-space tasks. Dispatches to the relevant syscall
  * handler depending on the value of the syscall number and other registers.
+ *
+ * Return: The syscall's result, which is left in EAX for the task.
  */
-void syscall_handler(struct syscall_regs * regs) {
+int32_t syscall_handler(struct syscall_regs * regs) {
     struct task * current_task = task_get_current();
+    int32_t rv = E_SUCCESS;
     klog("Syscall from task ('%s' | ID: %d)\n",
             current_task->name,
             current_task->id);
@@ -37,10 +40,16 @@ void syscall_handler(struct syscall_regs * regs) {
         case SYSCALL_WRITE:
             syscall_write(regs->edi, (void*)regs->esi, regs->edx);
             break;
+        case SYSCALL_MADVISE:
+            rv = syscall_madvise((void*)regs->edi, regs->esi, regs->edx);
+            break;
         default:
             klog("Invalid syscall: %d\n", regs->syscall_no);
+            rv = E_ERROR;
             break;
     }
+
+    return rv;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -25,7 +25,7 @@ extern void task_context_switch(struct task * current_task,
  *
  * Return: E_SUCCESS on success, E_ERROR on failure.
  */
-int32_t arch_task_init(struct task * init_task) {
+int32_t __init arch_task_init(struct task * init_task) {
     return E_SUCCESS;
 }
 
@@ -19,7 +19,7 @@ uint64_t ticks = 0;
  *
  * Return: E_SUCCESS
  */
-int32_t timer_init() {
+int32_t __init timer_init() {
     klog("Configuring Programmable Interrupt Timer interval "
            "to 1Hz\n");
     uint32_t divisor = 1193180 / 1;
@@ -56,3 +56,14 @@ int32_t timer_tick() {
 }
 
 /* ------------------------------------------------------------------------- */
+
+/**
+ * timer_get_ticks() - Returns the number of timer ticks since boot.
+ *
+ * Return: The tick count.
+ */
+uint64_t timer_get_ticks() {
+    return ticks;
+}
+
+/* ------------------------------------------------------------------------- */
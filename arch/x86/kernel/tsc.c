@@ -0,0 +1,95 @@
+/*
+ * arch/x86/kernel/tsc.c
+ * x86 Time Stamp Counter
+ *
+ * Provides cycle-accurate timestamps using the TSC, which is first read at
+ * the very start of boot.asm. The TSC frequency is calibrated against channel
+ * 2 of the Programmable Interval Timer, so that cycles can be converted into
+ * wall-clock time.
+ */
+
+#include <arch/tsc.h>
+#include <rotary/core/bootprof.h>
+
+/* Written by boot.asm before paging is enabled, so addressed physically */
+extern uint64_t boot_tsc_start;
+
+uint32_t tsc_khz = 0;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * tsc_calibrate() - Measure the TSC frequency using the PIT.
+ *
+ * Programs PIT channel 2 for a one-shot countdown of TSC_CALIBRATE_MS, with
+ * the speaker disconnected, and counts the TSC cycles that elapse until its
+ * output goes high. The result is cached, so the delay is only incurred once.
+ *
+ * Return: The TSC frequency in kHz, or 0 if the TSC is unavailable.
+ */
+uint32_t tsc_calibrate() {
+    if(tsc_khz || !cpuid_check_tsc()) {
+        return tsc_khz;
+    }
+
+    uint16_t latch = (PIT_FREQUENCY_HZ * TSC_CALIBRATE_MS) / 1000;
+
+    /* Raise the channel 2 gate, and disconnect the speaker */
+    uint8_t gate = io_port_in(IO_PORT_PIT_CHAN_2_GATE);
+    io_port_out(IO_PORT_PIT_CHAN_2_GATE, (gate & ~0x02) | 0x01);
+
+    /* Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count) */
+    io_port_out(IO_PORT_PIT_CMD, 0xB0);
+    io_port_out(IO_PORT_PIT_CHAN_2, latch & 0xFF);
+    io_port_out(IO_PORT_PIT_CHAN_2, latch >> 8);
+
+    /* Output goes high once the count reaches zero */
+    uint64_t start = tsc_read();
+    while(!(io_port_in(IO_PORT_PIT_CHAN_2_GATE) & 0x20)) { }
+    uint64_t end = tsc_read();
+
+    io_port_out(IO_PORT_PIT_CHAN_2_GATE, gate);
+
+    tsc_khz = (uint32_t)udiv64(end - start, TSC_CALIBRATE_MS);
+    klog("TSC calibrated at %d kHz\n", tsc_khz);
+
+    return tsc_khz;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arch_timestamp() - Read the current timestamp in cycles.
+ *
+ * The TSC is read unconditionally, as boot.asm has already relied upon it
+ * before CPUID information is available.
+ *
+ * Return: The current TSC value.
+ */
+uint64_t arch_timestamp() {
+    return tsc_read();
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arch_boot_timestamp() - Retrieve the timestamp taken on entry to boot.asm.
+ *
+ * Return: The TSC value at the earliest point of boot.
+ */
+uint64_t arch_boot_timestamp() {
+    return *(uint64_t*)PHY_TO_VIR(&boot_tsc_start);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arch_timestamp_khz() - Retrieve the frequency of arch_timestamp().
+ *
+ * Return: The frequency in kHz, or 0 if unknown.
+ */
+uint32_t arch_timestamp_khz() {
+    return tsc_calibrate();
+}
+
+/* ------------------------------------------------------------------------- */
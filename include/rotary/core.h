@@ -48,6 +48,14 @@
 
 /* ------------------------------------------------------------------------- */
 
+/* Code and data only needed during boot. The linker collects these into the
+ * .init section, whose pages are handed to the page allocator by
+ * free_initmem() once boot has completed. */
+#define __init     __attribute__((section(".init.text")))
+#define __initdata __attribute__((section(".init.data")))
+
+/* ------------------------------------------------------------------------- */
+
 typedef uint32_t flags_t;
 
 /* ------------------------------------------------------------------------- */
@@ -0,0 +1,40 @@
+/*
+ * include/rotary/core/bootprof.h
+ * Boot Stage Profiler
+ */
+
+#ifndef INC_CORE_BOOTPROF_H
+#define INC_CORE_BOOTPROF_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/options.h>
+#include <rotary/util/math.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define BOOT_STAGE_MAX 32
+
+/* ------------------------------------------------------------------------- */
+
+struct boot_stage {
+    const char * name;
+    uint64_t     start;  /* Timestamp when the stage began */
+    uint64_t     end;    /* Timestamp when the stage ended, 0 if running */
+};
+
+/* ------------------------------------------------------------------------- */
+
+void     boot_stage_begin(const char * name);
+void     boot_stage_end();
+void     boot_timeline_print();
+
+/* ------------------------------------------------------------------------- */
+
+uint64_t arch_timestamp();
+uint64_t arch_boot_timestamp();
+uint32_t arch_timestamp_khz();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
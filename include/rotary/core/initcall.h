@@ -0,0 +1,78 @@
+/*
+ * include/rotary/core/initcall.h
+ * Initcalls
+ */
+
+#ifndef INC_CORE_INITCALL_H
+#define INC_CORE_INITCALL_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Levels, run in ascending order */
+#define INITCALL_EARLY      0
+#define INITCALL_CORE       1
+#define INITCALL_ARCH       2
+#define INITCALL_SUBSYS     3
+#define INITCALL_FS         4
+#define INITCALL_DEVICE     5
+#define INITCALL_LATE       6
+#define INITCALL_LEVEL_MAX  INITCALL_LATE
+
+/* Flags */
+#define INITCALL_ASYNC      0x01 /* Run in a kernel task after task_init() */
+
+/* ------------------------------------------------------------------------- */
+
+typedef int32_t (*initcall_fn_t)(void);
+
+struct initcall {
+    const char *  name;
+    initcall_fn_t fn;
+    uint32_t      level;
+    flags_t       flags;
+};
+
+/* ------------------------------------------------------------------------- */
+
+/* As with KTEST_MODULE_DEFINE(), initcalls are placed in their own section
+ * (.initcall) so that they can be collected at boot without a central
+ * registry, and run at the appropriate level by initcall_run_level(). */
+#define INITCALL_DEFINE(func, lvl, flg) \
+    static __attribute__((used)) \
+    __attribute__((section(".initcall"))) \
+    struct initcall TP(initcall, __COUNTER__) = \
+    { \
+        .name  = #func, \
+        .fn    = (func), \
+        .level = (lvl), \
+        .flags = (flg) \
+    }
+
+#define early_initcall(fn)        INITCALL_DEFINE(fn, INITCALL_EARLY, 0)
+#define core_initcall(fn)         INITCALL_DEFINE(fn, INITCALL_CORE, 0)
+#define arch_initcall(fn)         INITCALL_DEFINE(fn, INITCALL_ARCH, 0)
+#define subsys_initcall(fn)       INITCALL_DEFINE(fn, INITCALL_SUBSYS, 0)
+#define fs_initcall(fn)           INITCALL_DEFINE(fn, INITCALL_FS, 0)
+#define device_initcall(fn)       INITCALL_DEFINE(fn, INITCALL_DEVICE, 0)
+#define late_initcall(fn)         INITCALL_DEFINE(fn, INITCALL_LATE, 0)
+
+#define fs_initcall_async(fn)     INITCALL_DEFINE(fn, INITCALL_FS, \
+                                                  INITCALL_ASYNC)
+#define device_initcall_async(fn) INITCALL_DEFINE(fn, INITCALL_DEVICE, \
+                                                  INITCALL_ASYNC)
+#define late_initcall_async(fn)   INITCALL_DEFINE(fn, INITCALL_LATE, \
+                                                  INITCALL_ASYNC)
+
+/* ------------------------------------------------------------------------- */
+
+int32_t initcall_run_level(uint32_t level);
+int32_t initcall_start_async();
+void    initcall_boot_complete();
+void    initcall_print_debug();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -8,6 +8,15 @@
 #include <rotary/sched/task.h>
 #include <rotary/mm/ptable.h>
 #include <rotary/mm/palloc.h>
+#include <rotary/mm/slab.h>
+#include <rotary/mm/ioremap.h>
+#include <rotary/mm/wss.h>
+#include <rotary/mm/reclaim.h>
+#include <rotary/drivers/block/ramdisk.h>
+#include <rotary/fs/pseudo/tree.h>
+#include <rotary/fs/initrd/initrd.h>
+#include <rotary/core/bootprof.h>
+#include <rotary/core/initcall.h>
 
 #include <arch/vga.h>
 
@@ -18,5 +27,6 @@ void shell_keyboard_handler(uint8_t key);
 void shell_print_prompt();
 void shell_register_handler(char * command, void * handler);
 void shell_process_command(char * command);
+void shell_print_buffer(char * buf);
 
 /* ========================================================================= */
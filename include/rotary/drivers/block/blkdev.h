@@ -0,0 +1,47 @@
+/*
+ * include/rotary/drivers/block/blkdev.h
+ * Block Devices
+ */
+
+#ifndef INC_DRIVERS_BLOCK_BLKDEV_H
+#define INC_DRIVERS_BLOCK_BLKDEV_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define BLKDEV_SECTOR_SIZE  512
+#define BLKDEV_SECTOR_SHIFT 9
+#define BLKDEV_NAME_MAX     16
+
+/* ------------------------------------------------------------------------- */
+
+struct block_device;
+
+/* Transfers whole sectors between the device and a kernel buffer. Requests
+ * are bounds checked by blkdev_read() and blkdev_write() beforehand */
+struct block_ops {
+    int32_t (*read) (struct block_device * dev, uint32_t sector,
+                     uint32_t count, void * buf);
+    int32_t (*write) (struct block_device * dev, uint32_t sector,
+                      uint32_t count, void * buf);
+};
+
+struct block_device {
+    char               name[BLKDEV_NAME_MAX];
+    uint32_t           sector_count;
+    struct block_ops * ops;
+    void *             private; /* The driver's own state */
+};
+
+/* ------------------------------------------------------------------------- */
+
+int32_t blkdev_read(struct block_device * dev, uint32_t sector,
+                    uint32_t count, void * buf);
+int32_t blkdev_write(struct block_device * dev, uint32_t sector,
+                     uint32_t count, void * buf);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * include/rotary/drivers/block/ramdisk.h
+ * RAM Disk
+ */
+
+#ifndef INC_DRIVERS_BLOCK_RAMDISK_H
+#define INC_DRIVERS_BLOCK_RAMDISK_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/string.h>
+#include <rotary/drivers/block/blkdev.h>
+#include <rotary/mm/kmalloc.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/highmem.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define RAMDISK_SECTORS_PER_PAGE (PAGE_SIZE / BLKDEV_SECTOR_SIZE)
+
+/* ------------------------------------------------------------------------- */
+
+struct ramdisk {
+    struct block_device dev;
+    struct page **      pages;
+    uint32_t            page_count;
+};
+
+/* ------------------------------------------------------------------------- */
+
+struct block_device * ramdisk_create(const char * name, uint32_t page_count);
+void ramdisk_destroy(struct block_device * dev);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -6,6 +6,7 @@
 #define INC_DRIVERS_KEYBOARD_H
 
 #include <rotary/core.h>
+#include <rotary/core/initcall.h>
 #include <arch/keyboard.h>
 
 /* ------------------------------------------------------------------------- */
@@ -9,6 +9,7 @@
 #include <rotary/core.h>
 #include <rotary/list.h>
 #include <rotary/mm/kmalloc.h>
+#include <rotary/core/initcall.h>
 #include <rotary/logging.h>
 #include <rotary/debug.h>
 
@@ -0,0 +1,77 @@
+/*
+ * include/rotary/fs/initrd/initrd.h
+ * Initial RAM Disk
+ */
+
+#ifndef INC_FS_INITRD_INITRD_H
+#define INC_FS_INITRD_INITRD_H
+
+#include <rotary/core.h>
+#include <rotary/list.h>
+#include <rotary/logging.h>
+#include <rotary/string.h>
+#include <rotary/mm/kmalloc.h>
+#include <rotary/mm/bootmem.h>
+#include <rotary/fs/vfs/fs_type.h>
+#include <rotary/fs/vfs/inode.h>
+#include <rotary/fs/vfs/super.h>
+#include <rotary/core/initcall.h>
+#include <arch/paging.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define INITRD_MODULES_MAX  4
+#define INITRD_CMDLINE_MAX  64
+#define INITRD_PATH_MAX     128
+
+/* cpio "newc" format, as produced by `cpio -o -H newc` */
+#define CPIO_NEWC_MAGIC     "070701"
+#define CPIO_NEWC_HDR_SIZE  110
+#define CPIO_TRAILER        "TRAILER!!!"
+
+/* File types, as stored in the mode field of the cpio header */
+#define INITRD_MODE_TYPE    0170000
+#define INITRD_MODE_DIR     0040000
+#define INITRD_MODE_FILE    0100000
+
+#define INITRD_IS_DIR(mode) (((mode) & INITRD_MODE_TYPE) == INITRD_MODE_DIR)
+
+/* ------------------------------------------------------------------------- */
+
+/* A boot module handed over by the bootloader, in physical memory */
+struct initrd_module {
+    uintptr_t start_addr;
+    uintptr_t end_addr;
+    char      cmdline[INITRD_CMDLINE_MAX];
+};
+
+/* A file within an archive. Both the name and the contents are referenced in
+ * place within the module, rather than being copied */
+struct initrd_file {
+    const char * name;      /* Path relative to the archive root */
+    uint32_t     mode;
+    uint32_t     size;
+    const void * data;
+    list_node_t  list_node;
+};
+
+/* ------------------------------------------------------------------------- */
+
+int32_t initrd_add_module(uintptr_t start_addr, uintptr_t end_addr,
+        const char * cmdline);
+
+int32_t initrd_unpack(list_head_t * files, const void * archive,
+        uint32_t size);
+void    initrd_free_files(list_head_t * files);
+struct initrd_file * initrd_find(list_head_t * files, const char * path);
+
+struct initrd_file * initrd_lookup(const char * path);
+int32_t initrd_read(struct initrd_file * file, void * buf, uint32_t offset,
+        uint32_t size);
+
+int32_t initrd_init();
+void    initrd_print_debug();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -1,5 +1,6 @@
 /*
  * include/rotary/fs/pseudo/tree.h
+ * Pseudo File Tree
  */
 
 #ifndef INC_FS_PSEUDO_TREE_H
@@ -7,28 +8,56 @@
 
 #include <rotary/core.h>
 #include <rotary/list.h>
+#include <rotary/logging.h>
+#include <rotary/string.h>
+#include <rotary/sync.h>
 
 /* ------------------------------------------------------------------------- */
 
 #define PSEUDO_FILE 0x01
 #define PSEUDO_DIR  0x02
 
+#define PSEUDO_PATH_MAX 64
+
 /* ------------------------------------------------------------------------- */
 
+/* Generates the contents of a pseudo file into buf, returning the length */
+typedef int32_t (*pseudo_show_t)(char * buf, uint32_t size);
+
 struct pseudo_node {
-    char * name;
-    flags_t mode;
-    list_head_t children;
+    char *               name;
+    flags_t              mode;
+    list_head_t          children;  /* Child nodes, if a directory */
+    list_node_t          sibling;   /* Entry in the parent's children list */
+    struct pseudo_node * parent;
+    pseudo_show_t        show;      /* Content generator, if a file */
 };
 
 /* ------------------------------------------------------------------------- */
 
-/*
-static inline void pseudo_register_child(struct pseudo_node parent,
-                                         struct pseudo_node child) {
-    llist_
-}
-*/
+#define PSEUDO_FILE_INIT(n, fn) \
+    {                           \
+        .name = (n),            \
+        .mode = PSEUDO_FILE,    \
+        .show = (fn)            \
+    }
+
+#define PSEUDO_DIR_INIT(node, n)                       \
+    {                                                  \
+        .name     = (n),                               \
+        .mode     = PSEUDO_DIR,                        \
+        .children = INIT_LIST_HEAD((node).children)    \
+    }
+
+/* ------------------------------------------------------------------------- */
+
+int32_t pseudo_register(struct pseudo_node * parent, struct pseudo_node * node);
+void    pseudo_unregister(struct pseudo_node * node);
+
+struct pseudo_node * pseudo_lookup(const char * path);
+int32_t pseudo_read(const char * path, char * buf, uint32_t size);
+
+void    pseudo_print_debug();
 
 /* ------------------------------------------------------------------------- */
 
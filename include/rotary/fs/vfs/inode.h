@@ -36,10 +36,14 @@ struct inode {
     uint32_t mode; /* File type - regular, directory, symlink, etc. */
     struct inode_ops * ops;
     struct super_block * sb;
+    uint32_t size;     /* Size of the file's contents in bytes */
+    void * private;    /* Filesystem specific data */
 };
 
 struct inode_ops {
     int (*lookup) (struct inode * dir_node, const char * name, size_t len, struct inode * result);
+    /* Returns the number of bytes read, which is short at the end of file */
+    int (*read) (struct inode * node, void * buf, uint32_t offset, uint32_t size);
 };
 
 /* ------------------------------------------------------------------------- */
@@ -12,6 +12,7 @@
 #include <rotary/fs/vfs/super.h>
 #include <rotary/fs/vfs/inode.h>
 #include <rotary/fs/vfs/fs_type.h>
+#include <rotary/core/initcall.h>
 
 /* TODO: Remove when initial implementation done */
 #include <rotary/fs/testfs/super.h>
@@ -25,6 +26,7 @@ extern struct inode * root_inode;
 
 void mount_root(int device, char * fs_type_name);
 void mount_root_testing(); /* TODO: remove when block implementation done */
+int32_t mount_root_init();
 
 /* ------------------------------------------------------------------------- */
 
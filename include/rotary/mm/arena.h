@@ -0,0 +1,79 @@
+/*
+ * include/rotary/mm/arena.h
+ * Arena (Region) Allocator
+ */
+
+#ifndef INC_MM_ARENA_H
+#define INC_MM_ARENA_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/string.h>
+#include <rotary/mm/palloc.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define ARENA_DEFAULT_ORDER 0
+#define ARENA_ALIGN         8
+
+#define ARENA_ALIGN_UP(x) (((x) + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1))
+
+/* ------------------------------------------------------------------------- */
+
+/* Chunk: a block of pages from page_alloc() that objects are carved out of */
+struct arena_chunk {
+    struct arena_chunk * next;  /* Next (older) chunk in the arena */
+    uint32_t             order; /* Order of the phys. pages allocated */
+};
+
+/* Arena: stored within its own first chunk, immediately after the header */
+struct arena {
+    uintptr_t            cursor;      /* Next free byte in the current chunk */
+    uintptr_t            limit;       /* End of the current chunk */
+    struct arena_chunk * chunks;      /* Most recently added chunk first */
+    uint32_t             order;       /* Order of regular chunks */
+    uint32_t             chunk_count; /* Chunks currently held */
+    uint32_t             bytes_used;  /* Bytes handed out since last reset */
+};
+
+/* ------------------------------------------------------------------------- */
+
+struct arena * arena_create(uint32_t order);
+void           arena_destroy(struct arena * arena);
+void           arena_reset(struct arena * arena);
+
+void *         arena_alloc_slow(struct arena * arena, uint32_t size);
+void *         arena_alloc_zero(struct arena * arena, uint32_t size);
+
+void           arena_print_debug(struct arena * arena);
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_alloc() - Allocate memory from an arena.
+ * @arena: The arena to allocate from.
+ * @size:  The amount of bytes to allocate.
+ *
+ * Bumps the arena's cursor if the current chunk has space, otherwise falls
+ * back to arena_alloc_slow() to add a new chunk. Memory cannot be freed
+ * individually, only in bulk with arena_reset() or arena_destroy().
+ *
+ * Return: A pointer to the allocation, or NULL on failure.
+ */
+static inline void * arena_alloc(struct arena * arena, uint32_t size) {
+    uint32_t aligned = ARENA_ALIGN_UP(size);
+
+    /* Sizes that wrap when aligned are refused by the slow path */
+    if(aligned >= size && aligned <= arena->limit - arena->cursor) {
+        void * ptr = (void*)arena->cursor;
+        arena->cursor     += aligned;
+        arena->bytes_used += aligned;
+        return ptr;
+    }
+
+    return arena_alloc_slow(arena, size);
+}
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -18,20 +18,52 @@
 
 /* ------------------------------------------------------------------------- */
 
-#define MAX_MEM_REGIONS 16
+/* Initial capacity of the region arrays, which double when full */
+#define BOOTMEM_INIT_REGIONS 32
 
 #define MEM_REGION_RESERVED  0
 #define MEM_REGION_AVAILABLE 1
 
 #define BM_NO_ALIGN 1
 
+/* Ranges of memory which can only be described by page frame number */
+#define BOOTMEM_PFN_RANGES   8
+
+/* Default allocation limits. Allocations are placed as high as possible
+ * below the upper limit, keeping low memory free for legacy DMA. Until the
+ * kernel page tables are loaded, only the first 4MB of memory is mapped */
+#define BOOTMEM_LIMIT_LOW    0x100000
+#define BOOTMEM_LIMIT_EARLY  0x400000
+
+/* Region flags, regions are only merged if their flags match */
+#define MEM_REGION_F_NONE     0x00
+#define MEM_REGION_F_TEMP     0x01 /* Released by bootmem_release_temp() */
+#define MEM_REGION_F_FIRMWARE 0x02 /* Reported reserved by the firmware */
+
 /* ------------------------------------------------------------------------- */
 
+/* A range of physical memory, from start_addr up to (not incl.) end_addr */
 struct mem_region {
     uintptr_t start_addr;
     uintptr_t end_addr;
-    uintptr_t orig_start_addr;
-    uint32_t  type;
+    flags_t   flags;
+};
+
+/* A sorted array of non-overlapping regions, grown on demand */
+struct mem_region_list {
+    const char *        name;
+    struct mem_region * regions;
+    uint32_t            count;
+    uint32_t            max;
+    uint32_t            dynamic; /* Array was allocated from bootmem */
+};
+
+/* A range of available page frames, from start_pfn up to (not incl.) end_pfn.
+ * Used for memory above 4GB, which a mem_region can't address. It's only
+ * ever handed to the page allocator, never allocated from by bootmem */
+struct pfn_range {
+    uint32_t start_pfn;
+    uint32_t end_pfn;
 };
 
 /* ------------------------------------------------------------------------- */
@@ -39,7 +71,12 @@ struct mem_region {
 int32_t  bootmem_mark_free();
 int32_t  bootmem_add_mem_region(uintptr_t start_addr, uintptr_t end_addr,
          uint32_t type);
+int32_t  bootmem_add_pfn_range(uint32_t start_pfn, uint32_t end_pfn);
+int32_t  bootmem_reserve(uintptr_t start_addr, uintptr_t end_addr);
+void     bootmem_set_limits(uintptr_t low, uintptr_t high);
 void *   bootmem_alloc(size_t size, size_t alignment);
+void *   bootmem_alloc_temp(size_t size);
+uint32_t bootmem_release_temp();
 void     bootmem_reset();
 uint32_t bootmem_highest_pfn();
 void     bootmem_print_debug();
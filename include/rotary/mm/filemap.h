@@ -0,0 +1,24 @@
+/*
+ * include/rotary/mm/filemap.h
+ * File-backed Mappings
+ */
+
+#ifndef INC_MM_FILEMAP_H
+#define INC_MM_FILEMAP_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/mm/highmem.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/ptable.h>
+#include <rotary/mm/vm.h>
+#include <rotary/fs/vfs/inode.h>
+
+/* ------------------------------------------------------------------------- */
+
+int32_t filemap_read_page(struct vm_map * map, struct page * page,
+                          void * virt_addr);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
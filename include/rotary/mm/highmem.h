@@ -0,0 +1,58 @@
+/*
+ * include/rotary/mm/highmem.h
+ * Highmem Temporary Mappings
+ */
+
+#ifndef INC_MM_HIGHMEM_H
+#define INC_MM_HIGHMEM_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/sync.h>
+#include <rotary/mm/palloc.h>
+#include <arch/cpu.h>
+#include <arch/paging.h>
+#include <arch/ptable.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* The kmap() area is split between slots for kmap(), which may be held for
+ * any length of time, followed by a small group of kmap_atomic() slots for
+ * each CPU, used as a stack */
+#define KMAP_SLOTS          1024
+#define KMAP_ATOMIC_DEPTH   8
+#define KMAP_ATOMIC_CPUS    8
+
+#define KMAP_SLOTS_START    KMAP_START_VIRT
+#define KMAP_ATOMIC_START   (KMAP_SLOTS_START + KMAP_SLOTS * PAGE_SIZE)
+
+#define KMAP_SLOT_ADDR(idx) ((void*)(KMAP_SLOTS_START + (idx) * PAGE_SIZE))
+#define KMAP_ATOMIC_ADDR(cpu, depth) ((void*)(KMAP_ATOMIC_START + \
+    ((cpu) * KMAP_ATOMIC_DEPTH + (depth)) * PAGE_SIZE))
+
+#define PAGE_IS_HIGHMEM(page) (((page)->flags & PF_ZONE_HIGHMEM) != 0)
+
+/* ------------------------------------------------------------------------- */
+
+/* A kmap() slot. A slot whose count has dropped to zero keeps its mapping,
+ * so mapping the same page again doesn't need the TLB to be invalidated */
+struct kmap_slot {
+    struct page * page;
+    uint32_t      count;
+};
+
+/* ------------------------------------------------------------------------- */
+
+void *  kmap(struct page * page);
+void    kunmap(struct page * page);
+void *  kmap_atomic(struct page * page);
+void    kunmap_atomic(void * virt_addr);
+
+void    highmem_zero_page(struct page * page);
+void    highmem_copy_page(struct page * dest, struct page * src);
+
+void    highmem_print_debug();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ * include/rotary/mm/initmem.h
+ * Boot-only Memory Release
+ */
+
+#ifndef INC_MM_INITMEM_H
+#define INC_MM_INITMEM_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/options.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/bootmem.h>
+#include <rotary/test/ktest.h>
+#include <arch/paging.h>
+
+/* ------------------------------------------------------------------------- */
+
+uint32_t free_initmem();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
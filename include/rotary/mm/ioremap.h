@@ -0,0 +1,35 @@
+/*
+ * include/rotary/mm/ioremap.h
+ * Device Memory Mappings
+ */
+
+#ifndef INC_MM_IOREMAP_H
+#define INC_MM_IOREMAP_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/sync.h>
+#include <rotary/mm/vm.h>
+#include <rotary/mm/ptable.h>
+#include <arch/paging.h>
+#include <arch/ptable.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Device memory is mapped into the upper half of the kmap() area, well clear
+ * of the kmap() and kmap_atomic() slots at its start */
+#define IOREMAP_START       (KMAP_START_VIRT + 0x08000000)
+#define IOREMAP_PAGES       4096
+
+#define IOREMAP_ADDR(idx)   ((void*)(IOREMAP_START + (idx) * PAGE_SIZE))
+#define IOREMAP_IDX(addr)   (((uintptr_t)(addr) - IOREMAP_START) / PAGE_SIZE)
+
+/* ------------------------------------------------------------------------- */
+
+void *  ioremap(uintptr_t phys_addr, uint32_t size, flags_t flags);
+void    iounmap(void * virt_addr);
+void    ioremap_print_debug();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -9,9 +9,11 @@
 #include <rotary/logging.h>
 #include <rotary/list.h>
 #include <rotary/mm/slab.h>
+#include <rotary/core/initcall.h>
 
 /* ------------------------------------------------------------------------- */
 
+int32_t kmalloc_init();
 void *  kmalloc(uint32_t size);
 int32_t kfree(void * addr);
 void    kmalloc_print_debug();
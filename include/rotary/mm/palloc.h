@@ -19,15 +19,20 @@
 #define ORDER_USED    -1
 #define ORDER_DEFAULT 0
 #define ORDER_MIN     0
-#define ORDER_MAX     6
+#define ORDER_MAX     10 /* Large enough for a 4MB huge page */
 
-#define PR_KERNEL 1
+/* page_alloc() flags */
+#define PR_KERNEL  0x01
+#define PR_HIGHMEM 0x02 /* May return highmem, which isn't directly mapped */
 
 /* page->flags values */
 #define PF_INVALID        0x01 // If set, page cannot be used.
 #define PF_ZONE_LOWMEM    0x02 // Page is directly mapped in kernel virt. mem.
 #define PF_ZONE_HIGHMEM   0x04
 #define PF_KERNEL         0x08 // Page contains fixed kernel code or structs
+#define PF_DIRTY          0x10 // Written to, as harvested from PTE dirty bits
+#define PF_LRU            0x20 // On an LRU list, so may be reclaimed
+#define PF_ACTIVE         0x40 // On the active LRU list, not the inactive
 
 /* Page presence */
 #define PAGE_NOT_PRESENT 0
@@ -62,19 +67,28 @@
 
 /* ------------------------------------------------------------------------- */
 
-/* Represents a physical page */
+struct rmap;
+
+/* Represents a physical page. buddy_node is only used by the buddy allocator
+ * while the page is free, so links a page in use onto an LRU list instead */
 struct page {
     uint32_t    pfn;
     uint32_t    use_count;
     uint32_t    flags;
     int32_t     order;
     list_node_t buddy_node;
+    uint32_t    last_access; /* wss_generation when last seen accessed */
+    struct rmap * rmap;      /* The page table entries mapping it */
 };
 
-/* Manages free pages for a given order */
+/* Manages free pages for a given order. Highmem blocks are kept on a list
+ * of their own, so that allocations needing directly mapped memory never
+ * have to search past them */
 struct block_list {
     list_node_t free_pages;
-    uint32_t    free_count;
+    list_node_t free_high;
+    uint32_t    free_count;  /* Including highmem blocks */
+    uint32_t    high_count;
     uint32_t    used_count;
 };
 
@@ -84,6 +98,7 @@ struct buddy_allocator {
     uint32_t page_count;
     struct block_list * blocks;
     uint32_t max_order;
+    uint32_t free_pages; /* Across every order, including highmem */
     volatile atomic_flag lock;
 };
 
@@ -91,12 +106,18 @@ struct buddy_allocator {
 
 struct page * page_alloc(uint32_t order, uint32_t flags);
 struct page * page_from_pfn(uint32_t pfn);
+int32_t       page_pfn_is_ram(uint32_t pfn);
 struct page * page_get_last(struct buddy_allocator * allocator,
-                            uint32_t order);
+                            uint32_t order, uint32_t zone);
 struct page * buddy_get(struct page * page, uint32_t order);
 
 int32_t page_free(struct page * current_page, int order);
+void    page_split(struct page * page, int order);
 void    page_initial_free(struct page * page);
+uint32_t page_release_range(uintptr_t start_addr, uintptr_t end_addr);
+
+uint32_t page_free_count();
+uint32_t page_total_count();
 
 int32_t  page_is_critical(struct page * page);
 void *   page_area_end();
@@ -104,7 +125,9 @@ void *   page_area_end();
 void     page_print_debug(struct page * page);
 
 int32_t  buddy_init(uint32_t highest_pfn);
-int32_t  buddy_split_block(uint32_t order);
+int32_t  buddy_split_block(uint32_t order, uint32_t zone);
+uint32_t buddy_free_count(uint32_t order, uint32_t zone);
+struct page * buddy_take_block(uint32_t order, uint32_t zone);
 int32_t  buddy_merge_block(struct page * block_page, uint32_t order);
 void     buddy_remove_block(struct page * block_page);
 void     buddy_add_block(struct page * block_page, uint32_t order);
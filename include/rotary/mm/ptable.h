@@ -9,28 +9,110 @@
 #include <rotary/core.h>
 #include <rotary/mm/palloc.h>
 #include <rotary/mm/vm.h>
+#include <rotary/mm/tlb.h>
+#include <rotary/mm/highmem.h>
+#include <rotary/mm/quicklist.h>
+#include <rotary/mm/rmap.h>
+#include <rotary/mm/swap.h>
+#include <rotary/core/initcall.h>
+#include <arch/cpu.h>
 #include <arch/paging.h>
 #include <arch/ptable.h>
 
 /* ------------------------------------------------------------------------- */
 
+struct pgd;
+struct pgt;
+struct pde;
+struct pte;
+struct page;
+struct tlb_gather;
+struct ptable_walk;
+
+/* ------------------------------------------------------------------------- */
+
 #define PTC_SHARE 0x01
 #define PTC_COPY  0x02
 #define PTC_COW   0x04
 
+/* Page table walk flags */
+#define PTW_ALLOC 0x01 /* Allocate page tables missing from the range */
+#define PTW_EMPTY 0x02 /* Visit entries that aren't present */
+
+/* Quicklist watermarks, in pages */
+#define PTABLE_QL_PGD_LOW  2
+#define PTABLE_QL_PGD_HIGH 8
+#define PTABLE_QL_PGT_LOW  4
+#define PTABLE_QL_PGT_HIGH 16
+
 /* ------------------------------------------------------------------------- */
 
+/* Called for each entry visited by ptable_walk_range() */
+typedef int32_t (*ptable_pte_fn_t)(struct ptable_walk * walk,
+                                   struct pte * pte, void * virt_addr);
+
+/* Called after each page table has been walked */
+typedef void (*ptable_pgt_fn_t)(struct ptable_walk * walk, struct pde * pde,
+                                void * table_addr);
+
+/* Called for each huge page lying entirely within the walked range */
+typedef int32_t (*ptable_huge_fn_t)(struct ptable_walk * walk,
+                                    struct pde * pde, void * virt_addr);
+
+/* Fills a page allocated by ptable_populate_fill() before it is mapped */
+typedef int32_t (*ptable_fill_fn_t)(struct page * page, void * virt_addr,
+                                    void * private);
+
+struct ptable_walk {
+    struct pgd *        pgd;
+    flags_t             flags;    /* PTW_* */
+    ptable_pte_fn_t     pte_fn;
+    ptable_pgt_fn_t     pgt_fn;   /* Optional */
+    struct tlb_gather * tlb;      /* Optional, for callbacks to gather into */
+    void *              private;  /* Data for the callbacks */
+    struct pgt *        pgt;      /* The table currently being walked */
+    ptable_huge_fn_t    huge_fn;  /* Optional, otherwise huge pages are split */
+};
+
+/* ------------------------------------------------------------------------- */
+
+int32_t ptable_quicklist_init();
+void    ptable_quicklist_refill();
+void    ptable_quicklist_print_debug();
+
 struct pgd * ptable_pgd_new();
 void    ptable_pgd_free(struct pgd * pgd);
 void    ptable_map(struct pgd * pgd, void * virt_addr, void * phys_addr,
                    flags_t flags);
+void    ptable_map_page(struct pgd * pgd, void * virt_addr,
+                        struct page * page, flags_t flags);
+int32_t ptable_map_huge(struct pgd * pgd, void * virt_addr,
+                        struct page * block, flags_t flags);
+int32_t ptable_split_huge(struct pgd * pgd, void * virt_addr);
 void    ptable_map_many(struct pgd * pgd, void * virt_addr, void * phys_addr,
                         int count, flags_t flags);
+int32_t ptable_populate_range(struct pgd * pgd, void * start_addr,
+                              void * end_addr, flags_t flags);
+int32_t ptable_populate_cow(struct pgd * pgd, void * start_addr,
+                            void * end_addr, struct page * page,
+                            flags_t flags);
+int32_t ptable_populate_fill(struct pgd * pgd, void * start_addr,
+                             void * end_addr, flags_t flags,
+                             ptable_fill_fn_t fill, void * private);
 void    ptable_unmap(struct pgd * pgd, void * virt_addr, int free);
 void    ptable_unmap_many(struct pgd * pgd, void * virt_addr, int count,
                           int free);
-void    ptable_copy_range(struct pgd * source_pgd, struct pgd * dest_pgd,
+void    ptable_unmap_range(struct tlb_gather * tlb, void * virt_addr,
+                           uint32_t count, int free);
+int32_t ptable_copy_range(struct pgd * source_pgd, struct pgd * dest_pgd,
                           void * start_addr, void * end_addr, flags_t flags);
+int32_t ptable_cow_fault(struct pgd * pgd, void * virt_addr);
+void    ptable_protect_range(struct pgd * pgd, void * virt_addr, int count,
+                             flags_t flags);
+uint32_t ptable_scan_accessed(struct pgd * pgd, void * virt_addr, int count,
+                              int clear);
+int32_t ptable_walk_range(struct ptable_walk * walk, void * start_addr,
+                          void * end_addr);
 int     ptable_pgt_is_clear(struct pgt * pgt);
 struct pte * ptable_get_pte(struct pgd * pgd, void *virt_addr);
 
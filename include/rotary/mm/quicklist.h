@@ -0,0 +1,56 @@
+/*
+ * include/rotary/mm/quicklist.h
+ * Page Quicklists
+ */
+
+#ifndef INC_MM_QUICKLIST_H
+#define INC_MM_QUICKLIST_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/sync.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Per-CPU quicklists */
+#define QUICKLIST_PGD   0 /* PGDs with the kernel half populated */
+#define QUICKLIST_PGT   1 /* Zeroed page tables */
+#define QUICKLIST_COUNT 2
+
+/* ------------------------------------------------------------------------- */
+
+/* Prepares a newly allocated page for the quicklist, returning E_ERROR if it
+ * can't be prepared, in which case the page is freed again */
+typedef int32_t (*quicklist_ctor_t)(void * page);
+
+/* Releases anything the constructor set up, before the page is freed */
+typedef void (*quicklist_dtor_t)(void * page);
+
+/* A cache of pages already in the state their user needs, linked through
+ * their first word, which is cleared again when the page is handed out */
+struct quicklist {
+    const char *     name;
+    void *           head;
+    uint32_t         count;
+    uint32_t         low;   /* Refilled when it drops below this */
+    uint32_t         high;  /* Refilled up to, and never holds more */
+    quicklist_ctor_t ctor;
+    quicklist_dtor_t dtor;  /* Optional */
+    atomic_flag      lock;
+    uint32_t         hits;
+    uint32_t         misses;
+};
+
+/* ------------------------------------------------------------------------- */
+
+void     quicklist_init(struct quicklist * ql, const char * name, uint32_t low,
+         uint32_t high, quicklist_ctor_t ctor, quicklist_dtor_t dtor);
+void *   quicklist_alloc(struct quicklist * ql);
+void     quicklist_free(struct quicklist * ql, void * page);
+uint32_t quicklist_refill(struct quicklist * ql);
+uint32_t quicklist_drain(struct quicklist * ql);
+void     quicklist_print_debug(struct quicklist * ql);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * include/rotary/mm/reclaim.h
+ * Page Reclaim
+ */
+
+#ifndef INC_MM_RECLAIM_H
+#define INC_MM_RECLAIM_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/list.h>
+#include <rotary/sync.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/rmap.h>
+#include <rotary/mm/swap.h>
+#include <rotary/mm/wss.h>
+#include <rotary/sched/task.h>
+#include <rotary/core/initcall.h>
+#include <arch/cpu.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Pages freed by each pass of reclaim_pages() from the reclaim task, and by
+ * each direct reclaim */
+#define RECLAIM_BATCH 32
+
+/* Inactive pages scanned per page asked for, before a pass gives up */
+#define RECLAIM_SCAN_RATIO 4
+
+/* ------------------------------------------------------------------------- */
+
+/* A list of pages, most recently added at the head */
+struct lru_list {
+    list_head_t head;
+    uint32_t    count;
+};
+
+struct reclaim_stats {
+    uint32_t wakeups;     /* Times the reclaim task was woken */
+    uint32_t direct;      /* Reclaims by a fault, with memory almost gone */
+    uint32_t scanned;     /* Inactive pages considered */
+    uint32_t activated;   /* Inactive pages found referenced */
+    uint32_t deactivated; /* Active pages moved to the inactive list */
+    uint32_t reclaimed;   /* Pages freed */
+};
+
+/* ------------------------------------------------------------------------- */
+
+/* Free page watermarks. Below low, the reclaim task is woken, and frees
+ * pages until there are high free. Below min, faults reclaim directly */
+extern uint32_t reclaim_wmark_min;
+extern uint32_t reclaim_wmark_low;
+extern uint32_t reclaim_wmark_high;
+
+/* ------------------------------------------------------------------------- */
+
+int32_t  reclaim_init();
+
+void     lru_add(struct page * page);
+void     lru_del(struct page * page);
+
+uint32_t reclaim_pages(uint32_t target);
+void     reclaim_wake();
+void     reclaim_direct();
+void     reclaim_print_debug();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * include/rotary/mm/rmap.h
+ * Reverse Mapping
+ */
+
+#ifndef INC_MM_RMAP_H
+#define INC_MM_RMAP_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/sync.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/ptable.h>
+#include <rotary/mm/slab.h>
+#include <rotary/mm/vm.h>
+#include <rotary/mm/reclaim.h>
+#include <arch/cpu.h>
+#include <arch/paging.h>
+#include <arch/ptable.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Whether pages mapped with a mapping's VM_MAP_* flags are tracked, and so
+ * may be reclaimed. Shared memory must stay the same page in every address
+ * space, and reserved memory must never be swapped out */
+#define RMAP_TRACKED(flags) \
+    (!TEST_BIT((flags), VM_MAP_SHARED | VM_MAP_RESERVED | VM_MAP_IO))
+
+/* ------------------------------------------------------------------------- */
+
+struct pgd;
+struct pte;
+struct page;
+
+/* One page table entry mapping a page, on a chain from page->rmap */
+struct rmap {
+    struct pgd *  pgd;
+    void *        addr;
+    struct rmap * next;
+};
+
+/* Called by rmap_walk() for each entry mapping a page. Returns a positive
+ * value if it changed the entry, which is then invalidated in the TLB, or
+ * an error to stop the walk */
+typedef int32_t (*rmap_fn_t)(struct page * page, struct pte * pte,
+                             void * virt_addr, void * private);
+
+/* ------------------------------------------------------------------------- */
+
+int32_t  rmap_init();
+
+void     rmap_add_new(struct page * page, struct pgd * pgd, void * virt_addr);
+void     rmap_add(struct page * page, struct pgd * pgd, void * virt_addr);
+void     rmap_remove(struct page * page, struct pgd * pgd, void * virt_addr);
+void     rmap_clear(struct page * page);
+uint32_t rmap_count(struct page * page);
+int32_t  rmap_walk(struct page * page, rmap_fn_t fn, void * private);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -10,10 +10,19 @@
 #include <rotary/logging.h>
 #include <rotary/list.h>
 #include <rotary/mm/palloc.h>
+#include <rotary/fs/pseudo/tree.h>
 
 /* ------------------------------------------------------------------------- */
 
 #define SLAB_DEFAULT_ORDER 4
+#define SLAB_DEFAULT_ALIGN sizeof(void*)
+
+/* slab_cache->flags values */
+#define SLAB_NO_MERGE      0x01 /* Never share slabs with another cache */
+#define SLAB_DYNAMIC       0x02 /* Cache struct was allocated by create() */
+
+/* Flags which must match for two caches to share slabs */
+#define SLAB_MERGE_MASK    (SLAB_NO_MERGE)
 
 /* ------------------------------------------------------------------------- */
 
@@ -23,6 +32,7 @@
         .object_size = obj_size,            \
         .total_size = 0,                    \
         .alloc_count = 0,                   \
+        .refcount = 1,                      \
         .first_slab = NULL                  \
     }
 
@@ -46,8 +56,10 @@ typedef struct slab_header {
     struct      slab_object_empty * free_list;
 } slab_header_t;
 
-/* Slab Cache: Contains objects of a fixed size */
-typedef struct {
+/* Slab Cache: Contains objects of a fixed size. A cache may instead be an
+ * alias of a compatible root cache, in which case objects are allocated from
+ * the root's slabs while the alias keeps its own name and statistics */
+typedef struct slab_cache {
     char            name[16];     /* Name for debugging purposes */
     uint32_t        object_size;  /* Size of the object type stored in the cache */
     uint32_t        max_objects;  /* The maximum number of objects it can store */
@@ -55,6 +67,20 @@ typedef struct {
     uint32_t        alloc_count;  /* Total phys. pages allocated for the cache */
     atomic_flag     lock;         /* Spinlock */
     slab_header_t * first_slab;   /* Pointer to the first slab */
+    list_node_t     cache_node;   /* Entry in the global list of caches */
+    uint32_t        align;        /* Object alignment, 0 for the default */
+    flags_t         flags;        /* SLAB_* flags */
+    uint32_t        refcount;     /* Caches using this cache's slabs */
+    struct slab_cache * root;     /* Backing cache if merged, else NULL */
+
+    /* Statistics, maintained incrementally for slab_info_show() */
+    uint32_t        active_objects; /* Objects currently allocated */
+    uint32_t        total_objects;  /* Objects across all slabs */
+    uint32_t        slab_count;     /* Slabs held by the cache */
+    uint32_t        wasted_bytes;   /* Slab space unusable for objects */
+    uint32_t        alloc_total;    /* Successful allocations */
+    uint32_t        free_total;     /* Successful frees */
+    uint32_t        fail_total;     /* Failed allocations */
 } slab_cache_t;
 
 /* ------------------------------------------------------------------------- */
@@ -69,6 +95,14 @@ void    slab_add_cache_frame(slab_cache_t * slab_cache, uint32_t flags);
 
 int32_t slab_cache_has_addr(slab_cache_t * slab_cache, void * addr);
 
+slab_cache_t * slab_cache_create(const char * name, uint32_t size,
+                                 uint32_t align, flags_t flags);
+void    slab_cache_destroy(slab_cache_t * slab_cache);
+void    slab_cache_register(slab_cache_t * slab_cache);
+
+int32_t slab_info_init();
+int32_t slab_info_show(char * buf, uint32_t size);
+
 void    slab_cache_print_debug(slab_cache_t * slab_cache);
 
 /* ------------------------------------------------------------------------- */
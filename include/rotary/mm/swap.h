@@ -0,0 +1,72 @@
+/*
+ * include/rotary/mm/swap.h
+ * Swap
+ */
+
+#ifndef INC_MM_SWAP_H
+#define INC_MM_SWAP_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/sync.h>
+#include <rotary/drivers/block/blkdev.h>
+#include <rotary/mm/highmem.h>
+#include <rotary/mm/kmalloc.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/ptable.h>
+#include <rotary/mm/reclaim.h>
+#include <rotary/mm/rmap.h>
+#include <rotary/mm/vm.h>
+#include <rotary/mm/zswap.h>
+#include <arch/cpu.h>
+#include <arch/paging.h>
+#include <arch/ptable.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define SWAP_SECTORS_PER_SLOT (PAGE_SIZE / BLKDEV_SECTOR_SIZE)
+
+/* Slot 0 is never allocated, so that no swap entry is ever empty */
+#define SWAP_SLOT_NONE 0
+
+/* ------------------------------------------------------------------------- */
+
+struct vm_map;
+
+/* A block device holding swapped out pages, one per page sized slot. Each
+ * slot counts the swap entries referring to it, and is free at zero */
+struct swap_area {
+    struct block_device * dev;
+    uint32_t   slot_count;
+    uint16_t * slot_uses;
+    uint32_t   slots_used;
+    uint32_t   next_slot;  /* Where to start searching for a free slot */
+    volatile atomic_flag lock;
+
+    /* Statistics */
+    uint32_t   swap_outs;
+    uint32_t   swap_ins;
+};
+
+/* ------------------------------------------------------------------------- */
+
+int32_t  swap_on(struct block_device * dev);
+int32_t  swap_off();
+int      swap_active();
+
+uint32_t swap_alloc();
+void     swap_dup(uint32_t slot);
+void     swap_put(uint32_t slot);
+uint32_t swap_slot_uses(uint32_t slot);
+int32_t  swap_read(uint32_t slot, struct page * page);
+int32_t  swap_write(uint32_t slot, struct page * page);
+
+int32_t  swap_out(struct page * page);
+struct pte * swap_get_pte(struct pgd * pgd, void * virt_addr);
+int32_t  swap_fault(struct vm_map * map, void * virt_addr, struct pte * pte);
+
+void     swap_print_debug();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
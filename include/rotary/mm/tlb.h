@@ -0,0 +1,53 @@
+/*
+ * include/rotary/mm/tlb.h
+ * Batched TLB Invalidation
+ */
+
+#ifndef INC_MM_TLB_H
+#define INC_MM_TLB_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/mm/palloc.h>
+#include <arch/paging.h>
+#include <arch/ptable.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Freed pages held back until the TLB has been invalidated */
+#define TLB_GATHER_PAGES     32
+
+/* Individual invalidations in a gather before a full TLB flush is cheaper */
+#define TLB_GATHER_INVAL_MAX 32
+
+/* ------------------------------------------------------------------------- */
+
+/* Collects the pages freed and the addresses unmapped while tearing down a
+ * range of mappings, so that the TLB is invalidated once and the pages are
+ * released together, rather than page by page */
+struct tlb_gather {
+    struct pgd *  pgd;
+    struct page * pages[TLB_GATHER_PAGES];
+    uint32_t      page_count;
+    void *        inval_addrs[TLB_GATHER_INVAL_MAX];
+    uint32_t      inval_count;   /* Queued since the last flush */
+    uint32_t      inval_total;   /* Queued since tlb_gather_init() */
+    uint32_t      flush_all;     /* Too many addresses, reload the TLB */
+
+    /* Statistics, kept across flushes */
+    uint32_t      pages_freed;
+    uint32_t      tables_freed;
+    uint32_t      full_flushes;
+};
+
+/* ------------------------------------------------------------------------- */
+
+void tlb_gather_init(struct tlb_gather * tlb, struct pgd * pgd);
+void tlb_gather_inval(struct tlb_gather * tlb, void * virt_addr);
+void tlb_gather_page(struct tlb_gather * tlb, struct page * page);
+void tlb_gather_flush(struct tlb_gather * tlb);
+void tlb_gather_finish(struct tlb_gather * tlb);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -9,6 +9,7 @@
 #include <rotary/core.h>
 #include <rotary/list.h>
 #include <rotary/mm/kmalloc.h>
+#include <rotary/util/avl.h>
 #include <arch/ptable.h>
 
 /* ------------------------------------------------------------------------- */
@@ -20,47 +21,133 @@
 #define VM_MAP_IO       0x10 /* Area contains device I/O space */
 #define VM_MAP_RESERVED 0x20 /* Area must not be swapped out */
 
+/* Memory type of the pages, write-back unless another is requested */
+#define VM_MAP_WB       0x00
+#define VM_MAP_WC       0x40 /* Write-combining, for framebuffers */
+#define VM_MAP_WT       0x80 /* Write-through */
+#define VM_MAP_UC       0xC0 /* Uncached, for MMIO registers */
+#define VM_MAP_CACHE    0xC0
+
+#define VM_MAP_POPULATE 0x100 /* Pages are allocated when the map is added */
+
+/* Access pattern hints, set by vm_space_madvise() */
+#define VM_MAP_SEQUENTIAL 0x200 /* Pages are read in order, once */
+#define VM_MAP_RANDOM     0x400 /* Pages are read in no particular order */
+#define VM_MAP_HINTS      0x600
+
+/* Pages mapped around a faulting address by default, a power of two */
+#define VM_FAULT_AROUND_DEFAULT 16
+
+/* How many times further ahead of a fault VM_MAP_SEQUENTIAL pages are mapped
+ * than the fault-around window */
+#define VM_FAULT_AHEAD_FACTOR   4
+
+/* Advice given to vm_space_madvise() */
+#define VM_MADV_NORMAL     0 /* Clear any access pattern hint */
+#define VM_MADV_RANDOM     1 /* Map only the page that faulted */
+#define VM_MADV_SEQUENTIAL 2 /* Map further ahead of each fault */
+#define VM_MADV_WILLNEED   3 /* Map the range's pages now */
+#define VM_MADV_DONTNEED   4 /* Free the range's pages now */
+
+/* Causes of a page fault, passed to vm_space_page_fault() */
+#define VM_FAULT_PRESENT 0x01 /* The page was mapped, but access was denied */
+#define VM_FAULT_WRITE   0x02 /* The access was a write */
+
 /* ------------------------------------------------------------------------- */
 
+struct vm_map;
+
 /* Operations that can be called on a VM mapping - for example, invoking
  * a page fault handler relevant to the type of mapping upon a page fault */
 struct vm_ops {
-    void (*placeholder) ();
+    /* Resolve a fault on an address with no page mapped */
+    int32_t (*fault) (struct vm_map * map, void * addr, flags_t fault_flags);
+    /* Map every unmapped page in a range, as far as memory allows */
+    int32_t (*map_pages) (struct vm_map * map, void * start_addr,
+                          void * end_addr);
+    /* Make a mapped, read-only page writable. Optional, without it writes
+     * to mapped pages are refused */
+    int32_t (*page_mkwrite) (struct vm_map * map, void * addr);
+    /* Unmap the mapping's pages as it is removed. Optional */
+    void (*close) (struct vm_map * map);
 };
 
 /* Represents a task's virtual address space, containing all of its mappings,
  * and a pointer to its architecture-specific page table */
 struct vm_space {
     struct pgd * pgd;      /* Pointer to the actual page table */
-    list_head_t  mappings; /* A list of struct vm_map structs */
+    list_head_t  mappings; /* A list of struct vm_map structs, by address */
     uint32_t     users;    /* How many tasks use this address space */
+
+    /* The same mappings, in a tree keyed by start address for lookups */
+    struct avl_node * map_tree;
+    struct vm_map *   map_cache; /* The mapping last found by vm_map_find() */
+    uint32_t          map_count;
+
+    /* Working set estimates, updated by wss_scan_space() */
+    uint32_t     rss_pages; /* Pages mapped */
+    uint32_t     wss_pages; /* Pages used within the last WSS_WINDOW scans */
 };
 
 /* Represents a region of physical memory mapped into virtual memory */
 struct vm_map {
     list_node_t  list_node;
+    struct avl_node tree_node;
     struct vm_space * space; /* A mapping will only belong to one VM space */
     void * start_addr;       /* First (inclusive) address in the range */
     void * end_addr;         /* Final (exclusive) address in the range */
     uint32_t flags;          /* Example: read, read/write, executable */
+
+    struct vm_ops * ops;     /* Chosen from the flags if left NULL */
+    void * private;          /* The backing object, e.g. a file's inode */
+    uintptr_t offset;        /* Of start_addr, within the backing object */
 };
 
 /* ------------------------------------------------------------------------- */
 
+int32_t vm_init();
+
+extern struct page * vm_zero_page;
+
+extern struct vm_ops vm_anon_ops;   /* Zeroed memory */
+extern struct vm_ops vm_device_ops; /* Physical memory from offset up */
+extern struct vm_ops vm_file_ops;   /* The inode in private, from offset up */
+
 struct vm_space * vm_space_new();
+struct vm_space * vm_space_fork(struct vm_space * space);
 void vm_space_destroy(struct vm_space * space);
+struct vm_space * vm_space_get(struct vm_space * space);
+void vm_space_put(struct vm_space * space);
+struct vm_space * vm_space_kernel();
 
-void vm_space_add_map(struct vm_space * space, struct vm_map * map);
+struct vm_map * vm_space_add_map(struct vm_space * space, struct vm_map * map);
 void vm_space_delete_map(struct vm_space * space, struct vm_map * map);
-
-int32_t vm_space_page_fault(struct vm_space * space, void * fault_addr);
-int32_t vm_space_map_page(struct vm_space * space, void * addr);
+int32_t vm_space_unmap(struct vm_space * space, void * start_addr,
+                       void * end_addr);
+int32_t vm_space_protect(struct vm_space * space, void * start_addr,
+                         void * end_addr, flags_t flags);
+int32_t vm_space_madvise(struct vm_space * space, void * start_addr,
+                         void * end_addr, uint32_t advice);
+
+int32_t vm_space_page_fault(struct vm_space * space, void * fault_addr,
+                            flags_t fault_flags);
+int32_t vm_space_map_page(struct vm_space * space, struct vm_map * map,
+                          void * addr);
+int32_t vm_space_map_zero(struct vm_space * space, struct vm_map * map,
+                          void * addr);
+int32_t vm_space_map_huge(struct vm_space * space, struct vm_map * map,
+                          void * addr);
+int32_t vm_space_populate(struct vm_space * space, struct vm_map * map);
+void    vm_space_fault_window(struct vm_map * map, void * addr,
+                              void ** start, void ** end);
+void    vm_set_fault_around(uint32_t pages);
 
 /* ------------------------------------------------------------------------- */
 
 struct vm_map * vm_map_new();
 void vm_map_destroy(struct vm_map * map);
 struct vm_map * vm_map_find(struct vm_space * space, void * addr);
+struct vm_map * vm_map_next(struct vm_map * map);
 
 /* ------------------------------------------------------------------------- */
 
@@ -0,0 +1,43 @@
+/*
+ * include/rotary/mm/wss.h
+ * Working Set Estimation
+ */
+
+#ifndef INC_MM_WSS_H
+#define INC_MM_WSS_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/ptable.h>
+#include <rotary/mm/vm.h>
+#include <rotary/sched/task.h>
+#include <rotary/timer.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Timer ticks between scans of every address space */
+#define WSS_SCAN_INTERVAL 16
+
+/* Scans after which a page that hasn't been accessed leaves the working set */
+#define WSS_WINDOW        4
+
+/* ------------------------------------------------------------------------- */
+
+struct wss_scan {
+    uint32_t rss_pages;
+    uint32_t wss_pages;
+    uint32_t dirty_pages; /* Pages found dirty during this scan */
+};
+
+/* ------------------------------------------------------------------------- */
+
+void     wss_scan_space(struct vm_space * space, struct wss_scan * scan);
+void     wss_scan_all();
+void     wss_scan_periodic();
+uint32_t wss_page_age(struct page * page);
+void     wss_print_debug();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
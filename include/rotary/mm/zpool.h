@@ -0,0 +1,60 @@
+/*
+ * include/rotary/mm/zpool.h
+ * Compressed Object Pool
+ */
+
+#ifndef INC_MM_ZPOOL_H
+#define INC_MM_ZPOOL_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/list.h>
+#include <rotary/sync.h>
+#include <rotary/mm/palloc.h>
+#include <arch/paging.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Object sizes are rounded up to a multiple of this */
+#define ZPOOL_ALIGN       32
+
+/* Each page starts with its header, padded to ZPOOL_ALIGN */
+#define ZPOOL_HEADER_SIZE ZPOOL_ALIGN
+
+#define ZPOOL_MAX_SIZE    (PAGE_SIZE - ZPOOL_HEADER_SIZE)
+#define ZPOOL_CLASSES     (ZPOOL_MAX_SIZE / ZPOOL_ALIGN)
+
+/* ------------------------------------------------------------------------- */
+
+/* The header at the start of each page of a pool. Free objects hold the
+ * offset of the next free object in the page, with 0 ending the list */
+struct zpool_page {
+    list_node_t node;     /* On its class's list, while it has free objects */
+    uint16_t    size;     /* Of each object */
+    uint16_t    count;    /* Objects in the page */
+    uint16_t    used;
+    uint16_t    free;     /* Offset of the first free object, or 0 */
+};
+
+/* Objects of every size, packed into pages with others of the same size
+ * class. Pages are taken as needed, and freed as soon as they empty */
+struct zpool {
+    list_head_t classes[ZPOOL_CLASSES];
+    volatile atomic_flag lock;
+
+    /* Statistics */
+    uint32_t    pages;
+    uint32_t    objects;
+    uint32_t    bytes;    /* Asked for, before rounding up */
+};
+
+/* ------------------------------------------------------------------------- */
+
+void     zpool_init(struct zpool * pool);
+void *   zpool_alloc(struct zpool * pool, uint32_t size);
+void     zpool_free(struct zpool * pool, void * object, uint32_t size);
+void     zpool_print_debug(struct zpool * pool);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
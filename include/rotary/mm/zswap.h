@@ -0,0 +1,71 @@
+/*
+ * include/rotary/mm/zswap.h
+ * Compressed Swap Cache
+ */
+
+#ifndef INC_MM_ZSWAP_H
+#define INC_MM_ZSWAP_H
+
+#include <rotary/core.h>
+#include <rotary/logging.h>
+#include <rotary/string.h>
+#include <rotary/sync.h>
+#include <rotary/util/lz4.h>
+#include <rotary/util/math.h>
+#include <rotary/mm/highmem.h>
+#include <rotary/mm/kmalloc.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/zpool.h>
+#include <arch/cpuid.h>
+#include <arch/tsc.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Pages compressing to more than this go to the swap device instead, as at
+ * least two must share a pool page for compressing them to save memory */
+#define ZSWAP_MAX_SIZE         (ZPOOL_MAX_SIZE / 2)
+
+/* The most of memory the pool may take, as a percentage */
+#define ZSWAP_MAX_POOL_PERCENT 20
+
+/* zswap_entry->type values */
+#define ZSWAP_NONE       0
+#define ZSWAP_SAME       1 /* Every word of the page holds the same value */
+#define ZSWAP_COMPRESSED 2
+
+/* ------------------------------------------------------------------------- */
+
+/* What is stored for a swap slot */
+struct zswap_entry {
+    union {
+        void *   object; /* ZSWAP_COMPRESSED: the compressed page */
+        uint32_t value;  /* ZSWAP_SAME: the word the page is filled with */
+    };
+    uint16_t length;     /* Of the compressed page */
+    uint8_t  type;
+};
+
+struct zswap_stats {
+    uint32_t stored;      /* Pages held compressed */
+    uint32_t same_filled; /* Pages held as a single word */
+    uint32_t too_large;   /* Pages that didn't compress well enough */
+    uint32_t pool_full;   /* Pages refused as the pool was at its limit */
+    uint32_t loads;
+    uint64_t load_cycles; /* TSC cycles spent in loads */
+};
+
+/* ------------------------------------------------------------------------- */
+
+int32_t zswap_enable(uint32_t slot_count);
+void    zswap_disable();
+
+int32_t zswap_store(uint32_t slot, struct page * page);
+int     zswap_has(uint32_t slot);
+int32_t zswap_load(uint32_t slot, struct page * page);
+void    zswap_invalidate(uint32_t slot);
+
+void    zswap_print_debug();
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -11,6 +11,12 @@
 #define KERNEL_VERSION          "0.1"
 #define KERNEL_MEMZERO_ON_FREE  1
 
+/* Boot stages taking longer than this are flagged in the boot timeline */
+#define KERNEL_BOOT_STAGE_WARN_US 50000
+
+/* Keep the unit tests in memory after boot, rather than freeing them */
+#define KERNEL_KTEST_RESIDENT   0
+
 /* ------------------------------------------------------------------------- */
 
 #endif
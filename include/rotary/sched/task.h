@@ -13,6 +13,7 @@
 #include <rotary/util/math.h>
 #include <rotary/logging.h>
 #include <rotary/mm/kmalloc.h>
+#include <rotary/mm/arena.h>
 #include <rotary/mm/ptable.h>
 #include <rotary/mm/vm.h>
 #include <rotary/sync.h>
@@ -81,6 +82,13 @@ struct task {
 
     /* Architecture-specific CPU info, e.g. pointer to the TSS on x86 */
     struct arch_data * arch_data;
+
+    /* Scratch arena for request-scoped allocations, created on first use */
+    struct arena * scratch;
+
+    /* Address space loaded while this task runs. For user tasks this is their
+     * own vm_space, kernel tasks have none and borrow the previous task's */
+    struct vm_space * active_vm_space;
 };
 
 /* cpu_info relies on struct task */
@@ -92,15 +100,20 @@ int32_t  task_init();
 
 struct task * task_create(char * name, uint32_t type, void * start_addr,
                           uint32_t priority, uint32_t state);
+struct task * task_fork(struct task * parent, uint32_t state);
 struct task * task_alloc_struct(char * name, uint32_t type, void * start_addr,
                                 uint32_t priority, uint32_t state);
                             
 int32_t  task_create_vm_space(struct task * task);
 void     task_destroy_vm_space(struct task * task);
+void     task_switch_vm_space(struct task * prev, struct task * next);
 
 int32_t  task_create_kernel_stack(struct task * new_task);
 void     task_destroy_kernel_stack(struct task * task);
 
+struct arena * task_get_scratch(struct task * task);
+void           task_reset_scratch(struct task * task);
+
 int32_t  task_kill(uint32_t task_id);
 int32_t  task_purge(uint32_t task_id);
 int32_t  task_exit_current();
@@ -115,6 +128,7 @@ void     task_add_to_scheduler(struct task * new_task);
 
 struct task * task_get_current();
 struct task * task_get_from_id(uint32_t task_id);
+struct vm_space * task_next_vm_space(uint32_t * task_id);
 
 /* ------------------------------------------------------------------------- */
 
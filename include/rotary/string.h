@@ -20,8 +20,10 @@ void     int_to_hex_str(uint32_t num, char *dest);
 
 void *   memset(void *dest, int value, size_t n);
 void *   memcpy(void *dest, const void *src, size_t n);
+int      memcmp(const void *buf1, const void *buf2, size_t n);
 
 int      strcmp(const char *str1, const char *str2);
+int      strncmp(const char *str1, const char *str2, size_t n);
 char *   strcpy(char *dest_buf, const char *src_buf);
 char *   strncpy(char *dest_buf, const char *src_buf, size_t n);
 char *   strcat(char *str1, const char *str2);
@@ -10,6 +10,7 @@
 #include <rotary/logging.h>
 #include <rotary/debug.h>
 #include <rotary/sched/task.h>
+#include <rotary/mm/vm.h>
 #include <arch/syscall.h>
 
 /* ------------------------------------------------------------------------- */
@@ -19,10 +20,12 @@
 #define SYSCALL_OPEN        0x02
 #define SYSCALL_CLOSE       0x03
 #define SYSCALL_EXIT        0x04
+#define SYSCALL_MADVISE     0x05
 
 /* ------------------------------------------------------------------------- */
 
 void syscall_write(int descriptor_id, void * src_buffer, size_t size);
+int32_t syscall_madvise(void * addr, size_t length, uint32_t advice);
 
 /* ------------------------------------------------------------------------- */
 
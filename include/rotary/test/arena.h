@@ -0,0 +1,15 @@
+/*
+ * include/rotary/test/arena.h
+ * Arena Allocator Testing
+ */
+
+#ifndef INC_TEST_ARENA_H
+#define INC_TEST_ARENA_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/arena.h>
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ * include/rotary/test/avl.h
+ * AVL Tree Testing
+ */
+
+#ifndef INC_TEST_AVL_H
+#define INC_TEST_AVL_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/util/avl.h>
+
+#endif
@@ -0,0 +1,17 @@
+/*
+ * include/rotary/test/filemap.h
+ * File-backed Mapping Testing
+ */
+
+#ifndef INC_TEST_FILEMAP_H
+#define INC_TEST_FILEMAP_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/filemap.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/ptable.h>
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * include/rotary/test/highmem.h
+ * Highmem Temporary Mapping Testing
+ */
+
+#ifndef INC_TEST_HIGHMEM_H
+#define INC_TEST_HIGHMEM_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/highmem.h>
+#include <rotary/mm/palloc.h>
+
+#endif
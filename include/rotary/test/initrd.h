@@ -0,0 +1,15 @@
+/*
+ * include/rotary/test/initrd.h
+ * Initial RAM Disk Testing
+ */
+
+#ifndef INC_TEST_INITRD_H
+#define INC_TEST_INITRD_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/fs/initrd/initrd.h>
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * include/rotary/test/ioremap.h
+ * Device Memory Mapping Testing
+ */
+
+#ifndef INC_TEST_IOREMAP_H
+#define INC_TEST_IOREMAP_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/ioremap.h>
+#include <rotary/mm/palloc.h>
+
+#endif
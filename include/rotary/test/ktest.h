@@ -13,6 +13,12 @@
 
 /* ------------------------------------------------------------------------- */
 
+/* A user address at the start of a page table, for tests to map pages at in
+ * address spaces or PGDs they create themselves, where nothing else is */
+#define KTEST_USER_ADDR ((void*)0x40000000)
+
+/* ------------------------------------------------------------------------- */
+
 typedef struct ktest_unit {
     char * name;
     uint32_t pass_count;
@@ -60,12 +66,19 @@ void _assert_bit_set(ktest_unit_t * ktest, unsigned int buffer,
                      unsigned int bit, char * file, int line);
 
 void ktest_run_all();
+void ktest_release();
 void ktest_run_module(char * module_name);
 ktest_module_t * ktest_get_module(char * module_name);
 void ktest_list_modules();
 
 /* ------------------------------------------------------------------------- */
 
+/* Test functions and their unit tables are placed alongside the ktest modules,
+ * so that the whole test suite can be released by free_initmem() after boot
+ * unless KERNEL_KTEST_RESIDENT is set. */
+#define __ktest      __attribute__((section(".ktest.text")))
+#define __ktest_data __attribute__((section(".ktest.data")))
+
 #define KTEST_UNIT(n, f) \
     { \
         .name = (n), \
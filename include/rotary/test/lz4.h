@@ -0,0 +1,15 @@
+/*
+ * include/rotary/test/lz4.h
+ * LZ4 Compression Testing
+ */
+
+#ifndef INC_TEST_LZ4_H
+#define INC_TEST_LZ4_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/util/lz4.h>
+
+#endif
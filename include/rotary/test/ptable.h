@@ -0,0 +1,15 @@
+/*
+ * include/rotary/test/ptable.h
+ * Page Table Operation Testing
+ */
+
+#ifndef INC_TEST_PTABLE_H
+#define INC_TEST_PTABLE_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/ptable.h>
+
+#endif
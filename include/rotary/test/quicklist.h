@@ -0,0 +1,16 @@
+/*
+ * include/rotary/test/quicklist.h
+ * Page Quicklist Testing
+ */
+
+#ifndef INC_TEST_QUICKLIST_H
+#define INC_TEST_QUICKLIST_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/quicklist.h>
+#include <rotary/mm/palloc.h>
+
+#endif
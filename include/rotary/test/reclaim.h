@@ -0,0 +1,15 @@
+/*
+ * include/rotary/test/reclaim.h
+ */
+
+#ifndef INC_TEST_RECLAIM_H
+#define INC_TEST_RECLAIM_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/reclaim.h>
+#include <rotary/mm/vm.h>
+
+#endif
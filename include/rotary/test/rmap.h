@@ -0,0 +1,15 @@
+/*
+ * include/rotary/test/rmap.h
+ */
+
+#ifndef INC_TEST_RMAP_H
+#define INC_TEST_RMAP_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/rmap.h>
+#include <rotary/mm/vm.h>
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ * include/rotary/test/slab.h
+ * Slab Allocator Testing
+ */
+
+#ifndef INC_TEST_SLAB_H
+#define INC_TEST_SLAB_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/slab.h>
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * include/rotary/test/swap.h
+ */
+
+#ifndef INC_TEST_SWAP_H
+#define INC_TEST_SWAP_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/drivers/block/ramdisk.h>
+#include <rotary/mm/swap.h>
+#include <rotary/mm/vm.h>
+
+#endif
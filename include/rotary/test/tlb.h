@@ -0,0 +1,16 @@
+/*
+ * include/rotary/test/tlb.h
+ * Batched TLB Invalidation Testing
+ */
+
+#ifndef INC_TEST_TLB_H
+#define INC_TEST_TLB_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/tlb.h>
+#include <rotary/mm/ptable.h>
+
+#endif
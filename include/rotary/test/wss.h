@@ -0,0 +1,17 @@
+/*
+ * include/rotary/test/wss.h
+ * Working Set Estimation Testing
+ */
+
+#ifndef INC_TEST_WSS_H
+#define INC_TEST_WSS_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/wss.h>
+#include <rotary/mm/palloc.h>
+#include <rotary/mm/ptable.h>
+
+#endif
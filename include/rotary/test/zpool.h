@@ -0,0 +1,14 @@
+/*
+ * include/rotary/test/zpool.h
+ */
+
+#ifndef INC_TEST_ZPOOL_H
+#define INC_TEST_ZPOOL_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/mm/zpool.h>
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * include/rotary/test/zswap.h
+ */
+
+#ifndef INC_TEST_ZSWAP_H
+#define INC_TEST_ZSWAP_H
+
+#include <rotary/core.h>
+#include <rotary/debug.h>
+#include <rotary/logging.h>
+#include <rotary/test/ktest.h>
+#include <rotary/drivers/block/ramdisk.h>
+#include <rotary/mm/swap.h>
+#include <rotary/mm/zswap.h>
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * include/rotary/util/avl.h
+ * AVL Trees
+ */
+
+#ifndef INC_UTIL_AVL_H
+#define INC_UTIL_AVL_H
+
+#include <rotary/core.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Embedded in the structures kept in a tree, which are retrieved from a node
+ * with avl_entry(), as with list nodes */
+struct avl_node {
+    struct avl_node * left;
+    struct avl_node * right;
+    int32_t           height; /* Of the subtree rooted here, 1 for a leaf */
+};
+
+/* Orders two nodes, returning <0, 0 or >0 as a sorts before, equal to or
+ * after b */
+typedef int32_t (*avl_cmp_t)(struct avl_node * a, struct avl_node * b);
+
+#define avl_entry(node, type, member) container_of(node, type, member)
+
+/* ------------------------------------------------------------------------- */
+
+struct avl_node * avl_insert(struct avl_node * root, struct avl_node * node,
+                             avl_cmp_t cmp);
+struct avl_node * avl_remove(struct avl_node * root, struct avl_node * node,
+                             avl_cmp_t cmp);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
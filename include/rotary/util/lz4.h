@@ -0,0 +1,39 @@
+/*
+ * include/rotary/util/lz4.h
+ * LZ4 Compression
+ */
+
+#ifndef INC_UTIL_LZ4_H
+#define INC_UTIL_LZ4_H
+
+#include <rotary/core.h>
+#include <rotary/string.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define LZ4_MIN_MATCH     4
+#define LZ4_LAST_LITERALS 5  /* The last bytes of a block are always literal */
+#define LZ4_MF_LIMIT      12 /* No match starts this close to the end */
+#define LZ4_MAX_OFFSET    0xFFFF
+#define LZ4_MAX_INPUT     0xFFFF /* So that positions fit the hash table */
+
+#define LZ4_HASH_BITS     12
+#define LZ4_HASH_SIZE     (1 << LZ4_HASH_BITS)
+
+/* ------------------------------------------------------------------------- */
+
+/* Scratch space for lz4_compress(), too large to live on the stack */
+struct lz4_state {
+    uint16_t table[LZ4_HASH_SIZE];
+};
+
+/* ------------------------------------------------------------------------- */
+
+uint32_t lz4_compress(struct lz4_state * state, const void * src,
+                      uint32_t src_size, void * dst, uint32_t dst_capacity);
+int32_t  lz4_decompress(const void * src, uint32_t src_size, void * dst,
+                        uint32_t dst_capacity);
+
+/* ------------------------------------------------------------------------- */
+
+#endif
@@ -13,6 +13,11 @@
 
 uint32_t log2(uint32_t n);
 
+void     udivmod64(uint64_t dividend, uint64_t divisor, uint64_t * quotient,
+                   uint64_t * remainder);
+uint64_t udiv64(uint64_t dividend, uint64_t divisor);
+void     uint64_to_str(uint64_t value, char * str, int base);
+
 /* ------------------------------------------------------------------------- */
 
 #endif
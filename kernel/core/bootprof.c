@@ -0,0 +1,111 @@
+/*
+ * kernel/core/bootprof.c
+ * Boot Stage Profiler
+ *
+ * Records a timestamp at the start and end of each initialisation stage, so
+ * that the time taken to boot can be attributed to individual stages. The
+ * timeline begins at the earliest timestamp taken by the architecture's boot
+ * code, so the time spent before the C kernel is entered is also included.
+ *
+ * Once boot completes, boot_timeline_print() reports each stage's duration
+ * in cycles and, if the timestamp frequency is known, in microseconds. Stages
+ * exceeding KERNEL_BOOT_STAGE_WARN_US are flagged.
+ */
+
+#include <rotary/core/bootprof.h>
+
+struct boot_stage boot_stages[BOOT_STAGE_MAX];
+uint32_t boot_stage_count = 0;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * boot_stage_begin() - Mark the beginning of a boot stage.
+ * @name: Name of the stage, which must remain valid after boot.
+ *
+ * Ends the previous stage if it is still running. The first call also
+ * records the time between the architecture's earliest boot timestamp and
+ * now as an "early" stage.
+ */
+void boot_stage_begin(const char * name) {
+    uint64_t now = arch_timestamp();
+
+    if(boot_stage_count == 0) {
+        boot_stages[0].name  = "early";
+        boot_stages[0].start = arch_boot_timestamp();
+        boot_stages[0].end   = now;
+        boot_stage_count = 1;
+    }
+
+    boot_stage_end();
+
+    if(boot_stage_count >= BOOT_STAGE_MAX) {
+        klog("boot_stage_begin(): too many stages, '%s' not recorded\n",
+             name);
+        return;
+    }
+
+    struct boot_stage * stage = &boot_stages[boot_stage_count++];
+    stage->name  = name;
+    stage->start = arch_timestamp();
+    stage->end   = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * boot_stage_end() - Mark the end of the currently running boot stage.
+ */
+void boot_stage_end() {
+    if(boot_stage_count == 0) return;
+
+    struct boot_stage * stage = &boot_stages[boot_stage_count - 1];
+    if(stage->end == 0) {
+        stage->end = arch_timestamp();
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * boot_timeline_print() - Print the duration of each boot stage.
+ *
+ * Durations are printed in thousands of cycles, and in microseconds if the
+ * timestamp frequency can be determined. Stages which took longer than
+ * KERNEL_BOOT_STAGE_WARN_US are flagged, and the slowest stage is reported.
+ */
+void boot_timeline_print() {
+    if(boot_stage_count == 0) return;
+
+    boot_stage_end();
+
+    uint32_t khz   = arch_timestamp_khz();
+    uint64_t total = boot_stages[boot_stage_count - 1].end -
+                     boot_stages[0].start;
+    uint32_t slowest = 0;
+
+    klog("Boot Timeline (%d kHz)\n", khz);
+    klog("%-16s %-10s %-10s %-4s\n", "stage", "kcycles", "us", "%");
+
+    for(uint32_t i = 0; i < boot_stage_count; i++) {
+        struct boot_stage * stage = &boot_stages[i];
+        uint64_t cycles = stage->end - stage->start;
+        uint32_t us     = khz ? (uint32_t)udiv64(cycles * 1000, khz) : 0;
+        uint32_t pct    = total ? (uint32_t)udiv64(cycles * 100, total) : 0;
+
+        if(cycles > boot_stages[slowest].end - boot_stages[slowest].start) {
+            slowest = i;
+        }
+
+        klog("%-16s %-10u %-10u %-4u%s\n", stage->name,
+             (uint32_t)udiv64(cycles, 1000), us, pct,
+             (us > KERNEL_BOOT_STAGE_WARN_US) ? " <- slow" : "");
+    }
+
+    klog("Total: %u kcycles, %u us, slowest stage: %s\n",
+         (uint32_t)udiv64(total, 1000),
+         khz ? (uint32_t)udiv64(total * 1000, khz) : 0,
+         boot_stages[slowest].name);
+}
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,149 @@
+/*
+ * kernel/core/initcall.c
+ * Initcalls
+ *
+ * Subsystems register their initialisation functions with the *_initcall()
+ * macros, which place them in the .initcall section. During boot, each level
+ * is run in turn with initcall_run_level(), from early to late.
+ *
+ * Initcalls flagged INITCALL_ASYNC are skipped by initcall_run_level().
+ * Instead, once the scheduler is running, initcall_start_async() creates a
+ * kernel task which runs them in level order. Slow initialisation such as
+ * mounting filesystems or probing devices then no longer delays the shell.
+ *
+ * Once the async initcalls have finished and the boot path has signalled
+ * initcall_boot_complete(), the same task releases boot-only memory with
+ * free_initmem().
+ */
+
+#include <rotary/core/initcall.h>
+#include <rotary/core/bootprof.h>
+#include <rotary/sched/task.h>
+#include <rotary/mm/initmem.h>
+
+/* ------------------------------------------------------------------------- */
+
+extern struct initcall __start_initcall[];
+extern struct initcall __stop_initcall[];
+
+/* Set by initcall_boot_complete() once no more __init code will be called */
+volatile uint32_t initcall_boot_done = false;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initcall_run_level() - Run all synchronous initcalls of a given level.
+ * @level: The initcall level to run, e.g. INITCALL_CORE.
+ *
+ * Each initcall is recorded as a stage by the boot profiler. A failing
+ * initcall does not prevent the remaining initcalls from running.
+ *
+ * Return: E_SUCCESS if all initcalls succeeded, E_ERROR otherwise.
+ */
+int32_t __init initcall_run_level(uint32_t level) {
+    int32_t rv = E_SUCCESS;
+
+    struct initcall * call;
+    for(call = __start_initcall; call < __stop_initcall; call++) {
+        if(call->level != level || TEST_BIT(call->flags, INITCALL_ASYNC))
+            continue;
+
+        klog("initcall: running %s (level %d)\n", call->name, level);
+        boot_stage_begin(call->name);
+
+        if(!SUCCESS(call->fn())) {
+            klog("initcall: %s failed!\n", call->name);
+            rv = E_ERROR;
+        }
+    }
+
+    boot_stage_end();
+
+    return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initcall_async_worker() - Run all asynchronous initcalls, in level order.
+ *
+ * Entry point of the "kinit" kernel task created by initcall_start_async().
+ * Once finished, waits for the boot path to complete and releases boot-only
+ * memory. The task then marks itself as killed, to be purged by the
+ * scheduler.
+ */
+static void initcall_async_worker() {
+    uint32_t khz = arch_timestamp_khz();
+
+    for(uint32_t level = 0; level <= INITCALL_LEVEL_MAX; level++) {
+        struct initcall * call;
+        for(call = __start_initcall; call < __stop_initcall; call++) {
+            if(call->level != level || !TEST_BIT(call->flags, INITCALL_ASYNC))
+                continue;
+
+            uint64_t start = arch_timestamp();
+            int32_t rv = call->fn();
+            uint64_t cycles = arch_timestamp() - start;
+
+            klog("initcall: async %s %s after %u us\n", call->name,
+                 SUCCESS(rv) ? "completed" : "FAILED",
+                 khz ? (uint32_t)udiv64(cycles * 1000, khz) : 0);
+        }
+    }
+
+    /* The boot path may still be running __init code on the idle task */
+    while(!initcall_boot_done) { }
+    free_initmem();
+
+    task_exit_current();
+    while(true) { }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initcall_start_async() - Start running asynchronous initcalls.
+ *
+ * Must only be called once the scheduler has been enabled by task_init().
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t __init initcall_start_async() {
+    struct task * task = task_create("kinit", TASK_KERNEL,
+                                     &initcall_async_worker,
+                                     TASK_PRIORITY_MIN, TASK_STATE_WAITING);
+    if(!task) {
+        klog("initcall_start_async(): failed to create task!\n");
+        return E_ERROR;
+    }
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initcall_boot_complete() - Signal that the synchronous boot path is done.
+ *
+ * Called by the architecture's init. code once it will no longer call any
+ * __init functions, allowing init. memory to be released.
+ */
+void initcall_boot_complete() {
+    initcall_boot_done = true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initcall_print_debug() - Print all registered initcalls to the kernel log.
+ */
+void initcall_print_debug() {
+    klog("Initcalls:\n");
+    struct initcall * call;
+    for(call = __start_initcall; call < __stop_initcall; call++) {
+        klog("  [%d] %s%s\n", call->level, call->name,
+             TEST_BIT(call->flags, INITCALL_ASYNC) ? " (async)" : "");
+    }
+}
+
+/* ------------------------------------------------------------------------- */
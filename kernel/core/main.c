@@ -8,5 +8,10 @@ void kernel_main(uint32_t arg1, uint32_t arg2) {
 
     arch_init(arg1, arg2);
 
-    while(true) { }
+    /* Prepare page tables while idle, so that they're ready when needed, and
+     * keep the working set estimates up to date */
+    while(true) {
+        ptable_quicklist_refill();
+        wss_scan_periodic();
+    }
 }
@@ -75,7 +75,8 @@ extern uint32_t t1_counter;
 void apple() {
     printk(LOG_INFO, "APPLE initialised\n");
 
-    char * test1 = (char*)0x300100;
+    char * test1 = kmalloc(16);
+    memset(test1, 0, 16);
     int magic = 0;
 
     while(true) {
@@ -98,38 +99,112 @@ void banana() {
 
 struct task * ktask1 = NULL;
 
+/* ------------------------------------------------------------------------- */
+
+/* Print a buffer to the kernel log line by line, as klog() can only format
+ * a limited amount of text at once */
+void shell_print_buffer(char * buf) {
+    char line[256];
+    while(*buf) {
+        uint32_t len = 0;
+        while(buf[len] && buf[len] != '\n' && len < sizeof(line) - 1) {
+            line[len] = buf[len];
+            len++;
+        }
+        line[len] = '\0';
+        buf += len;
+        if(*buf == '\n') buf++;
+        klog("%s\n", line);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
 void shell_process_command(char * command) {
 
-    /*
-    #include <rotary/fs/pseudo/tree.h>
+    if(strcmp(command, "slabinfo") == 0) {
+        char * buf = kmalloc(PAGE_SIZE);
+        if(!buf) return;
+        slab_info_show(buf, PAGE_SIZE);
+        shell_print_buffer(buf);
+        kfree(buf);
+        return;
+    }
+
+    if(strcmp(command, "boottime") == 0) {
+        boot_timeline_print();
+        return;
+    }
+
+    if(strcmp(command, "initcalls") == 0) {
+        initcall_print_debug();
+        return;
+    }
+
     if(strcmp(command, "pseudo") == 0) {
+        pseudo_print_debug();
+        return;
+    }
 
-        struct pseudo_node dir1;
-        dir1.name = "example_dir";
-        dir1.mode = PSEUDO_DIR;
-        dir1.children.prev = NULL;
-        dir1.children.next = NULL;
+    if(strcmp(command, "quicklist") == 0) {
+        ptable_quicklist_print_debug();
+        return;
+    }
 
-        struct pseudo_node dir1_child1;
-        dir1_child1.name = "file1";
-        dir1_child1.mode = PSEUDO_DIR;
-        dir1_child1.prev = NULL;
-        dir1_child1.next = NULL;
+    if(strcmp(command, "kmap") == 0) {
+        highmem_print_debug();
+        return;
+    }
 
-        dir1.children
+    if(strcmp(command, "ioremap") == 0) {
+        ioremap_print_debug();
+        return;
     }
-    */
 
+    if(strcmp(command, "wss") == 0) {
+        wss_print_debug();
+        return;
+    }
+
+    if(strcmp(command, "reclaim") == 0) {
+        reclaim_print_debug();
+        return;
+    }
+
+    if(strcmp(command, "swapon") == 0) {
+        struct block_device * dev = ramdisk_create("ram0", 1024);
+        if(dev && !SUCCESS(swap_on(dev))) {
+            ramdisk_destroy(dev);
+        }
+        return;
+    }
 
+    if(strcmp(command, "initrd") == 0) {
+        initrd_print_debug();
+        return;
+    }
+
+    if(strncmp(command, "cat ", 4) == 0) {
+        char * buf = kmalloc(PAGE_SIZE);
+        if(!buf) return;
+        struct initrd_file * file = initrd_lookup(command + 4);
+        if(file) {
+            int32_t len = initrd_read(file, buf, 0, PAGE_SIZE - 1);
+            if(len >= 0) {
+                buf[len] = '\0';
+                shell_print_buffer(buf);
+            }
+        } else if(SUCCESS(pseudo_read(command + 4, buf, PAGE_SIZE))) {
+            shell_print_buffer(buf);
+        }
+        kfree(buf);
+        return;
+    }
 
     if(strcmp(command, "kt") == 0) {
         ktask1 = task_create("ktask_test1", TASK_KERNEL, &apple,
                                        TASK_PRIORITY_MIN,
                                        TASK_STATE_WAITING);
-        struct vm_map * map = vm_map_new();
-        map->start_addr = (void*)0x300000;
-        map->end_addr   = (void*)0x400000;
-        vm_space_add_map(ktask1->vm_space, map);
         return;
     }
 
@@ -165,7 +240,7 @@ void shell_process_command(char * command) {
     }
 
     if(strcmp(command, "slab-test") == 0) {
-        ktest_run_module("awodawd");
+        ktest_run_module("slab");
     }
 
     if(strcmp(command, "palloc-test") == 0) {
@@ -186,10 +261,24 @@ void shell_process_command(char * command) {
         struct vm_map * map = vm_map_new();
         map->start_addr = (void*)0x400000;
         map->end_addr   = (void*)0x600000;
+        map->flags      = VM_MAP_READ | VM_MAP_EXEC;
         vm_space_add_map(task->vm_space, map);
         return;
     }
 
+    if(strncmp(command, "faultaround ", 12) == 0) {
+        vm_set_fault_around(atoi(command + 12));
+        return;
+    }
+
+    if(strncmp(command, "fork ", 5) == 0) {
+        struct task * parent = task_get_from_id(atoi(command + 5));
+        if(parent) {
+            task_fork(parent, TASK_STATE_WAITING);
+        }
+        return;
+    }
+
     if(strcmp(command, "clear") == 0 || strcmp(command, "cls") == 0) {
         for(uint32_t i = 4; i < VGA_HEIGHT; i++) {
             vga_clear_line(i);
@@ -30,6 +30,21 @@ void * memcpy(void *dest, const void *src, size_t n) {
 
 /* ------------------------------------------------------------------------- */
 
+int memcmp(const void *buf1, const void *buf2, size_t n) {
+    const unsigned char *a = buf1;
+    const unsigned char *b = buf2;
+    while (n--) {
+        if (*a != *b) {
+            return *a - *b;
+        }
+        a++;
+        b++;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
 void int_to_str(int32_t num, char *dest) {
     int i = 0;
     int isNegative = 0;
@@ -149,6 +164,13 @@ int sprintf(char *dest_buf, const char *format_str, ...) {
 
             index++; // Move past '%'
 
+            // Process optional left-justify flag, padded with spaces.
+            int left = 0;
+            if (format_str[index] == '-') {
+                left = 1;
+                index++;
+            }
+
             // Process optional padding.
             int padding = 0;
             while (format_str[index] >= '0' && format_str[index] <= '9') {
@@ -162,7 +184,7 @@ int sprintf(char *dest_buf, const char *format_str, ...) {
                 case 's': {
                         char *str_arg = __builtin_va_arg(list, char*);
                         length = strlen(str_arg);
-                        if (padding > length) {
+                        if (!left && padding > length) {
                             fill_buffer(dest_buf, &dest_index, '0', padding - length);
                         }
                         while (*str_arg != '\0') {
@@ -173,7 +195,7 @@ int sprintf(char *dest_buf, const char *format_str, ...) {
                 case 'd': {
                         int_to_str(__builtin_va_arg(list, int), num);
                         length = strlen(num);
-                        if (padding > length) {
+                        if (!left && padding > length) {
                             fill_buffer(dest_buf, &dest_index, '0', padding - length);
                         }
                         char *num_ptr = num;
@@ -185,7 +207,7 @@ int sprintf(char *dest_buf, const char *format_str, ...) {
                 case 'u': {
                         uint_to_str(__builtin_va_arg(list, unsigned int), num);
                         length = strlen(num);
-                        if (padding > length) {
+                        if (!left && padding > length) {
                             fill_buffer(dest_buf, &dest_index, '0', padding - length);
                         }
                         char *unum_ptr = num;
@@ -197,7 +219,7 @@ int sprintf(char *dest_buf, const char *format_str, ...) {
                 case 'x': {
                         int_to_hex_str(__builtin_va_arg(list, int), num);
                         length = strlen(num);
-                        if (padding > length) {
+                        if (!left && padding > length) {
                             fill_buffer(dest_buf, &dest_index, '0', padding - length);
                         }
                         char *hex_ptr = num;
@@ -207,7 +229,8 @@ int sprintf(char *dest_buf, const char *format_str, ...) {
                     }
                     break;
                 case 'c': {
-                        if (padding > 1) {
+                        length = 1;
+                        if (!left && padding > 1) {
                             fill_buffer(dest_buf, &dest_index, '0', padding - 1);
                         }
                         dest_buf[dest_index++] = __builtin_va_arg(list, int);
@@ -219,6 +242,10 @@ int sprintf(char *dest_buf, const char *format_str, ...) {
                     break;
             }
 
+            if (left && padding > length) {
+                fill_buffer(dest_buf, &dest_index, ' ', padding - length);
+            }
+
             processed = index + 1;
         }
         index++;
@@ -246,6 +273,20 @@ int strcmp(const char *s1, const char *s2) {
 
 /* ------------------------------------------------------------------------- */
 
+int strncmp(const char *s1, const char *s2, size_t n) {
+    while (n && *s1 && (*s1 == *s2)) {
+        s1++;
+        s2++;
+        n--;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    return ((unsigned char)*s1 - (unsigned char)*s2);
+}
+
+/* ------------------------------------------------------------------------- */
+
 char * strcpy(char *dest, const char *src) {
     char *d = dest;
     while ((*d++ = *src++));
@@ -0,0 +1,76 @@
+/*
+ * kernel/drivers/block/blkdev.c
+ * Block Devices
+ *
+ * A block device is read and written in whole sectors of BLKDEV_SECTOR_SIZE
+ * bytes, through the operations of the driver behind it. These wrappers
+ * refuse requests running past the end of the device, so that drivers don't
+ * each have to.
+ */
+
+#include <rotary/drivers/block/blkdev.h>
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * blkdev_check() - Returns whether a request lies within a device.
+ * @dev:    The block device.
+ * @sector: The first sector of the request.
+ * @count:  The number of sectors.
+ *
+ * Return: 1 if the request is valid, 0 otherwise.
+ */
+static int blkdev_check(struct block_device * dev, uint32_t sector,
+                        uint32_t count) {
+    if(sector >= dev->sector_count || count > dev->sector_count - sector) {
+        klog("blkdev: %s: Sectors %d+%d are beyond the end of the device\n",
+             dev->name, sector, count);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * blkdev_read() - Read sectors from a block device.
+ * @dev:    The block device.
+ * @sector: The first sector to read.
+ * @count:  The number of sectors to read.
+ * @buf:    The buffer to read into, of count * BLKDEV_SECTOR_SIZE bytes.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the request was invalid or the
+ *         device failed to read it.
+ */
+int32_t blkdev_read(struct block_device * dev, uint32_t sector,
+                    uint32_t count, void * buf) {
+    if(!blkdev_check(dev, sector, count)) {
+        return E_ERROR;
+    }
+
+    return dev->ops->read(dev, sector, count, buf);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * blkdev_write() - Write sectors to a block device.
+ * @dev:    The block device.
+ * @sector: The first sector to write.
+ * @count:  The number of sectors to write.
+ * @buf:    The buffer to write from, of count * BLKDEV_SECTOR_SIZE bytes.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the request was invalid or the
+ *         device failed to write it.
+ */
+int32_t blkdev_write(struct block_device * dev, uint32_t sector,
+                     uint32_t count, void * buf) {
+    if(!blkdev_check(dev, sector, count)) {
+        return E_ERROR;
+    }
+
+    return dev->ops->write(dev, sector, count, buf);
+}
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,129 @@
+/*
+ * kernel/drivers/block/ramdisk.c
+ * RAM Disk
+ *
+ * A block device backed by pages of memory, allocated in full when the disk
+ * is created so that writes to it never need memory. The pages may be
+ * highmem, and are mapped with kmap_atomic() for each transfer.
+ */
+
+#include <rotary/drivers/block/ramdisk.h>
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ramdisk_transfer() - Copy sectors between a RAM disk and a buffer.
+ * @dev:    The RAM disk.
+ * @sector: The first sector.
+ * @count:  The number of sectors.
+ * @buf:    The kernel buffer.
+ * @write:  Whether to copy into the disk, rather than out of it.
+ *
+ * Return: E_SUCCESS
+ */
+static int32_t ramdisk_transfer(struct block_device * dev, uint32_t sector,
+                                uint32_t count, void * buf, int write) {
+    struct ramdisk * disk = dev->private;
+
+    while(count) {
+        uint32_t first = sector % RAMDISK_SECTORS_PER_PAGE;
+        uint32_t run   = RAMDISK_SECTORS_PER_PAGE - first;
+        if(run > count) {
+            run = count;
+        }
+
+        struct page * page = disk->pages[sector / RAMDISK_SECTORS_PER_PAGE];
+        void * data = kmap_atomic(page) + first * BLKDEV_SECTOR_SIZE;
+        if(write) {
+            memcpy(data, buf, run * BLKDEV_SECTOR_SIZE);
+        } else {
+            memcpy(buf, data, run * BLKDEV_SECTOR_SIZE);
+        }
+        kunmap_atomic(data);
+
+        sector += run;
+        count  -= run;
+        buf    += run * BLKDEV_SECTOR_SIZE;
+    }
+
+    return E_SUCCESS;
+}
+
+static int32_t ramdisk_read(struct block_device * dev, uint32_t sector,
+                            uint32_t count, void * buf) {
+    return ramdisk_transfer(dev, sector, count, buf, 0);
+}
+
+static int32_t ramdisk_write(struct block_device * dev, uint32_t sector,
+                             uint32_t count, void * buf) {
+    return ramdisk_transfer(dev, sector, count, buf, 1);
+}
+
+static struct block_ops ramdisk_ops = {
+    .read  = ramdisk_read,
+    .write = ramdisk_write
+};
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ramdisk_create() - Create a RAM disk.
+ * @name:       The name of the disk, for debugging.
+ * @page_count: The size of the disk, in pages.
+ *
+ * The disk's contents start zeroed.
+ *
+ * Return: The new block device, or NULL if memory ran out.
+ */
+struct block_device * ramdisk_create(const char * name, uint32_t page_count) {
+    struct ramdisk * disk = kmalloc(sizeof(struct ramdisk));
+    if(!disk) {
+        return NULL;
+    }
+
+    memset(disk, 0, sizeof(struct ramdisk));
+    disk->pages = kmalloc(page_count * sizeof(struct page *));
+    if(!disk->pages) {
+        kfree(disk);
+        return NULL;
+    }
+
+    for(; disk->page_count < page_count; disk->page_count++) {
+        struct page * page = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+        if(!page) {
+            klog("ramdisk_create(): Out of memory for %s after %d pages\n",
+                 name, disk->page_count);
+            ramdisk_destroy(&disk->dev);
+            return NULL;
+        }
+
+        highmem_zero_page(page);
+        disk->pages[disk->page_count] = page;
+    }
+
+    strncpy(disk->dev.name, name, BLKDEV_NAME_MAX - 1);
+    disk->dev.sector_count = page_count * RAMDISK_SECTORS_PER_PAGE;
+    disk->dev.ops          = &ramdisk_ops;
+    disk->dev.private      = disk;
+
+    return &disk->dev;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ramdisk_destroy() - Free a RAM disk, along with its contents.
+ * @dev: The block device returned by ramdisk_create().
+ */
+void ramdisk_destroy(struct block_device * dev) {
+    struct ramdisk * disk = container_of(dev, struct ramdisk, dev);
+
+    for(uint32_t i = 0; i < disk->page_count; i++) {
+        page_free(disk->pages[i], 0);
+    }
+
+    kfree(disk->pages);
+    kfree(disk);
+}
+
+/* ------------------------------------------------------------------------- */
@@ -17,11 +17,13 @@ void * keyboard_event_handlers[MAX_INTERRUPT_HANDLERS];
  *
  * Return: E_SUCCESS
  */
-int32_t keyboard_init() {
+int32_t __init keyboard_init() {
     arch_keyboard_init();
     return E_SUCCESS;
 }
 
+device_initcall(keyboard_init);
+
 /* ------------------------------------------------------------------------- */
 
 /**
@@ -22,7 +22,7 @@ uint32_t serial_debug_port = 0;
  *
  * Return: E_SUCCESS on success, E_ERROR on failure.
  */
-int32_t serial_init() {
+int32_t __init serial_init() {
     if(!SUCCESS(arch_serial_init())) {
         return E_ERROR;
     }
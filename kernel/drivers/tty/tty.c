@@ -16,7 +16,7 @@ struct tty tty_list_head;
  *
  * Return: E_SUCCESS
  */
-int32_t tty_init() {
+int32_t __init tty_init() {
     klog("Initialising default TTYs..\n");
 
     // Initialise TTY list head and mark it as an invalid TTY
@@ -33,6 +33,8 @@ int32_t tty_init() {
     return E_SUCCESS;
 }
 
+subsys_initcall(tty_init);
+
 /* ------------------------------------------------------------------------- */
 
 /**
@@ -0,0 +1,485 @@
+/*
+ * kernel/fs/initrd/initrd.c
+ * Initial RAM Disk
+ *
+ * Exposes the modules loaded by the bootloader (e.g. with GRUB's `module`
+ * command) as files, so that user binaries and test data can be supplied at
+ * boot without rebuilding the kernel.
+ *
+ * A module containing a cpio "newc" archive is unpacked into one file per
+ * archive entry, and any other module is exposed as a single file named after
+ * its path. Module memory is reserved from bootmem and lies within the
+ * kernel's direct mapping, so file names and contents are referenced in place
+ * rather than copied - the only memory used per file is its initrd_file.
+ *
+ * The files are registered with the VFS as the "initrd" filesystem type.
+ */
+
+#include <rotary/fs/initrd/initrd.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define CPIO_ALIGN(x) (((x) + 3) & ~3)
+
+/* Field indices within a cpio newc header, following the magic bytes */
+#define CPIO_FIELD_MODE     1
+#define CPIO_FIELD_FILESIZE 6
+#define CPIO_FIELD_NAMESIZE 11
+
+/* Physical memory above this isn't in the direct mapping */
+#define INITRD_DIRECT_LIMIT (KMAP_START_VIRT - KERNEL_START_VIRT)
+
+/* ------------------------------------------------------------------------- */
+
+struct initrd_module initrd_modules[INITRD_MODULES_MAX] __initdata;
+uint32_t initrd_module_count __initdata = 0;
+
+list_head_t initrd_files = INIT_LIST_HEAD(initrd_files);
+struct super_block * initrd_sb = NULL;
+
+static int initrd_inode_lookup(struct inode * dir_node, const char * name,
+        size_t len, struct inode * result);
+static int initrd_inode_read(struct inode * node, void * buf, uint32_t offset,
+        uint32_t size);
+static struct super_block * initrd_super_alloc();
+
+struct inode_ops initrd_inode_ops = {
+    .lookup = initrd_inode_lookup,
+    .read   = initrd_inode_read
+};
+
+struct file_system_type initrd_fs_type = {
+    .name = "initrd",
+    .flags = FS_TYPE_NODEV,
+    .super_alloc = initrd_super_alloc,
+    .super_dealloc = NULL
+};
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_add_module() - Record a module loaded by the bootloader.
+ * @start_addr: Physical address of the start of the module.
+ * @end_addr:   Physical address of the end of the module (not incl.).
+ * @cmdline:    The module's command line, or NULL.
+ *
+ * Called by the architecture's boot code while parsing the bootloader's
+ * information. The module is reserved from bootmem, so that its memory is
+ * never handed to the page allocator and can be referenced by initrd_init().
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t __init initrd_add_module(uintptr_t start_addr, uintptr_t end_addr,
+        const char * cmdline) {
+    if(end_addr <= start_addr) {
+        klog("initrd_add_module(): empty module at 0x%x\n", start_addr);
+        return E_ERROR;
+    }
+
+    if(initrd_module_count >= INITRD_MODULES_MAX) {
+        klog("initrd_add_module(): too many modules, 0x%x ignored\n",
+             start_addr);
+        return E_ERROR;
+    }
+
+    struct initrd_module * mod = &initrd_modules[initrd_module_count++];
+    mod->start_addr = start_addr;
+    mod->end_addr   = end_addr;
+    mod->cmdline[0] = '\0';
+
+    /* The bootloader's copy of the command line isn't reserved, so it may be
+     * overwritten before initrd_init() runs */
+    if(cmdline) {
+        strncpy(mod->cmdline, cmdline, INITRD_CMDLINE_MAX - 1);
+        mod->cmdline[INITRD_CMDLINE_MAX - 1] = '\0';
+    }
+
+    return bootmem_reserve(start_addr, end_addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * cpio_field() - Parse a hexadecimal field of a cpio newc header.
+ * @hdr:   The header, starting at its magic bytes.
+ * @index: The index of the field following the magic bytes.
+ * @value: Where to store the parsed value.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the field isn't valid hex.
+ */
+static int32_t cpio_field(const char * hdr, uint32_t index, uint32_t * value) {
+    const char * field = hdr + 6 + (index * 8);
+    uint32_t result = 0;
+
+    for(uint32_t i = 0; i < 8; i++) {
+        char c = field[i];
+        uint32_t digit;
+
+        if(c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if(c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if(c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return E_ERROR;
+        }
+
+        result = (result << 4) | digit;
+    }
+
+    *value = result;
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_unpack() - Build a list of files from a cpio newc archive.
+ * @files:   The list to append the files to.
+ * @archive: The archive, which must remain mapped while the files are used.
+ * @size:    The size of the archive in bytes.
+ *
+ * Files reference their names and contents within the archive. A leading
+ * "./" or "/" is stripped from each name, and the "." entry is skipped. Any
+ * files unpacked before an error is found are left in the list.
+ *
+ * Return: The number of files unpacked, or E_ERROR if the archive is invalid.
+ */
+int32_t initrd_unpack(list_head_t * files, const void * archive,
+        uint32_t size) {
+    const char * base = archive;
+    uint32_t offset = 0;
+    int32_t count = 0;
+
+    while(offset + CPIO_NEWC_HDR_SIZE <= size) {
+        const char * hdr = base + offset;
+        uint32_t mode, file_size, name_size;
+
+        if(strncmp(hdr, CPIO_NEWC_MAGIC, 6) != 0 ||
+           !SUCCESS(cpio_field(hdr, CPIO_FIELD_MODE, &mode)) ||
+           !SUCCESS(cpio_field(hdr, CPIO_FIELD_FILESIZE, &file_size)) ||
+           !SUCCESS(cpio_field(hdr, CPIO_FIELD_NAMESIZE, &name_size))) {
+            klog("initrd_unpack(): bad header at offset 0x%x\n", offset);
+            return E_ERROR;
+        }
+
+        /* Check the sizes individually first, so the sums can't overflow */
+        const char * name = hdr + CPIO_NEWC_HDR_SIZE;
+        if(name_size == 0 || name_size > size || file_size > size ||
+           offset + CPIO_NEWC_HDR_SIZE + name_size > size) {
+            klog("initrd_unpack(): truncated entry at offset 0x%x\n", offset);
+            return E_ERROR;
+        }
+
+        uint32_t data_offset = CPIO_ALIGN(offset + CPIO_NEWC_HDR_SIZE +
+                                          name_size);
+        if(name[name_size - 1] != '\0' || data_offset > size ||
+           file_size > size - data_offset) {
+            klog("initrd_unpack(): truncated entry at offset 0x%x\n", offset);
+            return E_ERROR;
+        }
+
+        if(strcmp(name, CPIO_TRAILER) == 0) {
+            return count;
+        }
+
+        offset = CPIO_ALIGN(data_offset + file_size);
+
+        if(name[0] == '.' && name[1] == '/') name += 2;
+        while(*name == '/') name++;
+        if(*name == '\0' || strcmp(name, ".") == 0) {
+            continue;
+        }
+
+        struct initrd_file * file = kmalloc(sizeof(struct initrd_file));
+        if(!file) {
+            klog("initrd_unpack(): failed to allocate file '%s'\n", name);
+            return E_ERROR;
+        }
+
+        file->name = name;
+        file->mode = mode;
+        file->size = file_size;
+        file->data = base + data_offset;
+        clist_add_before(files, &file->list_node);
+        count++;
+    }
+
+    klog("initrd_unpack(): archive has no trailer\n");
+    return E_ERROR;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_free_files() - Free every file in a list built by initrd_unpack().
+ * @files: The list of files to free.
+ *
+ * The archive the files reference is not freed.
+ */
+void initrd_free_files(list_head_t * files) {
+    struct initrd_file * file;
+    struct initrd_file * tmp;
+    clist_for_each_safe(file, tmp, files, list_node) {
+        clist_delete_node(&file->list_node);
+        kfree(file);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_find() - Find a file in a list by its path.
+ * @files: The list of files to search.
+ * @path:  The path of the file, with or without a leading '/'.
+ *
+ * Return: A pointer to the file if found, otherwise NULL.
+ */
+struct initrd_file * initrd_find(list_head_t * files, const char * path) {
+    while(*path == '/') path++;
+
+    struct initrd_file * file;
+    clist_for_each(file, files, list_node) {
+        if(strcmp(file->name, path) == 0) {
+            return file;
+        }
+    }
+
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_lookup() - Find a file in the initial RAM disk by its path.
+ * @path: The path of the file, e.g. "bin/init".
+ *
+ * Return: A pointer to the file if found, otherwise NULL.
+ */
+struct initrd_file * initrd_lookup(const char * path) {
+    return initrd_find(&initrd_files, path);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_read() - Copy part of a file's contents into a buffer.
+ * @file:   The file to read.
+ * @buf:    The buffer to copy the contents into.
+ * @offset: The offset within the file to start reading from.
+ * @size:   The maximum number of bytes to read.
+ *
+ * Callers which can use the contents in place, such as loaders, should read
+ * file->data directly instead.
+ *
+ * Return: The number of bytes read, or E_ERROR if the file is a directory.
+ */
+int32_t initrd_read(struct initrd_file * file, void * buf, uint32_t offset,
+        uint32_t size) {
+    if(INITRD_IS_DIR(file->mode)) {
+        return E_ERROR;
+    }
+
+    if(offset >= file->size) {
+        return 0;
+    }
+
+    if(size > file->size - offset) {
+        size = file->size - offset;
+    }
+
+    memcpy(buf, (const char *)file->data + offset, size);
+    return size;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_inode_lookup() - Look up a name within an initrd directory.
+ * @dir_node: The directory to search, whose private data is its file (or
+ *            NULL for the root directory).
+ * @name:     The name to look up, which need not be NUL terminated.
+ * @len:      The length of the name.
+ * @result:   The inode to fill in if the name is found.
+ *
+ * Return: E_SUCCESS if found, otherwise E_ERROR.
+ */
+static int initrd_inode_lookup(struct inode * dir_node, const char * name,
+        size_t len, struct inode * result) {
+    struct initrd_file * dir = dir_node->private;
+    char path[INITRD_PATH_MAX];
+    uint32_t pos = 0;
+
+    if(dir) {
+        uint32_t dir_len = strlen(dir->name);
+        if(dir_len + 1 >= INITRD_PATH_MAX) return E_ERROR;
+        memcpy(path, dir->name, dir_len);
+        path[dir_len] = '/';
+        pos = dir_len + 1;
+    }
+
+    if(pos + len >= INITRD_PATH_MAX) return E_ERROR;
+    memcpy(path + pos, name, len);
+    path[pos + len] = '\0';
+
+    struct initrd_file * file = initrd_lookup(path);
+    if(!file) return E_ERROR;
+
+    result->mode    = file->mode;
+    result->ops     = &initrd_inode_ops;
+    result->sb      = dir_node->sb;
+    result->size    = file->size;
+    result->private = file;
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_inode_read() - Read the contents of an initrd file.
+ * @node:   The file's inode, whose private data is the file.
+ * @buf:    The buffer to read into.
+ * @offset: The offset into the file to start reading from.
+ * @size:   The maximum number of bytes to read.
+ *
+ * Return: The number of bytes read, or E_ERROR if the inode is a directory.
+ */
+static int initrd_inode_read(struct inode * node, void * buf, uint32_t offset,
+        uint32_t size) {
+    struct initrd_file * file = node->private;
+    if(!file) return E_ERROR;
+
+    return initrd_read(file, buf, offset, size);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_super_alloc() - Allocate a super block for the initial RAM disk.
+ *
+ * Return: A pointer to the super block, or NULL on failure.
+ */
+static struct super_block * initrd_super_alloc() {
+    struct super_block * sb = super_block_alloc(&initrd_fs_type);
+    if(!sb) return NULL;
+
+    sb->root_inode.mode    = INITRD_MODE_DIR;
+    sb->root_inode.ops     = &initrd_inode_ops;
+    sb->root_inode.sb      = sb;
+    sb->root_inode.size    = 0;
+    sb->root_inode.private = NULL;
+
+    return sb;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_add_raw() - Expose a module which isn't an archive as a single file.
+ * @mod:  The module.
+ * @data: The module's contents, mapped in the kernel's address space.
+ *
+ * The file is named after the final component of the first word of the
+ * module's command line, e.g. "/boot/init.elf arg" becomes "init.elf".
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+static int32_t __init initrd_add_raw(struct initrd_module * mod,
+        const void * data) {
+    const char * name = mod->cmdline;
+    uint32_t len = 0;
+
+    for(const char * c = mod->cmdline; *c && *c != ' '; c++) {
+        if(*c == '/') name = c + 1;
+    }
+    while(name[len] && name[len] != ' ') len++;
+
+    if(len == 0) {
+        name = "module";
+        len  = strlen(name);
+    }
+
+    /* The command line is freed after boot, so the name is stored with the
+     * file rather than referenced */
+    struct initrd_file * file = kmalloc(sizeof(struct initrd_file) + len + 1);
+    if(!file) return E_ERROR;
+
+    char * file_name = (char *)(file + 1);
+    memcpy(file_name, name, len);
+    file_name[len] = '\0';
+
+    file->name = file_name;
+    file->mode = INITRD_MODE_FILE;
+    file->size = mod->end_addr - mod->start_addr;
+    file->data = data;
+    clist_add_before(&initrd_files, &file->list_node);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_init() - Expose the bootloader's modules through the VFS.
+ *
+ * Return: E_SUCCESS, or E_ERROR if the super block can't be allocated.
+ */
+int32_t __init initrd_init() {
+    for(uint32_t i = 0; i < initrd_module_count; i++) {
+        struct initrd_module * mod = &initrd_modules[i];
+        uint32_t size = mod->end_addr - mod->start_addr;
+
+        if(mod->end_addr > INITRD_DIRECT_LIMIT) {
+            klog("initrd: module %d at 0x%x is outside lowmem, ignored\n",
+                 i, mod->start_addr);
+            continue;
+        }
+
+        const void * data = PHY_TO_VIR(mod->start_addr);
+
+        if(size >= CPIO_NEWC_HDR_SIZE &&
+           strncmp(data, CPIO_NEWC_MAGIC, 6) == 0) {
+            int32_t count = initrd_unpack(&initrd_files, data, size);
+            klog("initrd: module %d (%s): %d files, %d KB\n", i, mod->cmdline,
+                 count, size / 1024);
+        } else if(SUCCESS(initrd_add_raw(mod, data))) {
+            klog("initrd: module %d (%s): raw, %d KB\n", i, mod->cmdline,
+                 size / 1024);
+        }
+    }
+
+    file_system_type_register(&initrd_fs_type);
+
+    initrd_sb = initrd_fs_type.super_alloc();
+    if(!initrd_sb) {
+        klog("initrd_init(): failed to allocate super block!\n");
+        return E_ERROR;
+    }
+
+    return E_SUCCESS;
+}
+
+fs_initcall(initrd_init);
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * initrd_print_debug() - Print the files in the initial RAM disk.
+ */
+void initrd_print_debug() {
+    klog("initrd files:\n");
+    struct initrd_file * file;
+    clist_for_each(file, &initrd_files, list_node) {
+        klog("  %s%s (%d bytes @ 0x%x)\n", file->name,
+             INITRD_IS_DIR(file->mode) ? "/" : "", file->size, file->data);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/initrd.c"
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,161 @@
+/*
+ * kernel/fs/pseudo/tree.c
+ * Pseudo File Tree
+ *
+ * A minimal tree of pseudo files, whose contents are generated on demand by
+ * a callback when read. Used by kernel subsystems to expose statistics and
+ * state (e.g. "slabinfo") without printing to the kernel log.
+ *
+ * Nodes are owned by the registering subsystem, typically statically
+ * allocated with PSEUDO_FILE_INIT() or PSEUDO_DIR_INIT().
+ */
+
+#include <rotary/fs/pseudo/tree.h>
+
+struct pseudo_node pseudo_root = PSEUDO_DIR_INIT(pseudo_root, "");
+atomic_flag pseudo_lock = ATOMIC_FLAG_INIT;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * pseudo_register() - Add a pseudo file or directory to the tree.
+ * @parent: The directory to add the node to, or NULL for the root.
+ * @node:   The node to add.
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t pseudo_register(struct pseudo_node * parent, struct pseudo_node * node) {
+    if(!parent) {
+        parent = &pseudo_root;
+    }
+
+    if(parent->mode != PSEUDO_DIR) {
+        klog("pseudo_register(): parent '%s' is not a directory!\n",
+             parent->name);
+        return E_ERROR;
+    }
+
+    if(node->mode == PSEUDO_DIR && node->children.next == NULL) {
+        clist_init(&node->children);
+    }
+
+    lock(&pseudo_lock);
+    node->parent = parent;
+    clist_add_before(&parent->children, &node->sibling);
+    unlock(&pseudo_lock);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * pseudo_unregister() - Remove a pseudo file or directory from the tree.
+ * @node: The node to remove.
+ */
+void pseudo_unregister(struct pseudo_node * node) {
+    if(!node->parent) return;
+
+    lock(&pseudo_lock);
+    clist_delete_node(&node->sibling);
+    node->parent = NULL;
+    unlock(&pseudo_lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * pseudo_lookup() - Find a node in the pseudo tree by its path.
+ * @path: A '/' separated path relative to the root, e.g. "mm/slabinfo".
+ *
+ * Return: A pointer to the node if found, otherwise NULL.
+ */
+struct pseudo_node * pseudo_lookup(const char * path) {
+    struct pseudo_node * node = &pseudo_root;
+    char component[PSEUDO_PATH_MAX];
+
+    lock(&pseudo_lock);
+
+    while(*path) {
+        /* Skip any separators */
+        while(*path == '/') path++;
+        if(!*path) break;
+
+        /* Copy the next path component */
+        uint32_t len = 0;
+        while(path[len] && path[len] != '/' && len < PSEUDO_PATH_MAX - 1) {
+            component[len] = path[len];
+            len++;
+        }
+        component[len] = '\0';
+        path += len;
+
+        if(node->mode != PSEUDO_DIR) {
+            node = NULL;
+            break;
+        }
+
+        struct pseudo_node * child;
+        struct pseudo_node * found = NULL;
+        clist_for_each(child, &node->children, sibling) {
+            if(strcmp(child->name, component) == 0) {
+                found = child;
+                break;
+            }
+        }
+
+        node = found;
+        if(!node) break;
+    }
+
+    unlock(&pseudo_lock);
+    return node;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * pseudo_read() - Generate the contents of a pseudo file.
+ * @path: The path of the file to read.
+ * @buf:  The buffer to write the contents into.
+ * @size: The size of the buffer in bytes.
+ *
+ * Return: The number of bytes written, or E_ERROR on failure.
+ */
+int32_t pseudo_read(const char * path, char * buf, uint32_t size) {
+    struct pseudo_node * node = pseudo_lookup(path);
+    if(!node) {
+        klog("pseudo_read(): no such file '%s'\n", path);
+        return E_ERROR;
+    }
+
+    if(node->mode != PSEUDO_FILE || !node->show) {
+        klog("pseudo_read(): '%s' is not a readable file\n", path);
+        return E_ERROR;
+    }
+
+    return node->show(buf, size);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void pseudo_print_node(struct pseudo_node * node, uint32_t depth) {
+    struct pseudo_node * child;
+    clist_for_each(child, &node->children, sibling) {
+        klog("%s%s%s\n", depth ? "  " : "", child->name,
+             child->mode == PSEUDO_DIR ? "/" : "");
+        if(child->mode == PSEUDO_DIR) {
+            pseudo_print_node(child, depth + 1);
+        }
+    }
+}
+
+/**
+ * pseudo_print_debug() - Print the pseudo file tree to the kernel log.
+ */
+void pseudo_print_debug() {
+    klog("Pseudo files:\n");
+    pseudo_print_node(&pseudo_root, 0);
+}
+
+/* ------------------------------------------------------------------------- */
@@ -26,7 +26,7 @@ void mount_root(int device, char * fs_type_name) {
  *
  * TO BE REMOVED WHEN BLOCK IMPLEMENTATION COMPLETE
  */
-void mount_root_testing() {
+void __init mount_root_testing() {
     klog("Mounting root in TEST MODE\n");
 
     /* Call testfs_init() which also registers the filesystem type */
@@ -57,3 +57,20 @@ void mount_root_testing() {
 }
 
 /* ------------------------------------------------------------------------- */
+
+/**
+ * mount_root_init() - Mount the root filesystem during boot.
+ *
+ * Run asynchronously after the scheduler has started, so that mounting does
+ * not delay the shell from coming up.
+ *
+ * Return: E_SUCCESS
+ */
+int32_t __init mount_root_init() {
+    mount_root_testing();
+    return E_SUCCESS;
+}
+
+fs_initcall_async(mount_root_init);
+
+/* ------------------------------------------------------------------------- */
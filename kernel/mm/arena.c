@@ -0,0 +1,253 @@
+/*
+ * kernel/mm/arena.c
+ * Arena (Region) Allocator
+ *
+ * Provides bump-pointer allocation for short-lived, request-scoped memory.
+ * An arena hands out memory by advancing a cursor through a chunk of pages
+ * obtained from page_alloc(), adding further chunks as required. Objects
+ * cannot be freed individually: instead, everything allocated from an arena
+ * is released at once with arena_reset() or arena_destroy().
+ *
+ * This suits paths such as path resolution or syscall argument marshalling,
+ * which make many small allocations that all die together at the end of the
+ * request, and would otherwise pay for a slab search on every kmalloc() and
+ * kfree().
+ *
+ * Arenas are not locked, and are intended to be owned by a single task.
+ */
+
+#include <rotary/mm/arena.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define ARENA_CHUNK_HDR ARENA_ALIGN_UP(sizeof(struct arena_chunk))
+#define ARENA_HDR       ARENA_ALIGN_UP(sizeof(struct arena))
+
+#define ARENA_FIRST_CHUNK(arena) \
+    ((struct arena_chunk *)((uintptr_t)(arena) - ARENA_CHUNK_HDR))
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_chunk_new() - Allocate a new chunk of pages for an arena.
+ * @order: The order of the pages to allocate.
+ *
+ * Return: A pointer to the chunk header, or NULL on failure.
+ */
+static struct arena_chunk * arena_chunk_new(uint32_t order) {
+    struct page * page = page_alloc(order, PR_KERNEL);
+    if(!page) {
+        klog("arena_chunk_new(): failed to alloc. order %d pages!\n", order);
+        return NULL;
+    }
+
+    struct arena_chunk * chunk = (struct arena_chunk *)PAGE_VA(page);
+    chunk->next  = NULL;
+    chunk->order = order;
+
+    return chunk;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_chunk_order() - Find the smallest chunk order that can hold a size.
+ * @size: The payload size in bytes, excluding the chunk header.
+ *
+ * Return: The order, or ORDER_MAX + 1 if no order is large enough.
+ */
+static uint32_t arena_chunk_order(uint32_t size) {
+    uint32_t order = 0;
+    while(order <= ORDER_MAX &&
+          (PAGE_SIZE << order) - ARENA_CHUNK_HDR < size) {
+        order++;
+    }
+    return order;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_create() - Create a new arena.
+ * @order: The order of the page chunks the arena will allocate from.
+ *
+ * Allocates the arena's first chunk, and places the arena structure itself at
+ * the start of it, so that creating an arena costs a single page_alloc().
+ *
+ * Return: A pointer to the new arena, or NULL on failure.
+ */
+struct arena * arena_create(uint32_t order) {
+    if(order > ORDER_MAX) {
+        klog("arena_create(): order %d exceeds ORDER_MAX!\n", order);
+        return NULL;
+    }
+
+    struct arena_chunk * chunk = arena_chunk_new(order);
+    if(!chunk) {
+        return NULL;
+    }
+
+    struct arena * arena = (struct arena *)((uintptr_t)chunk +
+                                            ARENA_CHUNK_HDR);
+    arena->order       = order;
+    arena->chunks      = chunk;
+    arena->chunk_count = 1;
+    arena->bytes_used  = 0;
+    arena->cursor      = (uintptr_t)arena + ARENA_HDR;
+    arena->limit       = (uintptr_t)chunk + (PAGE_SIZE << order);
+
+    return arena;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_destroy() - Destroy an arena, freeing all memory allocated from it.
+ * @arena: The arena to destroy.
+ */
+void arena_destroy(struct arena * arena) {
+    if(!arena) return;
+
+    /* The arena lives in its first chunk, so that chunk must be freed last */
+    struct arena_chunk * first = ARENA_FIRST_CHUNK(arena);
+    struct arena_chunk * chunk = arena->chunks;
+    while(chunk) {
+        struct arena_chunk * next = chunk->next;
+        if(chunk != first) {
+            page_free_va(chunk, chunk->order);
+        }
+        chunk = next;
+    }
+
+    page_free_va(first, first->order);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_reset() - Release all allocations made from an arena.
+ * @arena: The arena to reset.
+ *
+ * Frees every chunk except the first, and rewinds the cursor to the start of
+ * it. Any pointers previously returned by the arena become invalid.
+ */
+void arena_reset(struct arena * arena) {
+    struct arena_chunk * first = ARENA_FIRST_CHUNK(arena);
+    struct arena_chunk * chunk = arena->chunks;
+    while(chunk) {
+        struct arena_chunk * next = chunk->next;
+        if(chunk != first) {
+            page_free_va(chunk, chunk->order);
+        }
+        chunk = next;
+    }
+
+    first->next        = NULL;
+    arena->chunks      = first;
+    arena->chunk_count = 1;
+    arena->bytes_used  = 0;
+    arena->cursor      = (uintptr_t)arena + ARENA_HDR;
+    arena->limit       = (uintptr_t)first + (PAGE_SIZE << first->order);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_alloc_slow() - Allocate memory when the current chunk is exhausted.
+ * @arena: The arena to allocate from.
+ * @size:  The amount of bytes to allocate.
+ *
+ * Called by arena_alloc() when the current chunk does not have enough space.
+ * Requests larger than a regular chunk are given a dedicated chunk of their
+ * own, leaving the current chunk in place for subsequent small allocations.
+ * Otherwise a new regular chunk is added and becomes the current chunk.
+ *
+ * Return: A pointer to the allocation, or NULL on failure.
+ */
+void * arena_alloc_slow(struct arena * arena, uint32_t size) {
+    uint32_t aligned = ARENA_ALIGN_UP(size);
+    if(aligned < size) {
+        return NULL;
+    }
+
+    struct arena_chunk * chunk;
+
+    /* Oversized request: place it in a dedicated chunk behind the current
+     * one, without moving the cursor */
+    if(aligned > (PAGE_SIZE << arena->order) - ARENA_CHUNK_HDR) {
+        uint32_t order = arena_chunk_order(aligned);
+        if(order > ORDER_MAX) {
+            klog("arena_alloc(): %d bytes exceeds max. chunk size!\n", size);
+            return NULL;
+        }
+
+        chunk = arena_chunk_new(order);
+        if(!chunk) {
+            return NULL;
+        }
+
+        chunk->next = arena->chunks->next;
+        arena->chunks->next = chunk;
+        arena->chunk_count++;
+        arena->bytes_used += aligned;
+
+        return (void*)((uintptr_t)chunk + ARENA_CHUNK_HDR);
+    }
+
+    /* Otherwise start a new regular chunk, abandoning the rest of the old */
+    chunk = arena_chunk_new(arena->order);
+    if(!chunk) {
+        return NULL;
+    }
+
+    chunk->next   = arena->chunks;
+    arena->chunks = chunk;
+    arena->chunk_count++;
+    arena->cursor = (uintptr_t)chunk + ARENA_CHUNK_HDR;
+    arena->limit  = (uintptr_t)chunk + (PAGE_SIZE << arena->order);
+
+    return arena_alloc(arena, size);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_alloc_zero() - Allocate zeroed memory from an arena.
+ * @arena: The arena to allocate from.
+ * @size:  The amount of bytes to allocate.
+ *
+ * Return: A pointer to the zeroed allocation, or NULL on failure.
+ */
+void * arena_alloc_zero(struct arena * arena, uint32_t size) {
+    void * ptr = arena_alloc(arena, size);
+    if(ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * arena_print_debug() - Print arena information to the kernel log.
+ * @arena: The arena to print debug information for.
+ */
+void arena_print_debug(struct arena * arena) {
+    klog("Arena [addr: 0x%x, order: %d, chunks: %d, used: %d bytes, "
+         "free in chunk: %d bytes]\n", arena, arena->order,
+         arena->chunk_count, arena->bytes_used,
+         arena->limit - arena->cursor);
+
+    struct arena_chunk * chunk = arena->chunks;
+    while(chunk) {
+        klog("  -> Chunk[addr: 0x%x, order: %d]\n", chunk, chunk->order);
+        chunk = chunk->next;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/arena.c"
+
+/* ------------------------------------------------------------------------- */
@@ -5,6 +5,17 @@
  * Provides memory allocation capability to the kernel before the page
  * allocator is initialised. Bootmem is used by the page allocator to identify
  * memory where the page structures can be stored.
+ *
+ * Bootmem keeps two sorted lists of physical memory regions: "memory", the
+ * usable RAM reported by the firmware, and "reserved", the ranges which must
+ * not be handed to the page allocator (the kernel image, firmware reserved
+ * areas and bootmem allocations). Adjacent or overlapping regions with the
+ * same flags are merged. Both lists start out in static arrays, and double
+ * in size when full using memory allocated from bootmem itself, so that
+ * fragmented memory maps can be described in full.
+ *
+ * Allocations are placed top-down between a lower and upper limit, leaving
+ * scarce low memory (e.g. for legacy DMA) free for as long as possible.
  */
 
 #include <rotary/mm/bootmem.h>
@@ -14,25 +25,283 @@
 extern uintptr_t KERNEL_PHYS_START;
 extern uintptr_t KERNEL_PHYS_END;
 
-struct mem_region mem_regions[MAX_MEM_REGIONS];
+struct mem_region memory_init[BOOTMEM_INIT_REGIONS];
+struct mem_region reserved_init[BOOTMEM_INIT_REGIONS];
+
+struct mem_region_list bootmem_memory = {
+    .name    = "memory",
+    .regions = memory_init,
+    .max     = BOOTMEM_INIT_REGIONS
+};
+
+struct mem_region_list bootmem_reserved = {
+    .name    = "reserved",
+    .regions = reserved_init,
+    .max     = BOOTMEM_INIT_REGIONS
+};
+
+uintptr_t limit_low  = BOOTMEM_LIMIT_LOW;
+uintptr_t limit_high = BOOTMEM_LIMIT_EARLY;
+
+struct pfn_range pfn_ranges[BOOTMEM_PFN_RANGES];
+uint32_t pfn_range_count = 0;
 
 uint32_t highest_pfn = 0;
-uint32_t region_count = 0;
+
+/* ------------------------------------------------------------------------- */
+
+static int32_t bootmem_region_add(struct mem_region_list * list,
+                                  uintptr_t start_addr, uintptr_t end_addr,
+                                  flags_t flags);
+static int32_t bootmem_region_remove(struct mem_region_list * list,
+                                     uintptr_t start_addr, uintptr_t end_addr);
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_region_delete() - Remove the region at an index from a list.
+ * @list:  The list to remove the region from.
+ * @index: The index of the region to remove.
+ */
+static void bootmem_region_delete(struct mem_region_list * list,
+                                  uint32_t index) {
+    for(uint32_t i = index; i + 1 < list->count; i++) {
+        list->regions[i] = list->regions[i + 1];
+    }
+    list->count--;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_region_find() - Find a region overlapping a range of memory.
+ * @list:       The list to search.
+ * @start_addr: The start of the range.
+ * @end_addr:   The end of the range (exclusive).
+ *
+ * Return: A pointer to the first overlapping region, or NULL if none.
+ */
+static struct mem_region * bootmem_region_find(struct mem_region_list * list,
+                                               uintptr_t start_addr,
+                                               uintptr_t end_addr) {
+    for(uint32_t i = 0; i < list->count; i++) {
+        struct mem_region * region = &list->regions[i];
+        if(region->start_addr >= end_addr)
+            break;
+        if(region->end_addr > start_addr)
+            return region;
+    }
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_find_range() - Find free memory for an allocation, top-down.
+ * @size:      The size of the allocation in bytes.
+ * @alignment: The alignment of the allocation.
+ * @addr:      Set to the physical address of the range found.
+ *
+ * Searches usable memory from the highest address downwards for a range
+ * which lies within the allocation limits and does not overlap any reserved
+ * region. The range is not reserved.
+ *
+ * Return: E_SUCCESS if a range was found, otherwise E_ERROR.
+ */
+static int32_t bootmem_find_range(size_t size, size_t alignment,
+                                  uintptr_t * addr) {
+    if(size == 0 || alignment == 0)
+        return E_ERROR;
+
+    for(uint32_t i = bootmem_memory.count; i > 0; i--) {
+        struct mem_region * region = &bootmem_memory.regions[i - 1];
+
+        uintptr_t bottom = region->start_addr;
+        uintptr_t top    = region->end_addr;
+        if(bottom < limit_low)
+            bottom = limit_low;
+        if(top > limit_high)
+            top = limit_high;
+
+        /* Try the highest aligned address that fits, moving below any
+         * reserved region in the way until we run out of space */
+        while(top > bottom && top - bottom >= size) {
+            uintptr_t candidate = ALIGN_DOWN(top - size, alignment);
+            if(candidate < bottom)
+                break;
+
+            struct mem_region * reserved = bootmem_region_find(
+                &bootmem_reserved, candidate, candidate + size);
+            if(!reserved) {
+                *addr = candidate;
+                return E_SUCCESS;
+            }
+
+            top = reserved->start_addr;
+        }
+    }
+
+    return E_ERROR;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_region_grow() - Double the capacity of a region list.
+ * @list: The list to grow.
+ *
+ * The new array is allocated from bootmem and reserved, and the old array is
+ * released if it was also allocated from bootmem.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if no memory was available.
+ */
+static int32_t bootmem_region_grow(struct mem_region_list * list) {
+    uint32_t  old_max     = list->max;
+    uint32_t  old_dynamic = list->dynamic;
+    uintptr_t old_addr    = (uintptr_t)VIR_TO_PHY(list->regions);
+    size_t    old_size    = old_max * sizeof(struct mem_region);
+    size_t    new_size    = old_size * 2;
+    uintptr_t new_addr;
+
+    if(!SUCCESS(bootmem_find_range(new_size, sizeof(uintptr_t), &new_addr))) {
+        klog("bootmem_region_grow(): No memory to grow %s list!\n",
+             list->name);
+        return E_ERROR;
+    }
+
+    struct mem_region * regions = PHY_TO_VIR(new_addr);
+    memset(regions, 0, new_size);
+    memcpy(regions, list->regions, list->count * sizeof(struct mem_region));
+
+    list->regions = regions;
+    list->max     = old_max * 2;
+    list->dynamic = true;
+
+    klog("bootmem_region_grow(): %s list grown to %d regions at 0x%x\n",
+         list->name, list->max, new_addr);
+
+    /* The list has room again, so reserving the new array cannot recurse
+     * into growing the same list */
+    bootmem_region_add(&bootmem_reserved, new_addr, new_addr + new_size,
+                       MEM_REGION_F_NONE);
+
+    if(old_dynamic) {
+        bootmem_region_remove(&bootmem_reserved, old_addr,
+                              old_addr + old_size);
+    }
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_region_add() - Add a range of memory to a region list.
+ * @list:       The list to add the range to.
+ * @start_addr: The start of the range.
+ * @end_addr:   The end of the range (exclusive).
+ * @flags:      The region's flags, e.g. MEM_REGION_F_TEMP.
+ *
+ * Any regions with the same flags which overlap or are adjacent to the range
+ * are merged with it, and the list is kept sorted by start address.
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+static int32_t bootmem_region_add(struct mem_region_list * list,
+                                  uintptr_t start_addr, uintptr_t end_addr,
+                                  flags_t flags) {
+    if(start_addr >= end_addr)
+        return E_ERROR;
+
+    /* Make room first, as growing the list allocates and reserves memory
+     * that must not overlap the range being added */
+    if(list->count == list->max && !SUCCESS(bootmem_region_grow(list)))
+        return E_ERROR;
+
+    /* Merge with overlapping or adjacent regions of the same type. Regions
+     * of the same type never touch each other, so one pass is enough */
+    for(uint32_t i = 0; i < list->count; i++) {
+        struct mem_region * region = &list->regions[i];
+        if(region->flags != flags ||
+           region->end_addr < start_addr || region->start_addr > end_addr)
+            continue;
+
+        if(region->start_addr < start_addr)
+            start_addr = region->start_addr;
+        if(region->end_addr > end_addr)
+            end_addr = region->end_addr;
+
+        bootmem_region_delete(list, i);
+        i--;
+    }
+
+    /* Insert the region, keeping the list sorted */
+    uint32_t pos = 0;
+    while(pos < list->count && list->regions[pos].start_addr < start_addr)
+        pos++;
+
+    for(uint32_t i = list->count; i > pos; i--) {
+        list->regions[i] = list->regions[i - 1];
+    }
+
+    list->regions[pos].start_addr = start_addr;
+    list->regions[pos].end_addr   = end_addr;
+    list->regions[pos].flags      = flags;
+    list->count++;
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_region_remove() - Remove a range of memory from a region list.
+ * @list:       The list to remove the range from.
+ * @start_addr: The start of the range.
+ * @end_addr:   The end of the range (exclusive).
+ *
+ * Regions entirely within the range are removed, and regions partially
+ * within it are trimmed, or split in two if the range lies in their middle.
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+static int32_t bootmem_region_remove(struct mem_region_list * list,
+                                     uintptr_t start_addr, uintptr_t end_addr) {
+    for(uint32_t i = 0; i < list->count; i++) {
+        struct mem_region * region = &list->regions[i];
+        if(region->end_addr <= start_addr || region->start_addr >= end_addr)
+            continue;
+
+        if(region->start_addr < start_addr && region->end_addr > end_addr) {
+            uintptr_t tail_end = region->end_addr;
+            region->end_addr = start_addr;
+            return bootmem_region_add(list, end_addr, tail_end,
+                                      region->flags);
+        }
+
+        if(region->start_addr >= start_addr && region->end_addr <= end_addr) {
+            bootmem_region_delete(list, i);
+            i--;
+        } else if(region->start_addr < start_addr) {
+            region->end_addr = start_addr;
+        } else {
+            region->start_addr = end_addr;
+        }
+    }
+
+    return E_SUCCESS;
+}
 
 /* ------------------------------------------------------------------------- */
 
 /**
  * bootmem_mark_free() - Mark memory as usable based on bootmem region maps.
  *
- * Initialises the bootmem subsystem to provide memory allocation capability
- * to the kernel, before the page allocation system is fully initialised.
- * The page allocator itself will make use of bootmem to find space for its
- * pre-allocated table of page structures.
+ * Hands all usable memory which is not reserved to the page allocator.
  *
- * This function expects available memory regions to have been added to the
- * mem_regions array through calls to bootmem_add_mem_region(), which is to be
- * called by architecture-specific code capable of detecting usable memory
- * regions.
+ * This function expects available memory regions to have been added through
+ * calls to bootmem_add_mem_region(), which is to be called by
+ * architecture-specific code capable of detecting usable memory regions.
  *
  * This function also expects the page struct array to have been initialised
  * by the page allocator initialisation. This will set all pages to INVALID,
@@ -40,74 +309,95 @@ uint32_t region_count = 0;
  * making pages available based on the memory regions provided to bootmem
  * previously.
  *
- * Additionally, bootmem_mark_free() will not make any pages containing
- * bootmem-allocated memory available. When bootmem is allocated via
- * bootmem_alloc(), the starting address of the memory region issued from is
- * adjusted to no longer include the allocated memory. This function will
- * therefore not iterate over memory allocated via bootmem_alloc(), and the
- * pages representing that memory will remain marked as INVALID.
+ * Pages overlapping a reserved region, such as the kernel image or memory
+ * allocated with bootmem_alloc(), remain INVALID. Pages reserved by the
+ * kernel are additionally marked KERNEL, so that page_free() refuses them.
  *
  * Return: E_SUCCESS on success, E_ERROR on failure.
  */
 int32_t bootmem_mark_free() {
-
-    /* Initialise the buddy allocator, this will request memory from bootmem
-     * for page structs and initialise them - then we can mark pages as free
-     * using our information on available memory regions. */
-    //buddy_init(highest_pfn);
-
     klog("bootmem_mark_free(): Initialising bootmem..\n");
     klog("bootmem_mark_free(): Highest PFN:  %d\n", highest_pfn);
-    klog("bootmem_mark_free(): Region count: %d\n", region_count);
+    klog("bootmem_mark_free(): Region count: %d\n", bootmem_memory.count);
 
     /* Panic if we don't seem to have any memory regions available - perhaps
      * we were called before init. code called add_mem_region()? */
-    if(region_count == 0 || highest_pfn == 0) {
+    if(bootmem_memory.count == 0 || highest_pfn == 0) {
         PANIC("No memory regions registered in bootmem at time of "
               "mark_free()!");
         return E_ERROR;
     }
 
-    /* Now all the page structs are initialised, we can mark available pages
-     * as free using our memory maps. As the start_addr attribute for each
-     * region is incremented when boot memory is allocated from it, this
-     * ensures that these allocated regions will not be marked as available
-     * in the following code. */
+    /* Both lists are sorted, so we can walk the reserved regions alongside
+     * each memory region, skipping any pages they overlap */
     uint32_t freed_pages = 0;
-    for(uint32_t i = 0; i < region_count; i++) {
-        if(mem_regions[i].start_addr == 0)
-            continue;
+    for(uint32_t i = 0; i < bootmem_memory.count; i++) {
+        struct mem_region * region = &bootmem_memory.regions[i];
+        uint32_t res = 0;
 
         klog("bootmem_mark_free(): Processing mem. region %d "
                           "(start: 0x%x | end: 0x%x)\n",
-                          i, mem_regions[i].start_addr,
-                          mem_regions[i].end_addr);
+                          i, region->start_addr, region->end_addr);
 
         /* Ensure we're working with page aligned addresses */
-        uintptr_t first_page = PAGE_ALIGN(mem_regions[i].start_addr);
-        uintptr_t end_page   = PAGE_ALIGN_DOWN(mem_regions[i].end_addr);
+        uintptr_t addr = PAGE_ALIGN(region->start_addr);
+        uintptr_t end  = PAGE_ALIGN_DOWN(region->end_addr);
+
+        while(addr < end) {
+            while(res < bootmem_reserved.count &&
+                  bootmem_reserved.regions[res].end_addr <= addr) {
+                res++;
+            }
+
+            if(res < bootmem_reserved.count &&
+               bootmem_reserved.regions[res].start_addr < addr + PAGE_SIZE) {
+                addr = PAGE_ALIGN(bootmem_reserved.regions[res].end_addr);
+                continue;
+            }
+
+            uint32_t pfn = PA_TO_PFN(addr);
+            if(pfn >= highest_pfn)
+                break;
+
+            /* Remove the INVALID flag and hand the page to the allocator */
+            struct page * page = page_from_pfn(pfn);
+            CLEAR_BIT(page->flags, PF_INVALID);
+            page_initial_free(page);
 
-        /* For each page in this memory section, mark it as free */
-        for(; first_page < end_page; first_page += PAGE_SIZE) {
+            freed_pages++;
+            addr += PAGE_SIZE;
+        }
+    }
 
-            /* Retrieve a handle to the buddy page */
-            uint32_t pfn = PA_TO_PFN(first_page);
+    /* Memory above 4GB can't overlap any reserved region, so is freed as
+     * a whole */
+    for(uint32_t i = 0; i < pfn_range_count; i++) {
+        for(uint32_t pfn = pfn_ranges[i].start_pfn;
+            pfn < pfn_ranges[i].end_pfn && pfn < highest_pfn; pfn++) {
             struct page * page = page_from_pfn(pfn);
-
-            /* Remove the INVALID flag */
             CLEAR_BIT(page->flags, PF_INVALID);
-
             page_initial_free(page);
-
             freed_pages++;
         }
     }
 
+    /* Flag pages the kernel has reserved, leaving firmware areas alone */
+    for(uint32_t i = 0; i < bootmem_reserved.count; i++) {
+        struct mem_region * region = &bootmem_reserved.regions[i];
+        if(TEST_BIT(region->flags, MEM_REGION_F_FIRMWARE))
+            continue;
+
+        uintptr_t addr = PAGE_ALIGN_DOWN(region->start_addr);
+        for(; addr < region->end_addr; addr += PAGE_SIZE) {
+            if(PA_TO_PFN(addr) >= highest_pfn)
+                break;
+            SET_BIT(page_from_pfn(PA_TO_PFN(addr))->flags, PF_KERNEL);
+        }
+    }
+
     klog("bootmem_mark_free(): Freed %d pages of %d total\n",
                       freed_pages, highest_pfn);
 
-    klog("\n");
-    // paging_print_debug();
     klog("\n");
     buddy_print_debug();
     klog("\n");
@@ -130,39 +420,18 @@ int32_t bootmem_mark_free() {
  * called by architecture-specific code, such as the Multiboot processing code
  * on x86, which makes use of memory maps passed through by GRUB.
  *
- * This function will also ensure that memory regions containing kernel code
- * are adjusted to avoid the kernel code region, but preserve the other areas.
+ * Available regions are added to the usable memory list, and if they contain
+ * the kernel image, it is reserved. Reserved regions are added to the
+ * reserved list, so that overlapping available regions reported by buggy
+ * firmware are not used.
  *
  * Return: E_SUCCESS on success, E_ERROR on failure.
  */
 int32_t bootmem_add_mem_region(uintptr_t start_addr, uintptr_t end_addr,
                                uint32_t type) {
-    /* Ensure we're working with page aligned addresses - align down for the
-     * end address so we don't end up including a bit more space than we were
-     * allowed to as a side effect */
-    start_addr = PAGE_ALIGN(start_addr);
-    end_addr   = PAGE_ALIGN_DOWN(end_addr);
-    uintptr_t kernel_start = PAGE_ALIGN(&KERNEL_PHYS_START);
-    uintptr_t kernel_end   = PAGE_ALIGN(&KERNEL_PHYS_END);
-
     klog("add_region(): Request w/ start_addr: 0x%x, end_addr: 0x%x\n",
          start_addr, end_addr);
 
-    /* Check whether we have space in the memory region array */
-    if(region_count == MAX_MEM_REGIONS) {
-        klog("add_region(): No space left in region array!\n");
-        return E_ERROR;
-    }
-
-    klog("start_addr: 0x%x kernel_start: 0x%x end_addr: 0x%x kernel_end: 0x%x\n",
-            start_addr, kernel_start, end_addr, kernel_end);
-
-    /* Check if the region is entirely within kernel memory */
-    if(start_addr >= kernel_start && end_addr < kernel_end) {
-        klog("add_region(): Region entirely in kernel memory!\n");
-        return E_ERROR;
-    }
-
     /* Ensure a valid type has been provided */
     if(type != MEM_REGION_RESERVED && type != MEM_REGION_AVAILABLE) {
         klog("add_region(): Invalid type (%d) provided!\n", type);
@@ -170,31 +439,34 @@ int32_t bootmem_add_mem_region(uintptr_t start_addr, uintptr_t end_addr,
     }
 
     /* Validate start and end addresses are in order */
-    if(start_addr > end_addr) {
+    if(start_addr >= end_addr) {
         klog("add_region(): Start/end addresses are not in order\n");
         return E_ERROR;
     }
 
+    if(type == MEM_REGION_RESERVED) {
+        /* Round outwards, so that no part of the region is ever used */
+        return bootmem_region_add(&bootmem_reserved,
+                                  PAGE_ALIGN_DOWN(start_addr),
+                                  PAGE_ALIGN(end_addr),
+                                  MEM_REGION_F_FIRMWARE);
+    }
+
+    /* Round inwards, so that we don't end up including a bit more space
+     * than we were allowed to as a side effect */
+    start_addr = PAGE_ALIGN(start_addr);
+    end_addr   = PAGE_ALIGN_DOWN(end_addr);
+
     /* Ensure the region is of valid size */
-    if((start_addr == end_addr) ||
-       (end_addr - start_addr < PAGE_SIZE)) {
+    if(start_addr >= end_addr) {
         klog("add_region(): Region is of invalid size!\n");
         return E_ERROR;
     }
 
-    /* Ensure that the provided memory region does not overlap with the kernel
-     * image in memory - if it does, we can adjust its bounds so it doesn't */
-   if (start_addr < kernel_start && end_addr > kernel_end) {
-        klog("add_region(): Region surrounds kernel memory, splitting..\n");
-        bootmem_add_mem_region(start_addr, kernel_start, type);
-        bootmem_add_mem_region(kernel_end, end_addr, type);
-        return E_SUCCESS;
-    } else if (start_addr < kernel_start && end_addr > kernel_start) {
-        klog("add_region(): Overlaps at beginning of kernel memory\n");
-        end_addr = kernel_start;
-    } else if (start_addr < kernel_end && end_addr > kernel_end) {
-        klog("add_region(): Overlaps at end of kernel memory\n");
-        start_addr = kernel_end;
+    if(!SUCCESS(bootmem_region_add(&bootmem_memory, start_addr, end_addr,
+                                   MEM_REGION_F_NONE))) {
+        klog("add_region(): Ran out of memory regions!\n");
+        return E_ERROR;
     }
 
     /* Keep a record of the highest page number, so we know how much memory
@@ -205,26 +477,51 @@ int32_t bootmem_add_mem_region(uintptr_t start_addr, uintptr_t end_addr,
         highest_pfn = pfn;
     }
 
-    klog("add_region(): Adding region: 0x%x -> 0x%x\n",
-                      start_addr, end_addr);
-
-    /* Find a free memory region in the array and update it */
-    for(uint32_t i = 0; i < MAX_MEM_REGIONS; i++) {
-        if(mem_regions[i].start_addr == 0x00) {
-            memset(&mem_regions[i], 0, sizeof(struct mem_region));
-            mem_regions[i].start_addr = start_addr;
-            mem_regions[i].end_addr   = end_addr;
-            mem_regions[i].type       = type;
-            mem_regions[i].orig_start_addr = start_addr;
-            klog("add_region(): New region ID: %d\n", i);
-            region_count++;
-            return E_SUCCESS;
-        }
+    /* Ensure the kernel image is never handed out */
+    uintptr_t kernel_start = PAGE_ALIGN_DOWN(&KERNEL_PHYS_START);
+    uintptr_t kernel_end   = PAGE_ALIGN(&KERNEL_PHYS_END);
+    if(start_addr < kernel_end && end_addr > kernel_start) {
+        klog("add_region(): Region contains kernel, reserving it..\n");
+        bootmem_reserve(kernel_start, kernel_end);
     }
 
-    /* If we've run out of memory regions in the array, return an error */
-    klog("add_region(): Ran out of memory regions!\n");
-    return E_ERROR;
+    klog("add_region(): Added region: 0x%x -> 0x%x\n", start_addr, end_addr);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_reserve() - Prevent a range of memory from being used.
+ * @start_addr: The start of the range.
+ * @end_addr:   The end of the range (exclusive).
+ *
+ * Reserved memory is never returned by bootmem_alloc(), and is not handed to
+ * the page allocator by bootmem_mark_free().
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t bootmem_reserve(uintptr_t start_addr, uintptr_t end_addr) {
+    klog("bootmem_reserve(): Reserving 0x%x -> 0x%x\n", start_addr, end_addr);
+    return bootmem_region_add(&bootmem_reserved, start_addr, end_addr,
+                              MEM_REGION_F_NONE);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_set_limits() - Set the range of memory allocations are made from.
+ * @low:  The lowest physical address that may be allocated.
+ * @high: The physical address allocations must end below.
+ *
+ * The upper limit must not exceed the memory mapped by the kernel, as
+ * allocations are returned as virtual addresses.
+ */
+void bootmem_set_limits(uintptr_t low, uintptr_t high) {
+    klog("bootmem_set_limits(): Allocating from 0x%x -> 0x%x\n", low, high);
+    limit_low  = low;
+    limit_high = high;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -235,17 +532,8 @@ int32_t bootmem_add_mem_region(uintptr_t start_addr, uintptr_t end_addr,
  * @alignment: The alignment requirement for the allocated memory.
  *
  * Allocates memory from the bootmem pool, considering the specified alignment.
- * Iterates through each registered memory region to find a region that has
- * sufficient available memory and satisfies the alignment constraint.
- *
- * The function ensures that the returned memory address is aligned to the
- * specified alignment value by adjusting the starting address of the memory
- * region if necessary.
- *
- * If a suitable region is found, the region's starting address is updated to
- * reflect the allocated space, and a virtual address pointer to the allocated
- * memory is returned. If no region can satisfy the request, the function
- * returns `NULL`.
+ * The highest suitably aligned free range within the allocation limits is
+ * used, and reserved.
  *
  * Return: A pointer to the allocated memory if successful, or `NULL` if no
  *         memory was available to sufficiently fulfill the request.
@@ -253,31 +541,112 @@ int32_t bootmem_add_mem_region(uintptr_t start_addr, uintptr_t end_addr,
 void * bootmem_alloc(size_t size, size_t alignment) {
     klog("bootmem_alloc(): %d bytes requested with %d alignment\n", size, alignment);
 
-    for (uint32_t i = 0; i < MAX_MEM_REGIONS; i++) {
-        if (mem_regions[i].type != MEM_REGION_AVAILABLE)
-            continue;
+    uintptr_t addr;
+    if(!SUCCESS(bootmem_find_range(size, alignment, &addr)) ||
+       !SUCCESS(bootmem_reserve(addr, addr + size))) {
+        klog("bootmem_alloc(): No regions could satisfy request!\n");
+        return NULL;
+    }
 
-        uintptr_t aligned_start = ALIGN(mem_regions[i].start_addr, alignment);
-        if (aligned_start >= mem_regions[i].end_addr)
-            continue; // Skip if alignment exceeds region bounds
+    klog("bootmem_alloc(): Returning allocation at %x\n", PHY_TO_VIR(addr));
+    return PHY_TO_VIR(addr);
+}
 
-        uintptr_t region_size = mem_regions[i].end_addr - aligned_start;
+/* ------------------------------------------------------------------------- */
 
-        if (region_size >= size) {
-            void *alloc_start = (void *)aligned_start;
-            mem_regions[i].start_addr = aligned_start + size;
+/**
+ * bootmem_alloc_temp() - Allocate memory that is only needed during boot.
+ * @size: The amount of memory to be allocated.
+ *
+ * As with bootmem_alloc(), but the allocation is reserved with the TEMP flag
+ * so that it can be given to the page allocator by bootmem_release_temp()
+ * once boot completes. Temporary allocations are page aligned and rounded up
+ * to whole pages, so that they never share a page with a permanent
+ * allocation.
+ *
+ * Return: A pointer to the allocated memory if successful, or `NULL` if no
+ *         memory was available to sufficiently fulfill the request.
+ */
+void * bootmem_alloc_temp(size_t size) {
+    size = PAGE_ALIGN(size);
+
+    uintptr_t addr;
+    if(!SUCCESS(bootmem_find_range(size, PAGE_SIZE, &addr)) ||
+       !SUCCESS(bootmem_region_add(&bootmem_reserved, addr, addr + size,
+                                   MEM_REGION_F_TEMP))) {
+        klog("bootmem_alloc_temp(): No regions could satisfy request!\n");
+        return NULL;
+    }
 
-            klog("bootmem_alloc(): Returning allocation at %x\n",
-                  PHY_TO_VIR(alloc_start));
-            return PHY_TO_VIR(alloc_start);
-        }
+    return PHY_TO_VIR(addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * bootmem_release_temp() - Release all temporary bootmem allocations.
+ *
+ * Gives the pages of each allocation made with bootmem_alloc_temp() to the
+ * page allocator, and removes their reservations. Must only be called once
+ * the page allocator is initialised and no users of the temporary
+ * allocations remain.
+ *
+ * Return: The number of pages released.
+ */
+uint32_t bootmem_release_temp() {
+    uint32_t released = 0;
+
+    for(uint32_t i = 0; i < bootmem_reserved.count; i++) {
+        struct mem_region * region = &bootmem_reserved.regions[i];
+        if(!TEST_BIT(region->flags, MEM_REGION_F_TEMP))
+            continue;
+
+        released += page_release_range(region->start_addr, region->end_addr);
+        bootmem_region_delete(&bootmem_reserved, i);
+        i--;
     }
 
-    klog("bootmem_alloc(): No regions could satisfy request!\n");
-    return NULL;
+    return released;
 }
 
+/* ------------------------------------------------------------------------- */
 
+/**
+ * bootmem_add_pfn_range() - Register available memory by page frame number.
+ * @start_pfn: The first page frame of the range.
+ * @end_pfn:   The page frame after the last one in the range.
+ *
+ * Used by architecture-specific code for memory which a struct mem_region
+ * can't describe, such as memory above 4GB with PAE. Such memory isn't
+ * directly mapped, so bootmem never allocates from it, but it is handed to
+ * the page allocator as highmem by bootmem_mark_free().
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t bootmem_add_pfn_range(uint32_t start_pfn, uint32_t end_pfn) {
+    klog("add_pfn_range(): Request w/ start_pfn: 0x%x, end_pfn: 0x%x\n",
+         start_pfn, end_pfn);
+
+    if(start_pfn >= end_pfn) {
+        klog("add_pfn_range(): Start/end PFNs are not in order\n");
+        return E_ERROR;
+    }
+
+    if(pfn_range_count >= BOOTMEM_PFN_RANGES) {
+        klog("add_pfn_range(): Ran out of PFN ranges!\n");
+        return E_ERROR;
+    }
+
+    pfn_ranges[pfn_range_count].start_pfn = start_pfn;
+    pfn_ranges[pfn_range_count].end_pfn   = end_pfn;
+    pfn_range_count++;
+
+    if(end_pfn > highest_pfn) {
+        highest_pfn = end_pfn;
+    }
+
+    return E_SUCCESS;
+}
 
 /* ------------------------------------------------------------------------- */
 
@@ -287,14 +656,30 @@ void * bootmem_alloc(size_t size, size_t alignment) {
  * Primarily intended for test code that may require resetting of the bootmem
  * allocator, while not actually being a bootmem test, and therefore does not
  * have direct access to bootmem variables and data structures. For example,
- * the buddy allocator test suite will want to ensure that bootmem is reset 
- * for each unit test, as buddy_init() requests memory from bootmem to store 
+ * the buddy allocator test suite will want to ensure that bootmem is reset
+ * for each unit test, as buddy_init() requests memory from bootmem to store
  * its page structures.
  */
 void bootmem_reset() {
-    memset(mem_regions, 0, sizeof(mem_regions));
-    highest_pfn  = 0;
-    region_count = 0;
+    memset(memory_init, 0, sizeof(memory_init));
+    memset(reserved_init, 0, sizeof(reserved_init));
+
+    bootmem_memory.regions   = memory_init;
+    bootmem_memory.count     = 0;
+    bootmem_memory.max       = BOOTMEM_INIT_REGIONS;
+    bootmem_memory.dynamic   = false;
+
+    bootmem_reserved.regions = reserved_init;
+    bootmem_reserved.count   = 0;
+    bootmem_reserved.max     = BOOTMEM_INIT_REGIONS;
+    bootmem_reserved.dynamic = false;
+
+    memset(pfn_ranges, 0, sizeof(pfn_ranges));
+    pfn_range_count = 0;
+
+    limit_low   = BOOTMEM_LIMIT_LOW;
+    limit_high  = BOOTMEM_LIMIT_EARLY;
+    highest_pfn = 0;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -310,22 +695,29 @@ uint32_t bootmem_highest_pfn() {
 
 /* ------------------------------------------------------------------------- */
 
+static void bootmem_print_list(struct mem_region_list * list) {
+    klog("%s: %d of %d regions%s\n", list->name, list->count, list->max,
+         list->dynamic ? " (grown)" : "");
+    for(uint32_t i = 0; i < list->count; i++) {
+        klog("  [%d] 0x%x -> 0x%x (flags: 0x%x)\n", i,
+             list->regions[i].start_addr, list->regions[i].end_addr,
+             list->regions[i].flags);
+    }
+}
+
 /**
  * bootmem_print_debug() - Print debug information about bootmem.
  */
 void bootmem_print_debug() {
     klog("--- Bootmem Info ---\n");
-    klog("Memory Regions:      %d\n", region_count);
     klog("Highests Phys. Addr: 0x%x\n", PFN_TO_PA(highest_pfn));
-    for(uint32_t i = 0; i < MAX_MEM_REGIONS; i++) {
-        if(mem_regions[i].start_addr != 0x00) {
-            uintptr_t bytes_used = mem_regions[i].start_addr -
-                                   mem_regions[i].orig_start_addr;
-            klog("Region[%d]: 0x%x -> 0x%x (%d bytes alloced.)\n",
-                              i, mem_regions[i].start_addr,
-                              mem_regions[i].end_addr,
-                              bytes_used);
-        }
+    klog("Alloc. Limits:       0x%x -> 0x%x\n", limit_low, limit_high);
+    bootmem_print_list(&bootmem_memory);
+    bootmem_print_list(&bootmem_reserved);
+
+    for(uint32_t i = 0; i < pfn_range_count; i++) {
+        klog("pfn range [%d]: 0x%x -> 0x%x\n", i, pfn_ranges[i].start_pfn,
+             pfn_ranges[i].end_pfn);
     }
 }
 
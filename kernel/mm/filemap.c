@@ -0,0 +1,124 @@
+/*
+ * kernel/mm/filemap.c
+ * File-backed Mappings
+ *
+ * A file-backed mapping has the file's inode as its private data, and the
+ * offset into the file of its start. Faults read the file's contents into a
+ * newly allocated page through the inode's read operation, along with the
+ * rest of the fault window, so that a file read sequentially takes one fault
+ * per window. Any part of a page beyond the end of the file is zeroed.
+ *
+ * The mappings are private. Once read in, the pages are the mapping's own,
+ * and are shared copy-on-write with forked address spaces in the same way as
+ * anonymous memory. Writes are never written back to the file, which the VFS
+ * has no way to do.
+ *
+ * The inode must remain valid for as long as the mapping exists.
+ */
+
+#include <rotary/mm/filemap.h>
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * filemap_read_page() - Read the contents of a page of a file-backed mapping.
+ * @map:       The mapping.
+ * @page:      The page to read into, which may be highmem.
+ * @virt_addr: The address within the mapping that the page is for.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the file couldn't be read or the
+ *         page couldn't be mapped into kernel space.
+ */
+int32_t filemap_read_page(struct vm_map * map, struct page * page,
+                          void * virt_addr) {
+    struct inode * inode = map->private;
+    uint32_t offset = map->offset + (virt_addr - map->start_addr);
+
+    if(!inode->ops->read) {
+        return E_ERROR;
+    }
+
+    /* The read may take a while, so the page isn't mapped atomically */
+    void * buf = kmap(page);
+    if(!buf) {
+        return E_ERROR;
+    }
+
+    int32_t count = inode->ops->read(inode, buf, offset, PAGE_SIZE);
+    if(count >= 0 && count < PAGE_SIZE) {
+        memset(buf + count, 0, PAGE_SIZE - count);
+    }
+
+    kunmap(page);
+
+    if(count < 0) {
+        klog("filemap_read_page(): Failed to read offset 0x%x of inode 0x%x\n",
+             offset, inode);
+        return E_ERROR;
+    }
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int32_t vm_file_fill(struct page * page, void * virt_addr,
+                            void * private) {
+    return filemap_read_page(private, page, virt_addr);
+}
+
+static int32_t vm_file_map_pages(struct vm_map * map, void * start_addr,
+                                 void * end_addr) {
+    return ptable_populate_fill(PHY_TO_VIR(map->space->pgd), start_addr,
+                                end_addr, map->flags, vm_file_fill, map);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int32_t vm_file_fault(struct vm_map * map, void * addr,
+                             flags_t fault_flags) {
+    void * page_addr = (void*)PAGE_ALIGN_DOWN(addr);
+    void * start;
+    void * end;
+
+    if(!SUCCESS(vm_file_map_pages(map, page_addr, page_addr + PAGE_SIZE))) {
+        return E_ERROR;
+    }
+
+    /* The rest of the window is best effort, so running out of memory here
+     * isn't an error */
+    vm_space_fault_window(map, addr, &start, &end);
+    vm_file_map_pages(map, start, end);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The pages are private, so are shared copy-on-write by vm_space_fork() */
+static int32_t vm_file_page_mkwrite(struct vm_map * map, void * addr) {
+    return ptable_cow_fault(PHY_TO_VIR(map->space->pgd), addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void vm_file_close(struct vm_map * map) {
+    ptable_unmap_many(PHY_TO_VIR(map->space->pgd), map->start_addr,
+                      (map->end_addr - map->start_addr) / PAGE_SIZE, 1);
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct vm_ops vm_file_ops = {
+    .fault        = vm_file_fault,
+    .map_pages    = vm_file_map_pages,
+    .page_mkwrite = vm_file_page_mkwrite,
+    .close        = vm_file_close
+};
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/filemap.c"
+
+/* ------------------------------------------------------------------------- */
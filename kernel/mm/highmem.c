@@ -0,0 +1,261 @@
+/*
+ * kernel/mm/highmem.c
+ * Highmem Temporary Mappings
+ *
+ * Only physical memory below LOWMEM_PLIMIT is permanently mapped into kernel
+ * space, from KERNEL_START_VIRT up to KMAP_START_VIRT. Pages above it are
+ * highmem, and must be mapped into the kmap() area, whose page tables were
+ * allocated along with the kernel PGD, before the kernel can touch them.
+ * Every PGD shares those page tables, so a kmap() mapping is visible in any
+ * address space.
+ *
+ * kmap() maps a page into one of KMAP_SLOTS shared slots until kunmap() is
+ * called. Slots are counted, so a page mapped twice shares a slot, and left
+ * mapped once their count drops to zero. The TLB entry of a slot is only
+ * invalidated when it is reused for a different page.
+ *
+ * kmap_atomic() is cheaper, taking the next of a few slots reserved for the
+ * current CPU, with interrupts disabled until the matching kunmap_atomic().
+ * Atomic mappings must be released in the reverse order they were taken.
+ *
+ * Lowmem pages are returned at their direct mapped address by both, so code
+ * that needs to touch the contents of any page can use them unconditionally.
+ */
+
+#include <rotary/mm/highmem.h>
+
+/* ------------------------------------------------------------------------- */
+
+struct kmap_slot kmap_slots[KMAP_SLOTS];
+uint32_t kmap_next = 0;
+
+volatile atomic_flag kmap_lock = ATOMIC_FLAG_INIT;
+
+/* Statistics */
+uint32_t kmap_hits   = 0; /* Page was already mapped by a slot */
+uint32_t kmap_misses = 0;
+uint32_t kmap_fails  = 0; /* No slot was free */
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * kmap_pte() - Find the kernel page table entry for a kmap() area address.
+ * @virt_addr: An address within the kmap() area.
+ *
+ * Return: A pointer to the page table entry.
+ */
+static struct pte * kmap_pte(void * virt_addr) {
+    struct pde * pde = GET_PDE(paging_kernel_pgd(), virt_addr);
+    return GET_PTE(PDE_TO_PGT(pde), virt_addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * kmap() - Map a page into kernel space.
+ * @page: The page to map.
+ *
+ * Must be balanced by a call to kunmap(). The mapping can be held across
+ * task switches, but as there are only KMAP_SLOTS slots, it shouldn't be
+ * held for longer than needed.
+ *
+ * Return: The virtual address the page is mapped at, or NULL if every kmap()
+ *         slot is in use.
+ */
+void * kmap(struct page * page) {
+    if(!PAGE_IS_HIGHMEM(page)) {
+        return PAGE_VA(page);
+    }
+
+    lock(&kmap_lock);
+
+    for(uint32_t i = 0; i < KMAP_SLOTS; i++) {
+        if(kmap_slots[i].page == page) {
+            kmap_slots[i].count++;
+            kmap_hits++;
+            unlock(&kmap_lock);
+            return KMAP_SLOT_ADDR(i);
+        }
+    }
+
+    /* Start searching after the last slot taken, so that recently released
+     * mappings are reused last */
+    for(uint32_t n = 0; n < KMAP_SLOTS; n++) {
+        uint32_t i = (kmap_next + n) % KMAP_SLOTS;
+        struct kmap_slot * slot = &kmap_slots[i];
+
+        if(slot->count) {
+            continue;
+        }
+
+        void * virt_addr = KMAP_SLOT_ADDR(i);
+        *kmap_pte(virt_addr) = MAKE_PTE_PFN(page->pfn, PTE_PRESENT |
+                                                       PTE_WRITABLE);
+        if(slot->page) {
+            paging_inval_tlb_entry(virt_addr);
+        }
+
+        slot->page  = page;
+        slot->count = 1;
+        kmap_next   = (i + 1) % KMAP_SLOTS;
+        kmap_misses++;
+
+        unlock(&kmap_lock);
+        return virt_addr;
+    }
+
+    kmap_fails++;
+    unlock(&kmap_lock);
+
+    klog("kmap(): No free slot to map PFN 0x%x\n", page->pfn);
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * kunmap() - Release a mapping made by kmap().
+ * @page: The page that was mapped.
+ */
+void kunmap(struct page * page) {
+    if(!PAGE_IS_HIGHMEM(page)) {
+        return;
+    }
+
+    lock(&kmap_lock);
+
+    for(uint32_t i = 0; i < KMAP_SLOTS; i++) {
+        if(kmap_slots[i].page == page && kmap_slots[i].count) {
+            kmap_slots[i].count--;
+            unlock(&kmap_lock);
+            return;
+        }
+    }
+
+    unlock(&kmap_lock);
+    klog("kunmap(): PFN 0x%x is not mapped\n", page->pfn);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * kmap_atomic() - Map a page into kernel space, for a short time.
+ * @page: The page to map.
+ *
+ * Interrupts are disabled until every atomic mapping taken on this CPU has
+ * been released, so the caller must not sleep or switch tasks before calling
+ * kunmap_atomic(). Requires the per-CPU data to have been set up.
+ *
+ * Return: The virtual address the page is mapped at.
+ */
+void * kmap_atomic(struct page * page) {
+    if(!PAGE_IS_HIGHMEM(page)) {
+        return PAGE_VA(page);
+    }
+
+    uint32_t eflags = cpu_irq_save();
+    struct cpu_info * cpu = cpu_get_local();
+
+    if(cpu->kmap_atomic_depth >= KMAP_ATOMIC_DEPTH) {
+        PANIC("kmap_atomic(): Too many nested atomic mappings!\n");
+    }
+
+    if(cpu->kmap_atomic_depth == 0) {
+        cpu->kmap_atomic_eflags = eflags;
+    }
+
+    /* The slot's TLB entry was invalidated when it was last released */
+    void * virt_addr = KMAP_ATOMIC_ADDR(cpu->cpu_id, cpu->kmap_atomic_depth);
+    *kmap_pte(virt_addr) = MAKE_PTE_PFN(page->pfn, PTE_PRESENT | PTE_WRITABLE);
+    cpu->kmap_atomic_depth++;
+
+    return virt_addr;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * kunmap_atomic() - Release the most recent mapping made by kmap_atomic().
+ * @virt_addr: The address returned by kmap_atomic().
+ */
+void kunmap_atomic(void * virt_addr) {
+    uintptr_t addr = (uintptr_t)virt_addr;
+    if(addr < KMAP_ATOMIC_START ||
+       addr >= (uintptr_t)KMAP_ATOMIC_ADDR(KMAP_ATOMIC_CPUS, 0)) {
+        /* A lowmem page, which was never mapped */
+        return;
+    }
+
+    struct cpu_info * cpu = cpu_get_local();
+    void * expected = KMAP_ATOMIC_ADDR(cpu->cpu_id,
+                                       cpu->kmap_atomic_depth - 1);
+
+    if(cpu->kmap_atomic_depth == 0 ||
+       (void*)PAGE_ALIGN_DOWN(virt_addr) != expected) {
+        PANIC("kunmap_atomic(): Mappings released out of order!\n");
+    }
+
+    *kmap_pte(expected) = (struct pte){ .entry = 0 };
+    paging_inval_tlb_entry(expected);
+
+    if(--cpu->kmap_atomic_depth == 0) {
+        cpu_irq_restore(cpu->kmap_atomic_eflags);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * highmem_zero_page() - Zero the contents of a page.
+ * @page: The page, which may be highmem.
+ */
+void highmem_zero_page(struct page * page) {
+    void * virt_addr = kmap_atomic(page);
+    memset(virt_addr, 0, PAGE_SIZE);
+    kunmap_atomic(virt_addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * highmem_copy_page() - Copy the contents of one page to another.
+ * @dest: The page to copy to, which may be highmem.
+ * @src:  The page to copy from, which may be highmem.
+ */
+void highmem_copy_page(struct page * dest, struct page * src) {
+    void * dest_addr = kmap_atomic(dest);
+    void * src_addr  = kmap_atomic(src);
+    memcpy(dest_addr, src_addr, PAGE_SIZE);
+    kunmap_atomic(src_addr);
+    kunmap_atomic(dest_addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * highmem_print_debug() - Print kmap() slot usage and statistics.
+ */
+void highmem_print_debug() {
+    uint32_t used   = 0;
+    uint32_t cached = 0;
+
+    for(uint32_t i = 0; i < KMAP_SLOTS; i++) {
+        if(kmap_slots[i].count) {
+            used++;
+        } else if(kmap_slots[i].page) {
+            cached++;
+        }
+    }
+
+    printk(LOG_DEBUG, "kmap slots: %d in use, %d cached, %d total\n",
+           used, cached, KMAP_SLOTS);
+    printk(LOG_DEBUG, "kmap hits: %d, misses: %d, failures: %d\n",
+           kmap_hits, kmap_misses, kmap_fails);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/highmem.c"
+
+/* ------------------------------------------------------------------------- */
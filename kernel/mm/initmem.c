@@ -0,0 +1,61 @@
+/*
+ * kernel/mm/initmem.c
+ * Boot-only Memory Release
+ *
+ * Code and data only used during boot is marked __init or __initdata, and is
+ * collected by the linker into the page aligned .init section. Likewise, the
+ * kernel unit tests are collected into the .ktest section, and some boot
+ * memory is allocated with bootmem_alloc_temp().
+ *
+ * None of this is needed once boot has completed, so free_initmem() gives
+ * these pages to the page allocator. The unit tests are kept if
+ * KERNEL_KTEST_RESIDENT is set, so that they can still be run from the shell.
+ */
+
+#include <rotary/mm/initmem.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Symbols marking the page aligned sections, provided by the linker script */
+extern char __init_start[];
+extern char __init_end[];
+extern char __ktest_start[];
+extern char __ktest_end[];
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * free_initmem() - Release boot-only memory to the page allocator.
+ *
+ * Must only be called once no code marked __init can run again, and no
+ * references remain to __initdata or temporary bootmem allocations.
+ *
+ * Return: The number of pages released.
+ */
+uint32_t free_initmem() {
+    uint32_t init_pages  = 0;
+    uint32_t ktest_pages = 0;
+    uint32_t temp_pages  = 0;
+
+    init_pages = page_release_range((uintptr_t)VIR_TO_PHY(__init_start),
+                                    (uintptr_t)VIR_TO_PHY(__init_end));
+
+#if !KERNEL_KTEST_RESIDENT
+    ktest_release();
+    ktest_pages = page_release_range((uintptr_t)VIR_TO_PHY(__ktest_start),
+                                     (uintptr_t)VIR_TO_PHY(__ktest_end));
+#endif
+
+    temp_pages = bootmem_release_temp();
+
+    uint32_t total = init_pages + ktest_pages + temp_pages;
+    klog("free_initmem(): Freed %d KB (init: %d KB, ktest: %d KB, "
+         "bootmem: %d KB)\n", total * (PAGE_SIZE / SIZE_1K),
+         init_pages * (PAGE_SIZE / SIZE_1K),
+         ktest_pages * (PAGE_SIZE / SIZE_1K),
+         temp_pages * (PAGE_SIZE / SIZE_1K));
+
+    return total;
+}
+
+/* ------------------------------------------------------------------------- */
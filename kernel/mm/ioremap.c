@@ -0,0 +1,200 @@
+/*
+ * kernel/mm/ioremap.c
+ * Device Memory Mappings
+ *
+ * Framebuffers and MMIO registers need a memory type other than the default
+ * write-back. Framebuffers are best written through write-combining, which
+ * merges writes into bursts, while MMIO registers must be uncached, so that
+ * every access reaches the device in order.
+ *
+ * ioremap() maps a range of physical memory into kernel space with the memory
+ * type requested by its VM_MAP_* flags, using the page tables shared by every
+ * PGD in the kmap() area. Regions are allocated first-fit from IOREMAP_PAGES
+ * pages, with the length of each region stored against its first page so
+ * that iounmap() only needs the address.
+ *
+ * Device memory is mapped into user address spaces by mappings with VM_MAP_IO,
+ * whose offset is the physical address of their start. Their faults map the
+ * device's pages in place, so nothing is allocated, and their pages are never
+ * freed when unmapped.
+ */
+
+#include <rotary/mm/ioremap.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* Pages in the region starting at each index, or 0 if none starts there */
+uint16_t ioremap_lengths[IOREMAP_PAGES];
+uint8_t  ioremap_used[IOREMAP_PAGES];
+
+volatile atomic_flag ioremap_lock = ATOMIC_FLAG_INIT;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ioremap_find() - Find a run of unused pages.
+ * @count: The number of pages needed.
+ *
+ * Return: The index of the first page, or -1 if no run is long enough.
+ */
+static int32_t ioremap_find(uint32_t count) {
+    uint32_t run = 0;
+
+    for(uint32_t i = 0; i < IOREMAP_PAGES; i++) {
+        run = ioremap_used[i] ? 0 : run + 1;
+        if(run == count) {
+            return i + 1 - count;
+        }
+    }
+
+    return -1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ioremap() - Map device memory into kernel space.
+ * @phys_addr: The physical address of the memory, which needn't be aligned.
+ * @size:      The size of the memory, in bytes.
+ * @flags:     VM_MAP_WB, VM_MAP_WC, VM_MAP_WT or VM_MAP_UC.
+ *
+ * Without the PAT, VM_MAP_WC falls back to VM_MAP_UC.
+ *
+ * Return: The virtual address of phys_addr, or NULL if there was no room.
+ */
+void * ioremap(uintptr_t phys_addr, uint32_t size, flags_t flags) {
+    uintptr_t phys_start = PAGE_ALIGN_DOWN(phys_addr);
+    uint32_t  count = (PAGE_ALIGN(phys_addr + size) - phys_start) / PAGE_SIZE;
+
+    if(size == 0 || count > IOREMAP_PAGES) {
+        return NULL;
+    }
+
+    lock(&ioremap_lock);
+
+    int32_t idx = ioremap_find(count);
+    if(idx < 0) {
+        unlock(&ioremap_lock);
+        klog("ioremap(): No room to map %d pages at 0x%x\n", count,
+             phys_addr);
+        return NULL;
+    }
+
+    ptable_entry_t pte_flags = PTE_PRESENT | PTE_WRITABLE |
+                               ptable_cache_flags(flags);
+
+    for(uint32_t i = 0; i < count; i++) {
+        struct pte * pte = ptable_get_pte(paging_kernel_pgd(),
+                                          IOREMAP_ADDR(idx + i));
+        *pte = MAKE_PTE(phys_start + i * PAGE_SIZE, pte_flags);
+        ioremap_used[idx + i] = 1;
+    }
+    ioremap_lengths[idx] = count;
+
+    unlock(&ioremap_lock);
+
+    return IOREMAP_ADDR(idx) + (phys_addr - phys_start);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * iounmap() - Remove a mapping made by ioremap().
+ * @virt_addr: The address returned by ioremap().
+ */
+void iounmap(void * virt_addr) {
+    uint32_t idx = IOREMAP_IDX(virt_addr);
+
+    lock(&ioremap_lock);
+
+    if((uintptr_t)virt_addr < IOREMAP_START || idx >= IOREMAP_PAGES ||
+       ioremap_lengths[idx] == 0) {
+        unlock(&ioremap_lock);
+        klog("iounmap(): 0x%x was not mapped by ioremap()\n", virt_addr);
+        return;
+    }
+
+    uint32_t count = ioremap_lengths[idx];
+    for(uint32_t i = 0; i < count; i++) {
+        struct pte * pte = ptable_get_pte(paging_kernel_pgd(),
+                                          IOREMAP_ADDR(idx + i));
+        *pte = (struct pte){ .entry = 0 };
+        paging_inval_tlb_entry(IOREMAP_ADDR(idx + i));
+        ioremap_used[idx + i] = 0;
+    }
+    ioremap_lengths[idx] = 0;
+
+    unlock(&ioremap_lock);
+}
+
+/* ------------------------------------------------------------------------- */
+/* User Mappings                                                             */
+/* ------------------------------------------------------------------------- */
+
+static int32_t vm_device_map_pages(struct vm_map * map, void * start_addr,
+                                   void * end_addr) {
+    uintptr_t phys_addr = map->offset + (start_addr - map->start_addr);
+
+    ptable_map_many(PHY_TO_VIR(map->space->pgd), start_addr,
+                    (void*)phys_addr, (end_addr - start_addr) / PAGE_SIZE,
+                    map->flags);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int32_t vm_device_fault(struct vm_map * map, void * addr,
+                               flags_t fault_flags) {
+    void * start;
+    void * end;
+
+    /* Mapping more pages costs no memory, so the whole window is mapped */
+    vm_space_fault_window(map, addr, &start, &end);
+    return vm_device_map_pages(map, start, end);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void vm_device_close(struct vm_map * map) {
+    ptable_unmap_many(PHY_TO_VIR(map->space->pgd), map->start_addr,
+                      (map->end_addr - map->start_addr) / PAGE_SIZE, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Device memory is shared by vm_space_fork(), and is never copied on write,
+ * so needs no page_mkwrite */
+struct vm_ops vm_device_ops = {
+    .fault     = vm_device_fault,
+    .map_pages = vm_device_map_pages,
+    .close     = vm_device_close
+};
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ioremap_print_debug() - Print the current device memory mappings.
+ */
+void ioremap_print_debug() {
+    printk(LOG_DEBUG, "PAT: %s\n", paging_pat_enabled() ? "enabled" :
+                                                         "unavailable");
+
+    for(uint32_t i = 0; i < IOREMAP_PAGES; i++) {
+        if(!ioremap_lengths[i]) {
+            continue;
+        }
+
+        struct pte * pte = ptable_get_pte(paging_kernel_pgd(),
+                                          IOREMAP_ADDR(i));
+        printk(LOG_DEBUG, "0x%x -> 0x%x [%d pages, cache bits 0x%x]\n",
+               IOREMAP_ADDR(i), PAGE_FRAME(pte->entry), ioremap_lengths[i],
+               (uint32_t)(pte->entry & PTE_CACHE_MASK));
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/ioremap.c"
+
+/* ------------------------------------------------------------------------- */
@@ -30,6 +30,27 @@ slab_cache_t slab_caches[] = {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * kmalloc_init() - Register the kmalloc slab caches.
+ *
+ * Adds each of the kmalloc slab caches to the global list of caches so that
+ * their utilisation is reported by slab_info_show(), and exposes the table
+ * as the "slabinfo" pseudo file.
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t __init kmalloc_init() {
+    for(uint32_t i = 0; i < ARRAY_SIZE(slab_caches); i++) {
+        slab_cache_register(&slab_caches[i]);
+    }
+
+    return slab_info_init();
+}
+
+early_initcall(kmalloc_init);
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * kmalloc() - Allocate general purpose memory of a given size.
  * @size: The amount of bytes of memory to be allocated.
@@ -77,7 +98,7 @@ void * kmalloc(uint32_t size) {
  * Return: E_SUCCESS on success, E_ERROR on failure.
  */
 int32_t kfree(void * addr) {
-    for(uint32_t i = 0; i < 13; i++) {
+    for(uint32_t i = 0; i < ARRAY_SIZE(slab_caches); i++) {
         if(slab_cache_has_addr(&slab_caches[i], addr)) {
             slab_free(&slab_caches[i], addr);
             return E_SUCCESS;
@@ -93,7 +114,7 @@ int32_t kfree(void * addr) {
  * kmalloc_print_debug() - Print debug information about kmalloc slab caches.
  */
 void kmalloc_print_debug() {
-    for(uint32_t i = 0; i < 13; i++) {
+    for(uint32_t i = 0; i < ARRAY_SIZE(slab_caches); i++) {
         slab_cache_print_debug(&slab_caches[i]);
     }
 }
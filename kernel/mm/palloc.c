@@ -23,7 +23,8 @@ struct buddy_allocator buddy_allocator;
 /**
  * page_alloc() - Allocate a block of pages of a given order.
  * @order: The order of the block to allocate, block size is 2^order pages.
- * @flags: Reserved for future use.
+ * @flags: PR_* flags. Without PR_HIGHMEM, the block is always directly mapped
+ *         into kernel space, so can be accessed through PAGE_VA().
  *
  * Attempts to allocate a block of pages from the block list of the desired
  * order. If no blocks are available, it attempts to split a larger block by
@@ -31,6 +32,10 @@ struct buddy_allocator buddy_allocator;
  * recursively search for larger blocks to split until the maximum order is
  * reached.
  *
+ * Callers passing PR_HIGHMEM are given highmem when there is any, keeping
+ * low memory for those that need it. Once free memory falls below the low
+ * watermark, the reclaim task is woken to swap out pages.
+ *
  * Return: A pointer to a page object representing the allocated page(s),
  *         or NULL if the allocation was unsuccessful.
  */
@@ -46,35 +51,38 @@ struct page * page_alloc(uint32_t order, uint32_t flags) {
 
     lock(&buddy_allocator.lock);
 
-    /* Check whether there's any blocks of the desired order */
-    if(buddy_allocator.blocks[order].free_count == 0) {
-        /* Attempt to split a larger block */
-        buddy_split_block(order + 1);
-
-        /* If no blocks are free after splitting, abort */
-        if(buddy_allocator.blocks[order].free_count == 0) {
-            klog("No solution found, aborting!\n");
-            unlock(&buddy_allocator.lock);
-            return NULL;
-        }
+    struct page * block = NULL;
+    if(TEST_BIT(flags, PR_HIGHMEM)) {
+        block = buddy_take_block(order, PF_ZONE_HIGHMEM);
+    }
+    if(!block) {
+        block = buddy_take_block(order, PF_ZONE_LOWMEM);
     }
 
-    /* Retrieve the last block page entry in the order list and return it */
-    struct page * last_page = page_get_last(&buddy_allocator, order);
-    if(last_page != NULL) {
-        buddy_remove_block(last_page);
-        klog("page_alloc(): returning page %d (paddr 0x%x, vaddr 0x%x), "
-             "order %d\n", last_page->pfn, PFN_TO_PA(last_page->pfn),
-             PHY_TO_VIR(PFN_TO_PA(last_page->pfn)), order);
-        PAGE_INC_USES(last_page);
-        unlock(&buddy_allocator.lock);
-        return last_page;
-    } else {
-        klog("page_alloc(): failed to get last page from list w/ order %d!",
-             order);
+    if(!block) {
+        klog("No solution found, aborting!\n");
         unlock(&buddy_allocator.lock);
         return NULL;
     }
+
+    klog("page_alloc(): returning page %d (paddr 0x%x, vaddr 0x%x), "
+         "order %d\n", block->pfn, PFN_TO_PA(block->pfn),
+         PHY_TO_VIR(PFN_TO_PA(block->pfn)), order);
+    PAGE_INC_USES(block);
+    uint32_t free_pages = buddy_allocator.free_pages;
+    unlock(&buddy_allocator.lock);
+
+    /* Start reclaiming in the background before memory actually runs out */
+    if(free_pages < reclaim_wmark_low) {
+        reclaim_wake();
+    }
+
+    /* Dirty state harvested while the pages were last mapped is stale */
+    for(uint32_t i = 0; i < (1u << order); i++) {
+        CLEAR_BIT(block[i].flags, PF_DIRTY);
+    }
+
+    return block;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -128,6 +136,27 @@ int32_t page_free(struct page * current_page, int order) {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * page_split() - Break an allocated block into individually freeable pages.
+ * @page:  The first page of the allocated block.
+ * @order: The order of the block.
+ *
+ * A block must normally be freed as a whole, with the order it was allocated
+ * with. Once split, each of its pages is treated as a separate order 0
+ * allocation, and can be freed on its own with page_free(page, 0). Used when
+ * a huge page mapping is broken up into individual pages.
+ */
+void page_split(struct page * page, int order) {
+    lock(&buddy_allocator.lock);
+    for(uint32_t i = 1; i < (1U << order); i++) {
+        page[i].order     = ORDER_USED;
+        page[i].use_count = page->use_count;
+    }
+    unlock(&buddy_allocator.lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * page_initial_free() - Adds a page to the buddy allocator
  * @page: The page to add to the buddy allocator.
@@ -147,6 +176,44 @@ void page_initial_free(struct page * page) {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * page_release_range() - Give reserved boot memory to the buddy allocator.
+ * @start_addr: Physical start address of the range, rounded up to a page.
+ * @end_addr:   Physical end address of the range, rounded down to a page.
+ *
+ * Pages holding the kernel image or bootmem allocations are left INVALID and
+ * KERNEL by buddy_init() and bootmem_mark_free(). Once boot has completed,
+ * some of them are no longer needed (e.g. the .init section), and this
+ * function clears those flags and adds the pages to the buddy allocator.
+ *
+ * Return: The number of pages released.
+ */
+uint32_t page_release_range(uintptr_t start_addr, uintptr_t end_addr) {
+    uintptr_t addr = PAGE_ALIGN(start_addr);
+    uintptr_t end  = PAGE_ALIGN_DOWN(end_addr);
+    uint32_t  released = 0;
+
+    for(; addr < end; addr += PAGE_SIZE) {
+        uint32_t pfn = PA_TO_PFN(addr);
+        if(pfn >= buddy_allocator.page_count)
+            break;
+
+        struct page * page = page_from_pfn(pfn);
+        CLEAR_BIT(page->flags, PF_INVALID);
+        CLEAR_BIT(page->flags, PF_KERNEL);
+        page->use_count = 0;
+        page_initial_free(page);
+        released++;
+    }
+
+    klog("page_release_range(): Released %d pages (0x%x -> 0x%x)\n",
+         released, start_addr, end_addr);
+
+    return released;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * page_from_pfn() - Retrieve a page from its page frame number.
  * @pfn: The page frame number.
@@ -161,14 +228,58 @@ struct page * page_from_pfn(uint32_t pfn) {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * page_pfn_is_ram() - Returns whether a page frame is usable memory.
+ * @pfn: The page frame number.
+ *
+ * A page table entry may map something other than memory managed by the
+ * buddy allocator, such as device memory, which has no struct page.
+ *
+ * Return: 1 if the frame has a usable struct page, 0 otherwise.
+ */
+int32_t page_pfn_is_ram(uint32_t pfn) {
+    if(pfn >= buddy_allocator.page_count) {
+        return 0;
+    }
+
+    return TEST_BIT(page_from_pfn(pfn)->flags, PF_INVALID) ? 0 : 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * page_free_count() - Returns the number of free pages.
+ *
+ * Return: The number of pages held by the buddy allocator, in either zone.
+ */
+uint32_t page_free_count() {
+    return buddy_allocator.free_pages;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * page_total_count() - Returns the number of pages of physical memory.
+ *
+ * Return: The number of pages with a struct page, in either zone, including
+ *         any reserved.
+ */
+uint32_t page_total_count() {
+    return low_pages + high_pages;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * page_is_critical() - Returns whether a page contains critical kernel data.
  * @page: Pointer to the page to be checked.
  *
  * Determines whether the given page contains critical kernel data, such as
- * kernel code or any other data that must never be freed.
+ * kernel code or any other data that must never be freed. Such pages are
+ * marked with PF_KERNEL by buddy_init(), which is cleared by
+ * page_release_range() for boot-only memory once it is no longer needed.
  *
- * Return: 1 if the page contains the kernel, 0 if it does not.
+ * Return: E_ERROR if the page contains the kernel, E_SUCCESS if it does not.
  */
 int32_t page_is_critical(struct page * page) {
     if (!page) {
@@ -176,13 +287,9 @@ int32_t page_is_critical(struct page * page) {
         return E_ERROR;
     }
 
-    uintptr_t page_phys_addr = PFN_TO_PA(page->pfn);
-
-    /* Check if the page belongs to the kernel or the page structure area */
-    if (page_phys_addr >= (uintptr_t)&KERNEL_PHYS_START &&
-        page_phys_addr < (uintptr_t)&KERNEL_PHYS_END) {
+    if(TEST_BIT(page->flags, PF_KERNEL)) {
         klog("page_is_critical(): Page 0x%x belongs to kernel memory!\n",
-             page_phys_addr);
+             PFN_TO_PA(page->pfn));
         return E_ERROR;
     }
 
@@ -208,14 +315,19 @@ void * page_area_end() {
  * page_get_last() - Returns the last free page for a given order.
  * @allocator: The buddy allocator to retrieve the page from.
  * @order:     The order of the block to retrieve.
+ * @zone:      PF_ZONE_LOWMEM or PF_ZONE_HIGHMEM.
  *
  * Return: A pointer to the last free block, NULL if no blocks are available.
  */
-struct page * page_get_last(struct buddy_allocator * allocator, uint32_t order) {
+struct page * page_get_last(struct buddy_allocator * allocator, uint32_t order,
+                            uint32_t zone) {
     list_head_t * head = &allocator->blocks[order].free_pages;
+    if(zone == PF_ZONE_HIGHMEM) {
+        head = &allocator->blocks[order].free_high;
+    }
 
     /* Return NULL if no blocks are available */
-    if(head->prev == NULL) {
+    if(head->prev == NULL || head->prev == head) {
         return NULL;
     }
 
@@ -290,7 +402,9 @@ int32_t buddy_init(uint32_t highest_pfn) {
         klog("buddy_init(): Init. buddy allocator block list"
                           "for order 2^%d\n", i);
         clist_init(&buddy_allocator.blocks[i].free_pages);
+        clist_init(&buddy_allocator.blocks[i].free_high);
         buddy_allocator.blocks[i].free_count = 0;
+        buddy_allocator.blocks[i].high_count = 0;
     }
 
     /* Initialise each page structure - we'll initially mark them all as
@@ -309,8 +423,9 @@ int32_t buddy_init(uint32_t highest_pfn) {
         /* Mark the page as INVALID - bootmem will free as appropriate later */
         SET_BIT(page->flags, PF_INVALID);
 
-        /* Mark the page as high or low memory */
-        if(PFN_TO_PA(page->pfn) < LOWMEM_PLIMIT) {
+        /* Mark the page as high or low memory. The limit is aligned to the
+         * largest block, so no block ever spans both zones */
+        if(page->pfn < PA_TO_PFN(LOWMEM_PLIMIT)) {
             SET_BIT(page->flags, PF_ZONE_LOWMEM);
             low_pages++;
         } else {
@@ -318,11 +433,12 @@ int32_t buddy_init(uint32_t highest_pfn) {
             high_pages++;
         }
 
-        /* If the page contains kernel code or the page structs, mark it with
-         * the KERNEL flag */
+        /* If the page contains kernel code, mark it with the KERNEL flag.
+         * Other reserved memory, such as the page structs, is marked by
+         * bootmem_mark_free() */
         uintptr_t page_phys_addr = PFN_TO_PA(page->pfn);
         if(page_phys_addr >= (uintptr_t)&KERNEL_PHYS_START &&
-           page_phys_addr <  page_area_end) {
+           page_phys_addr <  (uintptr_t)&KERNEL_PHYS_END) {
             SET_BIT(page->flags, PF_KERNEL);
         }
 
@@ -340,14 +456,70 @@ int32_t buddy_init(uint32_t highest_pfn) {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * buddy_free_count() - Count the free blocks of an order within a zone.
+ * @order: The block order.
+ * @zone:  PF_ZONE_LOWMEM or PF_ZONE_HIGHMEM.
+ *
+ * Return: The number of free blocks.
+ */
+uint32_t buddy_free_count(uint32_t order, uint32_t zone) {
+    struct block_list * list = &buddy_allocator.blocks[order];
+
+    if(zone == PF_ZONE_HIGHMEM) {
+        return list->high_count;
+    }
+
+    return list->free_count - list->high_count;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * buddy_take_block() - Remove a free block of an order from a zone.
+ * @order: The order of the block.
+ * @zone:  PF_ZONE_LOWMEM or PF_ZONE_HIGHMEM.
+ *
+ * Splits a larger block from the same zone if there are none of the order.
+ * The caller must hold the allocator lock.
+ *
+ * Return: The first page of the block, or NULL if the zone has none left.
+ */
+struct page * buddy_take_block(uint32_t order, uint32_t zone) {
+    /* Check whether there's any blocks of the desired order */
+    if(buddy_free_count(order, zone) == 0) {
+        /* Attempt to split a larger block */
+        buddy_split_block(order + 1, zone);
+
+        /* If no blocks are free after splitting, abort */
+        if(buddy_free_count(order, zone) == 0) {
+            return NULL;
+        }
+    }
+
+    /* Retrieve the last block page entry in the order list */
+    struct page * block = page_get_last(&buddy_allocator, order, zone);
+    if(!block) {
+        klog("buddy_take_block(): failed to get last page from list w/ "
+             "order %d!\n", order);
+        return NULL;
+    }
+
+    buddy_remove_block(block);
+    return block;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * buddy_split_block() - Attempt to split a larger block into smaller blocks.
  * @order: The block order to be split into smaller blocks.
+ * @zone:  PF_ZONE_LOWMEM or PF_ZONE_HIGHMEM, the zone to split a block from.
  *
  * Return: E_SUCCESS if the split was successful, E_ERROR if no
  *         block could be split.
  */
-int32_t buddy_split_block(uint32_t order) {
+int32_t buddy_split_block(uint32_t order, uint32_t zone) {
     /* If we're asked to split the largest block possible, refuse */
     if(order > ORDER_MAX)
         return E_ERROR;
@@ -355,19 +527,19 @@ int32_t buddy_split_block(uint32_t order) {
     /* We are normally asked to split blocks of an order 1 above the desired
      * block type, however there is no guarantee that blocks are free at this
      * order either. If this is the case, attempt to split higher again. */
-    if(buddy_allocator.blocks[order].free_count == 0) {
+    if(buddy_free_count(order, zone) == 0) {
         klog("No blocks at this order (%d) are free, attempting +1\n", order);
-        buddy_split_block(order + 1);
+        buddy_split_block(order + 1, zone);
 
-        /* If free_count is still 0, it did not succeed */
-        if(buddy_allocator.blocks[order].free_count == 0) {
+        /* If the count is still 0, it did not succeed */
+        if(buddy_free_count(order, zone) == 0) {
             klog("Recursive split also failed!\n");
             return E_ERROR;
         }
     }
 
     /* Retrieve a page from the target order for us to split */
-    struct page * target = page_get_last(&buddy_allocator, order);
+    struct page * target = page_get_last(&buddy_allocator, order, zone);
     if(!target) {
         klog("Failed to retrieve a valid last block at order %d!\n", order);
         return E_ERROR;
@@ -405,6 +577,11 @@ int32_t buddy_merge_block(struct page * block_page, uint32_t order) {
     struct page * buddy = NULL;
 
     while(order < ORDER_MAX) {
+        /* Blocks at the end of memory may have no buddy */
+        if((block_page->pfn ^ (1 << order)) >= buddy_allocator.page_count) {
+            break;
+        }
+
         buddy = buddy_get(block_page, order);
 
         /* Ensure the buddy is eligible to be merged (is free and valid) */
@@ -418,11 +595,9 @@ int32_t buddy_merge_block(struct page * block_page, uint32_t order) {
             break;
         }
 
-        /* This block is getting merged, so remove it from its current list */
-        clist_delete_node(&buddy->buddy_node);
-
-        /* Decrement the available free page count for the order */
-        buddy_allocator.blocks[order].free_count--;
+        /* This block is getting merged, so remove it from its current list,
+         * decrementing the available free page count for the order */
+        buddy_remove_block(buddy);
 
         /* Make sure we're working with the lowest page of the pair */
         block_page = page_from_pfn(block_page->pfn & ~(1 << order));
@@ -462,8 +637,14 @@ struct page * buddy_get(struct page * page, uint32_t order) {
  * updates the free count.
  */
 void buddy_remove_block(struct page * block_page) {
+    struct block_list * list = &buddy_allocator.blocks[block_page->order];
+
     clist_delete_node(&block_page->buddy_node);
-    buddy_allocator.blocks[block_page->order].free_count--;
+    list->free_count--;
+    buddy_allocator.free_pages -= 1 << block_page->order;
+    if(TEST_BIT(block_page->flags, PF_ZONE_HIGHMEM)) {
+        list->high_count--;
+    }
     block_page->order = ORDER_USED;
 }
 
@@ -478,10 +659,17 @@ void buddy_remove_block(struct page * block_page) {
  * order and updates the free count.
  */
 void buddy_add_block(struct page * block_page, uint32_t order) {
+    struct block_list * list = &buddy_allocator.blocks[order];
+
     block_page->order = order;
-    clist_add(&buddy_allocator.blocks[order].free_pages,
-              &block_page->buddy_node);
-    buddy_allocator.blocks[order].free_count++;
+    if(TEST_BIT(block_page->flags, PF_ZONE_HIGHMEM)) {
+        clist_add(&list->free_high, &block_page->buddy_node);
+        list->high_count++;
+    } else {
+        clist_add(&list->free_pages, &block_page->buddy_node);
+    }
+    list->free_count++;
+    buddy_allocator.free_pages += 1 << order;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -496,6 +684,7 @@ void buddy_print_debug() {
     klog("--- Buddy Allocator Info ---\n");
     klog("Page Count:          %d\n", buddy_allocator.page_count);
     klog("Max Order:           %d\n", ORDER_MAX);
+    klog("Free Pages:          %d\n", buddy_allocator.free_pages);
     klog("Page Area Start:     0x%x\n",
                       buddy_allocator.page_area);
     klog("Page Area End:       0x%x\n",
@@ -503,8 +692,9 @@ void buddy_print_debug() {
                       (buddy_allocator.page_count * sizeof(struct page)));
 
     for(uint32_t i = 0; i < ORDER_MAX + 1; i++) {
-        klog("Order[%d] Free: %d\n", i,
-             buddy_allocator.blocks[i].free_count);
+        klog("Order[%d] Free: %d (%d highmem)\n", i,
+             buddy_allocator.blocks[i].free_count,
+             buddy_allocator.blocks[i].high_count);
     }
 }
 
@@ -21,26 +21,163 @@
 
 /* ------------------------------------------------------------------------- */
 
+uint32_t ptable_quicklists_ready = 0;
+
+/* ------------------------------------------------------------------------- */
+/* Quicklists                                                                */
+/* ------------------------------------------------------------------------- */
+
 /**
- * ptable_pgd_new() - Allocate a new top-level page global directory.
+ * ptable_pgd_ctor() - Prepare a page to be used as a PGD.
+ * @page: The virtual address of the page.
  *
- * Allocates memory for a new top-level page global directory, ensures the
- * memory is cleared, then copies the kernel page directory into it. This
- * ensures that all new page tables created for tasks contain the essential
- * kernel mappings. There is no scenario where we want to create a page table
- * without the kernel mappings.
+ * Gives the PGD the kernel mappings through ptable_pgd_init(), which the
+ * architecture implements. The kernel mappings don't change after boot, as
+ * even the kmap() page tables are allocated up front, so PGDs prepared in
+ * advance remain valid.
  *
- * Return: A pointer to the struct pgd object for the new page directory.
+ * Return: E_SUCCESS on success, E_ERROR on failure.
  */
-struct pgd * ptable_pgd_new() {
-    struct pgd * pgd = page_alloc_va(0, PR_KERNEL);
-    if(!pgd)
+static int32_t ptable_pgd_ctor(void * page) {
+    return ptable_pgd_init(page);
+}
+
+/**
+ * ptable_pgd_dtor() - Release a prepared PGD before its page is freed.
+ * @page: The virtual address of the page.
+ */
+static void ptable_pgd_dtor(void * page) {
+    ptable_pgd_fini(page);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_pgt_ctor() - Prepare a page to be used as a page table.
+ * @page: The virtual address of the page.
+ *
+ * Return: E_SUCCESS
+ */
+static int32_t ptable_pgt_ctor(void * page) {
+    memset(page, 0, PAGE_SIZE);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_quicklist_alloc() - Allocate a page from this CPU's quicklist.
+ * @type: QUICKLIST_PGD or QUICKLIST_PGT.
+ * @ctor: The quicklist's constructor, used if the quicklists aren't ready.
+ *
+ * Return: The virtual address of the prepared page, or NULL on failure.
+ */
+static void * ptable_quicklist_alloc(uint32_t type, quicklist_ctor_t ctor) {
+    if(ptable_quicklists_ready) {
+        return quicklist_alloc(&cpu_get_local()->quicklists[type]);
+    }
+
+    void * page = page_alloc_va(0, PR_KERNEL);
+    if(page && !SUCCESS(ctor(page))) {
+        page_free_va(page, 0);
         return NULL;
+    }
+    return page;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_quicklist_free() - Return a prepared page to this CPU's quicklist.
+ * @type: QUICKLIST_PGD or QUICKLIST_PGT.
+ * @page: The virtual address of the page, in its prepared state.
+ * @dtor: The quicklist's destructor, used if the quicklists aren't ready.
+ */
+static void ptable_quicklist_free(uint32_t type, void * page,
+                                  quicklist_dtor_t dtor) {
+    if(ptable_quicklists_ready) {
+        quicklist_free(&cpu_get_local()->quicklists[type], page);
+        return;
+    }
+
+    if(dtor) {
+        dtor(page);
+    }
+    page_free_va(page, 0);
+}
 
-    memset(pgd, 0, PAGE_SIZE);
-    memcpy(pgd, paging_kernel_pgd(), PAGE_SIZE);
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_quicklist_init() - Initialise this CPU's page table quicklists.
+ *
+ * Run once the per-CPU data is available. Until then, PGDs and page tables
+ * are prepared when allocated.
+ *
+ * Return: E_SUCCESS
+ */
+int32_t __init ptable_quicklist_init() {
+    struct quicklist * lists = cpu_get_local()->quicklists;
+
+    quicklist_init(&lists[QUICKLIST_PGD], "pgd", PTABLE_QL_PGD_LOW,
+                   PTABLE_QL_PGD_HIGH, ptable_pgd_ctor, ptable_pgd_dtor);
+    quicklist_init(&lists[QUICKLIST_PGT], "pgt", PTABLE_QL_PGT_LOW,
+                   PTABLE_QL_PGT_HIGH, ptable_pgt_ctor, NULL);
+    ptable_quicklists_ready = 1;
 
-    return pgd;
+    return E_SUCCESS;
+}
+
+arch_initcall(ptable_quicklist_init);
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_quicklist_refill() - Top up this CPU's page table quicklists.
+ *
+ * Called from the idle loop, so that PGDs and page tables are prepared while
+ * there's nothing else to do.
+ */
+void ptable_quicklist_refill() {
+    if(!ptable_quicklists_ready) return;
+
+    struct quicklist * lists = cpu_get_local()->quicklists;
+    for(uint32_t i = 0; i < QUICKLIST_COUNT; i++) {
+        quicklist_refill(&lists[i]);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_quicklist_print_debug() - Print this CPU's page table quicklists.
+ */
+void ptable_quicklist_print_debug() {
+    if(!ptable_quicklists_ready) return;
+
+    struct quicklist * lists = cpu_get_local()->quicklists;
+    for(uint32_t i = 0; i < QUICKLIST_COUNT; i++) {
+        quicklist_print_debug(&lists[i]);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+/* Page Directories                                                          */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_pgd_new() - Allocate a new top-level page global directory.
+ *
+ * Takes a PGD from the quicklist, which has no user mappings and already
+ * holds the kernel mappings. This ensures that all
+ * new page tables created for tasks contain the essential kernel mappings.
+ * There is no scenario where we want to create a page table without the
+ * kernel mappings.
+ *
+ * Return: A pointer to the struct pgd object for the new page directory.
+ */
+struct pgd * ptable_pgd_new() {
+    return ptable_quicklist_alloc(QUICKLIST_PGD, ptable_pgd_ctor);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -49,8 +186,10 @@ struct pgd * ptable_pgd_new() {
  * ptable_pgd_free() - Frees and erases a top-level page global directory.
  * @pgd: A pointer to the virtual address of the PGD to be freed.
  *
- * Frees the page used for the PGD, and frees pages for any page tables that
- * do not map kernel memory using ptable_unmap() and ptable_unmap_many().
+ * Frees the pages mapped by any page tables that do not map kernel memory,
+ * and the page tables themselves, along with any huge pages and swap slots.
+ * Each user directory entry is cleared as it's freed, and the PGD is
+ * returned to the quicklist with its kernel mappings intact for reuse.
  */
 void ptable_pgd_free(struct pgd * pgd) {
     klog("ptable_pgd_free(): Freeing PGD at 0x%x\n", pgd);
@@ -58,30 +197,231 @@ void ptable_pgd_free(struct pgd * pgd) {
     /* Free all page tables that don't cover kernel space */
     int pde_max = PAGE_DIRECTORY_INDEX(KERNEL_START_VIRT);
     for(int pde_index = 0; pde_index < pde_max; pde_index++) {
-        struct pde * pde = &pgd->entries[pde_index];
+        struct pde * pde = PGD_ENTRY(pgd, pde_index);
         if(!PDE_EXISTS(pde)) {
             continue;
         }
 
         if(PDE_IS_HUGE(pde)) {
-            /* TODO: free 4MB page area */
-        } else {
-            struct pgt * pgt = PDE_TO_PGT(&pgd->entries[pde_index]);
-
-            for(int pte_index = 0; pte_index < PAGE_TABLE_SIZE; pte_index++) {
-                struct pte * pte = &pgt->entries[pte_index];
-                if(!PTE_EXISTS(pte))
-                    continue;
-                page_free_va(PTE_VA(pte), 0);
+            /* The whole huge page was allocated as a single block */
+            page_free(PDE_PAGE(pde), HUGE_PAGE_ORDER);
+            pde->entry = 0;
+            continue;
+        }
+
+        struct pgt * pgt = PDE_TO_PGT(pde);
+
+        for(int pte_index = 0; pte_index < PAGE_TABLE_SIZE; pte_index++) {
+            struct pte * pte = &pgt->entries[pte_index];
+            if(PTE_IS_SWAP(pte)) {
+                swap_put(PTE_SWAP_SLOT(pte));
+                continue;
             }
+
+            /* Device memory mapped into user space has no struct page */
+            if(!PTE_EXISTS(pte) || !page_pfn_is_ram(PTE_PFN(pte)))
+                continue;
+
+            void * virt_addr = (void*)(((uintptr_t)pde_index * PAGE_TABLE_SIZE +
+                                        pte_index) * PAGE_SIZE);
+            rmap_remove(PTE_PAGE(pte), pgd, virt_addr);
+            page_free(PTE_PAGE(pte), 0);
         }
 
         /* De-allocate the PDE */
         page_free_va(PDE_VA(pde), 0);
+        pde->entry = 0;
+    }
+
+    /* Finally, recycle the PGD itself */
+    ptable_quicklist_free(QUICKLIST_PGD, pgd, ptable_pgd_dtor);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_pgt_alloc() - Allocate an empty page table for a directory entry.
+ * @pde: The page directory entry to point at the new table.
+ *
+ * The table is taken from the quicklist, so is usually already zeroed.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if no page could be allocated.
+ */
+static int32_t ptable_pgt_alloc(struct pde * pde) {
+    struct pgt * pgt = ptable_quicklist_alloc(QUICKLIST_PGT, ptable_pgt_ctor);
+    if(!pgt) {
+        klog("ptable_pgt_alloc(): failed to allocate page table!\n");
+        return E_ERROR;
+    }
+
+    /* Point the PDE entry to our newly allocated page table */
+    *pde = MAKE_PDE(VIR_TO_PHY(pgt), PDE_PRESENT | PDE_WRITABLE | PDE_USER);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_nx_flags() - Returns the no-execute bit for a user mapping.
+ * @flags: VM_MAP_* flags for the mapping.
+ *
+ * Return: PTE_NX if the mapping lacks VM_MAP_EXEC and the CPU honours the
+ *         bit, 0 otherwise. The bit is in the same place in PDEs.
+ */
+static inline ptable_entry_t ptable_nx_flags(flags_t flags) {
+    if(TEST_BIT(flags, VM_MAP_EXEC) || !paging_nx_enabled()) {
+        return 0;
+    }
+    return PTE_NX;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_make_pte() - Make a user page table entry.
+ * @pfn:   The page frame to map to.
+ * @flags: VM_MAP_* flags for the page (e.g. writable, or a memory type).
+ *
+ * Return: The page table entry.
+ */
+static struct pte ptable_make_pte(uint32_t pfn, flags_t flags) {
+    struct pte entry = MAKE_PTE_PFN(pfn, PTE_PRESENT | PTE_USER |
+                                         ptable_cache_flags(flags));
+
+    if(TEST_BIT(flags, VM_MAP_WRITE)) {
+        PTE_SET_WRITABLE(&entry);
+    }
+    entry.entry |= ptable_nx_flags(flags);
+
+    return entry;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Range Walker                                                              */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_walk_range() - Visit each page table entry in a range of addresses.
+ * @walk:       The walk, describing the PGD, the callbacks and flags.
+ * @start_addr: The first (inclusive) address of the range.
+ * @end_addr:   The final (exclusive) address of the range.
+ *
+ * Walks the range one page table at a time, keeping hold of the current
+ * table across consecutive entries rather than going back to the PGD for
+ * each page. Unpopulated directory entries are stepped over in one go,
+ * unless PTW_ALLOC is set, in which case a table is allocated for them.
+ *
+ * walk->pte_fn() is called for each present entry, or for every entry if
+ * PTW_EMPTY is set. If it fails, the walk stops. walk->pgt_fn(), if set, is
+ * called after each table has been walked, and may unhook the table.
+ *
+ * A user huge page entirely within the range is passed to walk->huge_fn() if
+ * set. Otherwise, or if the range only covers part of it, it is split into a
+ * page table first. Huge pages in kernel space are shared by every PGD, so
+ * are never split, and are stepped over.
+ *
+ * Return: E_SUCCESS on success, otherwise the error which stopped the walk.
+ */
+int32_t ptable_walk_range(struct ptable_walk * walk, void * start_addr,
+                          void * end_addr) {
+    uintptr_t addr = PAGE_ALIGN_DOWN(start_addr);
+    uintptr_t end  = PAGE_ALIGN(end_addr);
+    uintptr_t table_span = PAGE_SIZE * PAGE_TABLE_SIZE;
+
+    while(addr < end) {
+        uintptr_t table_start = ALIGN_DOWN(addr, table_span);
+        uintptr_t table_end   = table_start + table_span;
+        if(table_end == 0 || table_end > end) {
+            table_end = end;
+        }
+
+        struct pde * pde = GET_PDE(walk->pgd, addr);
+        if(!PDE_EXISTS(pde) && TEST_BIT(walk->flags, PTW_ALLOC)) {
+            if(!SUCCESS(ptable_pgt_alloc(pde))) {
+                return E_ERROR;
+            }
+        }
+
+        if(PDE_EXISTS(pde) && PDE_IS_HUGE(pde) &&
+           table_start < KERNEL_START_VIRT) {
+            if(walk->huge_fn && addr == table_start &&
+               table_end - table_start == table_span) {
+                int32_t rv = walk->huge_fn(walk, pde, (void*)table_start);
+                if(!SUCCESS(rv)) {
+                    return rv;
+                }
+                addr = table_end;
+                continue;
+            }
+
+            if(!SUCCESS(ptable_split_huge(walk->pgd, (void*)table_start))) {
+                return E_ERROR;
+            }
+        }
+
+        if(!PDE_EXISTS(pde) || PDE_IS_HUGE(pde)) {
+            addr = table_end;
+            continue;
+        }
+
+        walk->pgt = PDE_TO_PGT(pde);
+        for(; addr < table_end; addr += PAGE_SIZE) {
+            struct pte * pte = GET_PTE(walk->pgt, addr);
+            if(!PTE_EXISTS(pte) && !TEST_BIT(walk->flags, PTW_EMPTY)) {
+                continue;
+            }
+
+            int32_t rv = walk->pte_fn(walk, pte, (void*)addr);
+            if(!SUCCESS(rv)) {
+                walk->pgt = NULL;
+                return rv;
+            }
+        }
+
+        if(walk->pgt_fn) {
+            walk->pgt_fn(walk, pde, (void*)table_start);
+        }
+        walk->pgt = NULL;
     }
 
-    /* Finally, de-allocate the PGD itself */
-    page_free_va(pgd, 0);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Mapping                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_map_pfn() - Add a single page mapping to a page table.
+ * @pgd:       The top-level page table (PGD) to add the mapping to.
+ * @virt_addr: The virtual address to map from.
+ * @pfn:       The page frame to map to.
+ * @flags:     VM_MAP_* flags for the page (e.g. writable).
+ */
+static void ptable_map_pfn(struct pgd * pgd, void * virt_addr, uint32_t pfn,
+                           flags_t flags) {
+    /* Get the top-level page directory entry responsible for this address */
+    struct pde * pde = GET_PDE(pgd, virt_addr);
+
+    /* If one doesn't already exist, allocate memory for one and assign it */
+    if(!PDE_EXISTS(pde)) {
+        klog("ptable_map(): PDE for vaddr 0x%x does not exist\n", virt_addr);
+        if(!SUCCESS(ptable_pgt_alloc(pde))) {
+            return;
+        }
+    } else if(PDE_IS_HUGE(pde)) {
+        if(!SUCCESS(ptable_split_huge(pgd, virt_addr))) {
+            return;
+        }
+    }
+
+    /* Get a pointer to the page table itself using the address in the PDE */
+    struct pgt * pgt = PDE_TO_PGT(pde);
+
+    /* Get a pointer to the entry within the page table */
+    struct pte * pte = GET_PTE(pgt, virt_addr);
+    *pte = ptable_make_pte(pfn, flags);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -102,39 +442,136 @@ void ptable_pgd_free(struct pgd * pgd) {
  */
 void ptable_map(struct pgd * pgd, void * virt_addr, void * phys_addr,
                 flags_t flags) {
-    /* Make the page table entry first, then add flags if necessary later */
-    struct pte entry = MAKE_PTE(phys_addr, PTE_PRESENT | PTE_USER);
+    ptable_map_pfn(pgd, virt_addr, PA_TO_PFN(phys_addr), flags);
+}
 
-    /* Make the page writable if specified */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_map_page() - Map a page, which may be highmem, into a page table.
+ * @pgd:       The top-level page table (PGD) to add the mapping to.
+ * @virt_addr: The virtual address to map from.
+ * @page:      The page to map to.
+ * @flags:     VM_MAP_* flags for the page (e.g. writable).
+ *
+ * Unlike a physical address passed to ptable_map(), the page may lie above
+ * 4GB when PAE is enabled.
+ */
+void ptable_map_page(struct pgd * pgd, void * virt_addr, struct page * page,
+                     flags_t flags) {
+    ptable_map_pfn(pgd, virt_addr, page->pfn, flags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_map_huge() - Map a huge page with a single directory entry.
+ * @pgd:       The top-level page table (PGD) to add the mapping to.
+ * @virt_addr: The virtual address to map from, aligned to HUGE_PAGE_SIZE.
+ * @block:     The first page of a HUGE_PAGE_ORDER block, which may be highmem.
+ * @flags:     VM_MAP_* flags for the page (e.g. writable).
+ *
+ * Mapping a whole HUGE_PAGE_SIZE region (4MB, or 2MB with PAE) with one PDE
+ * avoids allocating a page table for it, and it then takes up a single TLB
+ * entry rather than PAGE_TABLE_SIZE. Requires PSE or PAE and a user address
+ * whose PDE is still unused, so callers should fall back to ptable_map() on
+ * failure.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the page could not be mapped.
+ */
+int32_t ptable_map_huge(struct pgd * pgd, void * virt_addr,
+                        struct page * block, flags_t flags) {
+    if(!x86_paging_huge_enabled()) {
+        return E_ERROR;
+    }
+
+    if(!IS_HUGE_ALIGNED(virt_addr) || block->pfn % PAGE_TABLE_SIZE != 0 ||
+       (uintptr_t)virt_addr >= KERNEL_START_VIRT) {
+        klog("ptable_map_huge(): Invalid huge page 0x%x -> PFN 0x%x\n",
+             virt_addr, block->pfn);
+        return E_ERROR;
+    }
+
+    struct pde * pde = GET_PDE(pgd, virt_addr);
+    if(PDE_EXISTS(pde)) {
+        return E_ERROR;
+    }
+
+    *pde = MAKE_PDE_PFN(block->pfn, PDE_PRESENT | PDE_USER |
+                                    PDE_PAGE_SIZE_4M);
     if(TEST_BIT(flags, VM_MAP_WRITE)) {
-        PTE_SET_WRITABLE(&entry);
+        PDE_SET_WRITABLE(pde);
     }
+    pde->entry |= ptable_nx_flags(flags);
 
-    /* Get the top-level page directory entry responsible for this address */
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_split_huge() - Replace a huge page with a page table.
+ * @pgd:       The top-level page table (PGD) containing the huge page.
+ * @virt_addr: An address within the huge page.
+ *
+ * The new page table maps the same physical memory with the same
+ * permissions, one page at a time, and the underlying block is split so that
+ * each page can then be unmapped and freed on its own. Used when only part of
+ * a huge page is unmapped or has its protection changed.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if no page table could be allocated.
+ */
+int32_t ptable_split_huge(struct pgd * pgd, void * virt_addr) {
     struct pde * pde = GET_PDE(pgd, virt_addr);
+    if(!PDE_EXISTS(pde) || !PDE_IS_HUGE(pde)) {
+        return E_ERROR;
+    }
 
-    /* If one doesn't already exist, allocate memory for one and assign it */
-    if(!PDE_EXISTS(pde)) {
-        klog("ptable_map(): PDE for vaddr 0x%x does not exist\n", virt_addr);
-        struct page * page = page_alloc(0, PR_KERNEL);
-        memset(PAGE_VA(page), 0, PAGE_SIZE);
+    struct pgt * pgt = ptable_quicklist_alloc(QUICKLIST_PGT, ptable_pgt_ctor);
+    if(!pgt) {
+        klog("ptable_split_huge(): failed to allocate page table!\n");
+        return E_ERROR;
+    }
 
-        /* Point the PDE entry to our newly allocated page table */
-        *pde = MAKE_PDE(PAGE_PA(page), PDE_PRESENT |
-                                          PDE_WRITABLE |
-                                          PDE_USER);
+    /* Bits 0-6 and the global bit share their meaning between a huge PDE and
+     * a PTE, whereas bit 7 is the page size in one and PAT in the other */
+    uint32_t       pfn       = PDE_PFN(pde);
+    ptable_entry_t pte_flags = pde->entry & (0x7F | PTE_GLOBAL | PTE_NX);
+    for(int i = 0; i < PAGE_TABLE_SIZE; i++) {
+        pgt->entries[i] = MAKE_PTE_PFN(pfn + i, pte_flags);
     }
 
-    /* Get a pointer to the page table itself using the address in the PDE */
-    struct pgt * pgt = PDE_TO_PGT(pde);
+    page_split(page_from_pfn(pfn), HUGE_PAGE_ORDER);
 
-    /* Get a pointer to the entry within the page table */
-    struct pte * pte = GET_PTE(pgt, virt_addr);
-    *pte = entry;
+    *pde = MAKE_PDE(VIR_TO_PHY(pgt), PDE_PRESENT | PDE_WRITABLE | PDE_USER);
+
+    /* The translations are unchanged, but the CPU may still hold the huge
+     * entry, which must not coexist with the new 4KB ones */
+    if(VIR_TO_PHY(pgd) == paging_current_pgd()) {
+        paging_inval_tlb_entry(virt_addr);
+    }
+
+    return E_SUCCESS;
 }
 
 /* ------------------------------------------------------------------------- */
 
+struct ptable_map_data {
+    uintptr_t virt_start;
+    uintptr_t phys_start;
+    flags_t   flags;
+};
+
+static int32_t ptable_map_pte(struct ptable_walk * walk, struct pte * pte,
+                              void * virt_addr) {
+    struct ptable_map_data * data = walk->private;
+    uintptr_t phys_addr = data->phys_start +
+                          ((uintptr_t)virt_addr - data->virt_start);
+
+    *pte = ptable_make_pte(PA_TO_PFN(phys_addr), data->flags);
+    return E_SUCCESS;
+}
+
 /**
  * ptable_map_many() - Add multiple contiguous page mappings to a page table.
  * @pgd:       The top-level page table (PGD) to add the mapping to.
@@ -143,19 +580,178 @@ void ptable_map(struct pgd * pgd, void * virt_addr, void * phys_addr,
  * @count:     How many pages to map.
  * @flags:     Flags for the page (e.g. writable)
  *
- * Adds multiple contiguous page mappings to a table by calling ptable_map()
- * for each page address in the range.
+ * Adds multiple contiguous page mappings to a table with a single walk of
+ * the range, allocating page tables as required.
  */
 void ptable_map_many(struct pgd * pgd, void * virt_addr, void * phys_addr,
                      int count, flags_t flags) {
-    for(uint32_t i = 0; i < count; i++) {
-        ptable_map(pgd, virt_addr + i * PAGE_SIZE, phys_addr + i * PAGE_SIZE,
-                   flags);
+    struct ptable_map_data data = {
+        .virt_start = PAGE_ALIGN_DOWN(virt_addr),
+        .phys_start = PAGE_ALIGN_DOWN(phys_addr),
+        .flags      = flags
+    };
+
+    struct ptable_walk walk = {
+        .pgd     = pgd,
+        .flags   = PTW_ALLOC | PTW_EMPTY,
+        .pte_fn  = ptable_map_pte,
+        .private = &data
+    };
+
+    if(!SUCCESS(ptable_walk_range(&walk, virt_addr,
+                                  virt_addr + count * PAGE_SIZE))) {
+        klog("ptable_map_many(): failed to map 0x%x (%d pages)\n",
+             virt_addr, count);
     }
 }
 
 /* ------------------------------------------------------------------------- */
 
+struct ptable_populate_data {
+    flags_t          flags;
+    struct page *    page;    /* Shared by every entry, or NULL to allocate */
+    ptable_fill_fn_t fill;    /* Fills each page allocated, or NULL to zero */
+    void *           private; /* Passed to fill */
+};
+
+static int32_t ptable_populate_pte(struct ptable_walk * walk,
+                                   struct pte * pte, void * virt_addr) {
+    struct ptable_populate_data * data = walk->private;
+
+    /* A page that was swapped out is read back in when it faults */
+    if(PTE_EXISTS(pte) || PTE_IS_SWAP(pte)) {
+        return E_SUCCESS;
+    }
+
+    /* The entry wasn't present, so the TLB can't be holding it */
+    if(data->page) {
+        PAGE_INC_USES(data->page);
+        *pte = ptable_make_pte(data->page->pfn, data->flags & ~VM_MAP_WRITE);
+        pte->entry |= PTE_COW;
+        return E_SUCCESS;
+    }
+
+    struct page * page = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+    if(!page) {
+        return E_ERROR;
+    }
+
+    if(!data->fill) {
+        highmem_zero_page(page);
+    } else if(!SUCCESS(data->fill(page, virt_addr, data->private))) {
+        page_free(page, 0);
+        return E_ERROR;
+    }
+
+    *pte = ptable_make_pte(page->pfn, data->flags);
+    if(RMAP_TRACKED(data->flags)) {
+        rmap_add_new(page, walk->pgd, virt_addr);
+    }
+    return E_SUCCESS;
+}
+
+static int32_t ptable_populate_huge(struct ptable_walk * walk,
+                                    struct pde * pde, void * virt_addr) {
+    /* Already backed in full */
+    return E_SUCCESS;
+}
+
+static int32_t ptable_populate(struct pgd * pgd, void * start_addr,
+                               void * end_addr,
+                               struct ptable_populate_data * data) {
+    struct ptable_walk walk = {
+        .pgd     = pgd,
+        .flags   = PTW_ALLOC | PTW_EMPTY,
+        .pte_fn  = ptable_populate_pte,
+        .huge_fn = ptable_populate_huge,
+        .private = data
+    };
+
+    return ptable_walk_range(&walk, start_addr, end_addr);
+}
+
+/**
+ * ptable_populate_range() - Back each unmapped page in a range with memory.
+ * @pgd:        The top-level page table (PGD) to add the mappings to.
+ * @start_addr: The first (inclusive) address of the range.
+ * @end_addr:   The final (exclusive) address of the range.
+ * @flags:      VM_MAP_* flags for the new pages (e.g. writable).
+ *
+ * Allocates a zeroed page for each entry in the range that isn't present,
+ * along with any page tables needed, in a single walk. Entries that are
+ * already present, or swapped out, are left as they are.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if memory ran out part way.
+ */
+int32_t ptable_populate_range(struct pgd * pgd, void * start_addr,
+                              void * end_addr, flags_t flags) {
+    struct ptable_populate_data data = {
+        .flags = flags,
+        .page  = NULL,
+        .fill  = NULL
+    };
+
+    return ptable_populate(pgd, start_addr, end_addr, &data);
+}
+
+/**
+ * ptable_populate_cow() - Map one page into each unmapped entry in a range.
+ * @pgd:        The top-level page table (PGD) to add the mappings to.
+ * @start_addr: The first (inclusive) address of the range.
+ * @end_addr:   The final (exclusive) address of the range.
+ * @page:       The page to map, which gains a use for each entry.
+ * @flags:      VM_MAP_* flags for the mappings.
+ *
+ * The page is mapped read-only and copy-on-write, even if @flags allows
+ * writes, so that ptable_cow_fault() gives each entry a copy of its own on
+ * the first write.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if no page table could be allocated.
+ */
+int32_t ptable_populate_cow(struct pgd * pgd, void * start_addr,
+                            void * end_addr, struct page * page,
+                            flags_t flags) {
+    struct ptable_populate_data data = {
+        .flags = flags,
+        .page  = page,
+        .fill  = NULL
+    };
+
+    return ptable_populate(pgd, start_addr, end_addr, &data);
+}
+
+/**
+ * ptable_populate_fill() - Back each unmapped page in a range with contents.
+ * @pgd:        The top-level page table (PGD) to add the mappings to.
+ * @start_addr: The first (inclusive) address of the range.
+ * @end_addr:   The final (exclusive) address of the range.
+ * @flags:      VM_MAP_* flags for the new pages (e.g. writable).
+ * @fill:       Called to fill in each new page before it's mapped.
+ * @private:    Passed to @fill.
+ *
+ * As ptable_populate_range(), but the contents of each page come from @fill,
+ * such as from the file backing a mapping, rather than being zeroed.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if memory ran out or @fill failed
+ *         part way.
+ */
+int32_t ptable_populate_fill(struct pgd * pgd, void * start_addr,
+                             void * end_addr, flags_t flags,
+                             ptable_fill_fn_t fill, void * private) {
+    struct ptable_populate_data data = {
+        .flags   = flags,
+        .page    = NULL,
+        .fill    = fill,
+        .private = private
+    };
+
+    return ptable_populate(pgd, start_addr, end_addr, &data);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unmapping                                                                 */
+/* ------------------------------------------------------------------------- */
+
 /**
  * ptable_unmap() - Remove a single page mapping from a page table.
  * @pgd:       The top-level page table (PGD) to remove the mapping from.
@@ -164,6 +760,7 @@ void ptable_map_many(struct pgd * pgd, void * virt_addr, void * phys_addr,
  *
  * Removes a single page mapping from a page table. Does not free memory used
  * for the page table if the mapping was the last mapping present in the table.
+ * Ranges of pages should be removed with ptable_unmap_many() instead.
  */
 void ptable_unmap(struct pgd * pgd, void * virt_addr, int free) {
     struct pde * pde = GET_PDE(pgd, virt_addr);
@@ -172,18 +769,21 @@ void ptable_unmap(struct pgd * pgd, void * virt_addr, int free) {
         return;
     }
 
+    if(PDE_IS_HUGE(pde) && !SUCCESS(ptable_split_huge(pgd, virt_addr))) {
+        return;
+    }
+
     /* Locate the Page Table Entry for this specific mapping */
     struct pgt * pgt = PDE_TO_PGT(pde);
     struct pte * pte = GET_PTE(pgt, virt_addr);
 
-    /* Get the physical address of the page the PTE maps to */
-    void * pte_pa = PTE_PA(pte);
-
     /* If a page has been allocated at the mapped address, free it */
-    if(free) {
-        uint32_t pfn = PA_TO_PFN(pte_pa);
-        struct page * page = page_from_pfn(pfn);
-        page_free(page, 0);
+    if(free && PTE_IS_SWAP(pte)) {
+        swap_put(PTE_SWAP_SLOT(pte));
+        pte->entry = 0;
+    } else if(free && PTE_EXISTS(pte)) {
+        rmap_remove(PTE_PAGE(pte), pgd, virt_addr);
+        page_free(PTE_PAGE(pte), 0);
     }
 
     /* Clear the mapping */
@@ -196,6 +796,101 @@ void ptable_unmap(struct pgd * pgd, void * virt_addr, int free) {
 
 /* ------------------------------------------------------------------------- */
 
+static int32_t ptable_unmap_pte(struct ptable_walk * walk, struct pte * pte,
+                                void * virt_addr) {
+    int free = *(int*)walk->private;
+
+    if(PTE_IS_SWAP(pte)) {
+        if(free) {
+            swap_put(PTE_SWAP_SLOT(pte));
+            pte->entry = 0;
+        }
+        return E_SUCCESS;
+    }
+
+    if(!PTE_EXISTS(pte)) {
+        return E_SUCCESS;
+    }
+
+    if(free) {
+        rmap_remove(PTE_PAGE(pte), walk->pgd, virt_addr);
+        tlb_gather_page(walk->tlb, PTE_PAGE(pte));
+    }
+
+    pte->entry = 0;
+    tlb_gather_inval(walk->tlb, virt_addr);
+    return E_SUCCESS;
+}
+
+static void ptable_unmap_pgt(struct ptable_walk * walk, struct pde * pde,
+                             void * table_addr) {
+    if((uintptr_t)table_addr >= KERNEL_START_VIRT ||
+       !ptable_pgt_is_clear(walk->pgt)) {
+        return;
+    }
+
+    /* Invalidating any address covered by the table also drops the CPU's
+     * cached copy of its PDE */
+    struct page * pgt_page = VA_PAGE(walk->pgt);
+    pde->entry = 0;
+    tlb_gather_inval(walk->tlb, table_addr);
+    tlb_gather_page(walk->tlb, pgt_page);
+    walk->tlb->tables_freed++;
+}
+
+static int32_t ptable_unmap_huge(struct ptable_walk * walk, struct pde * pde,
+                                 void * virt_addr) {
+    int free = *(int*)walk->private;
+    struct page * page = PDE_PAGE(pde);
+
+    pde->entry = 0;
+    tlb_gather_inval(walk->tlb, virt_addr);
+
+    /* The block can only be freed as a whole, once the CPU can no longer
+     * reach it through the TLB */
+    if(free) {
+        tlb_gather_flush(walk->tlb);
+        page_free(page, HUGE_PAGE_ORDER);
+        walk->tlb->pages_freed += PAGE_TABLE_SIZE;
+    }
+
+    return E_SUCCESS;
+}
+
+/**
+ * ptable_unmap_range() - Remove a range of page mappings, gathering the work.
+ * @tlb:       The gather structure, initialised with the PGD to unmap from.
+ * @virt_addr: The virtual address to unmap from.
+ * @count:     How many pages to unmap.
+ * @free:      Whether to free the physical page frames used.
+ *
+ * Clears each present entry in the range, queuing its invalidation and, if
+ * requested, its page in the gather structure. When freeing, the swap slots
+ * of pages that were swapped out are released too. Page tables below kernel
+ * space left empty are unhooked from the PGD and freed too. Kernel page
+ * tables are shared by every PGD, so are never freed here. Huge pages only
+ * partly covered by the range are split first.
+ *
+ * Nothing is invalidated or freed until the gather structure is flushed, so
+ * the caller must finish with tlb_gather_finish().
+ */
+void ptable_unmap_range(struct tlb_gather * tlb, void * virt_addr,
+                        uint32_t count, int free) {
+    struct ptable_walk walk = {
+        .pgd     = tlb->pgd,
+        .flags   = PTW_EMPTY,
+        .pte_fn  = ptable_unmap_pte,
+        .pgt_fn  = ptable_unmap_pgt,
+        .huge_fn = ptable_unmap_huge,
+        .tlb     = tlb,
+        .private = &free
+    };
+
+    ptable_walk_range(&walk, virt_addr, virt_addr + count * PAGE_SIZE);
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * ptable_unmap_many() - Remove multiple page mappings from a page table.
  * @pgd:       The top-level page table (PGD) to removing the mappings from.
@@ -203,106 +898,318 @@ void ptable_unmap(struct pgd * pgd, void * virt_addr, int free) {
  * @count:     How many pages to unmap.
  * @free:      Whether to free the physical page frames used.
  *
- * Frees multiple contiguous page mappings to a table by calling ptable_unmap()
- * for each page address in the range.
+ * Removes multiple contiguous page mappings with ptable_unmap_range(), so
+ * that the TLB is invalidated and the pages are freed in batches, and any
+ * emptied page tables are freed.
  */
 void ptable_unmap_many(struct pgd * pgd, void * virt_addr, int count, int free) {
-    for(int i = 0; i < count; i++) {
-        ptable_unmap(pgd, virt_addr + i * PAGE_SIZE, free);
-    }
+    struct tlb_gather tlb;
+
+    tlb_gather_init(&tlb, pgd);
+    ptable_unmap_range(&tlb, virt_addr, count, free);
+    tlb_gather_finish(&tlb);
 }
 
 /* ------------------------------------------------------------------------- */
+/* Copying, Protection and Scanning                                          */
+/* ------------------------------------------------------------------------- */
+
+struct ptable_copy_data {
+    struct pgd * dest_pgd;
+    flags_t      flags;
+};
+
+static int32_t ptable_copy_pte(struct ptable_walk * walk, struct pte * pte_old,
+                               void * virt_addr) {
+    struct ptable_copy_data * data = walk->private;
+
+    if(!PTE_EXISTS(pte_old) && !PTE_IS_SWAP(pte_old)) {
+        return E_SUCCESS;
+    }
+
+    /* Check if a PDE already exists in the destination table */
+    struct pde * pde_new = GET_PDE(data->dest_pgd, virt_addr);
+    if(!PDE_EXISTS(pde_new) && !SUCCESS(ptable_pgt_alloc(pde_new))) {
+        return E_ERROR;
+    }
+
+    struct pte * pte_new = GET_PTE(PDE_TO_PGT(pde_new), virt_addr);
+
+    /* A page that was swapped out is read back in separately by each */
+    if(PTE_IS_SWAP(pte_old)) {
+        swap_dup(PTE_SWAP_SLOT(pte_old));
+        *pte_new = *pte_old;
+        return E_SUCCESS;
+    }
+
+    if(TEST_BIT(data->flags, PTC_SHARE)) {
+        /* New PTEs will refer to the same physical pages as the source
+         * table. Device memory has no struct page to count */
+        if(page_pfn_is_ram(PTE_PFN(pte_old))) {
+            PAGE_INC_USES(PTE_PAGE(pte_old));
+            rmap_add(PTE_PAGE(pte_old), data->dest_pgd, virt_addr);
+        }
+        *pte_new = *pte_old;
+    } else if(TEST_BIT(data->flags, PTC_COPY)) {
+        /* New PTEs will refer to new physical pages containing the copied
+         * content of the original pages, with the same permissions */
+        struct page * page = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+        if(!page) {
+            return E_ERROR;
+        }
+
+        highmem_copy_page(page, PTE_PAGE(pte_old));
+        *pte_new = MAKE_PTE_PFN(page->pfn, pte_old->entry &
+                                ~(PTE_ACCESSED | PTE_DIRTY));
+    } else if(TEST_BIT(data->flags, PTC_COW)) {
+        /* New PTEs will refer to the same physical pages as the source
+         * table, but will be copied to new pages upon a write. Device memory
+         * has no struct page to count, and is simply shared */
+        if(!page_pfn_is_ram(PTE_PFN(pte_old))) {
+            *pte_new = *pte_old;
+            return E_SUCCESS;
+        }
+
+        /* Both sides lose write access, so that the first to write faults
+         * and takes a copy of its own */
+        if(PTE_IS_WRITABLE(pte_old)) {
+            PTE_UNSET_WRITABLE(pte_old);
+            pte_old->entry |= PTE_COW;
+            tlb_gather_inval(walk->tlb, virt_addr);
+        }
+
+        PAGE_INC_USES(PTE_PAGE(pte_old));
+        rmap_add(PTE_PAGE(pte_old), data->dest_pgd, virt_addr);
+        *pte_new = *pte_old;
+    }
+
+    return E_SUCCESS;
+}
 
 /**
  * ptable_copy_range() - Copy a range of mappings from one PGD to another.
  * @source_pgd: The PGD to copy the mappings from.
  * @dest_pgd:   The PGD to copy the mappings to.
  * @start_addr: The starting address of the virtual address range to copy.
- * @end_addr:   The end address of the virtual address range to copy.
- * @flags:      Reserved.
+ * @end_addr:   The end (exclusive) address of the virtual address range.
+ * @flags:      PTC_SHARE to share the source's pages, PTC_COPY to copy
+ *              them into newly allocated pages, or PTC_COW to share them
+ *              until either side writes to them.
+ *
+ * Walks the present entries of the source range, allocating page tables in
+ * the destination as required. Swap entries are copied whatever the flags,
+ * each taking another use of the swap slot. With PTC_COW, writable source entries are
+ * made read-only, so only the page tables are copied up front, and huge
+ * pages in the source are split so that each page can be copied alone.
  *
- * TODO
+ * Return: E_SUCCESS on success, E_ERROR if memory ran out part way.
  */
-void ptable_copy_range(struct pgd * source_pgd, struct pgd * dest_pgd,
-                        void * start_addr, void * end_addr, flags_t flags) {
+int32_t ptable_copy_range(struct pgd * source_pgd, struct pgd * dest_pgd,
+                          void * start_addr, void * end_addr, flags_t flags) {
 
     klog("ptable_copy_range(src: 0x%x, dst: 0x%x, sa: 0x%x, ea: 0x%x)\n",
          source_pgd, dest_pgd, start_addr, end_addr);
 
-    int start_pde = PAGE_DIRECTORY_INDEX(start_addr);
-    int end_pde   = PAGE_DIRECTORY_INDEX(end_addr);
-    int start_pte = PAGE_TABLE_INDEX(start_addr);
-    int end_pte   = PAGE_TABLE_INDEX(end_addr);
+    struct ptable_copy_data data = {
+        .dest_pgd = dest_pgd,
+        .flags    = flags
+    };
 
-    /* For each Page Directory Entry */
-    for(int curr_pde = start_pde; curr_pde <= end_pde; curr_pde++) {
-        /* Check that a PDE exists at this index in the source */
-        struct pde * pde_old = &source_pgd->entries[curr_pde];
-        if(!PDE_EXISTS(pde_old)) {
-            continue;
-        }
+    struct tlb_gather tlb;
+    tlb_gather_init(&tlb, source_pgd);
 
-        /* Check if a PDE already exists in the destination table */
-        struct pde * pde_new = &dest_pgd->entries[curr_pde];
-        if(!PDE_EXISTS(pde_new)) {
-            struct page * pde_page = page_alloc(0, PR_KERNEL);
+    struct ptable_walk walk = {
+        .pgd     = source_pgd,
+        .flags   = PTW_EMPTY,
+        .pte_fn  = ptable_copy_pte,
+        .tlb     = &tlb,
+        .private = &data
+    };
 
-            /* Set the new PDE entry to point to the new page */
-            *pde_new = MAKE_PDE(PAGE_PA(pde_page),
-                                PDE_PRESENT | PDE_WRITABLE | PDE_USER);
-        }
+    int32_t rv = ptable_walk_range(&walk, start_addr, end_addr);
+    tlb_gather_finish(&tlb);
 
-        /* Get the PGTs for the PDE */
-        struct pgt * pgt_new = PDE_TO_PGT(pde_new);
-        struct pgt * pgt_old = PDE_TO_PGT(pde_old);
-
-        /* Iterate through each page table entry - for the first PDE, we will
-         * want to make sure that we start from the right index in the first
-         * table and end at the right index in the last table. Any tables in
-         * the middle, we'll cover entirely. */
-        int curr_start_pte = 0;
-        int curr_end_pte   = PAGE_TABLE_SIZE;
-        if(curr_pde == start_pde) {
-            curr_start_pte = start_pte; /* First PDE */
-        } else if (curr_pde == end_pde) {
-            curr_end_pte = end_pte;     /* End PDE */
-        }
+    if(!SUCCESS(rv)) {
+        klog("ptable_copy_range(): failed to copy range!\n");
+    }
 
-        for(; curr_start_pte < curr_end_pte; curr_start_pte++) {
-            if(!PTE_EXISTS(&pgt_old->entries[curr_start_pte])) {
-                continue;
-            }
+    return rv;
+}
 
-            struct pte * pte_new = &pgt_new->entries[curr_start_pte];
-            struct pte * pte_old = &pgt_old->entries[curr_start_pte];
-
-            if(TEST_BIT(flags, PTC_SHARE)) {
-                /* New PTEs will refer to the same physical pages as the source
-                 * table */
-                void * pte_old_pa = PTE_PA(pte_old);
-                struct page * page_old = PA_PAGE(pte_old_pa);
-                PAGE_INC_USES(page_old);
-                *pte_new = *pte_old;
-            } else if(TEST_BIT(flags, PTC_COPY)) {
-                /* New PTEs will refer to new physical pages containing the
-                 * copied content of the original pages */
-                void * copied_page = PAGE_VA(page_alloc(0, PR_KERNEL));
-                void * orig_page   = PTE_VA(pte_old);
-
-                /* Copy the contents of the source page to our new page */
-                memcpy(copied_page, orig_page, PAGE_SIZE);
-
-                /* Create a new PTE pointing to our new page */
-                *pte_new = MAKE_PTE(VIR_TO_PHY(copied_page),
-                                    PTE_PRESENT | PTE_USER);
-            } else if(TEST_BIT(flags, PTC_COW)) {
-                /* New PTEs will refer to the same physical pages as the source
-                 * table, but will be copied to new pages upon a write */
-                /* TODO */
-            }
+/* ------------------------------------------------------------------------- */
+
+/**
+ * ptable_cow_fault() - Resolve a write to a copy-on-write page.
+ * @pgd:       The top-level page table (PGD) containing the mapping.
+ * @virt_addr: The address that was written to.
+ *
+ * If other page tables still share the page, it is copied into a new page
+ * for this one. Otherwise, this is the last mapping of the page, which can
+ * be made writable again without copying.
+ *
+ * Return: E_SUCCESS if the page can now be written to, E_ERROR if it wasn't
+ *         copy-on-write or no page could be allocated for the copy.
+ */
+int32_t ptable_cow_fault(struct pgd * pgd, void * virt_addr) {
+    struct pde * pde = GET_PDE(pgd, virt_addr);
+    if(!PDE_EXISTS(pde) || PDE_IS_HUGE(pde)) {
+        return E_ERROR;
+    }
+
+    struct pte * pte = GET_PTE(PDE_TO_PGT(pde), virt_addr);
+    if(!PTE_EXISTS(pte) || !TEST_BIT(pte->entry, PTE_COW)) {
+        return E_ERROR;
+    }
+
+    struct page * page = PTE_PAGE(pte);
+    if(page->use_count > 1) {
+        struct page * copy = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+        if(!copy) {
+            klog("ptable_cow_fault(): No page to copy 0x%x into\n",
+                 virt_addr);
+            return E_ERROR;
         }
+
+        highmem_copy_page(copy, page);
+        *pte = MAKE_PTE_PFN(copy->pfn, pte->entry & PTE_FLAGS_MASK &
+                                       ~(PTE_ACCESSED | PTE_DIRTY));
+
+        /* Drops this table's reference to the shared page */
+        rmap_remove(page, pgd, virt_addr);
+        rmap_add_new(copy, pgd, virt_addr);
+        page_free(page, 0);
+    }
+
+    pte->entry &= ~PTE_COW;
+    PTE_SET_WRITABLE(pte);
+    paging_inval_tlb_entry(virt_addr);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int32_t ptable_protect_pte(struct ptable_walk * walk, struct pte * pte,
+                                  void * virt_addr) {
+    flags_t flags = *(flags_t*)walk->private;
+
+    /* A copy-on-write page stays read-only until it has been copied */
+    if(TEST_BIT(flags, VM_MAP_WRITE) && !TEST_BIT(pte->entry, PTE_COW)) {
+        PTE_SET_WRITABLE(pte);
+    } else {
+        PTE_UNSET_WRITABLE(pte);
+    }
+    pte->entry = (pte->entry & ~PTE_NX) | ptable_nx_flags(flags);
+
+    tlb_gather_inval(walk->tlb, virt_addr);
+    return E_SUCCESS;
+}
+
+static int32_t ptable_protect_huge(struct ptable_walk * walk,
+                                   struct pde * pde, void * virt_addr) {
+    flags_t flags = *(flags_t*)walk->private;
+
+    if(TEST_BIT(flags, VM_MAP_WRITE)) {
+        PDE_SET_WRITABLE(pde);
+    } else {
+        PDE_UNSET_WRITABLE(pde);
     }
+    pde->entry = (pde->entry & ~PTE_NX) | ptable_nx_flags(flags);
+
+    tlb_gather_inval(walk->tlb, virt_addr);
+    return E_SUCCESS;
+}
+
+/**
+ * ptable_protect_range() - Change the protection of a range of mappings.
+ * @pgd:       The top-level page table (PGD) containing the mappings.
+ * @virt_addr: The first virtual address to change.
+ * @count:     How many pages to change.
+ * @flags:     The new VM_MAP_* flags (e.g. writable) for the pages.
+ */
+void ptable_protect_range(struct pgd * pgd, void * virt_addr, int count,
+                          flags_t flags) {
+    struct tlb_gather tlb;
+    tlb_gather_init(&tlb, pgd);
+
+    struct ptable_walk walk = {
+        .pgd     = pgd,
+        .pte_fn  = ptable_protect_pte,
+        .huge_fn = ptable_protect_huge,
+        .tlb     = &tlb,
+        .private = &flags
+    };
+
+    ptable_walk_range(&walk, virt_addr, virt_addr + count * PAGE_SIZE);
+    tlb_gather_finish(&tlb);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int32_t ptable_accessed_pte(struct ptable_walk * walk, struct pte * pte,
+                                   void * virt_addr) {
+    if(!pte->accessed) {
+        return E_SUCCESS;
+    }
+
+    (*(uint32_t*)walk->private)++;
+
+    if(walk->tlb) {
+        pte->accessed = 0;
+        tlb_gather_inval(walk->tlb, virt_addr);
+    }
+
+    return E_SUCCESS;
+}
+
+static int32_t ptable_accessed_huge(struct ptable_walk * walk,
+                                    struct pde * pde, void * virt_addr) {
+    if(!pde->accessed) {
+        return E_SUCCESS;
+    }
+
+    /* A huge page has a single accessed bit for all of its pages */
+    *(uint32_t*)walk->private += PAGE_TABLE_SIZE;
+
+    if(walk->tlb) {
+        pde->accessed = 0;
+        tlb_gather_inval(walk->tlb, virt_addr);
+    }
+
+    return E_SUCCESS;
+}
+
+/**
+ * ptable_scan_accessed() - Count the recently accessed pages in a range.
+ * @pgd:       The top-level page table (PGD) containing the mappings.
+ * @virt_addr: The first virtual address to scan.
+ * @count:     How many pages to scan.
+ * @clear:     Whether to clear the accessed bits found.
+ *
+ * The CPU sets a page's accessed bit whenever it is used. Clearing the bits
+ * also invalidates their TLB entries, so that the CPU sets them again on the
+ * next access rather than using a cached translation.
+ *
+ * Return: The number of present pages with the accessed bit set.
+ */
+uint32_t ptable_scan_accessed(struct pgd * pgd, void * virt_addr, int count,
+                              int clear) {
+    uint32_t accessed = 0;
+    struct tlb_gather tlb;
+    tlb_gather_init(&tlb, pgd);
+
+    struct ptable_walk walk = {
+        .pgd     = pgd,
+        .pte_fn  = ptable_accessed_pte,
+        .huge_fn = ptable_accessed_huge,
+        .tlb     = clear ? &tlb : NULL,
+        .private = &accessed
+    };
+
+    ptable_walk_range(&walk, virt_addr, virt_addr + count * PAGE_SIZE);
+    tlb_gather_finish(&tlb);
+
+    return accessed;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -334,7 +1241,7 @@ int ptable_pgt_is_clear(struct pgt * pgt) {
  *
  * Retrieves a pointer to the page table entry for the given virtual address
  * in the target page global directory. Fails if no PDE can be found for
- * the virtual address. Can be used to retrieve the physical address for a
+ * the virtual address, or if it is mapped by a huge page. Can be used to retrieve the physical address for a
  * virtual mapping and its associated properties.
  *
  * Return: A pointer to the pte object for the address mapping.
@@ -347,6 +1254,12 @@ struct pte * ptable_get_pte(struct pgd * pgd, void * virt_addr) {
         return NULL;
     }
 
+    if(PDE_IS_HUGE(pde)) {
+        klog("ptable_get_pte(): va. 0x%x is mapped by a huge page\n",
+             virt_addr);
+        return NULL;
+    }
+
     struct pgt * pgt = PDE_TO_PGT(pde);
     struct pte * pte = GET_PTE(pgt, virt_addr);
 
@@ -354,3 +1267,8 @@ struct pte * ptable_get_pte(struct pgd * pgd, void * virt_addr) {
 }
 
 /* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/ptable.c"
+
+/* ------------------------------------------------------------------------- */
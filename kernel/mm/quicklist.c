@@ -0,0 +1,227 @@
+/*
+ * kernel/mm/quicklist.c
+ * Page Quicklists
+ *
+ * A quicklist caches single pages which have already been prepared for a
+ * particular use, such as PGDs with the kernel mappings copied in, so that
+ * the preparation is skipped when a page is needed. Pages are prepared by
+ * the quicklist's constructor when the list is refilled, which is done from
+ * the idle loop, keeping the cost off the allocation path.
+ *
+ * Pages freed to a quicklist must be returned in their prepared state, apart
+ * from the first word, which is used to link the list and is cleared when
+ * the page is handed out again. Once a quicklist holds its high watermark,
+ * further pages are freed to the page allocator, after the quicklist's
+ * destructor, if it has one, has released anything the constructor set up.
+ */
+
+#include <rotary/mm/quicklist.h>
+#include <rotary/mm/palloc.h>
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_init() - Initialise an empty quicklist.
+ * @ql:   The quicklist to initialise.
+ * @name: Name of the quicklist, for debugging.
+ * @low:  The quicklist is refilled when it holds fewer pages than this.
+ * @high: The most pages the quicklist will hold.
+ * @ctor: Prepares each newly allocated page.
+ * @dtor: Releases anything held by a prepared page before it is freed, or
+ *        NULL if there's nothing to release.
+ */
+void quicklist_init(struct quicklist * ql, const char * name, uint32_t low,
+        uint32_t high, quicklist_ctor_t ctor, quicklist_dtor_t dtor) {
+    ql->name   = name;
+    ql->head   = NULL;
+    ql->count  = 0;
+    ql->low    = low;
+    ql->high   = high;
+    ql->ctor   = ctor;
+    ql->dtor   = dtor;
+    ql->hits   = 0;
+    ql->misses = 0;
+    atomic_flag_clear(&ql->lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_prepare() - Allocate a page and prepare it with the constructor.
+ * @ql: The quicklist.
+ *
+ * Return: The virtual address of the page, or NULL on failure.
+ */
+static void * quicklist_prepare(struct quicklist * ql) {
+    void * page = page_alloc_va(0, PR_KERNEL);
+    if(!page) {
+        return NULL;
+    }
+
+    if(!SUCCESS(ql->ctor(page))) {
+        page_free_va(page, 0);
+        return NULL;
+    }
+
+    return page;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_release() - Free a prepared page to the page allocator.
+ * @ql:   The quicklist.
+ * @page: The virtual address of the page, in its prepared state.
+ */
+static void quicklist_release(struct quicklist * ql, void * page) {
+    if(ql->dtor) {
+        ql->dtor(page);
+    }
+
+    page_free_va(page, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_push() - Add a prepared page to a quicklist.
+ * @ql:   The quicklist.
+ * @page: The virtual address of the page.
+ *
+ * Return: E_SUCCESS if added, E_ERROR if the quicklist is full.
+ */
+static int32_t quicklist_push(struct quicklist * ql, void * page) {
+    lock(&ql->lock);
+    if(ql->count >= ql->high) {
+        unlock(&ql->lock);
+        return E_ERROR;
+    }
+
+    *(void**)page = ql->head;
+    ql->head = page;
+    ql->count++;
+    unlock(&ql->lock);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_alloc() - Allocate a prepared page.
+ * @ql: The quicklist to allocate from.
+ *
+ * If the quicklist is empty, a page is allocated and prepared immediately.
+ *
+ * Return: The virtual address of the page, or NULL on failure.
+ */
+void * quicklist_alloc(struct quicklist * ql) {
+    lock(&ql->lock);
+    void * page = ql->head;
+    if(page) {
+        ql->head = *(void**)page;
+        ql->count--;
+        ql->hits++;
+        unlock(&ql->lock);
+
+        *(void**)page = NULL;
+        return page;
+    }
+    ql->misses++;
+    unlock(&ql->lock);
+
+    return quicklist_prepare(ql);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_free() - Return a prepared page to a quicklist.
+ * @ql:   The quicklist the page was allocated from.
+ * @page: The virtual address of the page, in its prepared state.
+ */
+void quicklist_free(struct quicklist * ql, void * page) {
+    if(!SUCCESS(quicklist_push(ql, page))) {
+        quicklist_release(ql, page);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_refill() - Top up a quicklist that has run low.
+ * @ql: The quicklist to refill.
+ *
+ * Does nothing unless the quicklist holds fewer than its low watermark,
+ * so is cheap enough to call repeatedly from the idle loop.
+ *
+ * Return: The number of pages added.
+ */
+uint32_t quicklist_refill(struct quicklist * ql) {
+    uint32_t added = 0;
+
+    if(ql->count >= ql->low) {
+        return 0;
+    }
+
+    while(ql->count < ql->high) {
+        void * page = quicklist_prepare(ql);
+        if(!page) {
+            break;
+        }
+
+        if(!SUCCESS(quicklist_push(ql, page))) {
+            quicklist_release(ql, page);
+            break;
+        }
+        added++;
+    }
+
+    return added;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_drain() - Free every page held by a quicklist.
+ * @ql: The quicklist to drain.
+ *
+ * Used when the prepared state of the cached pages is no longer valid.
+ *
+ * Return: The number of pages freed.
+ */
+uint32_t quicklist_drain(struct quicklist * ql) {
+    lock(&ql->lock);
+    void * page = ql->head;
+    uint32_t count = ql->count;
+    ql->head  = NULL;
+    ql->count = 0;
+    unlock(&ql->lock);
+
+    while(page) {
+        void * next = *(void**)page;
+        quicklist_release(ql, page);
+        page = next;
+    }
+
+    return count;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * quicklist_print_debug() - Print quicklist information to the kernel log.
+ * @ql: The quicklist.
+ */
+void quicklist_print_debug(struct quicklist * ql) {
+    klog("Quicklist '%s' [count: %d, low: %d, high: %d, hits: %d, "
+         "misses: %d]\n", ql->name, ql->count, ql->low, ql->high, ql->hits,
+         ql->misses);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/quicklist.c"
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,394 @@
+/*
+ * kernel/mm/reclaim.c
+ * Page Reclaim
+ *
+ * User pages that may be reclaimed are kept on two LRU lists. New pages join
+ * the head of the inactive list, and reclaim works from its tail, giving
+ * each page a second chance: if any entry mapping it has been accessed since
+ * it was last looked at, or the working set scan last saw it used, it is
+ * moved to the active list rather than reclaimed. The accessed bits are
+ * found through the page's reverse mapping, and cleared as they're checked.
+ * Whenever the active list outgrows the inactive one, pages from its tail
+ * that haven't been referenced are moved back to the inactive list, so that
+ * pages used once and then forgotten eventually become candidates again.
+ *
+ * Reclaiming a page writes it to swap, and points every entry mapping it at
+ * its swap slot. Without a swap area, nothing can be reclaimed.
+ *
+ * Reclaim is driven by the number of free pages. When an allocation leaves
+ * fewer than reclaim_wmark_low, the reclaim task (kswapd) is woken, and
+ * frees pages in batches until there are reclaim_wmark_high free, before
+ * pausing itself until woken again. Should it fall behind, and free pages
+ * drop below reclaim_wmark_min, page faults reclaim a batch directly before
+ * allocating, so that memory runs out only once swap has too.
+ *
+ * Each page is aged and reclaimed with interrupts disabled, so that faults
+ * and unmaps can't change its entries part way through.
+ */
+
+#include <rotary/mm/reclaim.h>
+
+/* ------------------------------------------------------------------------- */
+
+struct lru_list lru_active = {
+    .head  = INIT_LIST_HEAD(lru_active.head),
+    .count = 0
+};
+
+struct lru_list lru_inactive = {
+    .head  = INIT_LIST_HEAD(lru_inactive.head),
+    .count = 0
+};
+
+volatile atomic_flag lru_lock = ATOMIC_FLAG_INIT;
+
+uint32_t reclaim_wmark_min  = 0;
+uint32_t reclaim_wmark_low  = 0;
+uint32_t reclaim_wmark_high = 0;
+
+struct reclaim_stats reclaim_stats;
+
+struct task * reclaim_task = NULL;
+volatile uint32_t reclaim_pending = 0;
+
+/* ------------------------------------------------------------------------- */
+/* LRU Lists                                                                 */
+/* ------------------------------------------------------------------------- */
+
+static struct lru_list * lru_list_of(struct page * page) {
+    return TEST_BIT(page->flags, PF_ACTIVE) ? &lru_active : &lru_inactive;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lru_add() - Put a page at the head of the inactive list.
+ * @page: The page, which must not be on either list.
+ *
+ * A page in use is never on the buddy allocator's free lists, so its
+ * buddy_node links it into the LRU lists instead.
+ */
+void lru_add(struct page * page) {
+    uint32_t eflags = cpu_irq_save();
+    lock(&lru_lock);
+
+    clist_add(&lru_inactive.head, &page->buddy_node);
+    lru_inactive.count++;
+    SET_BIT(page->flags, PF_LRU);
+    CLEAR_BIT(page->flags, PF_ACTIVE);
+
+    unlock(&lru_lock);
+    cpu_irq_restore(eflags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lru_del() - Take a page off the LRU lists.
+ * @page: The page, which is left alone if it is on neither list.
+ */
+void lru_del(struct page * page) {
+    uint32_t eflags = cpu_irq_save();
+    lock(&lru_lock);
+
+    if(TEST_BIT(page->flags, PF_LRU)) {
+        clist_delete_node(&page->buddy_node);
+        lru_list_of(page)->count--;
+        CLEAR_BIT(page->flags, PF_LRU | PF_ACTIVE);
+    }
+
+    unlock(&lru_lock);
+    cpu_irq_restore(eflags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lru_move() - Move a page to the head of a list.
+ * @page:   The page, which is on one of the lists.
+ * @active: Whether to move it to the active list, rather than inactive.
+ *
+ * The page is left alone if it has been taken off the lists meanwhile.
+ */
+static void lru_move(struct page * page, int active) {
+    lock(&lru_lock);
+
+    if(TEST_BIT(page->flags, PF_LRU)) {
+        clist_delete_node(&page->buddy_node);
+        lru_list_of(page)->count--;
+
+        struct lru_list * list = active ? &lru_active : &lru_inactive;
+        clist_add(&list->head, &page->buddy_node);
+        list->count++;
+
+        if(active) {
+            SET_BIT(page->flags, PF_ACTIVE);
+        } else {
+            CLEAR_BIT(page->flags, PF_ACTIVE);
+        }
+    }
+
+    unlock(&lru_lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lru_tail() - Retrieve the least recently added page on a list.
+ * @list: The list.
+ *
+ * Return: The page, or NULL if the list is empty.
+ */
+static struct page * lru_tail(struct lru_list * list) {
+    struct page * page = NULL;
+
+    lock(&lru_lock);
+    if(list->count) {
+        page = container_of(list->head.prev, struct page, buddy_node);
+    }
+    unlock(&lru_lock);
+
+    return page;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Aging                                                                     */
+/* ------------------------------------------------------------------------- */
+
+static int32_t reclaim_young_pte(struct page * page, struct pte * pte,
+                                 void * virt_addr, void * private) {
+    if(!TEST_BIT(pte->entry, PTE_ACCESSED)) {
+        return 0;
+    }
+
+    CLEAR_BIT(pte->entry, PTE_ACCESSED);
+    (*(uint32_t*)private)++;
+    return 1;
+}
+
+/**
+ * reclaim_referenced() - Returns whether a page has been used recently.
+ * @page: The page.
+ *
+ * Checks and clears the accessed bit of every entry mapping the page. The
+ * working set scan clears them too, so a page it saw used in its latest scan
+ * also counts as referenced.
+ *
+ * Return: 1 if the page has been referenced, 0 otherwise.
+ */
+static int reclaim_referenced(struct page * page) {
+    uint32_t young = 0;
+
+    rmap_walk(page, reclaim_young_pte, &young);
+    return young || wss_page_age(page) == 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * reclaim_balance() - Refill the inactive list from the active list.
+ *
+ * Pages at the tail of the active list that haven't been referenced since
+ * they were last checked are deactivated, while the active list is the
+ * larger, up to a batch at a time. Referenced pages are rotated back to the
+ * head of the active list.
+ */
+static void reclaim_balance() {
+    for(uint32_t i = 0; i < RECLAIM_BATCH; i++) {
+        uint32_t eflags = cpu_irq_save();
+
+        struct page * page = lru_tail(&lru_active);
+        if(!page || lru_active.count <= lru_inactive.count) {
+            cpu_irq_restore(eflags);
+            return;
+        }
+
+        if(reclaim_referenced(page)) {
+            lru_move(page, 1);
+        } else {
+            lru_move(page, 0);
+            reclaim_stats.deactivated++;
+        }
+
+        cpu_irq_restore(eflags);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+/* Reclaim                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * reclaim_pages() - Free pages by swapping out inactive ones.
+ * @target: The number of pages to free.
+ *
+ * Scans the inactive list from its tail, activating pages that have been
+ * referenced and swapping out those that haven't. Pages that can't be
+ * swapped out, such as those shared writable or with swap full, are rotated
+ * to the head of the list. Gives up after RECLAIM_SCAN_RATIO pages have been
+ * scanned for each one asked for.
+ *
+ * Return: The number of pages freed.
+ */
+uint32_t reclaim_pages(uint32_t target) {
+    uint32_t reclaimed = 0;
+
+    if(!swap_active()) {
+        return 0;
+    }
+
+    reclaim_balance();
+
+    for(uint32_t i = 0; i < target * RECLAIM_SCAN_RATIO; i++) {
+        if(reclaimed >= target) {
+            break;
+        }
+
+        uint32_t eflags = cpu_irq_save();
+
+        struct page * page = lru_tail(&lru_inactive);
+        if(!page) {
+            cpu_irq_restore(eflags);
+            break;
+        }
+
+        reclaim_stats.scanned++;
+        if(reclaim_referenced(page)) {
+            lru_move(page, 1);
+            reclaim_stats.activated++;
+        } else if(SUCCESS(swap_out(page))) {
+            reclaimed++;
+        } else {
+            lru_move(page, 0);
+        }
+
+        cpu_irq_restore(eflags);
+    }
+
+    reclaim_stats.reclaimed += reclaimed;
+    return reclaimed;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * reclaim_wake() - Wake the reclaim task.
+ *
+ * Called by page_alloc() once free pages fall below reclaim_wmark_low. Does
+ * nothing without a swap area, as there would be nothing to reclaim to.
+ */
+void reclaim_wake() {
+    if(!reclaim_task || !swap_active()) {
+        return;
+    }
+
+    uint32_t eflags = cpu_irq_save();
+    if(!reclaim_pending) {
+        reclaim_pending = 1;
+        reclaim_stats.wakeups++;
+        if(reclaim_task->state == TASK_STATE_PAUSED) {
+            reclaim_task->state = TASK_STATE_WAITING;
+        }
+    }
+    cpu_irq_restore(eflags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * reclaim_direct() - Reclaim a batch of pages, if memory has almost run out.
+ *
+ * Called by page faults before allocating, for when the reclaim task can't
+ * keep up.
+ */
+void reclaim_direct() {
+    if(page_free_count() >= reclaim_wmark_min || !swap_active()) {
+        return;
+    }
+
+    reclaim_stats.direct++;
+    reclaim_pages(RECLAIM_BATCH);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * reclaim_task_main() - Entry point of the reclaim task.
+ *
+ * Pauses itself until woken by reclaim_wake(), then frees pages until there
+ * are reclaim_wmark_high free, or nothing more can be reclaimed. A wake-up
+ * arriving while it is reclaiming sets reclaim_pending again, so isn't lost.
+ */
+static void reclaim_task_main() {
+    while(true) {
+        uint32_t eflags = cpu_irq_save();
+        if(!reclaim_pending) {
+            reclaim_task->state = TASK_STATE_PAUSED;
+        }
+        cpu_irq_restore(eflags);
+
+        /* The scheduler won't return to a paused task until it is woken */
+        while(*(volatile task_state_t *)&reclaim_task->state ==
+              TASK_STATE_PAUSED) { }
+
+        reclaim_pending = 0;
+        while(page_free_count() < reclaim_wmark_high &&
+              reclaim_pages(RECLAIM_BATCH)) { }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * reclaim_init() - Set the watermarks and start the reclaim task.
+ *
+ * The watermarks scale with the size of memory, at 1/256, 1/128 and 1/64 of
+ * it. The task starts paused, as there is nothing to do until swap has been
+ * enabled and memory runs low.
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t reclaim_init() {
+    uint32_t total = page_total_count();
+
+    reclaim_wmark_min  = total / 256;
+    reclaim_wmark_low  = total / 128;
+    reclaim_wmark_high = total / 64;
+
+    reclaim_task = task_create("kswapd", TASK_KERNEL, &reclaim_task_main,
+                               TASK_PRIORITY_MIN, TASK_STATE_PAUSED);
+    if(!reclaim_task) {
+        klog("reclaim_init(): Failed to create the reclaim task!\n");
+        return E_ERROR;
+    }
+
+    return E_SUCCESS;
+}
+
+late_initcall(reclaim_init);
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * reclaim_print_debug() - Print the LRU lists, watermarks and statistics.
+ */
+void reclaim_print_debug() {
+    printk(LOG_DEBUG, "LRU: %d active, %d inactive\n", lru_active.count,
+           lru_inactive.count);
+    printk(LOG_DEBUG, "Free: %d pages (min %d, low %d, high %d)\n",
+           page_free_count(), reclaim_wmark_min, reclaim_wmark_low,
+           reclaim_wmark_high);
+    printk(LOG_DEBUG, "Reclaimed: %d of %d scanned, %d activated, "
+           "%d deactivated\n", reclaim_stats.reclaimed, reclaim_stats.scanned,
+           reclaim_stats.activated, reclaim_stats.deactivated);
+    printk(LOG_DEBUG, "kswapd wakeups: %d, direct reclaims: %d\n",
+           reclaim_stats.wakeups, reclaim_stats.direct);
+    swap_print_debug();
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/reclaim.c"
+
+/* ------------------------------------------------------------------------- */
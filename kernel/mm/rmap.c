@@ -0,0 +1,305 @@
+/*
+ * kernel/mm/rmap.c
+ * Reverse Mapping
+ *
+ * Page tables map from virtual addresses to pages, but reclaiming a page
+ * needs the opposite: every page table entry mapping it, so that each can be
+ * checked for recent use and pointed at the page's copy in swap. A page that
+ * may be reclaimed has a chain of struct rmap entries from page->rmap, one
+ * per entry mapping it, added and removed by the page table code as it maps
+ * and unmaps user pages. While the chain isn't empty, the page is also kept
+ * on the LRU lists.
+ *
+ * Only anonymous pages private to their mappings are tracked. The zero page,
+ * huge pages and device memory never are. Should an entry fail to allocate,
+ * the page's whole chain is dropped, so that a tracked page's chain is always
+ * complete and the page is simply never reclaimed.
+ *
+ * Changes to the chains happen with interrupts disabled, so that they can't
+ * interleave with the reclaim of the same page.
+ */
+
+#include <rotary/mm/rmap.h>
+
+/* ------------------------------------------------------------------------- */
+
+slab_cache_t * rmap_cache = NULL;
+
+volatile atomic_flag rmap_lock = ATOMIC_FLAG_INIT;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_init() - Create the slab cache for reverse mapping entries.
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t __init rmap_init() {
+    rmap_cache = slab_cache_create("rmap", sizeof(struct rmap), 0, 0);
+    return rmap_cache ? E_SUCCESS : E_ERROR;
+}
+
+core_initcall(rmap_init);
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_new() - Allocate a reverse mapping entry.
+ * @pgd:       The PGD containing the page table entry.
+ * @virt_addr: The address the entry maps.
+ *
+ * Return: The entry, or NULL if memory ran out.
+ */
+static struct rmap * rmap_new(struct pgd * pgd, void * virt_addr) {
+    if(!rmap_cache) {
+        return NULL;
+    }
+
+    struct rmap * entry = slab_malloc(rmap_cache, 0);
+    if(!entry) {
+        return NULL;
+    }
+
+    entry->pgd  = pgd;
+    entry->addr = (void*)PAGE_ALIGN_DOWN(virt_addr);
+    entry->next = NULL;
+    return entry;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_free_chain() - Free every entry on a chain.
+ * @entry: The first entry.
+ */
+static void rmap_free_chain(struct rmap * entry) {
+    while(entry) {
+        struct rmap * next = entry->next;
+        slab_free(rmap_cache, entry);
+        entry = next;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_add_new() - Start tracking a newly mapped page.
+ * @page:      The page, which has just been mapped for the first time.
+ * @pgd:       The PGD it has been mapped into.
+ * @virt_addr: The address it has been mapped at.
+ *
+ * The page is put on the LRU lists, so that it may be reclaimed. If it is
+ * already tracked, the entry is added to its chain instead.
+ */
+void rmap_add_new(struct page * page, struct pgd * pgd, void * virt_addr) {
+    if(TEST_BIT(page->flags, PF_LRU)) {
+        rmap_add(page, pgd, virt_addr);
+        return;
+    }
+
+    struct rmap * entry = rmap_new(pgd, virt_addr);
+    if(!entry) {
+        return;
+    }
+
+    uint32_t eflags = cpu_irq_save();
+    lock(&rmap_lock);
+    page->rmap = entry;
+    unlock(&rmap_lock);
+
+    lru_add(page);
+    cpu_irq_restore(eflags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_add() - Record another entry mapping a page.
+ * @page:      The page, which has gained a mapping.
+ * @pgd:       The PGD it has been mapped into.
+ * @virt_addr: The address it has been mapped at.
+ *
+ * Does nothing if the page isn't tracked.
+ */
+void rmap_add(struct page * page, struct pgd * pgd, void * virt_addr) {
+    if(!TEST_BIT(page->flags, PF_LRU)) {
+        return;
+    }
+
+    struct rmap * entry = rmap_new(pgd, virt_addr);
+    if(!entry) {
+        /* An incomplete chain can't be used to unmap the page */
+        klog("rmap_add(): No memory, PFN 0x%x can no longer be reclaimed\n",
+             page->pfn);
+        rmap_clear(page);
+        return;
+    }
+
+    uint32_t eflags = cpu_irq_save();
+    lock(&rmap_lock);
+    entry->next = page->rmap;
+    page->rmap  = entry;
+    unlock(&rmap_lock);
+    cpu_irq_restore(eflags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_remove() - Forget an entry that no longer maps a page.
+ * @page:      The page, which has lost a mapping.
+ * @pgd:       The PGD it was mapped in.
+ * @virt_addr: The address it was mapped at.
+ *
+ * Once its last mapping is removed, the page is taken off the LRU lists.
+ * Does nothing if the page isn't tracked.
+ */
+void rmap_remove(struct page * page, struct pgd * pgd, void * virt_addr) {
+    if(!TEST_BIT(page->flags, PF_LRU)) {
+        return;
+    }
+
+    void * addr = (void*)PAGE_ALIGN_DOWN(virt_addr);
+    struct rmap * found = NULL;
+
+    uint32_t eflags = cpu_irq_save();
+    lock(&rmap_lock);
+
+    for(struct rmap ** link = &page->rmap; *link; link = &(*link)->next) {
+        if((*link)->pgd == pgd && (*link)->addr == addr) {
+            found = *link;
+            *link = found->next;
+            break;
+        }
+    }
+
+    int empty = page->rmap == NULL;
+    unlock(&rmap_lock);
+
+    if(found) {
+        slab_free(rmap_cache, found);
+    }
+    if(empty) {
+        lru_del(page);
+    }
+
+    cpu_irq_restore(eflags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_clear() - Stop tracking a page.
+ * @page: The page.
+ *
+ * Frees the page's chain and takes it off the LRU lists, leaving its page
+ * table entries untouched. Used once the page has been unmapped from every
+ * entry by reclaim, or when its chain can't be kept complete.
+ */
+void rmap_clear(struct page * page) {
+    uint32_t eflags = cpu_irq_save();
+    lock(&rmap_lock);
+    struct rmap * chain = page->rmap;
+    page->rmap = NULL;
+    unlock(&rmap_lock);
+
+    rmap_free_chain(chain);
+    if(TEST_BIT(page->flags, PF_LRU)) {
+        lru_del(page);
+    }
+
+    cpu_irq_restore(eflags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_count() - Count the entries mapping a page.
+ * @page: The page.
+ *
+ * Return: The number of entries on the page's chain, 0 if it isn't tracked.
+ */
+uint32_t rmap_count(struct page * page) {
+    uint32_t count = 0;
+
+    uint32_t eflags = cpu_irq_save();
+    lock(&rmap_lock);
+    for(struct rmap * entry = page->rmap; entry; entry = entry->next) {
+        count++;
+    }
+    unlock(&rmap_lock);
+    cpu_irq_restore(eflags);
+
+    return count;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * rmap_get_pte() - Find the entry a chain entry refers to.
+ * @page:  The page that should be mapped.
+ * @entry: The chain entry.
+ *
+ * Return: The page table entry, or NULL if it no longer maps the page.
+ */
+static struct pte * rmap_get_pte(struct page * page, struct rmap * entry) {
+    struct pde * pde = GET_PDE(entry->pgd, entry->addr);
+    if(!PDE_EXISTS(pde) || PDE_IS_HUGE(pde)) {
+        return NULL;
+    }
+
+    struct pte * pte = GET_PTE(PDE_TO_PGT(pde), entry->addr);
+    if(!PTE_EXISTS(pte) || PTE_PFN(pte) != page->pfn) {
+        return NULL;
+    }
+
+    return pte;
+}
+
+/**
+ * rmap_walk() - Visit each page table entry mapping a page.
+ * @page:    The page.
+ * @fn:      Called for each entry, which may change it. Must not add or
+ *           remove entries of any chain.
+ * @private: Passed to @fn.
+ *
+ * Entries changed by @fn are invalidated in the TLB if their PGD is the one
+ * currently loaded. Other PGDs hold nothing in the TLB to invalidate.
+ *
+ * Return: E_SUCCESS, or the error returned by @fn which stopped the walk.
+ */
+int32_t rmap_walk(struct page * page, rmap_fn_t fn, void * private) {
+    int32_t rv = E_SUCCESS;
+
+    uint32_t eflags = cpu_irq_save();
+    lock(&rmap_lock);
+
+    for(struct rmap * entry = page->rmap; entry; entry = entry->next) {
+        struct pte * pte = rmap_get_pte(page, entry);
+        if(!pte) {
+            continue;
+        }
+
+        rv = fn(page, pte, entry->addr, private);
+        if(!SUCCESS(rv)) {
+            break;
+        }
+
+        if(rv > 0 && VIR_TO_PHY(entry->pgd) == paging_current_pgd()) {
+            paging_inval_tlb_entry(entry->addr);
+        }
+        rv = E_SUCCESS;
+    }
+
+    unlock(&rmap_lock);
+    cpu_irq_restore(eflags);
+
+    return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/rmap.c"
+
+/* ------------------------------------------------------------------------- */
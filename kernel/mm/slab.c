@@ -11,10 +11,23 @@
  * are blocks of contiguous memory used to store the cache's objects. These
  * slabs are allocated via the buddy page allocator with page_alloc().
  *
+ * Caches created with slab_cache_create() may be merged with an existing
+ * cache of compatible object size, alignment and flags. The new cache then
+ * becomes an alias: allocations are served from the root cache's slabs, so
+ * that subsystems don't each hold a partially used slab of identically sized
+ * objects, while the alias keeps its own name and statistics.
+ *
  * Used as the backing allocator for kmalloc().
  */
 
 #include <rotary/mm/slab.h>
+#include <rotary/mm/kmalloc.h>
+
+list_head_t slab_cache_list = INIT_LIST_HEAD(slab_cache_list);
+atomic_flag slab_cache_list_lock = ATOMIC_FLAG_INIT;
+
+struct pseudo_node slab_info_node = PSEUDO_FILE_INIT("slabinfo",
+                                                     slab_info_show);
 
 /* ------------------------------------------------------------------------- */
 
@@ -32,9 +45,23 @@
  * Return: A pointer to the allocated object, or NULL if the allocation fails.
  */
 void * slab_malloc(slab_cache_t * slab_cache, uint32_t flags) {
+    /* Aliases allocate from their root cache, but keep their own stats */
+    if(slab_cache->root) {
+        void * object = slab_malloc(slab_cache->root, flags);
+        if(object) {
+            slab_cache->active_objects++;
+            slab_cache->alloc_total++;
+        } else {
+            slab_cache->fail_total++;
+        }
+        return object;
+    }
+
     /* Attempt to allocate from an existing cache */
     void * new_object = slab_alloc_from_cache(slab_cache);
     if(new_object != NULL) {
+        slab_cache->active_objects++;
+        slab_cache->alloc_total++;
         return new_object;
     }
 
@@ -43,9 +70,12 @@ void * slab_malloc(slab_cache_t * slab_cache, uint32_t flags) {
 
     new_object = slab_alloc_from_cache(slab_cache);
     if(new_object != NULL) {
+        slab_cache->active_objects++;
+        slab_cache->alloc_total++;
         return new_object;
     }
 
+    slab_cache->fail_total++;
     klog("slab_malloc(): failed to alloc. new slab and issue object!\n");
     return NULL;
 }
@@ -68,6 +98,15 @@ void * slab_malloc(slab_cache_t * slab_cache, uint32_t flags) {
 int32_t slab_free(slab_cache_t * slab_cache, void * object) {
     klog("slab_free(): freeing obj. 0x%x\n", object);
 
+    if(slab_cache->root) {
+        int32_t rv = slab_free(slab_cache->root, object);
+        if(SUCCESS(rv)) {
+            slab_cache->active_objects--;
+            slab_cache->free_total++;
+        }
+        return rv;
+    }
+
     /* Iterate through each slab in the cache and identify which slab's
      * address range it falls within */
     slab_header_t ** curr_slab = &slab_cache->first_slab;
@@ -86,6 +125,8 @@ int32_t slab_free(slab_cache_t * slab_cache, void * object) {
                     *curr_obj = new_free_obj;
 
                     (*curr_slab)->free_count++;
+                    slab_cache->active_objects--;
+                    slab_cache->free_total++;
 
                     return E_SUCCESS;
                 }
@@ -99,6 +140,8 @@ int32_t slab_free(slab_cache_t * slab_cache, void * object) {
             new_free_obj->next = NULL;
             *curr_obj = new_free_obj;
             (*curr_slab)->free_count++;
+            slab_cache->active_objects--;
+            slab_cache->free_total++;
 
             return E_SUCCESS;
         }
@@ -203,16 +246,20 @@ void slab_add_cache_frame(slab_cache_t * slab_cache, uint32_t flags) {
     /* Place the cache header at the very start of the allocated page(s) */
     slab_header_t * header = (slab_header_t*)PAGE_VA(new_page);
 
+    /* Objects begin after the header, at the cache's alignment */
+    uint32_t align = slab_cache->align ? slab_cache->align : SLAB_DEFAULT_ALIGN;
+    uint32_t first_offset = (sizeof(slab_header_t) + align - 1) & ~(align - 1);
+
     /* Calculate available memory and the maximum object count */
     header->page_order    = SLAB_DEFAULT_ORDER;
     uint32_t page_count   = 1UL << SLAB_DEFAULT_ORDER;
     uint32_t total_size   = page_count * PAGE_SIZE;
-    uint32_t usable_size  = total_size - sizeof(slab_header_t);
+    uint32_t usable_size  = total_size - first_offset;
     uint32_t object_count = usable_size / slab_cache->object_size;
 
     /* Assign information about the slab */
     void * page_vaddr    = (void*)PAGE_VA(new_page);
-    header->start_addr   = page_vaddr + sizeof(slab_header_t);
+    header->start_addr   = page_vaddr + first_offset;
     header->end_addr     = page_vaddr + total_size;
     header->object_count = object_count;
     header->object_size  = slab_cache->object_size;
@@ -220,8 +267,12 @@ void slab_add_cache_frame(slab_cache_t * slab_cache, uint32_t flags) {
     header->next_slab    = NULL;
 
     /* Update the slab cache metadata */
-    slab_cache->total_size  += total_size;
-    slab_cache->alloc_count += page_count;
+    slab_cache->total_size     += total_size;
+    slab_cache->alloc_count    += page_count;
+    slab_cache->slab_count     += 1;
+    slab_cache->total_objects  += object_count;
+    slab_cache->wasted_bytes   += total_size -
+                                  (object_count * slab_cache->object_size);
 
     /* Add the new slab to the slab cache's list */
     slab_header_t ** curr_slab = &slab_cache->first_slab;
@@ -266,6 +317,10 @@ void slab_add_cache_frame(slab_cache_t * slab_cache, uint32_t flags) {
  * Return: 1 if the address is within the slab allocator, 0 if not.
  */
 int32_t slab_cache_has_addr(slab_cache_t * slab_cache, void * addr) {
+    if(slab_cache->root) {
+        slab_cache = slab_cache->root;
+    }
+
     slab_header_t * curr_slab = slab_cache->first_slab;
     while(curr_slab) {
         if(addr >= curr_slab->start_addr && addr < curr_slab->end_addr)
@@ -277,6 +332,245 @@ int32_t slab_cache_has_addr(slab_cache_t * slab_cache, void * addr) {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * slab_cache_find_mergeable() - Find an existing cache a new cache can share.
+ * @size:  The object size of the new cache, already aligned.
+ * @align: The alignment of the new cache.
+ * @flags: The flags of the new cache.
+ *
+ * A root cache is compatible if its objects are at least as large as the
+ * requested size, waste less than a pointer's worth of space per object, are
+ * placed at a compatible alignment, and its mergeable flags match.
+ *
+ * Return: A pointer to a compatible root cache, or NULL if none exists.
+ */
+static slab_cache_t * slab_cache_find_mergeable(uint32_t size,
+                                                uint32_t align,
+                                                flags_t flags) {
+    if(TEST_BIT(flags, SLAB_NO_MERGE)) {
+        return NULL;
+    }
+
+    slab_cache_t * cache;
+    clist_for_each(cache, &slab_cache_list, cache_node) {
+        uint32_t cache_align = cache->align ? cache->align : SLAB_DEFAULT_ALIGN;
+
+        if(cache->root)
+            continue;
+        if((cache->flags & SLAB_MERGE_MASK) != (flags & SLAB_MERGE_MASK))
+            continue;
+        if(cache->object_size < size ||
+           cache->object_size - size >= sizeof(void*))
+            continue;
+        if(cache_align < align || cache->object_size % align != 0)
+            continue;
+
+        return cache;
+    }
+
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * slab_cache_create() - Create a new slab cache for objects of a given size.
+ * @name:  Name of the cache, used for statistics and debugging.
+ * @size:  The size of each object in bytes.
+ * @align: Required object alignment in bytes (a power of two), or 0 for the
+ *         default alignment.
+ * @flags: SLAB_* flags, e.g. SLAB_NO_MERGE to prevent slabs being shared.
+ *
+ * If a compatible cache already exists, the new cache is created as an alias
+ * of it, and will allocate objects from its slabs. Otherwise, a new root
+ * cache is created. Either way, the cache is registered under its own name.
+ *
+ * Return: A pointer to the new cache, or NULL on failure.
+ */
+slab_cache_t * slab_cache_create(const char * name, uint32_t size,
+                                 uint32_t align, flags_t flags) {
+    if(align == 0) {
+        align = SLAB_DEFAULT_ALIGN;
+    }
+
+    /* Objects must be able to hold a free list pointer */
+    if(size < sizeof(struct slab_object_empty)) {
+        size = sizeof(struct slab_object_empty);
+    }
+    size = (size + align - 1) & ~(align - 1);
+
+    slab_cache_t * cache = kmalloc(sizeof(slab_cache_t));
+    if(!cache) {
+        klog("slab_cache_create(): failed to alloc. cache '%s'!\n", name);
+        return NULL;
+    }
+
+    memset(cache, 0, sizeof(slab_cache_t));
+    strncpy(cache->name, name, sizeof(cache->name));
+    cache->name[sizeof(cache->name) - 1] = '\0';
+    cache->object_size = size;
+    cache->align       = align;
+    cache->flags       = flags | SLAB_DYNAMIC;
+    cache->refcount    = 1;
+
+    lock(&slab_cache_list_lock);
+    slab_cache_t * root = slab_cache_find_mergeable(size, align, flags);
+    if(root) {
+        cache->root = root;
+        root->refcount++;
+    }
+    unlock(&slab_cache_list_lock);
+
+    if(root) {
+        klog("slab_cache_create(): '%s' merged with '%s'\n", cache->name,
+             root->name);
+    }
+
+    slab_cache_register(cache);
+
+    return cache;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * slab_cache_destroy() - Destroy a cache created by slab_cache_create().
+ * @slab_cache: The cache to destroy.
+ *
+ * Removes the cache from the list of caches. The slabs of a root cache are
+ * only freed once no aliases remain which share them, at which point all
+ * objects must have been freed.
+ */
+void slab_cache_destroy(slab_cache_t * slab_cache) {
+    if(!TEST_BIT(slab_cache->flags, SLAB_DYNAMIC)) {
+        klog("slab_cache_destroy(): '%s' is a static cache!\n",
+             slab_cache->name);
+        return;
+    }
+
+    if(slab_cache->active_objects) {
+        klog("slab_cache_destroy(): '%s' still has %d active objects!\n",
+             slab_cache->name, slab_cache->active_objects);
+    }
+
+    lock(&slab_cache_list_lock);
+
+    slab_cache_t * root = slab_cache->root ? slab_cache->root : slab_cache;
+    slab_cache_t * free_root = NULL;
+
+    /* Aliases can be removed immediately, but they hold a reference on the
+     * root cache whose slabs they share */
+    if(slab_cache->root) {
+        clist_delete_node(&slab_cache->cache_node);
+    }
+
+    root->refcount--;
+    if(root->refcount == 0 && TEST_BIT(root->flags, SLAB_DYNAMIC)) {
+        clist_delete_node(&root->cache_node);
+        free_root = root;
+    }
+
+    unlock(&slab_cache_list_lock);
+
+    if(free_root) {
+        slab_header_t * curr_slab = free_root->first_slab;
+        while(curr_slab) {
+            slab_header_t * next_slab = curr_slab->next_slab;
+            page_free_va(curr_slab, curr_slab->page_order);
+            curr_slab = next_slab;
+        }
+        if(free_root != slab_cache) {
+            kfree(free_root);
+        }
+    }
+
+    if(slab_cache->root || free_root == slab_cache) {
+        kfree(slab_cache);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * slab_cache_register() - Add a slab cache to the global list of caches.
+ * @slab_cache: The slab cache to register.
+ *
+ * Registered caches are included in the output of slab_info_show(). Caches
+ * are registered once, further calls for the same cache have no effect.
+ */
+void slab_cache_register(slab_cache_t * slab_cache) {
+    lock(&slab_cache_list_lock);
+    if(slab_cache->cache_node.next == NULL) {
+        clist_add_before(&slab_cache_list, &slab_cache->cache_node);
+    }
+    unlock(&slab_cache_list_lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * slab_info_init() - Expose slab cache statistics as a pseudo file.
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t __init slab_info_init() {
+    return pseudo_register(NULL, &slab_info_node);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * slab_info_show() - Format a table of per-cache utilisation.
+ * @buf:  The buffer to write the table into.
+ * @size: The size of the buffer in bytes.
+ *
+ * Writes one row per registered cache, using the counters maintained as
+ * objects are allocated and freed, so no slabs need to be walked. Merged
+ * caches list the root cache whose slabs they share. Rows which do not fit
+ * within the buffer are omitted.
+ *
+ * Return: The number of bytes written to the buffer.
+ */
+int32_t slab_info_show(char * buf, uint32_t size) {
+    char line[128];
+    uint32_t len = 0;
+
+    if(size == 0) return 0;
+    buf[0] = '\0';
+
+    uint32_t line_len = sprintf(line,
+        "%-16s %-7s %-7s %-6s %-5s %-5s %-7s %-8s %-8s %-5s %s\n",
+        "name", "active", "total", "objsz", "slabs", "pages", "waste",
+        "allocs", "frees", "fails", "root");
+    if(line_len >= size) return 0;
+    memcpy(buf, line, line_len + 1);
+    len += line_len;
+
+    lock(&slab_cache_list_lock);
+
+    slab_cache_t * cache;
+    clist_for_each(cache, &slab_cache_list, cache_node) {
+        /* Aliases own no slabs, so report the root cache they share */
+        line_len = sprintf(line,
+            "%-16s %-7u %-7u %-6u %-5u %-5u %-7u %-8u %-8u %-5u %s\n",
+            cache->name, cache->active_objects, cache->total_objects,
+            cache->object_size, cache->slab_count, cache->alloc_count,
+            cache->wasted_bytes, cache->alloc_total, cache->free_total,
+            cache->fail_total, cache->root ? cache->root->name : "-");
+
+        if(len + line_len >= size) break;
+
+        memcpy(buf + len, line, line_len + 1);
+        len += line_len;
+    }
+
+    unlock(&slab_cache_list_lock);
+
+    return len;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * slab_cache_print_debug() - Print cache information to the kernel log.
  * @slab_cache: Pointer to the slab cache to print debug information for.
@@ -311,3 +605,8 @@ void slab_cache_print_debug(slab_cache_t * slab_cache) {
 }
 
 /* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/slab.c"
+
+/* ------------------------------------------------------------------------- */
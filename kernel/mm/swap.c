@@ -0,0 +1,419 @@
+/*
+ * kernel/mm/swap.c
+ * Swap
+ *
+ * Pages reclaimed from user address spaces are written to a swap area on a
+ * block device, divided into page sized slots. Every entry that mapped the
+ * page is replaced by a swap entry holding the slot, which isn't present, so
+ * that the next access faults and swap_fault() reads the page back into a
+ * newly allocated one. Each slot counts the swap entries referring to it,
+ * including copies made by vm_space_fork(), and is freed once the last has
+ * been faulted back in or unmapped.
+ *
+ * Only pages that would be copied before being written are swapped out
+ * while mapped more than once, as those mapping it would each fault in a
+ * copy of their own. A page shared writable has to stay one page, so is only
+ * swapped out by its last mapping.
+ *
+ * There is a single swap area, enabled with swap_on(). Pages are always
+ * written out when reclaimed, and there is no swap cache, so a page faulted
+ * in by two address spaces is read twice into separate pages. Writes go to
+ * zswap first, which keeps the pages that compress well in memory, and only
+ * the rest reach the device.
+ */
+
+#include <rotary/mm/swap.h>
+
+/* ------------------------------------------------------------------------- */
+
+struct swap_area swap_area = {
+    .dev  = NULL,
+    .lock = ATOMIC_FLAG_INIT
+};
+
+/* ------------------------------------------------------------------------- */
+/* Swap Area                                                                 */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_on() - Start swapping to a block device.
+ * @dev: The device, whose contents are overwritten.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if swap is already enabled, the
+ *         device is too small or memory ran out.
+ */
+int32_t swap_on(struct block_device * dev) {
+    uint32_t slot_count = dev->sector_count / SWAP_SECTORS_PER_SLOT;
+
+    if(swap_active() || slot_count < 2) {
+        klog("swap_on(): Can't swap to %s\n", dev->name);
+        return E_ERROR;
+    }
+
+    uint16_t * slot_uses = kmalloc(slot_count * sizeof(uint16_t));
+    if(!slot_uses) {
+        return E_ERROR;
+    }
+    memset(slot_uses, 0, slot_count * sizeof(uint16_t));
+
+    if(!SUCCESS(zswap_enable(slot_count))) {
+        kfree(slot_uses);
+        return E_ERROR;
+    }
+
+    lock(&swap_area.lock);
+    swap_area.slot_count = slot_count;
+    swap_area.slot_uses  = slot_uses;
+    swap_area.slots_used = 0;
+    swap_area.next_slot  = 1;
+    swap_area.dev        = dev;
+    unlock(&swap_area.lock);
+
+    klog("swap_on(): Swapping to %s, %d slots\n", dev->name, slot_count - 1);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_off() - Stop swapping.
+ *
+ * Pages are never read back in bulk, so swap can only be disabled once
+ * every swapped out page has been faulted back in or unmapped.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if slots are still in use.
+ */
+int32_t swap_off() {
+    lock(&swap_area.lock);
+
+    if(!swap_area.dev || swap_area.slots_used) {
+        unlock(&swap_area.lock);
+        return E_ERROR;
+    }
+
+    uint16_t * slot_uses = swap_area.slot_uses;
+    swap_area.dev        = NULL;
+    swap_area.slot_uses  = NULL;
+    swap_area.slot_count = 0;
+    unlock(&swap_area.lock);
+
+    zswap_disable();
+    kfree(slot_uses);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_active() - Returns whether swap is enabled.
+ *
+ * Return: 1 if there is a swap area, 0 otherwise.
+ */
+int swap_active() {
+    return swap_area.dev != NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_alloc() - Allocate a free swap slot.
+ *
+ * Slots are handed out in a cycle, from after the last one allocated.
+ *
+ * Return: The slot, with one use, or SWAP_SLOT_NONE if swap is full or
+ *         disabled.
+ */
+uint32_t swap_alloc() {
+    uint32_t slot = SWAP_SLOT_NONE;
+
+    lock(&swap_area.lock);
+
+    for(uint32_t i = 1; i < swap_area.slot_count; i++) {
+        uint32_t candidate = swap_area.next_slot;
+        if(++swap_area.next_slot >= swap_area.slot_count) {
+            swap_area.next_slot = 1;
+        }
+
+        if(!swap_area.slot_uses[candidate]) {
+            swap_area.slot_uses[candidate] = 1;
+            swap_area.slots_used++;
+            slot = candidate;
+            break;
+        }
+    }
+
+    unlock(&swap_area.lock);
+    return slot;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_dup() - Take another use of a swap slot.
+ * @slot: The slot, which must be in use.
+ */
+void swap_dup(uint32_t slot) {
+    lock(&swap_area.lock);
+    swap_area.slot_uses[slot]++;
+    unlock(&swap_area.lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_put() - Release a use of a swap slot.
+ * @slot: The slot, which is freed once its last use is released.
+ */
+void swap_put(uint32_t slot) {
+    lock(&swap_area.lock);
+
+    if(slot == SWAP_SLOT_NONE || slot >= swap_area.slot_count ||
+       !swap_area.slot_uses[slot]) {
+        unlock(&swap_area.lock);
+        klog("swap_put(): Slot %d is not in use!\n", slot);
+        return;
+    }
+
+    /* zswap's copy is dropped before the slot is free to be reallocated,
+     * or a late invalidation could drop the next page stored to it */
+    if(swap_area.slot_uses[slot] == 1) {
+        zswap_invalidate(slot);
+        swap_area.slots_used--;
+    }
+    swap_area.slot_uses[slot]--;
+
+    unlock(&swap_area.lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_slot_uses() - Returns the number of uses of a swap slot.
+ * @slot: The slot.
+ *
+ * Return: The number of uses, 0 if the slot is free.
+ */
+uint32_t swap_slot_uses(uint32_t slot) {
+    if(slot >= swap_area.slot_count) {
+        return 0;
+    }
+    return swap_area.slot_uses[slot];
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_read() - Read a page from a swap slot.
+ * @slot: The slot.
+ * @page: The page to read into, which may be highmem.
+ *
+ * The page is decompressed if zswap holds it, otherwise read from the device.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the device failed.
+ */
+int32_t swap_read(uint32_t slot, struct page * page) {
+    if(zswap_has(slot)) {
+        return zswap_load(slot, page);
+    }
+
+    void * virt_addr = kmap_atomic(page);
+    int32_t rv = blkdev_read(swap_area.dev, slot * SWAP_SECTORS_PER_SLOT,
+                             SWAP_SECTORS_PER_SLOT, virt_addr);
+    kunmap_atomic(virt_addr);
+    return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_write() - Write a page to a swap slot.
+ * @slot: The slot.
+ * @page: The page to write, which may be highmem.
+ *
+ * zswap is offered the page first, and only if it refuses is the page
+ * written to the device.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the device failed.
+ */
+int32_t swap_write(uint32_t slot, struct page * page) {
+    if(SUCCESS(zswap_store(slot, page))) {
+        return E_SUCCESS;
+    }
+
+    void * virt_addr = kmap_atomic(page);
+    int32_t rv = blkdev_write(swap_area.dev, slot * SWAP_SECTORS_PER_SLOT,
+                              SWAP_SECTORS_PER_SLOT, virt_addr);
+    kunmap_atomic(virt_addr);
+    return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Swapping Pages Out and In                                                 */
+/* ------------------------------------------------------------------------- */
+
+struct swap_check_data {
+    uint32_t mapped;
+    uint32_t writable; /* Entries that aren't copy-on-write */
+};
+
+static int32_t swap_check_pte(struct page * page, struct pte * pte,
+                              void * virt_addr, void * private) {
+    struct swap_check_data * data = private;
+
+    data->mapped++;
+    if(!TEST_BIT(pte->entry, PTE_COW)) {
+        data->writable++;
+    }
+
+    return 0;
+}
+
+static int32_t swap_unmap_pte(struct page * page, struct pte * pte,
+                              void * virt_addr, void * private) {
+    uint32_t slot = *(uint32_t*)private;
+
+    swap_dup(slot);
+    *pte = MAKE_SWAP_PTE(slot);
+    return 1;
+}
+
+/**
+ * swap_out() - Write a page to swap and unmap it everywhere.
+ * @page: The page, which must be tracked by its reverse mapping.
+ *
+ * The page is freed once every entry mapping it refers to its swap slot.
+ * The caller must have interrupts disabled, so that the entries can't change
+ * in the meantime.
+ *
+ * Return: E_SUCCESS if the page was freed, E_ERROR if it can't be swapped
+ *         out, or swap is full.
+ */
+int32_t swap_out(struct page * page) {
+    struct swap_check_data check = { 0 };
+
+    if(!swap_active()) {
+        return E_ERROR;
+    }
+
+    /* Every use of the page must be a mapping found through the chain, or
+     * it would still be in use once unmapped */
+    rmap_walk(page, swap_check_pte, &check);
+    if(!check.mapped || check.mapped != page->use_count ||
+       check.mapped != rmap_count(page) ||
+       (check.mapped > 1 && check.writable)) {
+        return E_ERROR;
+    }
+
+    uint32_t slot = swap_alloc();
+    if(slot == SWAP_SLOT_NONE) {
+        return E_ERROR;
+    }
+
+    if(!SUCCESS(swap_write(slot, page))) {
+        swap_put(slot);
+        return E_ERROR;
+    }
+
+    /* Each entry takes a use of the slot, then the allocation's is dropped */
+    rmap_walk(page, swap_unmap_pte, &slot);
+    swap_put(slot);
+
+    rmap_clear(page);
+    for(uint32_t i = 0; i < check.mapped; i++) {
+        page_free(page, 0);
+    }
+
+    swap_area.swap_outs++;
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_get_pte() - Find the swap entry for an address.
+ * @pgd:       The PGD to look in.
+ * @virt_addr: The address.
+ *
+ * Return: The page table entry if it is a swap entry, otherwise NULL.
+ */
+struct pte * swap_get_pte(struct pgd * pgd, void * virt_addr) {
+    struct pde * pde = GET_PDE(pgd, virt_addr);
+    if(!PDE_EXISTS(pde) || PDE_IS_HUGE(pde)) {
+        return NULL;
+    }
+
+    struct pte * pte = GET_PTE(PDE_TO_PGT(pde), virt_addr);
+    return PTE_IS_SWAP(pte) ? pte : NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_fault() - Read a swapped out page back in.
+ * @map:       The mapping containing the address.
+ * @virt_addr: The address that faulted.
+ * @pte:       The swap entry for the address.
+ *
+ * The page is read into a new page, mapped with the mapping's permissions.
+ * Whoever else shared the swapped out page has a swap entry of their own,
+ * so the new page belongs to this entry alone and can be writable. If no
+ * page is free, a batch is reclaimed first.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if memory ran out or the read failed.
+ */
+int32_t swap_fault(struct vm_map * map, void * virt_addr, struct pte * pte) {
+    struct pgd * pgd = PHY_TO_VIR(map->space->pgd);
+    uint32_t slot = PTE_SWAP_SLOT(pte);
+    int32_t rv = E_ERROR;
+
+    uint32_t eflags = cpu_irq_save();
+
+    struct page * page = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+    if(!page && reclaim_pages(RECLAIM_BATCH)) {
+        page = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+    }
+
+    if(!page) {
+        klog("swap_fault(): No page to read slot %d into\n", slot);
+    } else if(!SUCCESS(swap_read(slot, page))) {
+        klog("swap_fault(): Failed to read slot %d\n", slot);
+        page_free(page, 0);
+    } else {
+        ptable_map_page(pgd, virt_addr, page, map->flags);
+        if(RMAP_TRACKED(map->flags)) {
+            rmap_add_new(page, pgd, virt_addr);
+        }
+
+        swap_put(slot);
+        swap_area.swap_ins++;
+        rv = E_SUCCESS;
+    }
+
+    cpu_irq_restore(eflags);
+    return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * swap_print_debug() - Print the swap area's usage and statistics.
+ */
+void swap_print_debug() {
+    if(!swap_active()) {
+        printk(LOG_DEBUG, "Swap: disabled\n");
+        return;
+    }
+
+    printk(LOG_DEBUG, "Swap: %s, %d of %d slots used\n", swap_area.dev->name,
+           swap_area.slots_used, swap_area.slot_count - 1);
+    printk(LOG_DEBUG, "Swapped out: %d pages, in: %d pages\n",
+           swap_area.swap_outs, swap_area.swap_ins);
+    zswap_print_debug();
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/swap.c"
+
+/* ------------------------------------------------------------------------- */
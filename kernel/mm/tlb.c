@@ -0,0 +1,129 @@
+/*
+ * kernel/mm/tlb.c
+ * Batched TLB Invalidation
+ *
+ * Unmapping a range page by page costs an invalidation and a page_free() per
+ * page. Instead, ptable_unmap_range() records each unmapped address and each
+ * page to be freed in a struct tlb_gather, which invalidates the TLB once
+ * per batch and then releases the pages together.
+ *
+ * Pages must not be freed until the TLB no longer holds a translation to
+ * them, as they could otherwise be reallocated while still being accessible
+ * through the old mapping. When the batch of pages fills, the pending
+ * invalidations are therefore carried out before the pages are released.
+ *
+ * Past TLB_GATHER_INVAL_MAX addresses, flushing the whole TLB is cheaper than
+ * invalidating each entry, so the individual addresses are discarded. The
+ * count is kept across batches, and once past it every later batch is
+ * flushed with a single CR3 reload, so that tearing down a large range
+ * doesn't cost an invalidation per page just because the batch of pages
+ * filled first. If the PGD isn't the one currently loaded, the TLB holds none
+ * of its entries and no invalidation is needed at all.
+ */
+
+#include <rotary/mm/tlb.h>
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * tlb_gather_init() - Prepare to gather the teardown of a range of mappings.
+ * @tlb: The gather structure to initialise.
+ * @pgd: The PGD that mappings will be removed from.
+ */
+void tlb_gather_init(struct tlb_gather * tlb, struct pgd * pgd) {
+    tlb->pgd          = pgd;
+    tlb->page_count   = 0;
+    tlb->inval_count  = 0;
+    tlb->inval_total  = 0;
+    tlb->flush_all    = 0;
+    tlb->pages_freed  = 0;
+    tlb->tables_freed = 0;
+    tlb->full_flushes = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * tlb_gather_inval() - Queue the invalidation of a TLB entry.
+ * @tlb:       The gather structure.
+ * @virt_addr: The virtual address whose translation has been removed.
+ */
+void tlb_gather_inval(struct tlb_gather * tlb, void * virt_addr) {
+    if(++tlb->inval_total > TLB_GATHER_INVAL_MAX) {
+        tlb->flush_all = 1;
+    }
+
+    /* inval_count can't exceed inval_total, so there is room for this */
+    if(!tlb->flush_all) {
+        tlb->inval_addrs[tlb->inval_count] = virt_addr;
+    }
+    tlb->inval_count++;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * tlb_gather_page() - Queue a page to be freed once the TLB is invalidated.
+ * @tlb:  The gather structure.
+ * @page: The page, which must no longer be mapped by tlb->pgd.
+ *
+ * If the batch is full, it is flushed first.
+ */
+void tlb_gather_page(struct tlb_gather * tlb, struct page * page) {
+    if(tlb->page_count >= TLB_GATHER_PAGES) {
+        tlb_gather_flush(tlb);
+    }
+
+    tlb->pages[tlb->page_count++] = page;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * tlb_gather_flush() - Invalidate the queued TLB entries, then free pages.
+ * @tlb: The gather structure.
+ *
+ * The gather structure can continue to be used afterwards. Once it has
+ * switched to full flushes, it keeps to them until it is initialised again.
+ */
+void tlb_gather_flush(struct tlb_gather * tlb) {
+    if(VIR_TO_PHY(tlb->pgd) == paging_current_pgd()) {
+        if(tlb->flush_all) {
+            paging_flush_tlb();
+            tlb->full_flushes++;
+        } else {
+            for(uint32_t i = 0; i < tlb->inval_count; i++) {
+                paging_inval_tlb_entry(tlb->inval_addrs[i]);
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < tlb->page_count; i++) {
+        page_free(tlb->pages[i], 0);
+    }
+
+    tlb->pages_freed += tlb->page_count;
+    tlb->page_count   = 0;
+    tlb->inval_count  = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * tlb_gather_finish() - Complete the teardown of a range of mappings.
+ * @tlb: The gather structure.
+ *
+ * Carries out any outstanding invalidations and frees any outstanding pages.
+ */
+void tlb_gather_finish(struct tlb_gather * tlb) {
+    if(tlb->page_count || tlb->inval_count) {
+        tlb_gather_flush(tlb);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/tlb.c"
+
+/* ------------------------------------------------------------------------- */
@@ -10,10 +10,250 @@
  *
  * Mappings added to a virtual address space will not necessarily immediately
  * be copied to the relevant architecture-specific page table,
+ *
+ * Mappings never overlap, so they are kept in an AVL tree ordered by start
+ * address, and the mapping containing an address is the last one starting at
+ * or below it. This keeps page faults O(log n) in the number of mappings,
+ * and faults tend to hit the same mapping as the last, which is cached. The
+ * mappings are also kept on a list in address order, for walking them and
+ * finding their neighbours. Adjacent mappings with the same flags are merged
+ * as they're added, and mappings are split when only part of one is
+ * unmapped, reprotected or given advice.
+ *
+ * How a mapping's pages are provided depends on what backs it, so each
+ * mapping has a table of operations, which page faults are passed on to.
+ * Anonymous memory is allocated zeroed, device memory is mapped in place
+ * with nothing allocated, and file-backed memory is read from its inode.
  */
 
 #include <rotary/mm/vm.h>
 
+slab_cache_t * vm_space_cache = NULL;
+slab_cache_t * vm_map_cache   = NULL;
+
+/* Address space containing only the kernel mappings, active until the first
+ * user task is scheduled */
+static struct vm_space kernel_vm_space;
+
+/* Pages mapped by each fault, in a naturally aligned window around it */
+uint32_t vm_fault_around_pages = VM_FAULT_AROUND_DEFAULT;
+
+/* Backs reads of private memory that hasn't been written to yet. Holds a
+ * use of its own, so is never freed when the last mapping of it goes */
+struct page * vm_zero_page = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_init() - Create the slab caches used for VM structures.
+ *
+ * Return: E_SUCCESS on success, E_ERROR on failure.
+ */
+int32_t __init vm_init() {
+    vm_space_cache = slab_cache_create("vm_space", sizeof(struct vm_space),
+                                       0, 0);
+    vm_map_cache   = slab_cache_create("vm_map", sizeof(struct vm_map),
+                                       0, 0);
+
+    if(!vm_space_cache || !vm_map_cache) {
+        return E_ERROR;
+    }
+
+    vm_zero_page = page_alloc(0, PR_KERNEL);
+    if(!vm_zero_page) {
+        return E_ERROR;
+    }
+    memset(PAGE_VA(vm_zero_page), 0, PAGE_SIZE);
+
+    /* The kernel address space holds a reference of its own, so is never
+     * destroyed */
+    llist_init(&kernel_vm_space.mappings);
+    kernel_vm_space.pgd   = VIR_TO_PHY(paging_kernel_pgd());
+    kernel_vm_space.users = 1;
+
+    return E_SUCCESS;
+}
+
+core_initcall(vm_init);
+
+/* ------------------------------------------------------------------------- */
+/* Mapping Tree                                                              */
+/* ------------------------------------------------------------------------- */
+
+static int32_t vm_map_cmp(struct avl_node * a, struct avl_node * b) {
+    void * start_a = avl_entry(a, struct vm_map, tree_node)->start_addr;
+    void * start_b = avl_entry(b, struct vm_map, tree_node)->start_addr;
+    return start_a < start_b ? -1 : start_a > start_b;
+}
+
+/**
+ * vm_map_floor() - Find the last mapping starting at or below an address
+ * @space: A pointer to the address space
+ * @addr:  The address
+ *
+ * Return: The mapping, which contains addr if any mapping does, or NULL if
+ *         every mapping starts above addr.
+ */
+static struct vm_map * vm_map_floor(struct vm_space * space, void * addr) {
+    struct avl_node * node = space->map_tree;
+    struct vm_map * floor = NULL;
+
+    while(node) {
+        struct vm_map * map = avl_entry(node, struct vm_map, tree_node);
+        if(addr < map->start_addr) {
+            node = node->left;
+        } else {
+            floor = map;
+            node  = node->right;
+        }
+    }
+
+    return floor;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static struct vm_map * vm_map_prev(struct vm_map * map) {
+    if(map->list_node.prev == &map->space->mappings) {
+        return NULL;
+    }
+    return container_of(map->list_node.prev, struct vm_map, list_node);
+}
+
+/* Whether b directly follows a, and the two can be treated as one. Unless
+ * they're anonymous, b must also continue where a leaves off in the object
+ * backing them */
+static int vm_map_mergeable(struct vm_map * a, struct vm_map * b) {
+    if(a->end_addr != b->start_addr || a->ops != b->ops ||
+       a->private != b->private ||
+       (a->flags & ~VM_MAP_POPULATE) != (b->flags & ~VM_MAP_POPULATE)) {
+        return 0;
+    }
+
+    return a->ops == &vm_anon_ops ||
+           b->offset == a->offset + (a->end_addr - a->start_addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_insert_map() - Link a mapping into an address space
+ * @space: A pointer to the address space
+ * @map:   A pointer to the mapping, which mustn't overlap any other
+ *
+ * Adds the mapping to the tree, and to the list after the mapping preceding
+ * it, without populating or merging it. A mapping without operations is
+ * given those for device memory if it has VM_MAP_IO, or anonymous memory.
+ */
+static void vm_space_insert_map(struct vm_space * space, struct vm_map * map) {
+    struct vm_map * prev = vm_map_floor(space, map->start_addr);
+
+    if(!map->ops) {
+        map->ops = TEST_BIT(map->flags, VM_MAP_IO) ? &vm_device_ops :
+                                                     &vm_anon_ops;
+    }
+
+    map->space = space;
+    llist_add(prev ? &prev->list_node : &space->mappings, &map->list_node);
+    space->map_tree = avl_insert(space->map_tree, &map->tree_node,
+                                 vm_map_cmp);
+    space->map_count++;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_merge_map() - Merge a mapping with its neighbours
+ * @space: A pointer to the address space
+ * @map:   A pointer to the mapping, which is in the address space
+ *
+ * A mapping directly followed by another with the same flags is extended to
+ * cover both, and the second is destroyed. Fewer mappings keep the tree
+ * shallow and give the map cache more hits.
+ *
+ * Return: The mapping now containing map's range.
+ */
+static struct vm_map * vm_space_merge_map(struct vm_space * space,
+                                          struct vm_map * map) {
+    struct vm_map * prev = vm_map_prev(map);
+    struct vm_map * next = vm_map_next(map);
+
+    if(prev && vm_map_mergeable(prev, map)) {
+        prev->end_addr = map->end_addr;
+        vm_space_delete_map(space, map);
+        vm_map_destroy(map);
+        map = prev;
+    }
+
+    if(next && vm_map_mergeable(map, next)) {
+        map->end_addr = next->end_addr;
+        vm_space_delete_map(space, next);
+        vm_map_destroy(next);
+    }
+
+    return map;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_split_map() - Split a mapping in two
+ * @space: A pointer to the address space
+ * @map:   A pointer to the mapping to split
+ * @addr:  The page aligned address to split at, within the mapping
+ *
+ * The mapping is shrunk to end at addr, and a new mapping with the same flags
+ * is added for the rest. The page table is left untouched.
+ *
+ * Return: The new mapping, starting at addr, or NULL if memory ran out.
+ */
+static struct vm_map * vm_space_split_map(struct vm_space * space,
+                                          struct vm_map * map, void * addr) {
+    struct vm_map * tail = vm_map_new();
+    if(!tail) {
+        return NULL;
+    }
+
+    tail->space      = space;
+    tail->start_addr = addr;
+    tail->end_addr   = map->end_addr;
+    tail->flags      = map->flags;
+    tail->ops        = map->ops;
+    tail->private    = map->private;
+    tail->offset     = map->offset + (addr - map->start_addr);
+
+    map->end_addr = addr;
+    vm_space_insert_map(space, tail);
+
+    return tail;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_first_map() - Find the first mapping ending above an address
+ * @space: A pointer to the address space
+ * @addr:  The address
+ *
+ * Return: The mapping containing addr if there is one, otherwise the first
+ *         mapping after it, or NULL if there is none.
+ */
+static struct vm_map * vm_space_first_map(struct vm_space * space,
+                                          void * addr) {
+    struct vm_map * map = vm_map_floor(space, addr);
+
+    if(!map) {
+        if(!space->mappings.next) {
+            return NULL;
+        }
+        return container_of(space->mappings.next, struct vm_map, list_node);
+    }
+
+    return addr < map->end_addr ? map : vm_map_next(map);
+}
+
+/* ------------------------------------------------------------------------- */
+
 /* ------------------------------------------------------------------------- */
 /* Address Space                                                             */
 /* ------------------------------------------------------------------------- */
@@ -28,24 +268,85 @@
  * The page table included within the address space will contain the kernel
  * mappings by default, as these are automatically added by ptable_pgd_new().
  *
+ * The caller holds the only reference to the new address space, which must be
+ * released with vm_space_put().
+ *
  * Return: A pointer to the newly allocated address space, NULL if memory
  *         allocation fails
  */
 struct vm_space * vm_space_new() {
-    struct vm_space * vms = (struct vm_space*)kmalloc(sizeof(struct vm_space));
+    struct vm_space * vms = slab_malloc(vm_space_cache, 0);
     if(!vms) {
         klog("vm_space_new(): Failed to alloc. memory!\n");
         return NULL;
     }
 
     llist_init(&vms->mappings);
-    vms->pgd = VIR_TO_PHY(ptable_pgd_new());
+    vms->map_tree  = NULL;
+    vms->map_cache = NULL;
+    vms->map_count = 0;
+    vms->pgd       = VIR_TO_PHY(ptable_pgd_new());
+    vms->users     = 1;
+    vms->rss_pages = 0;
+    vms->wss_pages = 0;
 
     return vms;
 }
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * vm_space_fork() - Duplicate an address space
+ * @space: The address space to duplicate.
+ *
+ * The new address space has a copy of each of the original's mappings. Pages
+ * that have already been faulted in are shared copy-on-write, except in
+ * shared mappings and device memory, where writes should be seen by both.
+ * Either way, only the page tables are copied up front.
+ *
+ * Return: A pointer to the new address space, or NULL on failure.
+ */
+struct vm_space * vm_space_fork(struct vm_space * space) {
+    struct vm_space * child = vm_space_new();
+    if(!child) {
+        return NULL;
+    }
+
+    struct vm_map * map;
+    list_for_each(map, &space->mappings, list_node) {
+        struct vm_map * copy = vm_map_new();
+        if(!copy) {
+            goto cleanup;
+        }
+
+        copy->space      = child;
+        copy->start_addr = map->start_addr;
+        copy->end_addr   = map->end_addr;
+        copy->flags      = map->flags;
+        copy->ops        = map->ops;
+        copy->private    = map->private;
+        copy->offset     = map->offset;
+        vm_space_insert_map(child, copy);
+
+        flags_t copy_flags = TEST_BIT(map->flags, VM_MAP_SHARED | VM_MAP_IO) ?
+                             PTC_SHARE : PTC_COW;
+        if(!SUCCESS(ptable_copy_range(PHY_TO_VIR(space->pgd),
+                                      PHY_TO_VIR(child->pgd), map->start_addr,
+                                      map->end_addr, copy_flags))) {
+            goto cleanup;
+        }
+    }
+
+    return child;
+
+cleanup:
+    klog("vm_space_fork(): Failed to duplicate address space 0x%x!\n", space);
+    vm_space_put(child);
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * vm_space_destroy() - De-allocate all memory used by an address space
  * @space: A pointer to the vm_space to be destroyed.
@@ -56,10 +357,72 @@ struct vm_space * vm_space_new() {
  * space is then freed.
  */
 void vm_space_destroy(struct vm_space * space) {
+    /* Free the mappings, which belong to this address space alone */
+    while(space->mappings.next) {
+        struct vm_map * map = container_of(space->mappings.next,
+                                           struct vm_map, list_node);
+        if(map->ops->close) {
+            map->ops->close(map);
+        }
+        vm_space_delete_map(space, map);
+        vm_map_destroy(map);
+    }
+
     /* Free the pages allocated for the page table */
     ptable_pgd_free(PHY_TO_VIR(space->pgd));
     /* Free the slab-alloced memory for the vm_space object */
-    kfree(space);
+    slab_free(vm_space_cache, space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_get() - Take a reference to an address space
+ * @space: A pointer to the address space.
+ *
+ * Kernel tasks have no address space of their own, and instead run on the
+ * address space of whichever task ran before them. They take a reference to
+ * it while running, so that it isn't destroyed underneath them if its owner
+ * exits.
+ *
+ * Return: The address space, for convenience.
+ */
+struct vm_space * vm_space_get(struct vm_space * space) {
+    space->users++;
+    return space;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_put() - Release a reference to an address space
+ * @space: A pointer to the address space.
+ *
+ * The address space is destroyed once its last user releases it. The caller
+ * must ensure that it is no longer the PGD loaded by the CPU.
+ */
+void vm_space_put(struct vm_space * space) {
+    if(!space) return;
+
+    if(space->users == 0) {
+        klog("vm_space_put(): Address space 0x%x has no users!\n", space);
+        return;
+    }
+
+    if(--space->users == 0) {
+        vm_space_destroy(space);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_kernel() - Retrieve the kernel address space
+ *
+ * Return: A pointer to the address space containing only kernel mappings.
+ */
+struct vm_space * vm_space_kernel() {
+    return &kernel_vm_space;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -67,12 +430,26 @@ void vm_space_destroy(struct vm_space * space) {
 /**
  * vm_space_add_map() - Add a mapping to an address space
  * @space: A pointer to the address space
- * @map:   A pointer to the mapping to add
+ * @map:   A pointer to the mapping to add, which mustn't overlap any other
+ *
+ * Adds the mapping to the address space's mapping list and tree. If it has
+ * the VM_MAP_POPULATE flag, its pages are allocated straight away rather than
+ * faulted in one by one. Should memory run out, the rest are left to fault.
+ *
+ * The mapping is then merged with its neighbours, if they are adjacent and
+ * have the same flags, in which case it may be destroyed.
  *
- * Adds the mapping to the address space's mapping list.
+ * Return: The mapping now covering the range, which the caller should use in
+ *         place of map.
  */
-void vm_space_add_map(struct vm_space * space, struct vm_map * map) {
-    llist_add(&space->mappings, &map->list_node);
+struct vm_map * vm_space_add_map(struct vm_space * space, struct vm_map * map) {
+    vm_space_insert_map(space, map);
+
+    if(TEST_BIT(map->flags, VM_MAP_POPULATE)) {
+        vm_space_populate(space, map);
+    }
+
+    return vm_space_merge_map(space, map);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -82,50 +459,355 @@ void vm_space_add_map(struct vm_space * space, struct vm_map * map) {
  * @space: A pointer to the address space
  * @map:   A pointer to the mapping to remove
  *
- * Unlinks the mapping from the address space's mapping list.
+ * Unlinks the mapping from the address space's mapping list and tree. Its
+ * pages are left mapped in the page table.
  */
 void vm_space_delete_map(struct vm_space * space, struct vm_map * map) {
     llist_delete_node(&map->list_node);
+    space->map_tree = avl_remove(space->map_tree, &map->tree_node,
+                                 vm_map_cmp);
+    space->map_count--;
+
+    if(space->map_cache == map) {
+        space->map_cache = NULL;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_unmap() - Remove a range of addresses from an address space
+ * @space:      A pointer to the address space
+ * @start_addr: The first (inclusive) address to unmap, page aligned
+ * @end_addr:   The final (exclusive) address to unmap, page aligned
+ *
+ * Every mapping within the range is closed, unmapping its pages, and
+ * removed. Mappings only partly within the range are split, so that the rest
+ * of them remains.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if memory ran out to split a mapping,
+ *         in which case only part of the range may have been unmapped.
+ */
+int32_t vm_space_unmap(struct vm_space * space, void * start_addr,
+                       void * end_addr) {
+    struct vm_map * map = vm_space_first_map(space, start_addr);
+
+    while(map && map->start_addr < end_addr) {
+        if(map->start_addr < start_addr) {
+            map = vm_space_split_map(space, map, start_addr);
+            if(!map) {
+                return E_ERROR;
+            }
+        }
+
+        if(map->end_addr > end_addr &&
+           !vm_space_split_map(space, map, end_addr)) {
+            return E_ERROR;
+        }
+
+        struct vm_map * next = vm_map_next(map);
+
+        if(map->ops->close) {
+            map->ops->close(map);
+        }
+        vm_space_delete_map(space, map);
+        vm_map_destroy(map);
+
+        map = next;
+    }
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_set_flags() - Change some of the flags of a range of addresses
+ * @space:      A pointer to the address space
+ * @start_addr: The first (inclusive) address to change, page aligned
+ * @end_addr:   The final (exclusive) address to change, page aligned
+ * @mask:       The VM_MAP_* flags to replace
+ * @flags:      Their new values
+ *
+ * Mappings only partly within the range are split, and the flags of the
+ * mappings within it replaced, along with the protection of the pages already
+ * mapped if that changed. Each is then merged with its neighbours where the
+ * flags now match.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if memory ran out to split a mapping,
+ *         in which case only part of the range may have been changed.
+ */
+static int32_t vm_space_set_flags(struct vm_space * space, void * start_addr,
+                                  void * end_addr, flags_t mask,
+                                  flags_t flags) {
+    const flags_t prot = VM_MAP_READ | VM_MAP_WRITE | VM_MAP_EXEC;
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    struct vm_map * map = vm_space_first_map(space, start_addr);
+
+    while(map && map->start_addr < end_addr) {
+        if(map->start_addr < start_addr) {
+            map = vm_space_split_map(space, map, start_addr);
+            if(!map) {
+                return E_ERROR;
+            }
+        }
+
+        if(map->end_addr > end_addr &&
+           !vm_space_split_map(space, map, end_addr)) {
+            return E_ERROR;
+        }
+
+        map->flags = (map->flags & ~mask) | (flags & mask);
+        if(TEST_BIT(mask, prot)) {
+            ptable_protect_range(pgd, map->start_addr,
+                                 (map->end_addr - map->start_addr) / PAGE_SIZE,
+                                 map->flags);
+        }
+
+        map = vm_map_next(vm_space_merge_map(space, map));
+    }
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_protect() - Change the protection of a range of addresses
+ * @space:      A pointer to the address space
+ * @start_addr: The first (inclusive) address to change, page aligned
+ * @end_addr:   The final (exclusive) address to change, page aligned
+ * @flags:      The new VM_MAP_READ, VM_MAP_WRITE and VM_MAP_EXEC flags
+ *
+ * Mappings only partly within the range are split, and the protection of the
+ * mappings within it replaced, along with that of the pages already mapped.
+ * Each is then merged with its neighbours where the flags now match.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if memory ran out to split a mapping,
+ *         in which case only part of the range may have been changed.
+ */
+int32_t vm_space_protect(struct vm_space * space, void * start_addr,
+                         void * end_addr, flags_t flags) {
+    return vm_space_set_flags(space, start_addr, end_addr,
+                              VM_MAP_READ | VM_MAP_WRITE | VM_MAP_EXEC, flags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Read back in any swapped out pages of the range, then map the rest */
+static int32_t vm_space_willneed(struct vm_space * space, void * start_addr,
+                                 void * end_addr) {
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    struct vm_map * map = vm_space_first_map(space, start_addr);
+    int32_t rv = E_SUCCESS;
+
+    for(; map && map->start_addr < end_addr; map = vm_map_next(map)) {
+        void * start = start_addr > map->start_addr ? start_addr :
+                                                      map->start_addr;
+        void * end   = end_addr < map->end_addr ? end_addr : map->end_addr;
+
+        for(void * addr = start; swap_active() && addr < end;
+            addr += PAGE_SIZE) {
+            struct pte * pte = swap_get_pte(pgd, addr);
+            if(pte && !SUCCESS(swap_fault(map, addr, pte))) {
+                rv = E_ERROR;
+            }
+        }
+
+        if(!SUCCESS(map->ops->map_pages(map, start, end))) {
+            rv = E_ERROR;
+        }
+    }
+
+    return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Unmap and free the pages of the range, flushing the TLB in batches */
+static int32_t vm_space_dontneed(struct vm_space * space, void * start_addr,
+                                 void * end_addr) {
+    struct vm_map * map = vm_space_first_map(space, start_addr);
+    struct tlb_gather tlb;
+
+    /* Check the whole range first, so nothing is freed if any is refused */
+    for(; map && map->start_addr < end_addr; map = vm_map_next(map)) {
+        if(TEST_BIT(map->flags, VM_MAP_RESERVED) ||
+           (TEST_BIT(map->flags, VM_MAP_SHARED) &&
+            !TEST_BIT(map->flags, VM_MAP_IO))) {
+            return E_ERROR;
+        }
+    }
+
+    tlb_gather_init(&tlb, PHY_TO_VIR(space->pgd));
+
+    map = vm_space_first_map(space, start_addr);
+    for(; map && map->start_addr < end_addr; map = vm_map_next(map)) {
+        void * start = start_addr > map->start_addr ? start_addr :
+                                                      map->start_addr;
+        void * end   = end_addr < map->end_addr ? end_addr : map->end_addr;
+
+        /* Device memory is only unmapped, as it isn't ours to free */
+        ptable_unmap_range(&tlb, start, (end - start) / PAGE_SIZE,
+                           !TEST_BIT(map->flags, VM_MAP_IO));
+    }
+
+    tlb_gather_finish(&tlb);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_madvise() - Advise how a range of addresses will be used
+ * @space:      A pointer to the address space
+ * @start_addr: The first (inclusive) address of the range, page aligned
+ * @end_addr:   The final (exclusive) address of the range, page aligned
+ * @advice:     A VM_MADV_* value
+ *
+ * VM_MADV_SEQUENTIAL and VM_MADV_RANDOM set the access pattern hint of the
+ * mappings within the range, which sizes the window each page fault maps
+ * (see vm_space_fault_window()), and VM_MADV_NORMAL clears it. Mappings are
+ * split and merged as by vm_space_protect(), so each part of one keeps its
+ * own hint.
+ *
+ * VM_MADV_WILLNEED reads back in any of the range's pages that were swapped
+ * out, and maps the rest through the mappings' map_pages operations, so that
+ * accessing them later takes no page faults.
+ *
+ * VM_MADV_DONTNEED unmaps the range's pages and frees them straight away,
+ * along with the swap slots of those swapped out, gathering the TLB
+ * invalidations for the whole range. Private memory reads back as zeroes, or
+ * from its file, when it is next touched, and device memory is mapped in
+ * place again. Shared memory has nowhere else to keep its contents, and
+ * reserved memory must stay mapped, so both are refused.
+ *
+ * Addresses in the range that aren't mapped are skipped.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the advice is unknown or was
+ *         refused, or memory ran out.
+ */
+int32_t vm_space_madvise(struct vm_space * space, void * start_addr,
+                         void * end_addr, uint32_t advice) {
+    switch(advice) {
+        case VM_MADV_NORMAL:
+            return vm_space_set_flags(space, start_addr, end_addr,
+                                      VM_MAP_HINTS, 0);
+        case VM_MADV_RANDOM:
+            return vm_space_set_flags(space, start_addr, end_addr,
+                                      VM_MAP_HINTS, VM_MAP_RANDOM);
+        case VM_MADV_SEQUENTIAL:
+            return vm_space_set_flags(space, start_addr, end_addr,
+                                      VM_MAP_HINTS, VM_MAP_SEQUENTIAL);
+        case VM_MADV_WILLNEED:
+            return vm_space_willneed(space, start_addr, end_addr);
+        case VM_MADV_DONTNEED:
+            return vm_space_dontneed(space, start_addr, end_addr);
+        default:
+            return E_ERROR;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_fault_window() - Find the pages to map around a faulting address
+ * @map:   The mapping containing the address
+ * @addr:  The address that faulted
+ * @start: Set to the first (inclusive) address of the window
+ * @end:   Set to the final (exclusive) address of the window
+ *
+ * Code touching memory sequentially would otherwise fault once per page.
+ * Instead, each fault maps the aligned window of vm_fault_around_pages pages
+ * around it, within the bounds of the mapping.
+ *
+ * Mappings hinted VM_MAP_RANDOM would mostly waste the window, so map only
+ * the page that faulted. Those hinted VM_MAP_SEQUENTIAL won't go back, so map
+ * VM_FAULT_AHEAD_FACTOR windows from the faulting page onwards instead.
+ */
+void vm_space_fault_window(struct vm_map * map, void * addr,
+                           void ** start, void ** end) {
+    uintptr_t window = vm_fault_around_pages * PAGE_SIZE;
+
+    if(TEST_BIT(map->flags, VM_MAP_SEQUENTIAL)) {
+        *start = (void*)PAGE_ALIGN_DOWN(addr);
+        *end   = *start + window * VM_FAULT_AHEAD_FACTOR;
+    } else {
+        if(TEST_BIT(map->flags, VM_MAP_RANDOM)) {
+            window = PAGE_SIZE;
+        }
+        *start = (void*)ALIGN_DOWN(addr, window);
+        *end   = *start + window;
+    }
+
+    if(*start < map->start_addr) {
+        *start = map->start_addr;
+    }
+    if(*end > map->end_addr || *end < *start) {
+        *end = map->end_addr;
+    }
 }
 
 /* ------------------------------------------------------------------------- */
 
 /**
  * vm_space_page_fault() - Handle a page fault
- * @space:      The VM space to search for mappings and potentially update
- * @fault_addr: The address of the page fault
+ * @space:       The VM space to search for mappings and potentially update
+ * @fault_addr:  The address of the page fault
+ * @fault_flags: VM_FAULT_* flags describing the cause of the fault
  *
  * Searches the VM space of the task affected by the page fault to identify
- * any mappings that contain the faulted address. If a mapping exists, invoke
- * map_page() to allocate a physical page and map it into the task's page table
- * at the relevant virtual address.
+ * any mappings that contain the faulted address. If a mapping exists, its
+ * fault operation maps a page at the relevant virtual address in the task's
+ * page table, in whichever way suits what backs the mapping.
  *
  * This is used for "lazy loading" of page table entries, in which they are
  * only added to the page table when they're accessed.
  *
+ * A write to a page that is already mapped is only allowed if the mapping is
+ * writable, in which case it is passed to the mapping's page_mkwrite
+ * operation - for example, to copy a page shared by vm_space_fork(). A page
+ * that has been swapped out is read back in by swap_fault().
+ *
  * Return: E_SUCCESS if handled without error, E_ERROR otherwise
  */
-int32_t vm_space_page_fault(struct vm_space * space, void * fault_addr) {
-    struct vm_map *map;
-
-    klog("vm_space_page_fault(): fault at 0x%x\n", fault_addr);
-
+int32_t vm_space_page_fault(struct vm_space * space, void * fault_addr,
+                            flags_t fault_flags) {
     /* Check whether there's any VM mappings in the VM space that cover the
      * fault address */
-    list_for_each(map, &space->mappings, list_node) {
-        klog("Map[start: 0x%x | end: 0x%x]\n", map->start_addr, map->end_addr);
-        if(fault_addr >= map->start_addr && fault_addr < map->end_addr) {
-            klog("Mapping contains fault address\n");
-            /* The faulted address is mapped, alloc. a page & update PGD */
-            return vm_space_map_page(space, fault_addr);
+    struct vm_map * map = vm_map_find(space, fault_addr);
+    if(!map) {
+        /* The caller kills a user task that faulted outside its mappings */
+        klog("vm_space_page_fault(): No mapping found for 0x%x, unhandled "
+             "page fault!!!\n", fault_addr);
+        return E_ERROR;
+    }
+
+    if(TEST_BIT(fault_flags, VM_FAULT_WRITE) &&
+       !TEST_BIT(map->flags, VM_MAP_WRITE)) {
+        return E_ERROR;
+    }
+
+    /* Resolving the fault may take a page, so if the reclaim task has let
+     * memory run almost dry, reclaim some here first */
+    reclaim_direct();
+
+    /* The page is mapped, so this can only be a write to a read-only page */
+    if(TEST_BIT(fault_flags, VM_FAULT_PRESENT)) {
+        if(!TEST_BIT(fault_flags, VM_FAULT_WRITE) ||
+           !map->ops->page_mkwrite) {
+            return E_ERROR;
         }
+        return map->ops->page_mkwrite(map, fault_addr);
     }
 
-    /* TODO: handle user tasks that have page faulted on an unmapped address */
+    /* Pages that were swapped out are read back in, whatever backs them */
+    struct pte * pte = swap_get_pte(PHY_TO_VIR(space->pgd), fault_addr);
+    if(pte) {
+        return swap_fault(map, fault_addr, pte);
+    }
 
-    /* No mapping was found */
-    klog("No mapping found, unhandled page fault!!!\n");
-    return E_ERROR;
+    return map->ops->fault(map, fault_addr, fault_flags);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -133,25 +815,226 @@ int32_t vm_space_page_fault(struct vm_space * space, void * fault_addr) {
 /**
  * vm_space_map_page() - Allocate a page for a mapped address
  * @space: The VM space containing the page table to update
+ * @map:   The mapping containing the address
  * @addr:  The virtual address to add to the page table
  *
  * Called when a page fault occurs, but the current executing task has a
- * mapping for the faulted address. Allocates a physical page and adds the
- * relevant mapping for it to the VM space's page table.
+ * mapping for the faulted address. Allocates a zeroed physical page and adds
+ * the relevant mapping for it to the VM space's page table, with the
+ * mapping's permissions, then does the same for the rest of the fault window.
  *
  * Return: E_SUCCESS if successfully mapped, E_ERROR otherwise
  */
-int32_t vm_space_map_page(struct vm_space * space, void * addr) {
-    struct page * new_page = page_alloc(0, PR_KERNEL);
+int32_t vm_space_map_page(struct vm_space * space, struct vm_map * map,
+                          void * addr) {
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * start;
+    void * end;
+
+    struct page * new_page = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
     if(!new_page) {
         return E_ERROR;
     }
 
-    ptable_map(PHY_TO_VIR(space->pgd), addr, PAGE_PA(new_page), 0x00);
+    highmem_zero_page(new_page);
+    ptable_map_page(pgd, addr, new_page, map->flags);
+    if(RMAP_TRACKED(map->flags)) {
+        rmap_add_new(new_page, pgd, addr);
+    }
+
+    /* The rest of the window is best effort, so running out of memory here
+     * isn't an error */
+    vm_space_fault_window(map, addr, &start, &end);
+    ptable_populate_range(pgd, start, end, map->flags);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_map_zero() - Map the zero page for a read of untouched memory
+ * @space: The VM space containing the page table to update
+ * @map:   The mapping containing the address
+ * @addr:  The virtual address that was read
+ *
+ * Every unmapped page in the fault window is mapped to the zero page,
+ * read-only and copy-on-write, so that reading sparse memory allocates
+ * nothing. The first write to each page takes a private copy through
+ * ptable_cow_fault().
+ *
+ * Return: E_SUCCESS if successfully mapped, E_ERROR otherwise
+ */
+int32_t vm_space_map_zero(struct vm_space * space, struct vm_map * map,
+                          void * addr) {
+    void * start;
+    void * end;
+
+    vm_space_fault_window(map, addr, &start, &end);
+    return ptable_populate_cow(PHY_TO_VIR(space->pgd), start, end,
+                               vm_zero_page, map->flags);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_map_huge() - Allocate a huge page for a mapped address
+ * @space: The VM space containing the page table to update
+ * @map:   The mapping containing the address
+ * @addr:  The virtual address to add to the page table
+ *
+ * If the huge page aligned region around the address lies entirely within
+ * the mapping and nothing in it has been mapped yet, it is backed by a single
+ * huge page. This takes one page fault and one TLB entry for the whole region,
+ * rather than one per 4KB page.
+ *
+ * Return: E_SUCCESS if mapped, E_ERROR if the caller should fall back to
+ *         vm_space_map_page()
+ */
+int32_t vm_space_map_huge(struct vm_space * space, struct vm_map * map,
+                          void * addr) {
+    void * huge_start = (void*)ALIGN_DOWN(addr, HUGE_PAGE_SIZE);
+    void * huge_end   = huge_start + HUGE_PAGE_SIZE;
+
+    if(huge_start < map->start_addr || huge_end > map->end_addr ||
+       huge_end < huge_start) {
+        return E_ERROR;
+    }
+
+    /* Part of the region has already been mapped with 4KB pages */
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    if(PDE_EXISTS(GET_PDE(pgd, huge_start))) {
+        return E_ERROR;
+    }
+
+    struct page * block = page_alloc(HUGE_PAGE_ORDER, PR_KERNEL | PR_HIGHMEM);
+    if(!block) {
+        return E_ERROR;
+    }
+
+    for(uint32_t i = 0; i < PAGE_TABLE_SIZE; i++) {
+        highmem_zero_page(&block[i]);
+    }
+
+    if(!SUCCESS(ptable_map_huge(pgd, huge_start, block, map->flags))) {
+        page_free(block, HUGE_PAGE_ORDER);
+        return E_ERROR;
+    }
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_space_populate() - Map every page of a mapping up front
+ * @space: The VM space containing the page table to update
+ * @map:   The mapping to populate
+ *
+ * Used for mappings that will be streamed through, which would otherwise
+ * take a page fault every vm_fault_around_pages pages.
+ *
+ * Return: E_SUCCESS if every page was mapped, E_ERROR if memory ran out
+ */
+int32_t vm_space_populate(struct vm_space * space, struct vm_map * map) {
+    if(!SUCCESS(map->ops->map_pages(map, map->start_addr, map->end_addr))) {
+        klog("vm_space_populate(): Failed to populate 0x%x\n",
+             map->start_addr);
+        return E_ERROR;
+    }
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_set_fault_around() - Set how many pages are mapped by each page fault
+ * @pages: The size of the window, rounded down to a power of two and capped
+ *         at a page table. 1 or 0 maps only the page that faulted.
+ */
+void vm_set_fault_around(uint32_t pages) {
+    if(pages > PAGE_TABLE_SIZE) {
+        pages = PAGE_TABLE_SIZE;
+    }
+
+    vm_fault_around_pages = pages ? 1U << log2(pages) : 1;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Anonymous Memory                                                          */
+/* ------------------------------------------------------------------------- */
+
+static int32_t vm_anon_fault(struct vm_map * map, void * addr,
+                             flags_t fault_flags) {
+    /* Reads of private memory that has never been written are served by the
+     * zero page, so untouched memory costs nothing */
+    if(!TEST_BIT(fault_flags, VM_FAULT_WRITE) &&
+       !TEST_BIT(map->flags, VM_MAP_SHARED)) {
+        return vm_space_map_zero(map->space, map, addr);
+    }
+
+    /* Large mappings are backed by huge pages where possible */
+    if(SUCCESS(vm_space_map_huge(map->space, map, addr))) {
+        return E_SUCCESS;
+    }
+
+    return vm_space_map_page(map->space, map, addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Each huge page aligned region that lies entirely within the range is backed
+ * by a huge page where possible, and the rest with 4KB pages */
+static int32_t vm_anon_map_pages(struct vm_map * map, void * start_addr,
+                                 void * end_addr) {
+    struct pgd * pgd = PHY_TO_VIR(map->space->pgd);
+    void * addr = start_addr;
+
+    while(addr < end_addr) {
+        if(IS_HUGE_ALIGNED(addr) && addr + HUGE_PAGE_SIZE <= end_addr &&
+           SUCCESS(vm_space_map_huge(map->space, map, addr))) {
+            addr += HUGE_PAGE_SIZE;
+            continue;
+        }
+
+        void * next = (void*)ALIGN((uintptr_t)addr + 1, HUGE_PAGE_SIZE);
+        if(next > end_addr || next < addr) {
+            next = end_addr;
+        }
+
+        if(!SUCCESS(ptable_populate_range(pgd, addr, next, map->flags))) {
+            return E_ERROR;
+        }
+        addr = next;
+    }
 
     return E_SUCCESS;
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* Private pages are shared copy-on-write by vm_space_fork() */
+static int32_t vm_anon_page_mkwrite(struct vm_map * map, void * addr) {
+    return ptable_cow_fault(PHY_TO_VIR(map->space->pgd), addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void vm_anon_close(struct vm_map * map) {
+    ptable_unmap_many(PHY_TO_VIR(map->space->pgd), map->start_addr,
+                      (map->end_addr - map->start_addr) / PAGE_SIZE, 1);
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct vm_ops vm_anon_ops = {
+    .fault        = vm_anon_fault,
+    .map_pages    = vm_anon_map_pages,
+    .page_mkwrite = vm_anon_page_mkwrite,
+    .close        = vm_anon_close
+};
+
 /* ------------------------------------------------------------------------- */
 /* Individual Mapping Operations                                             */
 /* ------------------------------------------------------------------------- */
@@ -164,7 +1047,11 @@ int32_t vm_space_map_page(struct vm_space * space, void * addr) {
  * Return: A pointer to the new VM mapping
  */
 struct vm_map * vm_map_new() {
-    struct vm_map * map = (struct vm_map*)kmalloc(sizeof(struct vm_map));
+    struct vm_map * map = slab_malloc(vm_map_cache, 0);
+    if(!map) {
+        klog("vm_map_new(): Failed to alloc. memory!\n");
+        return NULL;
+    }
     memset(map, 0, sizeof(struct vm_map));
     llist_init(&map->list_node);
 
@@ -177,7 +1064,49 @@ struct vm_map * vm_map_new() {
  * vm_map_free() - Free an existing VM mapping
  */
 void vm_map_destroy(struct vm_map * map) {
-    kfree(map);
+    slab_free(vm_map_cache, map);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_map_find() - Find the mapping containing an address
+ * @space: A pointer to the address space to search
+ * @addr:  The address
+ *
+ * The mapping found is cached, and checked first by the next lookup, as
+ * consecutive faults tend to fall in the same mapping.
+ *
+ * Return: The mapping, or NULL if the address isn't mapped.
+ */
+struct vm_map * vm_map_find(struct vm_space * space, void * addr) {
+    struct vm_map * map = space->map_cache;
+    if(map && addr >= map->start_addr && addr < map->end_addr) {
+        return map;
+    }
+
+    map = vm_map_floor(space, addr);
+    if(!map || addr >= map->end_addr) {
+        return NULL;
+    }
+
+    space->map_cache = map;
+    return map;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * vm_map_next() - Retrieve the next mapping in an address space
+ * @map: A pointer to a mapping in the address space
+ *
+ * Return: The mapping at the next highest address, or NULL if there is none.
+ */
+struct vm_map * vm_map_next(struct vm_map * map) {
+    if(!map->list_node.next) {
+        return NULL;
+    }
+    return container_of(map->list_node.next, struct vm_map, list_node);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -0,0 +1,211 @@
+/*
+ * kernel/mm/wss.c
+ * Working Set Estimation
+ *
+ * The CPU sets the accessed bit of a page table entry whenever the page is
+ * used, and the dirty bit whenever it's written to. Every WSS_SCAN_INTERVAL
+ * ticks, the idle loop walks the user half of each address space, harvesting
+ * and clearing both bits so that the CPU sets them again on the next access.
+ *
+ * Each scan of every address space is a generation. A page's last_access
+ * records the generation in which it was last seen accessed, so its age is
+ * the number of scans it has gone unused, whichever address spaces map it.
+ * Dirty bits are moved into PF_DIRTY on the page, so that they aren't lost
+ * when cleared from the entry.
+ *
+ * An address space's working set is the pages it maps that have been used
+ * within the last WSS_WINDOW generations. Reclaim should take pages from
+ * outside the working set first, oldest first.
+ */
+
+#include <rotary/mm/wss.h>
+
+/* ------------------------------------------------------------------------- */
+
+uint32_t wss_generation = 1;
+uint64_t wss_last_scan  = 0;
+
+/* Statistics, from the most recent wss_scan_all() */
+struct wss_scan wss_totals;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * wss_touch() - Harvest the accessed and dirty bits of an entry.
+ * @page:  The first page mapped by the entry.
+ * @count: The number of pages mapped by the entry.
+ * @entry: The entry, whose accessed and dirty bits are cleared.
+ * @scan:  The scan to add the pages to.
+ *
+ * Return: Whether the entry was changed, in which case its TLB entry must
+ *         be invalidated.
+ */
+static int wss_touch(struct page * page, uint32_t count,
+                     ptable_entry_t * entry, struct wss_scan * scan) {
+    ptable_entry_t bits = *entry & (PTE_ACCESSED | PTE_DIRTY);
+
+    for(uint32_t i = 0; i < count; i++) {
+        if(TEST_BIT(bits, PTE_ACCESSED)) {
+            page[i].last_access = wss_generation;
+        }
+        if(TEST_BIT(bits, PTE_DIRTY)) {
+            SET_BIT(page[i].flags, PF_DIRTY);
+        }
+    }
+
+    scan->rss_pages += count;
+    if(wss_page_age(page) < WSS_WINDOW) {
+        scan->wss_pages += count;
+    }
+    if(TEST_BIT(bits, PTE_DIRTY)) {
+        scan->dirty_pages += count;
+    }
+
+    *entry &= ~bits;
+    return bits != 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int32_t wss_scan_pte(struct ptable_walk * walk, struct pte * pte,
+                            void * virt_addr) {
+    /* The zero page stands in for memory that has never been written, so
+     * isn't resident on behalf of any address space */
+    if(!page_pfn_is_ram(PTE_PFN(pte)) || PTE_PAGE(pte) == vm_zero_page) {
+        return E_SUCCESS;
+    }
+
+    if(wss_touch(PTE_PAGE(pte), 1, &pte->entry, walk->private)) {
+        tlb_gather_inval(walk->tlb, virt_addr);
+    }
+
+    return E_SUCCESS;
+}
+
+static int32_t wss_scan_huge(struct ptable_walk * walk, struct pde * pde,
+                             void * virt_addr) {
+    if(!page_pfn_is_ram(PDE_PFN(pde))) {
+        return E_SUCCESS;
+    }
+
+    /* A huge page has a single pair of bits for all of its pages, in the same
+     * positions as PTE_ACCESSED and PTE_DIRTY */
+    if(wss_touch(PDE_PAGE(pde), PAGE_TABLE_SIZE, &pde->entry,
+                 walk->private)) {
+        tlb_gather_inval(walk->tlb, virt_addr);
+    }
+
+    return E_SUCCESS;
+}
+
+/**
+ * wss_scan_space() - Update the working set estimate of an address space.
+ * @space: The address space to scan.
+ * @scan:  Filled with the pages found.
+ *
+ * Walks every user mapping in the address space, so the caller must ensure
+ * that its page tables aren't changed during the scan.
+ */
+void wss_scan_space(struct vm_space * space, struct wss_scan * scan) {
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    struct tlb_gather tlb;
+
+    memset(scan, 0, sizeof(struct wss_scan));
+    tlb_gather_init(&tlb, pgd);
+
+    struct ptable_walk walk = {
+        .pgd     = pgd,
+        .pte_fn  = wss_scan_pte,
+        .huge_fn = wss_scan_huge,
+        .tlb     = &tlb,
+        .private = scan
+    };
+
+    ptable_walk_range(&walk, NULL, (void*)KERNEL_START_VIRT);
+    tlb_gather_finish(&tlb);
+
+    space->rss_pages = scan->rss_pages;
+    space->wss_pages = scan->wss_pages;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * wss_scan_all() - Scan the address space of every task.
+ *
+ * Starts a new generation, so pages not accessed since the last call age by
+ * one. Task switching is disabled while each address space is scanned, so
+ * that its owner can't change its page tables underneath the scan.
+ */
+void wss_scan_all() {
+    struct vm_space * space;
+    uint32_t task_id = 0;
+
+    wss_generation++;
+    memset(&wss_totals, 0, sizeof(struct wss_scan));
+
+    while((space = task_next_vm_space(&task_id))) {
+        struct wss_scan scan;
+        uint8_t sched_enabled = cpu_get_local()->sched_enabled;
+
+        task_disable_scheduler();
+        wss_scan_space(space, &scan);
+        if(sched_enabled) {
+            task_enable_scheduler();
+        }
+
+        wss_totals.rss_pages   += scan.rss_pages;
+        wss_totals.wss_pages   += scan.wss_pages;
+        wss_totals.dirty_pages += scan.dirty_pages;
+
+        vm_space_put(space);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * wss_scan_periodic() - Scan every address space, if a scan is due.
+ *
+ * Called from the idle loop.
+ */
+void wss_scan_periodic() {
+    uint64_t now = timer_get_ticks();
+    if(now - wss_last_scan < WSS_SCAN_INTERVAL) {
+        return;
+    }
+
+    wss_last_scan = now;
+    wss_scan_all();
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * wss_page_age() - Returns how long a page has gone unused.
+ * @page: The page, which should be mapped by an address space.
+ *
+ * Return: The number of scans since the page was last seen accessed.
+ */
+uint32_t wss_page_age(struct page * page) {
+    return wss_generation - page->last_access;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * wss_print_debug() - Print the results of the most recent scan.
+ */
+void wss_print_debug() {
+    printk(LOG_DEBUG, "Working set scan %d: %d pages resident, "
+           "%d in working sets, %d newly dirty\n", wss_generation,
+           wss_totals.rss_pages, wss_totals.wss_pages,
+           wss_totals.dirty_pages);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/wss.c"
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,186 @@
+/*
+ * kernel/mm/zpool.c
+ * Compressed Object Pool
+ *
+ * Compressed pages come in every size up to a page, and kmalloc()'s power of
+ * two caches would waste up to half of each. A pool instead rounds sizes up
+ * to a multiple of ZPOOL_ALIGN, and packs objects of each size class into
+ * pages of their own, so that an object wastes less than ZPOOL_ALIGN bytes
+ * plus its share of the page's tail.
+ *
+ * Each page starts with a header, and its objects follow, linked through a
+ * free list while unused. Pages with free objects are kept on their class's
+ * list, new objects being taken from the first of them, and a page is
+ * given back to the page allocator as soon as its last object is freed.
+ *
+ * Objects never straddle pages, so one larger than half of ZPOOL_MAX_SIZE
+ * takes a page to itself. Callers storing compressed pages should refuse to
+ * store those that don't compress to within that.
+ *
+ * Pages are lowmem, so objects are addressed directly, by pointer.
+ */
+
+#include <rotary/mm/zpool.h>
+
+/* ------------------------------------------------------------------------- */
+
+static inline uint32_t zpool_class(uint32_t size) {
+    return (size + ZPOOL_ALIGN - 1) / ZPOOL_ALIGN - 1;
+}
+
+static inline struct zpool_page * zpool_page_of(void * object) {
+    return (struct zpool_page *)PAGE_ALIGN_DOWN(object);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zpool_init() - Initialise an empty pool.
+ * @pool: The pool.
+ */
+void zpool_init(struct zpool * pool) {
+    for(uint32_t i = 0; i < ZPOOL_CLASSES; i++) {
+        clist_init(&pool->classes[i]);
+    }
+
+    atomic_flag_clear(&pool->lock);
+    pool->pages   = 0;
+    pool->objects = 0;
+    pool->bytes   = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zpool_new_page() - Take a new page for a size class.
+ * @pool:      The pool.
+ * @class_idx: The size class.
+ *
+ * Return: The page's header, with every object free, or NULL if memory ran
+ *         out.
+ */
+static struct zpool_page * zpool_new_page(struct zpool * pool,
+                                          uint32_t class_idx) {
+    struct page * page = page_alloc(0, PR_KERNEL);
+    if(!page) {
+        return NULL;
+    }
+
+    struct zpool_page * header = PAGE_VA(page);
+    uint32_t size = (class_idx + 1) * ZPOOL_ALIGN;
+
+    header->size  = size;
+    header->count = ZPOOL_MAX_SIZE / size;
+    header->used  = 0;
+    header->free  = ZPOOL_HEADER_SIZE;
+
+    /* Chain the objects in address order */
+    for(uint32_t i = 0; i < header->count; i++) {
+        uint32_t offset = ZPOOL_HEADER_SIZE + i * size;
+        uint16_t * next = (void*)header + offset;
+        *next = i + 1 < header->count ? offset + size : 0;
+    }
+
+    clist_add(&pool->classes[class_idx], &header->node);
+    pool->pages++;
+    return header;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zpool_alloc() - Allocate an object from a pool.
+ * @pool: The pool.
+ * @size: The size of the object, at most ZPOOL_MAX_SIZE.
+ *
+ * Return: The object, or NULL if memory ran out or it was too large.
+ */
+void * zpool_alloc(struct zpool * pool, uint32_t size) {
+    if(size == 0 || size > ZPOOL_MAX_SIZE) {
+        return NULL;
+    }
+
+    uint32_t class_idx = zpool_class(size);
+    list_head_t * list = &pool->classes[class_idx];
+
+    lock(&pool->lock);
+
+    struct zpool_page * header;
+    if(list->next != list) {
+        header = container_of(list->next, struct zpool_page, node);
+    } else if(!(header = zpool_new_page(pool, class_idx))) {
+        unlock(&pool->lock);
+        return NULL;
+    }
+
+    void * object = (void*)header + header->free;
+    header->free = *(uint16_t*)object;
+    header->used++;
+
+    /* Full pages are left off the list until an object is freed */
+    if(!header->free) {
+        clist_delete_node(&header->node);
+    }
+
+    pool->objects++;
+    pool->bytes += size;
+
+    unlock(&pool->lock);
+    return object;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zpool_free() - Free an object.
+ * @pool:   The pool it was allocated from.
+ * @object: The object.
+ * @size:   The size it was allocated with.
+ *
+ * The page holding the object is freed along with its last object.
+ */
+void zpool_free(struct zpool * pool, void * object, uint32_t size) {
+    struct zpool_page * header = zpool_page_of(object);
+
+    lock(&pool->lock);
+
+    if(!header->free) {
+        clist_add(&pool->classes[zpool_class(header->size)], &header->node);
+    }
+
+    *(uint16_t*)object = header->free;
+    header->free = object - (void*)header;
+    header->used--;
+
+    pool->objects--;
+    pool->bytes -= size;
+
+    if(!header->used) {
+        clist_delete_node(&header->node);
+        page_free_va(header, 0);
+        pool->pages--;
+    }
+
+    unlock(&pool->lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zpool_print_debug() - Print a pool's usage.
+ * @pool: The pool.
+ */
+void zpool_print_debug(struct zpool * pool) {
+    uint32_t held = pool->pages * PAGE_SIZE;
+
+    printk(LOG_DEBUG, "zpool: %d objects, %d bytes in %d pages (%d%% used)\n",
+           pool->objects, pool->bytes, pool->pages,
+           held ? pool->bytes / (held / 100) : 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/zpool.c"
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,291 @@
+/*
+ * kernel/mm/zswap.c
+ * Compressed Swap Cache
+ *
+ * Writing a page to the swap device and reading it back is slow, while the
+ * cold pages reclaim picks usually compress well. zswap sits in front of the
+ * swap device as its first tier: swap_write() offers it each page first, and
+ * it keeps the page compressed in memory, against the page's swap slot,
+ * so that the device is only written when a page doesn't compress. Reads of
+ * a slot zswap holds are served from memory by swap_read().
+ *
+ * Pages with every word the same, most often zero, are held as just that
+ * word. Others are compressed with LZ4, and kept in a zpool, unless they
+ * compress to more than ZSWAP_MAX_SIZE, or the pool already has
+ * ZSWAP_MAX_POOL_PERCENT of memory.
+ *
+ * A slot's copy is kept until the slot is freed, as every swap entry that
+ * shares the slot reads it back separately. Decompression time is measured
+ * with the TSC, when there is one.
+ */
+
+#include <rotary/mm/zswap.h>
+
+/* ------------------------------------------------------------------------- */
+
+struct zswap_entry * zswap_entries = NULL;
+uint32_t zswap_slot_count = 0;
+uint32_t zswap_max_pages  = 0;
+
+struct zpool zswap_pool;
+struct zswap_stats zswap_stats;
+int32_t zswap_has_tsc = 0;
+
+/* Compression scratch space, used under zswap_lock */
+struct lz4_state zswap_lz4;
+uint8_t zswap_buffer[ZSWAP_MAX_SIZE];
+
+volatile atomic_flag zswap_lock = ATOMIC_FLAG_INIT;
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zswap_enable() - Start holding pages for a new swap area.
+ * @slot_count: The number of slots in the swap area.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if memory ran out.
+ */
+int32_t zswap_enable(uint32_t slot_count) {
+    uint32_t size = slot_count * sizeof(struct zswap_entry);
+
+    struct zswap_entry * entries = kmalloc(size);
+    if(!entries) {
+        klog("zswap_enable(): No memory for %d slots\n", slot_count);
+        return E_ERROR;
+    }
+    memset(entries, 0, size);
+
+    lock(&zswap_lock);
+    zpool_init(&zswap_pool);
+    memset(&zswap_stats, 0, sizeof(struct zswap_stats));
+    zswap_max_pages  = page_total_count() / 100 * ZSWAP_MAX_POOL_PERCENT;
+    zswap_has_tsc    = cpuid_check_tsc();
+    zswap_slot_count = slot_count;
+    zswap_entries    = entries;
+    unlock(&zswap_lock);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zswap_disable() - Stop holding pages.
+ *
+ * Called by swap_off(), once no slot is in use, so nothing is held.
+ */
+void zswap_disable() {
+    lock(&zswap_lock);
+    struct zswap_entry * entries = zswap_entries;
+    zswap_entries    = NULL;
+    zswap_slot_count = 0;
+    unlock(&zswap_lock);
+
+    kfree(entries);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zswap_same_filled() - Check whether a page repeats a single word.
+ * @virt_addr: The page.
+ * @value:     Set to the word, if it does.
+ *
+ * Return: 1 if every word of the page is the same, 0 otherwise.
+ */
+static int zswap_same_filled(uint32_t * virt_addr, uint32_t * value) {
+    for(uint32_t i = 1; i < PAGE_SIZE / sizeof(uint32_t); i++) {
+        if(virt_addr[i] != virt_addr[0]) {
+            return 0;
+        }
+    }
+
+    *value = virt_addr[0];
+    return 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zswap_store() - Hold a page being swapped out to a slot.
+ * @slot: The slot the page has been given.
+ * @page: The page, which may be highmem.
+ *
+ * Return: E_SUCCESS if the page is held, E_ERROR if it must be written to
+ *         the swap device instead.
+ */
+int32_t zswap_store(uint32_t slot, struct page * page) {
+    int32_t rv = E_ERROR;
+    uint32_t value;
+
+    lock(&zswap_lock);
+
+    if(!zswap_entries || slot >= zswap_slot_count) {
+        unlock(&zswap_lock);
+        return E_ERROR;
+    }
+
+    struct zswap_entry * entry = &zswap_entries[slot];
+    void * virt_addr = kmap_atomic(page);
+
+    if(zswap_same_filled(virt_addr, &value)) {
+        entry->value = value;
+        entry->type  = ZSWAP_SAME;
+        zswap_stats.same_filled++;
+        rv = E_SUCCESS;
+    } else if(zswap_pool.pages >= zswap_max_pages) {
+        zswap_stats.pool_full++;
+    } else {
+        uint32_t size = lz4_compress(&zswap_lz4, virt_addr, PAGE_SIZE,
+                                     zswap_buffer, ZSWAP_MAX_SIZE);
+        void * object = size ? zpool_alloc(&zswap_pool, size) : NULL;
+
+        if(!size) {
+            zswap_stats.too_large++;
+        } else if(object) {
+            memcpy(object, zswap_buffer, size);
+            entry->object = object;
+            entry->length = size;
+            entry->type   = ZSWAP_COMPRESSED;
+            zswap_stats.stored++;
+            rv = E_SUCCESS;
+        }
+    }
+
+    kunmap_atomic(virt_addr);
+    unlock(&zswap_lock);
+    return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zswap_has() - Returns whether a slot's page is held by zswap.
+ * @slot: The slot.
+ *
+ * Return: 1 if it is, 0 if the page is on the swap device.
+ */
+int zswap_has(uint32_t slot) {
+    return zswap_entries && slot < zswap_slot_count &&
+           zswap_entries[slot].type != ZSWAP_NONE;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zswap_load() - Read a page held by zswap.
+ * @slot: The slot, which zswap_has() said is held.
+ * @page: The page to read into, which may be highmem.
+ *
+ * The copy is kept, for any other swap entries sharing the slot.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the page wasn't held or its
+ *         compressed copy is corrupt.
+ */
+int32_t zswap_load(uint32_t slot, struct page * page) {
+    int32_t rv = E_SUCCESS;
+
+    lock(&zswap_lock);
+
+    if(!zswap_has(slot)) {
+        unlock(&zswap_lock);
+        return E_ERROR;
+    }
+
+    struct zswap_entry * entry = &zswap_entries[slot];
+    uint64_t start = zswap_has_tsc ? tsc_read() : 0;
+    uint32_t * virt_addr = kmap_atomic(page);
+
+    if(entry->type == ZSWAP_SAME) {
+        for(uint32_t i = 0; i < PAGE_SIZE / sizeof(uint32_t); i++) {
+            virt_addr[i] = entry->value;
+        }
+    } else if(lz4_decompress(entry->object, entry->length, virt_addr,
+                             PAGE_SIZE) != PAGE_SIZE) {
+        klog("zswap_load(): Slot %d is corrupt!\n", slot);
+        rv = E_ERROR;
+    }
+
+    kunmap_atomic(virt_addr);
+
+    if(zswap_has_tsc) {
+        zswap_stats.load_cycles += tsc_read() - start;
+    }
+    zswap_stats.loads++;
+
+    unlock(&zswap_lock);
+    return rv;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zswap_invalidate() - Drop whatever is held for a slot.
+ * @slot: The slot, whose last use is being released.
+ *
+ * Called by swap_put() with the swap area locked, so that the slot can't be
+ * reallocated and stored to again before its old copy is dropped.
+ */
+void zswap_invalidate(uint32_t slot) {
+    lock(&zswap_lock);
+
+    if(!zswap_has(slot)) {
+        unlock(&zswap_lock);
+        return;
+    }
+
+    struct zswap_entry * entry = &zswap_entries[slot];
+    if(entry->type == ZSWAP_COMPRESSED) {
+        zpool_free(&zswap_pool, entry->object, entry->length);
+        zswap_stats.stored--;
+    } else {
+        zswap_stats.same_filled--;
+    }
+
+    memset(entry, 0, sizeof(struct zswap_entry));
+    unlock(&zswap_lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * zswap_print_debug() - Print the pages held, compression ratio and load
+ *                       latency.
+ */
+void zswap_print_debug() {
+    if(!zswap_entries) {
+        printk(LOG_DEBUG, "zswap: disabled\n");
+        return;
+    }
+
+    /* The ratio of the memory the compressed pages took to what they take
+     * now, in hundredths, counting the pool's wasted space */
+    uint32_t ratio = zswap_pool.pages ?
+        (uint32_t)udiv64((uint64_t)zswap_stats.stored * 100,
+                         zswap_pool.pages) : 0;
+
+    printk(LOG_DEBUG, "zswap: %d compressed pages in %d (ratio %d.%d%d), "
+           "%d same-filled\n", zswap_stats.stored, zswap_pool.pages,
+           ratio / 100, ratio / 10 % 10, ratio % 10, zswap_stats.same_filled);
+    printk(LOG_DEBUG, "zswap: refused %d incompressible, %d with pool full "
+           "(limit %d pages)\n", zswap_stats.too_large, zswap_stats.pool_full,
+           zswap_max_pages);
+    zpool_print_debug(&zswap_pool);
+
+    uint32_t tsc_khz = zswap_has_tsc ? tsc_calibrate() : 0;
+    if(!zswap_stats.loads || !tsc_khz) {
+        printk(LOG_DEBUG, "zswap: %d loads\n", zswap_stats.loads);
+        return;
+    }
+
+    uint64_t cycles = udiv64(zswap_stats.load_cycles, zswap_stats.loads);
+    printk(LOG_DEBUG, "zswap: %d loads, %d ns each on average\n",
+           zswap_stats.loads, (uint32_t)udiv64(cycles * 1000000, tsc_khz));
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/zswap.c"
+
+/* ------------------------------------------------------------------------- */
@@ -27,7 +27,7 @@ struct task task_head;
  *
  * Return: E_SUCCESS on success, E_ERROR on failure.
  */
-int32_t task_init() {
+int32_t __init task_init() {
     /* Our initial task will continue the execution of kernel_main(), as when
      * we switch to a new task the current EIP/ESP will be stored in the
      * tasks[0] struct. */
@@ -43,6 +43,7 @@ int32_t task_init() {
         PANIC("Failed to kmalloc() memory for initial task struct!\n");
         return E_ERROR;
     }
+    memset(idle_task, 0, sizeof(struct task));
 
     /* Set default idle task state */
     idle_task->state = TASK_STATE_RUNNING;
@@ -51,9 +52,9 @@ int32_t task_init() {
     /* Set the kernel stack bottom using symbol from the init stub */
     idle_task->kstack_bot = PHY_TO_VIR(&KERNEL_STACK_BOTTOM);
 
-    /* Create a new virtual address space, by default it will include mappings
-     * for the kernel */
-    idle_task->vm_space = vm_space_new();
+    /* The idle task is a kernel task, so has no address space of its own and
+     * starts on the kernel's, which is already loaded */
+    idle_task->active_vm_space = vm_space_get(vm_space_kernel());
 
     /* Assign the task name */
     strncpy(idle_task->name, "kernel_idle", TASK_NAME_LENGTH_MAX);
@@ -132,8 +133,8 @@ struct task * task_create(char * name, uint32_t type, void * start_addr,
         goto cleanup;
     }
 
-    /* Initialise the address space and page table, kernel mappings will be
-     * included by default */
+    /* Initialise the address space and page table for user tasks, kernel
+     * mappings will be included by default */
     if(!SUCCESS(task_create_vm_space(new_task))) {
         goto cleanup;
     }
@@ -169,6 +170,74 @@ cleanup:
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * task_fork() - Create a copy of a user task
+ * @parent: The task to copy.
+ * @state:  The initial state of the new task, TASK_STATE_WAITING or
+ *          TASK_STATE_PAUSED.
+ *
+ * The new task is given a duplicate of the parent's address space with
+ * vm_space_fork(), sharing its pages copy-on-write, so that forking costs the
+ * parent's page tables rather than its resident memory. It starts from the
+ * parent's entry point, with the same name and priority.
+ *
+ * Return: Pointer to the new struct task object on success, NULL on failure.
+ */
+struct task * task_fork(struct task * parent, uint32_t state) {
+    if(!parent->vm_space) {
+        klog("task_fork(): Task '%s' has no address space to copy!\n",
+             parent->name);
+        return NULL;
+    }
+
+    if(state != TASK_STATE_PAUSED && state != TASK_STATE_WAITING) {
+        klog("Invalid starting state, can only be "
+               "WAITING or PAUSED!\n");
+        return NULL;
+    }
+
+    /* Copy the page tables before taking the task lock, which the timer
+     * interrupt also needs */
+    struct vm_space * space = vm_space_fork(parent->vm_space);
+    if(!space) {
+        return NULL;
+    }
+
+    lock(&task_lock);
+
+    struct task * new_task = task_alloc_struct(parent->name, parent->type,
+                                               parent->start_addr,
+                                               parent->priority, state);
+    if(!new_task) {
+        klog("Failed to create new task struct!\n");
+        unlock(&task_lock);
+        vm_space_put(space);
+        return NULL;
+    }
+
+    new_task->vm_space = space;
+
+    if(!SUCCESS(task_create_kernel_stack(new_task)) ||
+       !SUCCESS(arch_task_create(new_task))) {
+        klog("Failed to set up forked task '%s'!\n", parent->name);
+        task_destroy_vm_space(new_task);
+        task_destroy_kernel_stack(new_task);
+        kfree(new_task);
+        unlock(&task_lock);
+        return NULL;
+    }
+
+    clist_add(&task_head.list_node, &new_task->list_node);
+    unlock(&task_lock);
+
+    klog("Forked task '%s' (PID %D) from PID %D\n", new_task->name,
+         new_task->id, parent->id);
+
+    return new_task;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * task_alloc_struct() - Allocate a struct task and set its values
  * @name:       The new task's name in ASCII format, with a maximum length of
@@ -219,9 +288,17 @@ struct task * task_alloc_struct(char * name, uint32_t type, void * start_addr,
  * task_create_vm_space() - Set-up an initial VM space for a new task
  * @task: Pointer to the task for which the VM space will be allocated
  *
+ * Kernel tasks never access user memory, so aren't given a VM space. They
+ * borrow the address space of the previous task when scheduled, avoiding both
+ * the PGD allocation here and a TLB flush on every switch to or from them.
+ *
  * Return: E_SUCCESS on success, E_ERROR on failure.
  */
 int32_t task_create_vm_space(struct task * task) {
+    if(task->type == TASK_KERNEL) {
+        return E_SUCCESS;
+    }
+
     task->vm_space = vm_space_new();
     if(!task->vm_space) {
         klog("Failed to create virtual address space for task '%s'!\n",
@@ -239,7 +316,42 @@ int32_t task_create_vm_space(struct task * task) {
  */
 void task_destroy_vm_space(struct task * task) {
     if(!task || !task->vm_space) return;
-    vm_space_destroy(task->vm_space);
+    vm_space_put(task->vm_space);
+    task->vm_space = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * task_switch_vm_space() - Load the address space of the next task
+ * @prev: The task being switched away from.
+ * @next: The task being switched to.
+ *
+ * A kernel task takes a reference to the address space of the task before it
+ * and carries on using it, so the PGD is only reloaded when switching to a
+ * user task whose address space isn't already loaded. The reference is held
+ * until the kernel task is switched away from, and is released only after
+ * the next PGD has been loaded, as it may be the last one.
+ */
+void task_switch_vm_space(struct task * prev, struct task * next) {
+    struct vm_space * prev_space = prev->active_vm_space;
+
+    if(prev == next) return;
+
+    if(next->vm_space) {
+        next->active_vm_space = next->vm_space;
+    } else {
+        next->active_vm_space = vm_space_get(prev_space);
+    }
+
+    if(next->active_vm_space->pgd != prev_space->pgd) {
+        paging_load_pgd(next->active_vm_space->pgd);
+    }
+
+    if(!prev->vm_space) {
+        prev->active_vm_space = NULL;
+        vm_space_put(prev_space);
+    }
 }
 
 /* ------------------------------------------------------------------------- */
@@ -287,6 +399,42 @@ void task_destroy_kernel_stack(struct task * task) {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * task_get_scratch() - Retrieve a task's scratch arena.
+ * @task: The task whose scratch arena should be returned.
+ *
+ * The scratch arena is intended for short-lived allocations made while
+ * servicing a single request on behalf of the task, such as a syscall. It is
+ * created on first use, and all of its memory can be released in one step
+ * with task_reset_scratch() once the request has completed.
+ *
+ * Return: A pointer to the task's arena, or NULL if it could not be created.
+ */
+struct arena * task_get_scratch(struct task * task) {
+    if(!task->scratch) {
+        task->scratch = arena_create(ARENA_DEFAULT_ORDER);
+        if(!task->scratch) {
+            klog("Failed to create scratch arena for task '%s'!\n",
+                 task->name);
+        }
+    }
+    return task->scratch;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * task_reset_scratch() - Release all allocations in a task's scratch arena.
+ * @task: The task whose scratch arena should be reset.
+ */
+void task_reset_scratch(struct task * task) {
+    if(task->scratch) {
+        arena_reset(task->scratch);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * task_kill() - Mark a task as killed.
  * @task_id: ID of the task to kill.
@@ -382,6 +530,9 @@ int32_t task_purge(uint32_t task_id) {
     /* Free stack memory allocated for this task */
     task_destroy_kernel_stack(task_tk);
 
+    /* Free the task's scratch arena, if one was ever created */
+    arena_destroy(task_tk->scratch);
+
     /* Finally, free the task object itself */
     kfree(task_tk);
 
@@ -450,6 +601,42 @@ struct task * task_get_from_id(uint32_t task_id) {
 
 /* ------------------------------------------------------------------------- */
 
+/**
+ * task_next_vm_space() - Take a reference to the next task's address space.
+ * @task_id: The ID of the last task visited, updated to the task found.
+ *
+ * Visits tasks with their own address space in order of ID, so that callers
+ * can work through every address space without holding task_lock. The
+ * reference must be released with vm_space_put().
+ *
+ * Return: The address space of the task with the lowest ID above *task_id,
+ *         or NULL if there are none left.
+ */
+struct vm_space * task_next_vm_space(uint32_t * task_id) {
+    struct task * next = NULL;
+    struct task * task;
+
+    lock(&task_lock);
+
+    clist_for_each(task, &task_head.list_node, list_node) {
+        if(task->vm_space && task->state != TASK_STATE_KILLED &&
+           task->id > *task_id && (!next || task->id < next->id)) {
+            next = task;
+        }
+    }
+
+    struct vm_space * space = NULL;
+    if(next) {
+        *task_id = next->id;
+        space = vm_space_get(next->vm_space);
+    }
+
+    unlock(&task_lock);
+    return space;
+}
+
+/* ------------------------------------------------------------------------- */
+
 /**
  * task_schedule() - Task scheduler.
  *
@@ -509,6 +696,7 @@ void task_schedule() {
     }
     next->state = TASK_STATE_RUNNING;
 
+    task_switch_vm_space(prev, next);
     arch_task_switch(prev, next);
 }
 
@@ -519,13 +707,15 @@ void task_schedule() {
  *
  * Iterates through all tasks to find tasks in state TASK_STATE_KILLED,
  * indicating that they should be purged by the scheduler. Purge any tasks
- * found.
+ * found, other than the current task: a task which has just exited is still
+ * running on its own kernel stack, so it is purged on a later tick.
  */
 void task_purge_killed_tasks() {
     struct task * task = NULL;
     struct task * tmp;
     clist_for_each_safe(task, tmp, &task_head.list_node, list_node) {
-        if(task->state == TASK_STATE_KILLED) {
+        if(task->state == TASK_STATE_KILLED &&
+           task != cpu_get_local()->current_task) {
             klog("Found KILLED task (%d) awaiting purge\n", task->id);
             task_purge(task->id);
         }
@@ -565,7 +755,12 @@ void task_print() {
         klog("      kstack top:  0x%x | bot: 0x%x\n", task->kstack_top, task->kstack_bot);
         klog("      kstack_size: %d bytes\n", task->kstack_size);
         klog("      stack_used:  %d bytes\n", task->kstack_bot - task->kstack_top);
-        klog("      vm_space:    0x%x\n", task->vm_space);
+        klog("      vm_space:    0x%x (active: 0x%x)\n", task->vm_space,
+             task->active_vm_space);
+        if(task->vm_space) {
+            klog("      resident:    %d pages (working set: %d)\n",
+                 task->vm_space->rss_pages, task->vm_space->wss_pages);
+        }
         klog("      ticks:  %d\n", task->ticks);
     }
 
@@ -0,0 +1,33 @@
+/*
+ * kernel/syscalls/madvise.c
+ * madvise Syscall
+ */
+
+#include <rotary/syscall.h>
+
+/**
+ * syscall_madvise() - Advise how a range of the task's memory will be used.
+ * @addr:   The start of the range, page aligned.
+ * @length: The length of the range in bytes, rounded up to whole pages.
+ * @advice: A VM_MADV_* value, see vm_space_madvise().
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the range isn't within user space
+ *         or vm_space_madvise() failed.
+ */
+int32_t syscall_madvise(void * addr, size_t length, uint32_t advice) {
+    struct task * current_task = task_get_current();
+    void * end_addr = (void*)PAGE_ALIGN(addr + length);
+
+    klog("Syscall: madvise\n");
+    klog("Address: 0x%x\n", addr);
+    klog("Length:  %d\n", length);
+    klog("Advice:  %d\n", advice);
+
+    if(!current_task->vm_space || !IS_PAGE_ALIGNED(addr) ||
+       end_addr < addr || (uintptr_t)end_addr > KERNEL_START_VIRT) {
+        klog("Invalid range for madvise!\n");
+        return E_ERROR;
+    }
+
+    return vm_space_madvise(current_task->vm_space, addr, end_addr, advice);
+}
@@ -10,6 +10,9 @@
 extern ktest_module_t __start_ktest[];
 extern ktest_module_t __stop_ktest[];
 
+/* Set once the test suite's memory has been released after boot */
+uint32_t ktest_released = false;
+
 /* ------------------------------------------------------------------------- */
 
 void assert_equal_int(ktest_unit_t * ktest, int expected, int actual,
@@ -146,6 +149,11 @@ void _assert_bit_set(ktest_unit_t * ktest, unsigned int buffer,
 /* ------------------------------------------------------------------------- */
 
 void ktest_run_all() {
+    if(ktest_released) {
+        klog("ktest_run_all(): Tests were released after boot!\n");
+        return;
+    }
+
     ktest_module_t *module;
     for (module = __start_ktest; module < __stop_ktest; module++) {
         ktest_run_module(module->name);
@@ -219,6 +227,11 @@ void ktest_run_module(char * module_name) {
 /* ------------------------------------------------------------------------- */
 
 ktest_module_t * ktest_get_module(char * module_name) {
+    if(ktest_released) {
+        klog("ktest_get_module(): Tests were released after boot!\n");
+        return NULL;
+    }
+
     ktest_module_t * module = NULL;
     for (module = __start_ktest; module < __stop_ktest; module++) {
         if(strcmp(module->name, module_name) == 0) {
@@ -232,6 +245,11 @@ ktest_module_t * ktest_get_module(char * module_name) {
 
 void ktest_list_modules() {
     ktest_module_t *module;
+    if(ktest_released) {
+        klog("No test modules, tests were released after boot\n");
+        return;
+    }
+
     klog("Kernel Test Modules Available:\n");
     for (module = __start_ktest; module < __stop_ktest; module++) {
         klog("Module: %s\n", module->name);
@@ -239,3 +257,15 @@ void ktest_list_modules() {
 }
 
 /* ------------------------------------------------------------------------- */
+
+/**
+ * ktest_release() - Mark the test modules as no longer available.
+ *
+ * Called by free_initmem() before the pages holding the test modules are
+ * given to the page allocator, after which they must not be accessed.
+ */
+void ktest_release() {
+    ktest_released = true;
+}
+
+/* ------------------------------------------------------------------------- */
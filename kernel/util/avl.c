@@ -0,0 +1,170 @@
+/*
+ * kernel/util/avl.c
+ * AVL Trees
+ *
+ * A self-balancing binary search tree, whose subtrees differ in height by at
+ * most one, so that a tree of n nodes is never more than about 1.44 log2(n)
+ * deep. Nodes are embedded in the structures they order, so the tree itself
+ * never allocates memory.
+ *
+ * Insertion and removal are recursive, and return the new root of the tree.
+ * Lookups are left to the user, who knows how to compare a key against the
+ * structure holding each node, by following left and right from the root.
+ */
+
+#include <rotary/util/avl.h>
+
+/* ------------------------------------------------------------------------- */
+
+static inline int32_t avl_height(struct avl_node * node) {
+    return node ? node->height : 0;
+}
+
+static inline void avl_update(struct avl_node * node) {
+    int32_t left  = avl_height(node->left);
+    int32_t right = avl_height(node->right);
+    node->height = (left > right ? left : right) + 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static struct avl_node * avl_rotate_right(struct avl_node * node) {
+    struct avl_node * pivot = node->left;
+
+    node->left   = pivot->right;
+    pivot->right = node;
+
+    avl_update(node);
+    avl_update(pivot);
+    return pivot;
+}
+
+static struct avl_node * avl_rotate_left(struct avl_node * node) {
+    struct avl_node * pivot = node->right;
+
+    node->right = pivot->left;
+    pivot->left = node;
+
+    avl_update(node);
+    avl_update(pivot);
+    return pivot;
+}
+
+/**
+ * avl_balance() - Restore the balance of a subtree after a change beneath it.
+ * @node: The root of the subtree, whose children are balanced.
+ *
+ * Return: The new root of the subtree.
+ */
+static struct avl_node * avl_balance(struct avl_node * node) {
+    int32_t balance = avl_height(node->left) - avl_height(node->right);
+
+    avl_update(node);
+
+    if(balance > 1) {
+        if(avl_height(node->left->left) < avl_height(node->left->right)) {
+            node->left = avl_rotate_left(node->left);
+        }
+        return avl_rotate_right(node);
+    }
+
+    if(balance < -1) {
+        if(avl_height(node->right->right) < avl_height(node->right->left)) {
+            node->right = avl_rotate_right(node->right);
+        }
+        return avl_rotate_left(node);
+    }
+
+    return node;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * avl_insert() - Add a node to a tree.
+ * @root: The root of the tree, or NULL if it is empty.
+ * @node: The node to add, which mustn't compare equal to any in the tree.
+ * @cmp:  The function ordering the tree's nodes.
+ *
+ * Return: The new root of the tree.
+ */
+struct avl_node * avl_insert(struct avl_node * root, struct avl_node * node,
+                             avl_cmp_t cmp) {
+    if(!root) {
+        node->left   = NULL;
+        node->right  = NULL;
+        node->height = 1;
+        return node;
+    }
+
+    if(cmp(node, root) < 0) {
+        root->left = avl_insert(root->left, node, cmp);
+    } else {
+        root->right = avl_insert(root->right, node, cmp);
+    }
+
+    return avl_balance(root);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * avl_remove_min() - Unlink the leftmost node of a subtree.
+ * @root: The root of the subtree.
+ * @min:  Set to the node unlinked.
+ *
+ * Return: The new root of the subtree.
+ */
+static struct avl_node * avl_remove_min(struct avl_node * root,
+                                        struct avl_node ** min) {
+    if(!root->left) {
+        *min = root;
+        return root->right;
+    }
+
+    root->left = avl_remove_min(root->left, min);
+    return avl_balance(root);
+}
+
+/**
+ * avl_remove() - Remove a node from a tree.
+ * @root: The root of the tree.
+ * @node: The node to remove, which must be in the tree.
+ * @cmp:  The function ordering the tree's nodes.
+ *
+ * Return: The new root of the tree, NULL if it is now empty.
+ */
+struct avl_node * avl_remove(struct avl_node * root, struct avl_node * node,
+                             avl_cmp_t cmp) {
+    if(!root) {
+        return NULL;
+    }
+
+    if(root != node) {
+        if(cmp(node, root) < 0) {
+            root->left = avl_remove(root->left, node, cmp);
+        } else {
+            root->right = avl_remove(root->right, node, cmp);
+        }
+        return avl_balance(root);
+    }
+
+    /* Replace the node with the smallest node of its right subtree */
+    if(!node->left || !node->right) {
+        return node->left ? node->left : node->right;
+    }
+
+    struct avl_node * successor;
+    struct avl_node * right = avl_remove_min(node->right, &successor);
+
+    successor->left  = node->left;
+    successor->right = right;
+    return avl_balance(successor);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/avl.c"
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,275 @@
+/*
+ * kernel/util/lz4.c
+ * LZ4 Compression
+ *
+ * Compresses blocks in the LZ4 block format, as a series of sequences, each
+ * of some literal bytes copied as they are followed by a match: a copy of
+ * at least LZ4_MIN_MATCH bytes from up to 64KB earlier in the output. Each
+ * sequence starts with a token byte, holding the literal length in its top
+ * four bits and the match length less LZ4_MIN_MATCH in the bottom four, with
+ * lengths of 15 or more continued in following bytes. The last sequence has
+ * no match.
+ *
+ * The compressor is the simple greedy one: a hash table of the last position
+ * each four byte sequence was seen at finds candidate matches, and the first
+ * that really does match is taken and extended as far as it will go. That
+ * gives up a little ratio against an exhaustive search, for speed.
+ *
+ * Decompression checks every length and offset against the buffers, so a
+ * corrupted block is rejected rather than overrunning them.
+ */
+
+#include <rotary/util/lz4.h>
+
+/* ------------------------------------------------------------------------- */
+
+static inline uint32_t lz4_read32(const uint8_t * p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lz4_write_length() - Write the continuation bytes of a length.
+ * @out: Where to write them.
+ * @len: The part of the length that didn't fit the token, less 15.
+ *
+ * Return: The position after the bytes written.
+ */
+static uint8_t * lz4_write_length(uint8_t * out, uint32_t len) {
+    while(len >= 255) {
+        *out++ = 255;
+        len -= 255;
+    }
+    *out++ = len;
+    return out;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lz4_emit() - Write a sequence.
+ * @out:       Where to write the sequence.
+ * @out_end:   The end of the output buffer.
+ * @literals:  The literal bytes.
+ * @lit_len:   The number of literal bytes.
+ * @offset:    How far back the match starts.
+ * @match_len: The length of the match, or 0 for the last sequence.
+ *
+ * Return: The position after the sequence, or NULL if it didn't fit.
+ */
+static uint8_t * lz4_emit(uint8_t * out, uint8_t * out_end,
+                          const uint8_t * literals, uint32_t lit_len,
+                          uint32_t offset, uint32_t match_len) {
+    uint32_t needed = 1 + lit_len / 255 + 1 + lit_len;
+    if(match_len) {
+        needed += 2 + match_len / 255 + 1;
+    }
+    if(needed > (uint32_t)(out_end - out)) {
+        return NULL;
+    }
+
+    uint8_t * token = out++;
+    *token = (lit_len < 15 ? lit_len : 15) << 4;
+    if(lit_len >= 15) {
+        out = lz4_write_length(out, lit_len - 15);
+    }
+
+    memcpy(out, literals, lit_len);
+    out += lit_len;
+
+    if(!match_len) {
+        return out;
+    }
+
+    *out++ = offset & 0xFF;
+    *out++ = offset >> 8;
+
+    match_len -= LZ4_MIN_MATCH;
+    *token |= match_len < 15 ? match_len : 15;
+    if(match_len >= 15) {
+        out = lz4_write_length(out, match_len - 15);
+    }
+
+    return out;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lz4_compress() - Compress a block of data.
+ * @state:        Scratch space, used for this call only.
+ * @src:          The data to compress.
+ * @src_size:     The size of the data, at most LZ4_MAX_INPUT.
+ * @dst:          The buffer to write the compressed block to.
+ * @dst_capacity: The size of the buffer.
+ *
+ * Data that doesn't compress grows slightly, so a buffer smaller than the
+ * input can be used to give up on it early.
+ *
+ * Return: The size of the compressed block, or 0 if it didn't fit the buffer.
+ */
+uint32_t lz4_compress(struct lz4_state * state, const void * src,
+                      uint32_t src_size, void * dst, uint32_t dst_capacity) {
+    const uint8_t * in = src;
+    uint8_t * out = dst;
+    uint8_t * out_end = out + dst_capacity;
+    uint32_t anchor = 0; /* The start of the pending literals */
+    uint32_t pos = 0;
+
+    if(src_size > LZ4_MAX_INPUT) {
+        return 0;
+    }
+
+    memset(state->table, 0, sizeof(state->table));
+
+    while(pos + LZ4_MF_LIMIT < src_size) {
+        uint32_t sequence = lz4_read32(in + pos);
+        uint32_t hash = lz4_hash(sequence);
+        uint32_t candidate = state->table[hash];
+        state->table[hash] = pos;
+
+        /* An empty slot reads as position 0, which the comparison rejects
+         * unless it really matches */
+        if(candidate >= pos || pos - candidate > LZ4_MAX_OFFSET ||
+           lz4_read32(in + candidate) != sequence) {
+            pos++;
+            continue;
+        }
+
+        uint32_t len = LZ4_MIN_MATCH;
+        while(pos + len < src_size - LZ4_LAST_LITERALS &&
+              in[candidate + len] == in[pos + len]) {
+            len++;
+        }
+
+        /* The match may also start earlier, taking from the literals */
+        while(pos > anchor && candidate > 0 &&
+              in[pos - 1] == in[candidate - 1]) {
+            pos--;
+            candidate--;
+            len++;
+        }
+
+        out = lz4_emit(out, out_end, in + anchor, pos - anchor,
+                       pos - candidate, len);
+        if(!out) {
+            return 0;
+        }
+
+        pos += len;
+        anchor = pos;
+    }
+
+    out = lz4_emit(out, out_end, in + anchor, src_size - anchor, 0, 0);
+    if(!out) {
+        return 0;
+    }
+
+    return out - (uint8_t*)dst;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lz4_read_length() - Read the continuation bytes of a length.
+ * @in:     The position to read from, advanced past the bytes.
+ * @in_end: The end of the input.
+ * @len:    The length to add them to.
+ *
+ * Return: E_SUCCESS on success, E_ERROR if the input ran out.
+ */
+static int32_t lz4_read_length(const uint8_t ** in, const uint8_t * in_end,
+                               uint32_t * len) {
+    uint8_t byte;
+
+    do {
+        if(*in >= in_end) {
+            return E_ERROR;
+        }
+        byte = *(*in)++;
+        *len += byte;
+    } while(byte == 255);
+
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * lz4_decompress() - Decompress a block of data.
+ * @src:          The compressed block.
+ * @src_size:     The size of the block.
+ * @dst:          The buffer to write the data to.
+ * @dst_capacity: The size of the buffer.
+ *
+ * Return: The size of the decompressed data, or E_ERROR if the block is
+ *         malformed or the data doesn't fit the buffer.
+ */
+int32_t lz4_decompress(const void * src, uint32_t src_size, void * dst,
+                       uint32_t dst_capacity) {
+    const uint8_t * in = src;
+    const uint8_t * in_end = in + src_size;
+    uint8_t * out = dst;
+    uint8_t * out_end = out + dst_capacity;
+
+    while(in < in_end) {
+        uint8_t  token = *in++;
+        uint32_t len = token >> 4;
+
+        if(len == 15 && !SUCCESS(lz4_read_length(&in, in_end, &len))) {
+            return E_ERROR;
+        }
+        if(len > (uint32_t)(in_end - in) || len > (uint32_t)(out_end - out)) {
+            return E_ERROR;
+        }
+
+        memcpy(out, in, len);
+        in  += len;
+        out += len;
+
+        /* The last sequence has no match */
+        if(in == in_end) {
+            break;
+        }
+
+        if(in_end - in < 2) {
+            return E_ERROR;
+        }
+        uint32_t offset = in[0] | (in[1] << 8);
+        in += 2;
+
+        if(offset == 0 || offset > (uint32_t)(out - (uint8_t*)dst)) {
+            return E_ERROR;
+        }
+
+        len = token & 0x0F;
+        if(len == 15 && !SUCCESS(lz4_read_length(&in, in_end, &len))) {
+            return E_ERROR;
+        }
+        len += LZ4_MIN_MATCH;
+        if(len > (uint32_t)(out_end - out)) {
+            return E_ERROR;
+        }
+
+        /* The match may overlap the bytes it produces, repeating them, so is
+         * copied a byte at a time */
+        const uint8_t * match = out - offset;
+        while(len--) {
+            *out++ = *match++;
+        }
+    }
+
+    return out - (uint8_t*)dst;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Include unit tests */
+#include "test/lz4.c"
+
+/* ------------------------------------------------------------------------- */
@@ -11,3 +11,84 @@ uint32_t log2(uint32_t n) {
 }
 
 /* ------------------------------------------------------------------------- */
+
+/**
+ * udivmod64() - Divide two unsigned 64-bit integers.
+ * @dividend:  The value to divide.
+ * @divisor:   The value to divide by.
+ * @quotient:  Where to store the quotient, may be NULL.
+ * @remainder: Where to store the remainder, may be NULL.
+ *
+ * 64-bit division is not natively available on 32-bit x86 without libgcc,
+ * so this performs a simple binary long division instead.
+ */
+void udivmod64(uint64_t dividend, uint64_t divisor, uint64_t * quotient,
+               uint64_t * remainder) {
+    uint64_t q = 0;
+    uint64_t r = 0;
+
+    for(int i = 63; i >= 0; i--) {
+        r <<= 1;
+        r |= (dividend >> i) & 1;
+
+        if(r >= divisor) {
+            r -= divisor;
+            q |= (uint64_t)1 << i;
+        }
+    }
+
+    if(quotient) {
+        *quotient = q;
+    }
+
+    if(remainder) {
+        *remainder = r;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * udiv64() - Divide an unsigned 64-bit integer, discarding the remainder.
+ * @dividend: The value to divide.
+ * @divisor:  The value to divide by.
+ *
+ * Return: The quotient.
+ */
+uint64_t udiv64(uint64_t dividend, uint64_t divisor) {
+    uint64_t quotient;
+    udivmod64(dividend, divisor, &quotient, NULL);
+    return quotient;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/**
+ * uint64_to_str() - Convert an unsigned 64-bit integer to a string.
+ * @value: The value to convert.
+ * @str:   The buffer to write the string to, at least 65 bytes.
+ * @base:  The numeric base, between 2 and 16.
+ */
+void uint64_to_str(uint64_t value, char * str, int base) {
+    char * ptr = str, * ptr1 = str, tmp_char;
+    uint64_t quotient, remainder;
+
+    /* Calculate the string representation of the number in the given base */
+    do {
+        udivmod64(value, base, &quotient, &remainder);
+        value = quotient;
+        *ptr++ = "0123456789abcdef"[remainder];
+    } while(value);
+
+    /* Null-terminate the string */
+    *ptr-- = '\0';
+
+    /* Reverse the string */
+    while(ptr1 < ptr) {
+        tmp_char = *ptr;
+        *ptr-- = *ptr1;
+        *ptr1++ = tmp_char;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
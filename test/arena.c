@@ -0,0 +1,150 @@
+/*
+ * kernel/test/arena.c
+ * Arena Allocator Testing
+ */
+
+#include <rotary/test/arena.h>
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest arena_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest arena_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest arena_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest arena_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest arena_test_create(ktest_unit_t * ktest) {
+    struct arena * arena = arena_create(ARENA_DEFAULT_ORDER);
+    assert_not_equal(arena, NULL);
+    assert_equal(arena->chunk_count, 1);
+    assert_equal(arena->bytes_used, 0);
+    assert(arena->cursor < arena->limit);
+    arena_destroy(arena);
+
+    assert_equal(arena_create(ORDER_MAX + 1), NULL);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest arena_test_alloc(ktest_unit_t * ktest) {
+    struct arena * arena = arena_create(ARENA_DEFAULT_ORDER);
+
+    /* Consecutive allocations are contiguous and aligned */
+    void * a = arena_alloc(arena, 3);
+    void * b = arena_alloc(arena, 16);
+    assert_not_equal(a, NULL);
+    assert_not_equal(b, NULL);
+    assert_equal(b, (void*)((uintptr_t)a + ARENA_ALIGN));
+    assert_equal((uintptr_t)b % ARENA_ALIGN, 0);
+    assert_equal(arena->bytes_used, ARENA_ALIGN + 16);
+
+    void * z = arena_alloc_zero(arena, 64);
+    assert_clear(z, 64);
+
+    arena_destroy(arena);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest arena_test_alloc_new_chunk(ktest_unit_t * ktest) {
+    struct arena * arena = arena_create(ARENA_DEFAULT_ORDER);
+
+    /* Exhausting the first chunk should add a second */
+    for(uint32_t i = 0; i < PAGE_SIZE / 64; i++) {
+        assert_not_equal(arena_alloc(arena, 64), NULL);
+    }
+    assert_equal(arena->chunk_count, 2);
+
+    arena_destroy(arena);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest arena_test_alloc_oversized(ktest_unit_t * ktest) {
+    struct arena * arena = arena_create(ARENA_DEFAULT_ORDER);
+
+    void * small = arena_alloc(arena, 32);
+    uintptr_t cursor = arena->cursor;
+
+    /* Oversized allocations get a dedicated chunk and leave the cursor */
+    void * big = arena_alloc(arena, PAGE_SIZE * 2);
+    assert_not_equal(big, NULL);
+    assert_equal(arena->chunk_count, 2);
+    assert_equal(arena->cursor, cursor);
+    memset(big, 0xAA, PAGE_SIZE * 2);
+
+    assert_equal(arena_alloc(arena, 8), (void*)((uintptr_t)small + 32));
+
+    /* Requests that can't fit in any chunk fail */
+    assert_equal(arena_alloc(arena, PAGE_SIZE << (ORDER_MAX + 1)), NULL);
+
+    /* As do sizes that wrap around when aligned, leaving the cursor */
+    assert_equal(arena_alloc(arena, UINT32_MAX), NULL);
+    assert_equal(arena->cursor, cursor + 8);
+
+    arena_destroy(arena);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest arena_test_reset(ktest_unit_t * ktest) {
+    struct arena * arena = arena_create(ARENA_DEFAULT_ORDER);
+
+    void * first = arena_alloc(arena, 16);
+    for(uint32_t i = 0; i < 4; i++) {
+        arena_alloc(arena, PAGE_SIZE / 2);
+    }
+    arena_alloc(arena, PAGE_SIZE * 4);
+    assert(arena->chunk_count > 1);
+
+    arena_reset(arena);
+    assert_equal(arena->chunk_count, 1);
+    assert_equal(arena->bytes_used, 0);
+
+    /* Allocation restarts from the beginning of the first chunk */
+    assert_equal(arena_alloc(arena, 16), first);
+
+    arena_destroy(arena);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("arena-test-create", arena_test_create),
+    KTEST_UNIT("arena-test-alloc", arena_test_alloc),
+    KTEST_UNIT("arena-test-alloc-new-chunk", arena_test_alloc_new_chunk),
+    KTEST_UNIT("arena-test-alloc-oversized", arena_test_alloc_oversized),
+    KTEST_UNIT("arena-test-reset", arena_test_reset),
+};
+
+KTEST_MODULE_DEFINE("arena", test_units,
+                    arena_pre_module,
+                    arena_post_module,
+                    arena_pre_test,
+                    arena_post_test);
+
+/* ------------------------------------------------------------------------- */
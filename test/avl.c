@@ -0,0 +1,154 @@
+/*
+ * kernel/test/avl.c
+ * AVL Tree Testing
+ */
+
+#include <rotary/test/avl.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define AVL_TEST_COUNT 64
+
+struct avl_test_item {
+    uint32_t        key;
+    struct avl_node node;
+};
+
+static struct avl_test_item avl_test_items[AVL_TEST_COUNT];
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest avl_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest avl_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest avl_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest avl_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+static int32_t __ktest avl_test_cmp(struct avl_node * a, struct avl_node * b) {
+    uint32_t key_a = avl_entry(a, struct avl_test_item, node)->key;
+    uint32_t key_b = avl_entry(b, struct avl_test_item, node)->key;
+    return key_a < key_b ? -1 : key_a > key_b;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Insert every item, with keys in an order that isn't sorted */
+static struct avl_node * __ktest avl_test_build() {
+    struct avl_node * root = NULL;
+
+    for(uint32_t i = 0; i < AVL_TEST_COUNT; i++) {
+        avl_test_items[i].key = (i * 37) % AVL_TEST_COUNT;
+        root = avl_insert(root, &avl_test_items[i].node, avl_test_cmp);
+    }
+
+    return root;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Returns the number of nodes in a subtree, or -1 if it is out of order or
+ * unbalanced, or a height is wrong */
+static int32_t __ktest avl_test_check(struct avl_node * node, uint32_t min,
+                                      uint32_t max) {
+    if(!node) {
+        return 0;
+    }
+
+    uint32_t key = avl_entry(node, struct avl_test_item, node)->key;
+    if(key < min || key > max) {
+        return -1;
+    }
+
+    int32_t left  = avl_test_check(node->left, min, key);
+    int32_t right = avl_test_check(node->right, key, max);
+    if(left < 0 || right < 0) {
+        return -1;
+    }
+
+    int32_t left_height  = node->left ? node->left->height : 0;
+    int32_t right_height = node->right ? node->right->height : 0;
+    int32_t height = (left_height > right_height ? left_height :
+                                                   right_height) + 1;
+    if(node->height != height || left_height - right_height > 1 ||
+       right_height - left_height > 1) {
+        return -1;
+    }
+
+    return left + right + 1;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest avl_test_insert(ktest_unit_t * ktest) {
+    struct avl_node * root = avl_test_build();
+
+    assert_equal(avl_test_check(root, 0, AVL_TEST_COUNT), AVL_TEST_COUNT);
+
+    /* 64 nodes fit within a height of 1.44 log2(64) */
+    assert(root->height <= 8);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest avl_test_remove(ktest_unit_t * ktest) {
+    struct avl_node * root = avl_test_build();
+
+    /* Removing the root and every other item keeps it balanced */
+    struct avl_node * first = root;
+    root = avl_remove(root, first, avl_test_cmp);
+    for(uint32_t i = 0; i < AVL_TEST_COUNT; i += 2) {
+        if(&avl_test_items[i].node != first) {
+            root = avl_remove(root, &avl_test_items[i].node, avl_test_cmp);
+        }
+    }
+
+    int32_t count = avl_test_check(root, 0, AVL_TEST_COUNT);
+    assert(count == AVL_TEST_COUNT / 2 || count == AVL_TEST_COUNT / 2 - 1);
+
+    /* Removing the rest empties the tree */
+    while(root) {
+        root = avl_remove(root, root, avl_test_cmp);
+    }
+    assert_equal(root, NULL);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("avl-test-insert", avl_test_insert),
+    KTEST_UNIT("avl-test-remove", avl_test_remove),
+};
+
+KTEST_MODULE_DEFINE("avl", test_units,
+                    avl_pre_module,
+                    avl_post_module,
+                    avl_pre_test,
+                    avl_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -9,32 +9,31 @@
 /* Test Set-up and Clean-up                                                  */
 /* ------------------------------------------------------------------------- */
 
-int32_t bootmem_pre_module(ktest_module_t * module) {
+int32_t __ktest bootmem_pre_module(ktest_module_t * module) {
     return E_SUCCESS;
 }
 
 /* ------------------------------------------------------------------------- */
 
-int32_t bootmem_post_module(ktest_module_t * module) {
+int32_t __ktest bootmem_post_module(ktest_module_t * module) {
     return E_SUCCESS;
 }
 
 /* ------------------------------------------------------------------------- */
 
-int32_t bootmem_pre_test(ktest_module_t * module) {
-    /* Clear the memory regions array */
-    memset(mem_regions, 0, sizeof(mem_regions));
+int32_t __ktest bootmem_pre_test(ktest_module_t * module) {
+    /* Clear both region lists and the highest observed PFN */
+    bootmem_reset();
 
-    /* Reset highest observed PFN and region count */
-    highest_pfn = 0;
-    region_count = 0;
+    /* The tests use low addresses, so lift the lower allocation limit */
+    bootmem_set_limits(0, BOOTMEM_LIMIT_EARLY);
 
     return E_SUCCESS;
 }
 
 /* ------------------------------------------------------------------------- */
 
-int32_t bootmem_post_test(ktest_module_t * module) {
+int32_t __ktest bootmem_post_test(ktest_module_t * module) {
     return E_SUCCESS;
 }
 
@@ -42,152 +41,159 @@ int32_t bootmem_post_test(ktest_module_t * module) {
 /* Unit Tests                                                                */
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_add_all_regions(ktest_unit_t * ktest) {
-    for(uint32_t i = 0; i < MAX_MEM_REGIONS; i++) {
-        uintptr_t start_addr = 0x10000 + (i * PAGE_SIZE);
-        uintptr_t end_addr   = 0x11000 + (i * PAGE_SIZE);
+void __ktest bootmem_test_add_all_regions(ktest_unit_t * ktest) {
+    /* Leave a gap between each region so that they aren't merged */
+    for(uint32_t i = 0; i < BOOTMEM_INIT_REGIONS; i++) {
+        uintptr_t start_addr = 0x10000 + (i * PAGE_SIZE * 2);
+        uintptr_t end_addr   = start_addr + PAGE_SIZE;
         int rv = bootmem_add_mem_region(start_addr, end_addr,
                                         MEM_REGION_AVAILABLE);
         assert_equal(rv, E_SUCCESS);
-        assert_equal(region_count, i + 1);
+        assert_equal(bootmem_memory.count, i + 1);
         assert_equal(highest_pfn, end_addr / PAGE_SIZE);
     }
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_excess_regions(ktest_unit_t * ktest) {
-    for(uint32_t i = 0; i < MAX_MEM_REGIONS + 1; i++) {
-        uintptr_t start_addr = 0x10000 + (i * PAGE_SIZE);
-        uintptr_t end_addr   = 0x11000 + (i * PAGE_SIZE);
+void __ktest bootmem_test_grow_regions(ktest_unit_t * ktest) {
+    for(uint32_t i = 0; i < BOOTMEM_INIT_REGIONS + 1; i++) {
+        uintptr_t start_addr = 0x10000 + (i * PAGE_SIZE * 2);
+        uintptr_t end_addr   = start_addr + PAGE_SIZE;
         int rv = bootmem_add_mem_region(start_addr, end_addr,
                                         MEM_REGION_AVAILABLE);
-        if(i == MAX_MEM_REGIONS) {
-            assert_equal(rv, E_ERROR);
-            assert_equal(region_count, i);
-            assert_equal(highest_pfn, (end_addr - PAGE_SIZE) / PAGE_SIZE);
-        } else {
-            assert_equal(rv, E_SUCCESS);
-            assert_equal(region_count, i + 1);
-            assert_equal(highest_pfn, end_addr / PAGE_SIZE);
-        }
+        assert_equal(rv, E_SUCCESS);
+        assert_equal(bootmem_memory.count, i + 1);
+    }
+
+    /* The list should have doubled, into memory reserved from bootmem */
+    assert_equal(bootmem_memory.max, BOOTMEM_INIT_REGIONS * 2);
+    assert_equal(bootmem_memory.dynamic, true);
+    assert_not_equal((void*)bootmem_memory.regions, (void*)memory_init);
+    assert_equal(bootmem_reserved.count, 1);
+
+    /* Regions must have been preserved, in order */
+    for(uint32_t i = 0; i < bootmem_memory.count; i++) {
+        assert_equal(bootmem_memory.regions[i].start_addr,
+                     0x10000 + (i * PAGE_SIZE * 2));
     }
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_kernel_region(ktest_unit_t * ktest) {
-    uintptr_t kernel_start = PAGE_ALIGN(&KERNEL_PHYS_START);
+void __ktest bootmem_test_kernel_region(ktest_unit_t * ktest) {
+    uintptr_t kernel_start = PAGE_ALIGN_DOWN(&KERNEL_PHYS_START);
     uintptr_t kernel_end   = PAGE_ALIGN(&KERNEL_PHYS_END);
-    kernel_end -= PAGE_SIZE;
-    int rv = bootmem_add_mem_region(kernel_start, kernel_end,
+    int rv = bootmem_add_mem_region(kernel_start - PAGE_SIZE,
+                                    kernel_end + PAGE_SIZE,
                                     MEM_REGION_AVAILABLE);
-    assert_equal(rv, E_ERROR);
-    assert_equal(region_count, 0);
-    assert_equal(highest_pfn, 0);
+
+    /* The region is kept whole, with the kernel image reserved */
+    assert_equal(rv, E_SUCCESS);
+    assert_equal(bootmem_memory.count, 1);
+    assert_equal(bootmem_reserved.count, 1);
+    assert_equal(bootmem_reserved.regions[0].start_addr, kernel_start);
+    assert_equal(bootmem_reserved.regions[0].end_addr, kernel_end);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_invalid_type(ktest_unit_t * ktest) {
+void __ktest bootmem_test_invalid_type(ktest_unit_t * ktest) {
     int rv = bootmem_add_mem_region(0x10000, 0x11000, MEM_REGION_AVAILABLE);
     assert_equal(rv, E_SUCCESS);
-    assert_equal(region_count, 1);
+    assert_equal(bootmem_memory.count, 1);
     assert_equal(highest_pfn, 0x11000 / PAGE_SIZE);
     rv = bootmem_add_mem_region(0x20000, 0x21000, MEM_REGION_RESERVED);
     assert_equal(rv, E_SUCCESS);
-    assert_equal(region_count, 2);
-    assert_equal(highest_pfn, 0x21000 / PAGE_SIZE);
+    assert_equal(bootmem_memory.count, 1);
+    assert_equal(bootmem_reserved.count, 1);
+    assert_equal(highest_pfn, 0x11000 / PAGE_SIZE);
     rv = bootmem_add_mem_region(0x30000, 0x31000, 2);
     assert_equal(rv, E_ERROR);
-    assert_equal(region_count, 2);
-    assert_equal(highest_pfn, 0x21000 / PAGE_SIZE);
+    assert_equal(bootmem_memory.count, 1);
+    assert_equal(bootmem_reserved.count, 1);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_highest_pfn(ktest_unit_t * ktest) {
+void __ktest bootmem_test_highest_pfn(ktest_unit_t * ktest) {
     uintptr_t end_addr = 0x11000;
     int rv = bootmem_add_mem_region(0x10000, end_addr, MEM_REGION_AVAILABLE);
     assert_equal(rv, E_SUCCESS);
-    assert_equal(region_count, 1);
+    assert_equal(bootmem_memory.count, 1);
     assert_equal(highest_pfn, end_addr / PAGE_SIZE);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_koverlap_low(ktest_unit_t * ktest) {
-    uintptr_t kernel_start = PAGE_ALIGN(&KERNEL_PHYS_START);
+void __ktest bootmem_test_pfn_range(ktest_unit_t * ktest) {
+    /* 64KB at 4GB, which can't be described by a mem_region */
+    assert_equal(bootmem_add_pfn_range(0x100000, 0x100010), E_SUCCESS);
+    assert_equal(pfn_range_count, 1);
+    assert_equal(highest_pfn, 0x100010);
+    assert_equal(bootmem_memory.count, 0);
 
-    /* One page before kernel start -> one page after kernel start */
-    uintptr_t start_addr   = kernel_start - PAGE_SIZE;
-    uintptr_t end_addr     = kernel_start + PAGE_SIZE;
+    /* Ranges are never allocated from */
+    assert_equal(bootmem_alloc(PAGE_SIZE, PAGE_SIZE), NULL);
 
-    bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
+    assert_equal(bootmem_add_pfn_range(0x100010, 0x100010), E_ERROR);
+    assert_equal(pfn_range_count, 1);
 
-    /* Expect start preserved, but end adjusted to kernel start */
-    assert_equal(region_count, 1);
-    assert_equal(highest_pfn, kernel_start / PAGE_SIZE);
-    assert_equal(mem_regions[0].start_addr, start_addr);
-    assert_equal(mem_regions[0].end_addr, kernel_start);
+    bootmem_reset();
+    assert_equal(pfn_range_count, 0);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_koverlap_high(ktest_unit_t * ktest) {
-    uintptr_t kernel_end   = PAGE_ALIGN(&KERNEL_PHYS_END);
-
-    /* One page before kernel end -> one page after kernel end */
-    uintptr_t start_addr   = kernel_end - PAGE_SIZE;
-    uintptr_t end_addr     = kernel_end + PAGE_SIZE;
-
-    bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
-
-    /* Expect start adjusted to kernel end, but end preserved */
-    assert_equal(region_count, 1);
-    assert_equal(highest_pfn, end_addr / PAGE_SIZE);
-    assert_equal(mem_regions[0].start_addr, kernel_end);
-    assert_equal(mem_regions[0].end_addr, end_addr);
+void __ktest bootmem_test_merge_adjacent(ktest_unit_t * ktest) {
+    bootmem_add_mem_region(0x10000, 0x11000, MEM_REGION_AVAILABLE);
+    bootmem_add_mem_region(0x11000, 0x12000, MEM_REGION_AVAILABLE);
+    assert_equal(bootmem_memory.count, 1);
+    assert_equal(bootmem_memory.regions[0].start_addr, 0x10000);
+    assert_equal(bootmem_memory.regions[0].end_addr, 0x12000);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_koverlap_all(ktest_unit_t * ktest) {
-    uintptr_t kernel_start = PAGE_ALIGN(&KERNEL_PHYS_START);
-    uintptr_t kernel_end   = PAGE_ALIGN(&KERNEL_PHYS_END);
-
-    /* One page before kernel start -> one page after kernel end */
-    uintptr_t start_addr   = kernel_start - PAGE_SIZE;
-    uintptr_t end_addr     = kernel_end + PAGE_SIZE;
+void __ktest bootmem_test_merge_overlap(ktest_unit_t * ktest) {
+    bootmem_add_mem_region(0x10000, 0x13000, MEM_REGION_AVAILABLE);
+    bootmem_add_mem_region(0x20000, 0x21000, MEM_REGION_AVAILABLE);
+    bootmem_add_mem_region(0x12000, 0x20000, MEM_REGION_AVAILABLE);
+    assert_equal(bootmem_memory.count, 1);
+    assert_equal(bootmem_memory.regions[0].start_addr, 0x10000);
+    assert_equal(bootmem_memory.regions[0].end_addr, 0x21000);
+}
 
-    bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
+/* ------------------------------------------------------------------------- */
 
-    /* Expect two regions:
-     * Region 1: End amended to kernel start
-     * Region 2: Start amended to kernel end
-     */
-    assert_equal(region_count, 2);
-    assert_equal(highest_pfn, end_addr / PAGE_SIZE);
-    assert_equal(mem_regions[0].start_addr, start_addr);
-    assert_equal(mem_regions[0].end_addr, kernel_start);
-    assert_equal(mem_regions[1].start_addr, kernel_end);
-    assert_equal(mem_regions[1].end_addr, end_addr);
+void __ktest bootmem_test_sorted(ktest_unit_t * ktest) {
+    bootmem_add_mem_region(0x30000, 0x31000, MEM_REGION_AVAILABLE);
+    bootmem_add_mem_region(0x10000, 0x11000, MEM_REGION_AVAILABLE);
+    bootmem_add_mem_region(0x20000, 0x21000, MEM_REGION_AVAILABLE);
+    assert_equal(bootmem_memory.count, 3);
+    assert_equal(bootmem_memory.regions[0].start_addr, 0x10000);
+    assert_equal(bootmem_memory.regions[1].start_addr, 0x20000);
+    assert_equal(bootmem_memory.regions[2].start_addr, 0x30000);
+    assert_equal(highest_pfn, 0x31000 / PAGE_SIZE);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_alloc_ok_partial(ktest_unit_t * ktest) {
+void __ktest bootmem_test_alloc_ok_partial(ktest_unit_t * ktest) {
     uintptr_t start_addr = 0x10000;
     uintptr_t end_addr   = start_addr + (PAGE_SIZE * 4);
     bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
+
+    /* Allocations are made from the top of memory */
     void * rv = bootmem_alloc(PAGE_SIZE, BM_NO_ALIGN);
     assert_not_equal(rv, NULL);
-    assert_equal(rv, PHY_TO_VIR(start_addr));
+    assert_equal(rv, PHY_TO_VIR(end_addr - PAGE_SIZE));
+    assert_equal(bootmem_reserved.count, 1);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_alloc_ok_all(ktest_unit_t * ktest) {
+void __ktest bootmem_test_alloc_ok_all(ktest_unit_t * ktest) {
     uintptr_t start_addr = 0x10000;
     uintptr_t end_addr   = start_addr + (PAGE_SIZE * 4);
     bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
@@ -198,7 +204,7 @@ void bootmem_test_alloc_ok_all(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_alloc_bad_exceed(ktest_unit_t * ktest) {
+void __ktest bootmem_test_alloc_bad_exceed(ktest_unit_t * ktest) {
     uintptr_t start_addr = 0x10000;
     uintptr_t end_addr   = start_addr + (PAGE_SIZE * 4);
     bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
@@ -208,14 +214,14 @@ void bootmem_test_alloc_bad_exceed(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_alloc_bad_no_regions(ktest_unit_t * ktest) {
+void __ktest bootmem_test_alloc_bad_no_regions(ktest_unit_t * ktest) {
     void * rv = bootmem_alloc(PAGE_SIZE, BM_NO_ALIGN);
     assert_equal(rv, NULL);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_alloc_multiple_regions(ktest_unit_t * ktest) {
+void __ktest bootmem_test_alloc_multiple_regions(ktest_unit_t * ktest) {
     /* Create region 1, two pages in size */
     uintptr_t start_addr1 = 0x10000;
     uintptr_t end_addr1   = start_addr1 + (PAGE_SIZE * 2);
@@ -226,13 +232,13 @@ void bootmem_test_alloc_multiple_regions(ktest_unit_t * ktest) {
     uintptr_t end_addr2   = start_addr2 + (PAGE_SIZE * 2);
     bootmem_add_mem_region(start_addr2, end_addr2, MEM_REGION_AVAILABLE);
 
-    /* Expect allocation from region 1 */
+    /* Expect allocation from the higher region 2 */
     void * rv = bootmem_alloc(PAGE_SIZE * 2, BM_NO_ALIGN);
-    assert_equal(rv, PHY_TO_VIR(start_addr1));
+    assert_equal(rv, PHY_TO_VIR(start_addr2));
 
-    /* Expect allocation from region 2 */
+    /* Expect allocation from region 1 */
     rv = bootmem_alloc(PAGE_SIZE * 2, BM_NO_ALIGN);
-    assert_equal(rv, PHY_TO_VIR(start_addr2));
+    assert_equal(rv, PHY_TO_VIR(start_addr1));
 
     /* Expect failure */
     rv = bootmem_alloc(PAGE_SIZE, BM_NO_ALIGN);
@@ -241,51 +247,126 @@ void bootmem_test_alloc_multiple_regions(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_zero_length_region(ktest_unit_t * ktest) {
+void __ktest bootmem_test_alloc_skip_reserved(ktest_unit_t * ktest) {
+    uintptr_t start_addr = 0x10000;
+    uintptr_t end_addr   = start_addr + (PAGE_SIZE * 4);
+    bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
+
+    /* Reserve the second page from the top, leaving a one page hole */
+    bootmem_reserve(end_addr - (PAGE_SIZE * 2), end_addr - PAGE_SIZE);
+
+    /* Two pages don't fit above the reservation, so must go below it */
+    void * rv = bootmem_alloc(PAGE_SIZE * 2, BM_NO_ALIGN);
+    assert_equal(rv, PHY_TO_VIR(start_addr));
+
+    /* A single page still fits in the hole */
+    rv = bootmem_alloc(PAGE_SIZE, BM_NO_ALIGN);
+    assert_equal(rv, PHY_TO_VIR(end_addr - PAGE_SIZE));
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest bootmem_test_alloc_limits(ktest_unit_t * ktest) {
+    uintptr_t start_addr = 0x10000;
+    uintptr_t end_addr   = start_addr + (PAGE_SIZE * 4);
+    bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
+
+    /* Allocations must end below the upper limit */
+    bootmem_set_limits(0, start_addr + (PAGE_SIZE * 2));
+    void * rv = bootmem_alloc(PAGE_SIZE, BM_NO_ALIGN);
+    assert_equal(rv, PHY_TO_VIR(start_addr + PAGE_SIZE));
+
+    /* ..and must not start below the lower limit */
+    bootmem_set_limits(start_addr + PAGE_SIZE, end_addr);
+    rv = bootmem_alloc(PAGE_SIZE * 3, BM_NO_ALIGN);
+    assert_equal(rv, NULL);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest bootmem_test_alloc_aligned(ktest_unit_t * ktest) {
+    uintptr_t start_addr = 0x10000;
+    uintptr_t end_addr   = start_addr + (PAGE_SIZE * 4);
+    bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
+
+    /* A small allocation at the top of memory, then a page aligned one */
+    void * rv = bootmem_alloc(16, BM_NO_ALIGN);
+    assert_equal(rv, PHY_TO_VIR(end_addr - 16));
+    rv = bootmem_alloc(16, PAGE_SIZE);
+    assert_equal(rv, PHY_TO_VIR(end_addr - PAGE_SIZE));
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest bootmem_test_zero_length_region(ktest_unit_t * ktest) {
     uintptr_t start_addr = 0x10000;
     uintptr_t end_addr   = 0x10000;
     int rv = bootmem_add_mem_region(start_addr, end_addr,
                                     MEM_REGION_AVAILABLE);
     assert_equal(rv, E_ERROR);
-    assert_equal(region_count, 0);
+    assert_equal(bootmem_memory.count, 0);
     assert_equal(highest_pfn, 0);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_invalid_region_bounds(ktest_unit_t * ktest) {
+void __ktest bootmem_test_invalid_region_bounds(ktest_unit_t * ktest) {
     uintptr_t start_addr = 0x11000;
     uintptr_t end_addr   = 0x10000;
     int rv = bootmem_add_mem_region(start_addr, end_addr,
                                     MEM_REGION_AVAILABLE);
     assert_equal(rv, E_ERROR);
-    assert_equal(region_count, 0);
+    assert_equal(bootmem_memory.count, 0);
     assert_equal(highest_pfn, 0);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void bootmem_test_reset(ktest_unit_t * ktest) {
+void __ktest bootmem_test_reset(ktest_unit_t * ktest) {
     bootmem_add_mem_region(0x10000, 0x11000, MEM_REGION_AVAILABLE);
+    bootmem_reserve(0x10000, 0x10100);
     bootmem_reset();
-    assert_clear(mem_regions, sizeof(mem_regions));
-    assert_equal(region_count, 0);
+    assert_clear(memory_init, sizeof(memory_init));
+    assert_clear(reserved_init, sizeof(reserved_init));
+    assert_equal(bootmem_memory.count, 0);
+    assert_equal(bootmem_reserved.count, 0);
     assert_equal(highest_pfn, 0);
 }
 
+/* ------------------------------------------------------------------------- */
+
+void __ktest bootmem_test_alloc_temp(ktest_unit_t * ktest) {
+    uintptr_t start_addr = 0x10000;
+    uintptr_t end_addr   = start_addr + (PAGE_SIZE * 4);
+    bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
+
+    /* A temporary allocation must not share a page with a permanent one */
+    bootmem_alloc(16, BM_NO_ALIGN);
+    void * rv = bootmem_alloc_temp(100);
+    assert_equal(rv, PHY_TO_VIR(end_addr - (PAGE_SIZE * 2)));
+
+    /* Its reservation is kept separately, flagged as temporary */
+    assert_equal(bootmem_reserved.count, 2);
+    assert_equal(bootmem_reserved.regions[0].start_addr,
+                 end_addr - (PAGE_SIZE * 2));
+    assert_equal(bootmem_reserved.regions[0].end_addr, end_addr - PAGE_SIZE);
+    assert_equal(bootmem_reserved.regions[0].flags, MEM_REGION_F_TEMP);
+}
+
 /* ------------------------------------------------------------------------- */
 /* Test Registration                                                         */
 /* ------------------------------------------------------------------------- */
 
-static ktest_unit_t test_units[] = {
+static ktest_unit_t test_units[] __ktest_data = {
     KTEST_UNIT("bootmem-test-add-all-regions", bootmem_test_add_all_regions),
-    KTEST_UNIT("bootmem-test-excess-regions", bootmem_test_excess_regions),
+    KTEST_UNIT("bootmem-test-grow-regions", bootmem_test_grow_regions),
     KTEST_UNIT("bootmem-test-kernel-region", bootmem_test_kernel_region),
     KTEST_UNIT("bootmem-test-invalid-type", bootmem_test_invalid_type),
     KTEST_UNIT("bootmem-test-highest-pfn", bootmem_test_highest_pfn),
-    KTEST_UNIT("bootmem-test-koverlap-low", bootmem_test_koverlap_low),
-    KTEST_UNIT("bootmem-test-koverlap-high", bootmem_test_koverlap_high),
-    KTEST_UNIT("bootmem-test-koverlap-all", bootmem_test_koverlap_all),
+    KTEST_UNIT("bootmem-test-pfn-range", bootmem_test_pfn_range),
+    KTEST_UNIT("bootmem-test-merge-adjacent", bootmem_test_merge_adjacent),
+    KTEST_UNIT("bootmem-test-merge-overlap", bootmem_test_merge_overlap),
+    KTEST_UNIT("bootmem-test-sorted", bootmem_test_sorted),
     KTEST_UNIT("bootmem-test-alloc-ok-partial", bootmem_test_alloc_ok_partial),
     KTEST_UNIT("bootmem-test-alloc-ok-all", bootmem_test_alloc_ok_all),
     KTEST_UNIT("bootmem-test-alloc-bad-exceed", bootmem_test_alloc_bad_exceed),
@@ -294,10 +375,15 @@ static ktest_unit_t test_units[] = {
                bootmem_test_alloc_bad_no_regions),
     KTEST_UNIT("bootmem-test-alloc-multiple-regions",
                bootmem_test_alloc_multiple_regions),
+    KTEST_UNIT("bootmem-test-alloc-skip-reserved",
+               bootmem_test_alloc_skip_reserved),
+    KTEST_UNIT("bootmem-test-alloc-limits", bootmem_test_alloc_limits),
+    KTEST_UNIT("bootmem-test-alloc-aligned", bootmem_test_alloc_aligned),
     KTEST_UNIT("bootmem-test-zero-length-region",
                bootmem_test_zero_length_region),
     KTEST_UNIT("bootmem-test-invalid-region-bounds",
                bootmem_test_invalid_region_bounds),
+    KTEST_UNIT("bootmem-test-alloc-temp", bootmem_test_alloc_temp),
 };
 
 KTEST_MODULE_DEFINE("bootmem", test_units,
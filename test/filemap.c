@@ -0,0 +1,169 @@
+/*
+ * kernel/test/filemap.c
+ * File-backed Mapping Testing
+ */
+
+#include <rotary/test/filemap.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* A file of two and a half pages, each byte holding its page number + 1 */
+#define FILEMAP_TEST_SIZE (2 * PAGE_SIZE + PAGE_SIZE / 2)
+
+static int __ktest filemap_test_read(struct inode * node, void * buf,
+                                     uint32_t offset, uint32_t size);
+
+static struct inode_ops filemap_test_inode_ops __ktest_data = {
+    .read = filemap_test_read
+};
+
+static struct inode filemap_test_inode __ktest_data = {
+    .ops  = &filemap_test_inode_ops,
+    .size = FILEMAP_TEST_SIZE
+};
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest filemap_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest filemap_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest filemap_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest filemap_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+static int __ktest filemap_test_read(struct inode * node, void * buf,
+                                     uint32_t offset, uint32_t size) {
+    if(offset >= node->size) {
+        return 0;
+    }
+    if(size > node->size - offset) {
+        size = node->size - offset;
+    }
+
+    for(uint32_t i = 0; i < size; i++) {
+        ((uint8_t*)buf)[i] = (offset + i) / PAGE_SIZE + 1;
+    }
+    return size;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Map the test file from the given offset, over as many pages */
+static struct vm_space * __ktest filemap_test_space(void * addr,
+                                                    uint32_t pages,
+                                                    uintptr_t offset) {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+
+    map->start_addr = addr;
+    map->end_addr   = addr + pages * PAGE_SIZE;
+    map->flags      = VM_MAP_READ | VM_MAP_WRITE;
+    map->ops        = &vm_file_ops;
+    map->private    = &filemap_test_inode;
+    map->offset     = offset;
+    vm_space_add_map(space, map);
+
+    return space;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Whether the page mapped at an address is filled with a byte, up to a
+ * length, and zeroed after it */
+static int __ktest filemap_test_page(struct vm_space * space, void * addr,
+                                     uint8_t byte, uint32_t length) {
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd), addr);
+    if(!pte || !PTE_EXISTS(pte)) {
+        return 0;
+    }
+
+    uint8_t * data = kmap_atomic(PTE_PAGE(pte));
+    int matches = 1;
+    for(uint32_t i = 0; i < PAGE_SIZE; i++) {
+        if(data[i] != (i < length ? byte : 0)) {
+            matches = 0;
+            break;
+        }
+    }
+    kunmap_atomic(data);
+
+    return matches;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest filemap_test_fault(ktest_unit_t * ktest) {
+    void * addr = (void*)0x40000000;
+    struct vm_space * space = filemap_test_space(addr, 4, 0);
+
+    /* One fault reads in the whole window, and the tail of the file's last
+     * page is zeroed, as is the page past its end */
+    assert_equal(vm_space_page_fault(space, addr + PAGE_SIZE, 0), E_SUCCESS);
+    assert(filemap_test_page(space, addr, 1, PAGE_SIZE));
+    assert(filemap_test_page(space, addr + PAGE_SIZE, 2, PAGE_SIZE));
+    assert(filemap_test_page(space, addr + 2 * PAGE_SIZE, 3, PAGE_SIZE / 2));
+    assert(filemap_test_page(space, addr + 3 * PAGE_SIZE, 0, 0));
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest filemap_test_offset(ktest_unit_t * ktest) {
+    void * addr = (void*)0x40000000;
+    struct vm_space * space = filemap_test_space(addr, 2, PAGE_SIZE);
+
+    assert_equal(vm_space_page_fault(space, addr, 0), E_SUCCESS);
+    assert(filemap_test_page(space, addr, 2, PAGE_SIZE));
+    assert(filemap_test_page(space, addr + PAGE_SIZE, 3, PAGE_SIZE / 2));
+
+    /* Splitting the mapping keeps the rest of it at the same place in the
+     * file, so a fault in the tail still reads the right page */
+    assert_equal(vm_space_unmap(space, addr, addr + PAGE_SIZE), E_SUCCESS);
+    struct vm_map * map = vm_map_find(space, addr + PAGE_SIZE);
+    assert_not_equal(map, NULL);
+    assert_equal(map->offset, 2 * PAGE_SIZE);
+    assert_equal(map->ops, &vm_file_ops);
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("filemap-test-fault", filemap_test_fault),
+    KTEST_UNIT("filemap-test-offset", filemap_test_offset),
+};
+
+KTEST_MODULE_DEFINE("filemap", test_units,
+                    filemap_pre_module,
+                    filemap_post_module,
+                    filemap_pre_test,
+                    filemap_post_test);
+
+/* ------------------------------------------------------------------------- */
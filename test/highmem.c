@@ -0,0 +1,161 @@
+/*
+ * kernel/test/highmem.c
+ * Highmem Temporary Mapping Testing
+ */
+
+#include <rotary/test/highmem.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define HIGHMEM_TEST_PATTERN 0xA5
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest highmem_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest highmem_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest highmem_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest highmem_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Allocate a highmem page, returning NULL if the system has no highmem */
+static struct page * __ktest highmem_test_alloc() {
+    struct page * page = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+    if(page && !PAGE_IS_HIGHMEM(page)) {
+        page_free(page, 0);
+        return NULL;
+    }
+    return page;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest highmem_test_lowmem(ktest_unit_t * ktest) {
+    struct page * page = page_alloc(0, PR_KERNEL);
+
+    /* Lowmem pages are already mapped, so no slot is used */
+    assert_equal(kmap(page), PAGE_VA(page));
+    kunmap(page);
+
+    void * virt_addr = kmap_atomic(page);
+    assert_equal(virt_addr, PAGE_VA(page));
+    assert_equal(cpu_get_local()->kmap_atomic_depth, 0);
+    kunmap_atomic(virt_addr);
+
+    page_free(page, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest highmem_test_kmap(ktest_unit_t * ktest) {
+    struct page * page = highmem_test_alloc();
+    if(!page) return;
+
+    void * virt_addr = kmap(page);
+    assert(virt_addr >= KMAP_SLOT_ADDR(0));
+    assert(virt_addr < KMAP_SLOT_ADDR(KMAP_SLOTS));
+    memset(virt_addr, HIGHMEM_TEST_PATTERN, PAGE_SIZE);
+
+    /* Mapping the page again shares its slot */
+    assert_equal(kmap(page), virt_addr);
+    kunmap(page);
+    kunmap(page);
+
+    /* The contents are visible through an atomic mapping too */
+    void * atomic_addr = kmap_atomic(page);
+    assert_not_equal(atomic_addr, virt_addr);
+    assert_filled(atomic_addr, PAGE_SIZE, HIGHMEM_TEST_PATTERN);
+    kunmap_atomic(atomic_addr);
+
+    page_free(page, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest highmem_test_atomic_nesting(ktest_unit_t * ktest) {
+    struct page * first  = highmem_test_alloc();
+    struct page * second = highmem_test_alloc();
+    if(!first || !second) {
+        if(first) page_free(first, 0);
+        if(second) page_free(second, 0);
+        return;
+    }
+
+    void * first_addr  = kmap_atomic(first);
+    void * second_addr = kmap_atomic(second);
+    assert_not_equal(first_addr, second_addr);
+    assert_equal(cpu_get_local()->kmap_atomic_depth, 2);
+
+    kunmap_atomic(second_addr);
+    kunmap_atomic(first_addr);
+    assert_equal(cpu_get_local()->kmap_atomic_depth, 0);
+
+    page_free(first, 0);
+    page_free(second, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest highmem_test_copy(ktest_unit_t * ktest) {
+    struct page * src  = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+    struct page * dest = page_alloc(0, PR_KERNEL | PR_HIGHMEM);
+
+    void * virt_addr = kmap_atomic(src);
+    memset(virt_addr, HIGHMEM_TEST_PATTERN, PAGE_SIZE);
+    kunmap_atomic(virt_addr);
+
+    highmem_zero_page(dest);
+    virt_addr = kmap_atomic(dest);
+    assert_clear(virt_addr, PAGE_SIZE);
+    kunmap_atomic(virt_addr);
+
+    highmem_copy_page(dest, src);
+    virt_addr = kmap_atomic(dest);
+    assert_filled(virt_addr, PAGE_SIZE, HIGHMEM_TEST_PATTERN);
+    kunmap_atomic(virt_addr);
+
+    page_free(src, 0);
+    page_free(dest, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("highmem-test-lowmem", highmem_test_lowmem),
+    KTEST_UNIT("highmem-test-kmap", highmem_test_kmap),
+    KTEST_UNIT("highmem-test-atomic-nesting", highmem_test_atomic_nesting),
+    KTEST_UNIT("highmem-test-copy", highmem_test_copy),
+};
+
+KTEST_MODULE_DEFINE("highmem", test_units,
+                    highmem_pre_module,
+                    highmem_post_module,
+                    highmem_pre_test,
+                    highmem_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,201 @@
+/*
+ * kernel/test/initrd.c
+ * Initial RAM Disk Testing
+ */
+
+#include <rotary/test/initrd.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define INITRD_TEST_BUF_SIZE 1024
+
+static char initrd_test_buf[INITRD_TEST_BUF_SIZE] __ktest_data;
+static list_head_t initrd_test_files __ktest_data;
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest initrd_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest initrd_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest initrd_pre_test(ktest_module_t * module) {
+    memset(initrd_test_buf, 0, INITRD_TEST_BUF_SIZE);
+    clist_init(&initrd_test_files);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest initrd_post_test(ktest_module_t * module) {
+    initrd_free_files(&initrd_test_files);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+static void __ktest initrd_test_hex(char * dest, uint32_t value) {
+    const char * digits = "0123456789abcdef";
+    for(int32_t i = 7; i >= 0; i--) {
+        dest[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Append a cpio newc entry to the test buffer, returning the next offset */
+static uint32_t __ktest initrd_test_entry(uint32_t offset, const char * name,
+        uint32_t mode, const char * data) {
+    char * hdr = initrd_test_buf + offset;
+    uint32_t name_size = strlen(name) + 1;
+    uint32_t file_size = data ? strlen(data) : 0;
+
+    memcpy(hdr, CPIO_NEWC_MAGIC, 6);
+    for(uint32_t i = 0; i < 13; i++) {
+        initrd_test_hex(hdr + 6 + (i * 8), 0);
+    }
+    initrd_test_hex(hdr + 6 + (1 * 8), mode);
+    initrd_test_hex(hdr + 6 + (6 * 8), file_size);
+    initrd_test_hex(hdr + 6 + (11 * 8), name_size);
+
+    memcpy(hdr + CPIO_NEWC_HDR_SIZE, name, name_size);
+    offset = (offset + CPIO_NEWC_HDR_SIZE + name_size + 3) & ~3;
+
+    if(file_size) {
+        memcpy(initrd_test_buf + offset, data, file_size);
+    }
+
+    return (offset + file_size + 3) & ~3;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint32_t __ktest initrd_test_archive() {
+    uint32_t offset = 0;
+    offset = initrd_test_entry(offset, ".", INITRD_MODE_DIR | 0755, NULL);
+    offset = initrd_test_entry(offset, "./etc", INITRD_MODE_DIR | 0755, NULL);
+    offset = initrd_test_entry(offset, "./etc/motd", INITRD_MODE_FILE | 0644,
+                               "hello");
+    offset = initrd_test_entry(offset, "./bin", INITRD_MODE_DIR | 0755, NULL);
+    offset = initrd_test_entry(offset, "./bin/init", INITRD_MODE_FILE | 0755,
+                               "\x7f" "ELF");
+    return initrd_test_entry(offset, CPIO_TRAILER, 0, NULL);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest initrd_test_unpack(ktest_unit_t * ktest) {
+    uint32_t size = initrd_test_archive();
+
+    /* The "." entry is skipped */
+    assert_equal(initrd_unpack(&initrd_test_files, initrd_test_buf, size), 4);
+
+    struct initrd_file * file = initrd_find(&initrd_test_files, "etc/motd");
+    assert_not_equal((void*)file, NULL);
+    assert_equal(file->size, 5);
+    assert_equal(file->mode, INITRD_MODE_FILE | 0644);
+    assert_equal(strncmp(file->data, "hello", 5), 0);
+
+    file = initrd_find(&initrd_test_files, "/bin");
+    assert_not_equal((void*)file, NULL);
+    assert(INITRD_IS_DIR(file->mode));
+
+    assert_equal((void*)initrd_find(&initrd_test_files, "bin/sh"), NULL);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest initrd_test_zero_copy(ktest_unit_t * ktest) {
+    uint32_t size = initrd_test_archive();
+    initrd_unpack(&initrd_test_files, initrd_test_buf, size);
+
+    /* Names and contents point into the archive itself */
+    struct initrd_file * file = initrd_find(&initrd_test_files, "bin/init");
+    assert_not_equal((void*)file, NULL);
+    assert((uintptr_t)file->data >= (uintptr_t)initrd_test_buf);
+    assert((uintptr_t)file->data < (uintptr_t)initrd_test_buf + size);
+    assert((uintptr_t)file->name >= (uintptr_t)initrd_test_buf);
+    assert((uintptr_t)file->name < (uintptr_t)initrd_test_buf + size);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest initrd_test_read(ktest_unit_t * ktest) {
+    uint32_t size = initrd_test_archive();
+    initrd_unpack(&initrd_test_files, initrd_test_buf, size);
+
+    struct initrd_file * file = initrd_find(&initrd_test_files, "etc/motd");
+    char buf[8];
+
+    assert_equal(initrd_read(file, buf, 0, sizeof(buf)), 5);
+    assert_equal(strncmp(buf, "hello", 5), 0);
+    assert_equal(initrd_read(file, buf, 3, sizeof(buf)), 2);
+    assert_equal(strncmp(buf, "lo", 2), 0);
+    assert_equal(initrd_read(file, buf, 5, sizeof(buf)), 0);
+
+    file = initrd_find(&initrd_test_files, "etc");
+    assert_equal(initrd_read(file, buf, 0, sizeof(buf)), E_ERROR);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest initrd_test_bad_magic(ktest_unit_t * ktest) {
+    uint32_t size = initrd_test_archive();
+    initrd_test_buf[0] = 'x';
+
+    assert_equal(initrd_unpack(&initrd_test_files, initrd_test_buf, size),
+                 E_ERROR);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest initrd_test_truncated(ktest_unit_t * ktest) {
+    uint32_t size = initrd_test_archive();
+
+    /* Cutting the archive short loses the trailer, but the files before it
+     * are kept */
+    assert_equal(initrd_unpack(&initrd_test_files, initrd_test_buf, size - 8),
+                 E_ERROR);
+    assert_not_equal((void*)initrd_find(&initrd_test_files, "etc/motd"), NULL);
+
+    /* An oversized file length is rejected rather than read past the end */
+    initrd_free_files(&initrd_test_files);
+    initrd_test_entry(0, "big", INITRD_MODE_FILE, "x");
+    initrd_test_hex(initrd_test_buf + 6 + (6 * 8), 0xFFFFFFF0);
+    assert_equal(initrd_unpack(&initrd_test_files, initrd_test_buf,
+                               INITRD_TEST_BUF_SIZE), E_ERROR);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("initrd-test-unpack", initrd_test_unpack),
+    KTEST_UNIT("initrd-test-zero-copy", initrd_test_zero_copy),
+    KTEST_UNIT("initrd-test-read", initrd_test_read),
+    KTEST_UNIT("initrd-test-bad-magic", initrd_test_bad_magic),
+    KTEST_UNIT("initrd-test-truncated", initrd_test_truncated),
+};
+
+KTEST_MODULE_DEFINE("initrd", test_units,
+                    initrd_pre_module,
+                    initrd_post_module,
+                    initrd_pre_test,
+                    initrd_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,163 @@
+/*
+ * kernel/test/ioremap.c
+ * Device Memory Mapping Testing
+ */
+
+#include <rotary/test/ioremap.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define IOREMAP_TEST_PATTERN 0x3C
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest ioremap_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest ioremap_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest ioremap_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest ioremap_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* The memory type bits of the entry mapping an address */
+static ptable_entry_t __ktest ioremap_test_cache_bits(void * virt_addr) {
+    struct pte * pte = ptable_get_pte(paging_kernel_pgd(), virt_addr);
+    return pte->entry & PTE_CACHE_MASK;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest ioremap_test_write_back(ktest_unit_t * ktest) {
+    struct page * page = page_alloc(0, PR_KERNEL);
+    memset(PAGE_VA(page), 0, PAGE_SIZE);
+
+    /* Writes through the new mapping reach the same memory, and the offset
+     * into the page is kept */
+    uint8_t * virt_addr = ioremap((uintptr_t)PAGE_PA(page) + 16, 32,
+                                  VM_MAP_WB);
+    assert((uintptr_t)virt_addr % PAGE_SIZE == 16);
+    assert(ioremap_test_cache_bits(virt_addr) == PTE_CACHE_WB);
+
+    memset(virt_addr, IOREMAP_TEST_PATTERN, 32);
+    assert_filled(PAGE_VA(page) + 16, 32, IOREMAP_TEST_PATTERN);
+
+    iounmap(virt_addr);
+    page_free(page, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ioremap_test_memory_types(ktest_unit_t * ktest) {
+    struct page * page = page_alloc(0, PR_KERNEL);
+
+    void * uc = ioremap((uintptr_t)PAGE_PA(page), PAGE_SIZE, VM_MAP_UC);
+    void * wt = ioremap((uintptr_t)PAGE_PA(page), PAGE_SIZE, VM_MAP_WT);
+    void * wc = ioremap((uintptr_t)PAGE_PA(page), PAGE_SIZE, VM_MAP_WC);
+
+    assert(ioremap_test_cache_bits(uc) == PTE_CACHE_UC);
+    assert(ioremap_test_cache_bits(wt) == PTE_CACHE_WT);
+    if(paging_pat_enabled()) {
+        assert(ioremap_test_cache_bits(wc) == PTE_CACHE_WC);
+    } else {
+        assert(ioremap_test_cache_bits(wc) == PTE_CACHE_UC);
+    }
+
+    iounmap(wc);
+    iounmap(wt);
+    iounmap(uc);
+    page_free(page, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ioremap_test_reuse(ktest_unit_t * ktest) {
+    /* A region spanning a page boundary takes two pages */
+    void * first = ioremap(PAGE_SIZE - 4, 8, VM_MAP_UC);
+    void * second = ioremap(0, PAGE_SIZE, VM_MAP_UC);
+    assert_equal(PAGE_ALIGN_DOWN(second) - PAGE_ALIGN_DOWN(first),
+                 2 * PAGE_SIZE);
+
+    /* The space released is reused */
+    iounmap(first);
+    void * third = ioremap(0, 2 * PAGE_SIZE, VM_MAP_UC);
+    assert_equal(PAGE_ALIGN_DOWN(third), PAGE_ALIGN_DOWN(first));
+
+    iounmap(third);
+    iounmap(second);
+
+    assert_equal(ioremap(0, 0, VM_MAP_UC), NULL);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ioremap_test_user_map(ktest_unit_t * ktest) {
+    struct page * block = page_alloc(1, PR_KERNEL);
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+    void * addr = (void*)0x40000000;
+    uint32_t uses = block->use_count;
+
+    map->start_addr = addr;
+    map->end_addr   = addr + 2 * PAGE_SIZE;
+    map->flags      = VM_MAP_READ | VM_MAP_WRITE | VM_MAP_IO | VM_MAP_UC;
+    map->offset     = (uintptr_t)PAGE_PA(block);
+    vm_space_add_map(space, map);
+    assert_equal(map->ops, &vm_device_ops);
+
+    /* The device's pages are mapped in place, with the memory type asked for,
+     * rather than being allocated */
+    assert_equal(vm_space_page_fault(space, addr + PAGE_SIZE, VM_FAULT_WRITE),
+                 E_SUCCESS);
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd), addr);
+    assert_equal(PTE_PFN(pte), block->pfn);
+    assert((pte->entry & PTE_CACHE_MASK) == PTE_CACHE_UC);
+    pte = ptable_get_pte(PHY_TO_VIR(space->pgd), addr + PAGE_SIZE);
+    assert_equal(PTE_PFN(pte), block->pfn + 1);
+
+    /* Nor are they freed along with the address space */
+    vm_space_put(space);
+    assert_equal(block->use_count, uses);
+
+    page_free(block, 1);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("ioremap-test-write-back", ioremap_test_write_back),
+    KTEST_UNIT("ioremap-test-memory-types", ioremap_test_memory_types),
+    KTEST_UNIT("ioremap-test-reuse", ioremap_test_reuse),
+    KTEST_UNIT("ioremap-test-user-map", ioremap_test_user_map),
+};
+
+KTEST_MODULE_DEFINE("ioremap", test_units,
+                    ioremap_pre_module,
+                    ioremap_post_module,
+                    ioremap_pre_test,
+                    ioremap_post_test);
+
+/* ------------------------------------------------------------------------- */
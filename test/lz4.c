@@ -0,0 +1,156 @@
+/*
+ * kernel/test/lz4.c
+ * LZ4 Compression Testing
+ */
+
+#include <rotary/test/lz4.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define LZ4_TEST_SIZE 4096
+
+static uint8_t lz4_test_src[LZ4_TEST_SIZE];
+static uint8_t lz4_test_dst[LZ4_TEST_SIZE + LZ4_TEST_SIZE / 64];
+static uint8_t lz4_test_out[LZ4_TEST_SIZE];
+static struct lz4_state lz4_test_state;
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest lz4_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest lz4_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest lz4_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest lz4_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Fill the source with bytes that don't repeat within the buffer */
+static void __ktest lz4_test_fill_random() {
+    uint32_t seed = 12345;
+
+    for(uint32_t i = 0; i < LZ4_TEST_SIZE; i++) {
+        seed = seed * 1103515245 + 12345;
+        lz4_test_src[i] = seed >> 16;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Compress and decompress the source, returning the compressed size, or 0
+ * if the data didn't survive the trip */
+static uint32_t __ktest lz4_test_round_trip() {
+    uint32_t size = lz4_compress(&lz4_test_state, lz4_test_src, LZ4_TEST_SIZE,
+                                 lz4_test_dst, sizeof(lz4_test_dst));
+    if(!size) {
+        return 0;
+    }
+
+    memset(lz4_test_out, 0, LZ4_TEST_SIZE);
+    if(lz4_decompress(lz4_test_dst, size, lz4_test_out, LZ4_TEST_SIZE) !=
+       LZ4_TEST_SIZE) {
+        return 0;
+    }
+
+    return memcmp(lz4_test_out, lz4_test_src, LZ4_TEST_SIZE) == 0 ? size : 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest lz4_test_repetitive(ktest_unit_t * ktest) {
+    /* A short repeating pattern is almost entirely matches */
+    for(uint32_t i = 0; i < LZ4_TEST_SIZE; i++) {
+        lz4_test_src[i] = "rotary"[i % 6];
+    }
+
+    uint32_t size = lz4_test_round_trip();
+    assert(size > 0);
+    assert(size < LZ4_TEST_SIZE / 64);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest lz4_test_mixed(ktest_unit_t * ktest) {
+    /* Random runs separated by copies of earlier data */
+    lz4_test_fill_random();
+    for(uint32_t i = 512; i < LZ4_TEST_SIZE; i += 512) {
+        memcpy(&lz4_test_src[i], &lz4_test_src[i - 300], 256);
+    }
+
+    uint32_t size = lz4_test_round_trip();
+    assert(size > 0);
+    assert(size < LZ4_TEST_SIZE);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest lz4_test_incompressible(ktest_unit_t * ktest) {
+    lz4_test_fill_random();
+
+    /* Data that doesn't compress still survives, a little larger */
+    uint32_t size = lz4_test_round_trip();
+    assert(size >= LZ4_TEST_SIZE);
+
+    /* But gives up once it outgrows a smaller buffer */
+    assert_equal(lz4_compress(&lz4_test_state, lz4_test_src, LZ4_TEST_SIZE,
+                              lz4_test_dst, LZ4_TEST_SIZE / 2), 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest lz4_test_malformed(ktest_unit_t * ktest) {
+    /* A match reaching back before the start of the output */
+    uint8_t before_start[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+    assert_equal(lz4_decompress(before_start, sizeof(before_start),
+                                lz4_test_out, LZ4_TEST_SIZE), E_ERROR);
+
+    /* Literals running past the end of the input */
+    uint8_t truncated[] = { 0x50, 'a', 'b' };
+    assert_equal(lz4_decompress(truncated, sizeof(truncated), lz4_test_out,
+                                LZ4_TEST_SIZE), E_ERROR);
+
+    /* Output that doesn't fit the buffer */
+    uint8_t overflow[] = { 0x1F, 'a', 0x01, 0x00, 0xFF, 0xFF, 0x00 };
+    assert_equal(lz4_decompress(overflow, sizeof(overflow), lz4_test_out,
+                                64), E_ERROR);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("lz4-test-repetitive", lz4_test_repetitive),
+    KTEST_UNIT("lz4-test-mixed", lz4_test_mixed),
+    KTEST_UNIT("lz4-test-incompressible", lz4_test_incompressible),
+    KTEST_UNIT("lz4-test-malformed", lz4_test_malformed),
+};
+
+KTEST_MODULE_DEFINE("lz4", test_units,
+                    lz4_pre_module,
+                    lz4_post_module,
+                    lz4_pre_test,
+                    lz4_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -12,19 +12,19 @@ extern uintptr_t KERNEL_PHYS_END;
 /* Test Set-up and Clean-up                                                  */
 /* ------------------------------------------------------------------------- */
 
-int32_t palloc_pre_module(ktest_module_t * module) {
+int32_t __ktest palloc_pre_module(ktest_module_t * module) {
     return E_SUCCESS;
 }
 
 /* ------------------------------------------------------------------------- */
 
-int32_t palloc_post_module(ktest_module_t * module) {
+int32_t __ktest palloc_post_module(ktest_module_t * module) {
     return E_SUCCESS;
 }
 
 /* ------------------------------------------------------------------------- */
 
-int32_t palloc_pre_test(ktest_module_t * module) {
+int32_t __ktest palloc_pre_test(ktest_module_t * module) {
     /* Page allocator initialisation requests memory from bootmem to store
      * its page structures, therefore we will want to ensure that bootmem
      * is in a consistent state each time we re-initialise palloc */
@@ -41,7 +41,7 @@ int32_t palloc_pre_test(ktest_module_t * module) {
 
 /* ------------------------------------------------------------------------- */
 
-int32_t palloc_post_test(ktest_module_t * module) {
+int32_t __ktest palloc_post_test(ktest_module_t * module) {
     return E_SUCCESS;
 }
 
@@ -49,8 +49,8 @@ int32_t palloc_post_test(ktest_module_t * module) {
 /* Utility Functions                                                         */
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_configure_memory(uintptr_t start_addr,
-                                  uintptr_t end_addr) {
+void __ktest palloc_test_configure_memory(uintptr_t start_addr,
+                                          uintptr_t end_addr) {
     /* We set up a temporary bootmem region which will be subsequently used
      * by buddy_init() to get space for the page struct pool. For the sake
      * of convenience, we will place the pool at a separate address.
@@ -97,7 +97,7 @@ void palloc_test_configure_memory(uintptr_t start_addr,
 /* Unit Tests                                                                */
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_buddy_init(ktest_unit_t * ktest) {
+void __ktest palloc_test_buddy_init(ktest_unit_t * ktest) {
     /* Register 128MB of usable memory */
     uintptr_t start_addr = 0x200000;
     uintptr_t end_addr = 0x8200000;
@@ -111,7 +111,9 @@ void palloc_test_buddy_init(ktest_unit_t * ktest) {
     assert_equal(rv, E_SUCCESS);
     assert_equal(page_count, end_addr / PAGE_SIZE);
     assert_equal(buddy_allocator.max_order, ORDER_MAX);
-    assert_equal(buddy_allocator.page_area, PHY_TO_VIR(start_addr));
+    assert_equal(buddy_allocator.page_area,
+                 PHY_TO_VIR(BOOTMEM_LIMIT_EARLY -
+                            (highest_pfn * sizeof(struct page))));
     assert_equal(buddy_allocator.page_count, highest_pfn);
     assert_equal(buddy_allocator.blocks, &blocks);
     assert_equal(sizeof(blocks), (ORDER_MAX+1) * sizeof(struct block_list));
@@ -146,7 +148,7 @@ void palloc_test_buddy_init(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_alloc_min_order(ktest_unit_t * ktest) {
+void __ktest palloc_test_alloc_min_order(ktest_unit_t * ktest) {
     /* Configure 128MB of usable memory */
     palloc_test_configure_memory(0x400000, 0x8400000);
 
@@ -191,7 +193,7 @@ void palloc_test_alloc_min_order(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_alloc_max_order(ktest_unit_t * ktest) {
+void __ktest palloc_test_alloc_max_order(ktest_unit_t * ktest) {
     /* Configure 128MB of usable memory */
     palloc_test_configure_memory(0x400000, 0x8400000);
 
@@ -229,7 +231,7 @@ void palloc_test_alloc_max_order(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_alloc_exhaust_all(ktest_unit_t * ktest) {
+void __ktest palloc_test_alloc_exhaust_all(ktest_unit_t * ktest) {
     /* Configure 128MB of usable memory */
     palloc_test_configure_memory(0x400000, 0x8400000);
 
@@ -252,7 +254,7 @@ void palloc_test_alloc_exhaust_all(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_alloc_split_and_free(ktest_unit_t * ktest) {
+void __ktest palloc_test_alloc_split_and_free(ktest_unit_t * ktest) {
     /* Configure 128MB of usable memory */
     palloc_test_configure_memory(0x400000, 0x8400000);
 
@@ -296,7 +298,7 @@ void palloc_test_alloc_split_and_free(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_free_null(ktest_unit_t * ktest) {
+void __ktest palloc_test_free_null(ktest_unit_t * ktest) {
     /* Configure 128MB of usable memory */
     palloc_test_configure_memory(0x400000, 0x8400000);
 
@@ -307,7 +309,7 @@ void palloc_test_free_null(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_free_critical(ktest_unit_t * ktest) {
+void __ktest palloc_test_free_critical(ktest_unit_t * ktest) {
     /* Configure 128MB of usable memory */
     palloc_test_configure_memory(0x400000, 0x8400000);
 
@@ -331,7 +333,7 @@ void palloc_test_free_critical(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_is_critical(ktest_unit_t * ktest) {
+void __ktest palloc_test_is_critical(ktest_unit_t * ktest) {
     /* Configure 128MB of usable memory */
     palloc_test_configure_memory(0x400000, 0x8400000);
 
@@ -348,7 +350,7 @@ void palloc_test_is_critical(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void palloc_test_partial_block_free(ktest_unit_t * ktest) {
+void __ktest palloc_test_partial_block_free(ktest_unit_t * ktest) {
     /* Configure 128MB of usable memory */
     palloc_test_configure_memory(0x400000, 0x8400000);
 
@@ -358,13 +360,12 @@ void palloc_test_partial_block_free(ktest_unit_t * ktest) {
 
     /* Check that we have an expected number of blocks in the allocator - this
      * assumes that 128MB of memory is used on a 4KB page system */
-    assert_equal(buddy_allocator.blocks[ORDER_MAX].free_count, 511);
-    assert_equal(buddy_allocator.blocks[ORDER_MAX-1].free_count, 1);
-    assert_equal(buddy_allocator.blocks[ORDER_MAX-2].free_count, 1);
-    assert_equal(buddy_allocator.blocks[ORDER_MAX-3].free_count, 1);
-    assert_equal(buddy_allocator.blocks[ORDER_MAX-4].free_count, 1);
-    assert_equal(buddy_allocator.blocks[ORDER_MAX-5].free_count, 1);
-    assert_equal(buddy_allocator.blocks[ORDER_MAX-6].free_count, 0);
+    assert_equal(buddy_allocator.blocks[ORDER_MAX].free_count,
+                 (0x8000000 >> (PAGE_SHIFT + ORDER_MAX)) - 1);
+    for(uint32_t i = 1; i < ORDER_MAX; i++) {
+        assert_equal(buddy_allocator.blocks[i].free_count, 1);
+    }
+    assert_equal(buddy_allocator.blocks[0].free_count, 0);
 
     /* Ensure both allocations succeeded */
     assert_not_equal(page1, NULL);
@@ -391,11 +392,96 @@ void palloc_test_partial_block_free(ktest_unit_t * ktest) {
     assert_equal(page2->order, 0);
 }
 
+/* ------------------------------------------------------------------------- */
+
+void __ktest palloc_test_split_block(ktest_unit_t * ktest) {
+    /* Configure 128MB of usable memory */
+    palloc_test_configure_memory(0x400000, 0x8400000);
+
+    uint32_t max_blocks = buddy_allocator.blocks[ORDER_MAX].free_count;
+
+    struct page * page = page_alloc(2, 0);
+    assert_not_equal(page, NULL);
+    if(!page) return;
+
+    /* Once split, each page of the block can be freed on its own */
+    page_split(page, 2);
+    for(uint32_t i = 0; i < 4; i++) {
+        assert_equal(page[i].order, ORDER_USED);
+    }
+
+    assert_equal(page_free(&page[2], 0), E_SUCCESS);
+    assert_equal(page[3].order, ORDER_USED);
+    assert_equal(page_free(&page[0], 0), E_SUCCESS);
+    assert_equal(page_free(&page[3], 0), E_SUCCESS);
+    assert_equal(page_free(&page[1], 0), E_SUCCESS);
+
+    /* The pages merge back into the block they were allocated from */
+    assert_equal(buddy_allocator.blocks[ORDER_MAX].free_count, max_blocks);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest palloc_test_alloc_highmem(ktest_unit_t * ktest) {
+    /* Configure 128MB of usable memory, as palloc_test_configure_memory()
+     * does, but treat the top 64MB as highmem before the pages are freed, as
+     * if it lay beyond the direct map. Like LOWMEM_PLIMIT, the boundary is
+     * aligned to the largest block */
+    uintptr_t start_addr = 0x400000;
+    uintptr_t end_addr   = 0x8400000;
+    uintptr_t high_addr  = 0x4400000;
+
+    bootmem_add_mem_region(0x200000, 0x200000 + sizeof(struct page) *
+                           (end_addr / PAGE_SIZE), MEM_REGION_AVAILABLE);
+    buddy_init(end_addr / PAGE_SIZE);
+
+    for(uint32_t pfn = PA_TO_PFN(high_addr); pfn < page_count; pfn++) {
+        struct page * page = page_from_pfn(pfn);
+        CLEAR_BIT(page->flags, PF_ZONE_LOWMEM);
+        SET_BIT(page->flags, PF_ZONE_HIGHMEM);
+    }
+
+    bootmem_reset();
+    bootmem_add_mem_region(start_addr, end_addr, MEM_REGION_AVAILABLE);
+    bootmem_mark_free();
+
+    uint32_t high_blocks = (end_addr - high_addr) /
+                           (PAGE_SIZE << ORDER_MAX);
+    uint32_t low_blocks  = (high_addr - start_addr) /
+                           (PAGE_SIZE << ORDER_MAX);
+    assert_equal(buddy_allocator.blocks[ORDER_MAX].high_count, high_blocks);
+    assert_equal(buddy_allocator.blocks[ORDER_MAX].free_count,
+                 high_blocks + low_blocks);
+
+    /* Highmem is only handed out when asked for, and preferred then */
+    struct page * low = page_alloc(0, PR_KERNEL);
+    assert_not_equal(low, NULL);
+    if(!low) return;
+    assert_bit_set(low->flags, PF_ZONE_LOWMEM);
+
+    struct page * high = page_alloc(0, PR_HIGHMEM);
+    assert_not_equal(high, NULL);
+    if(!high) return;
+    assert_bit_set(high->flags, PF_ZONE_HIGHMEM);
+
+    /* Once low memory runs out, highmem isn't used in its place */
+    uint32_t allocated = 0;
+    while(page_alloc(ORDER_MAX, PR_KERNEL)) {
+        allocated++;
+    }
+    assert_equal(allocated, low_blocks - 1);
+
+    struct page * block = page_alloc(ORDER_MAX, PR_HIGHMEM);
+    assert_not_equal(block, NULL);
+    if(!block) return;
+    assert_bit_set(block->flags, PF_ZONE_HIGHMEM);
+}
+
 /* ------------------------------------------------------------------------- */
 /* Test Registration                                                         */
 /* ------------------------------------------------------------------------- */
 
-static ktest_unit_t test_units[] = {
+static ktest_unit_t test_units[] __ktest_data = {
     KTEST_UNIT("palloc-buddy-init", palloc_test_buddy_init),
     KTEST_UNIT("palloc-test-min-order", palloc_test_alloc_min_order),
     KTEST_UNIT("palloc-test-max-order", palloc_test_alloc_max_order),
@@ -407,6 +493,8 @@ static ktest_unit_t test_units[] = {
     KTEST_UNIT("palloc-test-is-critical", palloc_test_is_critical),
     KTEST_UNIT("palloc-test-partial-block-free",
                palloc_test_partial_block_free),
+    KTEST_UNIT("palloc-test-split-block", palloc_test_split_block),
+    KTEST_UNIT("palloc-test-alloc-highmem", palloc_test_alloc_highmem),
 };
 
 KTEST_MODULE_DEFINE("palloc", test_units,
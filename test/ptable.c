@@ -0,0 +1,339 @@
+/*
+ * kernel/test/ptable.c
+ * Page Table Operation Testing
+ */
+
+#include <rotary/test/ptable.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* A user address two pages below a page table boundary */
+#define PTABLE_TEST_ADDR ((void*)0x403FE000)
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest ptable_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest ptable_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest ptable_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest ptable_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Map count newly allocated pages into a PGD */
+static void __ktest ptable_test_map(struct pgd * pgd, void * virt_addr,
+                                    uint32_t count, flags_t flags) {
+    for(uint32_t i = 0; i < count; i++) {
+        struct page * page = page_alloc(0, PR_KERNEL);
+        ptable_map(pgd, virt_addr + i * PAGE_SIZE, PAGE_PA(page), flags);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int32_t __ktest ptable_test_count_pte(struct ptable_walk * walk,
+                                             struct pte * pte,
+                                             void * virt_addr) {
+    ((uint32_t*)walk->private)[0]++;
+    return E_SUCCESS;
+}
+
+static void __ktest ptable_test_count_pgt(struct ptable_walk * walk,
+                                          struct pde * pde,
+                                          void * table_addr) {
+    ((uint32_t*)walk->private)[1]++;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_map_many(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    struct page * page = page_alloc(2, PR_KERNEL);
+
+    /* The range crosses into a second page table */
+    ptable_map_many(pgd, PTABLE_TEST_ADDR, PAGE_PA(page), 4, VM_MAP_WRITE);
+
+    for(uint32_t i = 0; i < 4; i++) {
+        struct pte * pte = ptable_get_pte(pgd, PTABLE_TEST_ADDR +
+                                               i * PAGE_SIZE);
+        assert_not_equal((void*)pte, NULL);
+        assert(PTE_EXISTS(pte));
+        assert(PTE_IS_WRITABLE(pte));
+        assert_equal(PTE_PA(pte), PAGE_PA(page) + i * PAGE_SIZE);
+    }
+
+    ptable_unmap_many(pgd, PTABLE_TEST_ADDR, 4, 0);
+    page_free(page, 2);
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_walk_skips_empty(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    ptable_test_map(pgd, (void*)0x40000000, 1, 0);
+    ptable_test_map(pgd, (void*)0x80000000, 2, 0);
+
+    /* Only the two populated tables, and their present entries, are seen */
+    uint32_t counts[2] = { 0, 0 };
+    struct ptable_walk walk = {
+        .pgd     = pgd,
+        .pte_fn  = ptable_test_count_pte,
+        .pgt_fn  = ptable_test_count_pgt,
+        .private = counts
+    };
+    assert_equal(ptable_walk_range(&walk, (void*)0, (void*)KERNEL_START_VIRT),
+                 E_SUCCESS);
+    assert_equal(counts[0], 3);
+    assert_equal(counts[1], 2);
+
+    ptable_unmap_many(pgd, (void*)0x40000000, 1, 1);
+    ptable_unmap_many(pgd, (void*)0x80000000, 2, 1);
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_copy_same_pde(ktest_unit_t * ktest) {
+    struct pgd * src = ptable_pgd_new();
+    struct pgd * dst = ptable_pgd_new();
+    void * addr = (void*)0x40001000;
+    ptable_test_map(src, addr, 3, VM_MAP_WRITE);
+
+    /* Start and end share a PDE, and the end is exclusive */
+    ptable_copy_range(src, dst, addr, addr + 2 * PAGE_SIZE, PTC_SHARE);
+
+    assert(ptable_get_pte(dst, addr)->entry ==
+           ptable_get_pte(src, addr)->entry);
+    assert(ptable_get_pte(dst, addr + PAGE_SIZE)->entry ==
+           ptable_get_pte(src, addr + PAGE_SIZE)->entry);
+    assert(!PTE_EXISTS(ptable_get_pte(dst, addr + 2 * PAGE_SIZE)));
+    assert(!PTE_EXISTS(ptable_get_pte(dst, addr - PAGE_SIZE)));
+
+    ptable_unmap_many(dst, addr, 2, 1);
+    ptable_unmap_many(src, addr, 3, 1);
+    ptable_pgd_free(dst);
+    ptable_pgd_free(src);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_copy_cow(ktest_unit_t * ktest) {
+    struct pgd * src = ptable_pgd_new();
+    struct pgd * dst = ptable_pgd_new();
+    void * addr = (void*)0x40001000;
+    ptable_test_map(src, addr, 2, VM_MAP_WRITE);
+
+    struct pte * src_pte = ptable_get_pte(src, addr);
+    struct page * page = PTE_PAGE(src_pte);
+    memset(PAGE_VA(page), 0x5A, PAGE_SIZE);
+
+    assert_equal(ptable_copy_range(src, dst, addr, addr + 2 * PAGE_SIZE,
+                                   PTC_COW), E_SUCCESS);
+
+    /* Both tables share the page, and neither can write to it */
+    struct pte * dst_pte = ptable_get_pte(dst, addr);
+    assert(dst_pte->entry == src_pte->entry);
+    assert(!PTE_IS_WRITABLE(src_pte));
+    assert(TEST_BIT(src_pte->entry, PTE_COW));
+    assert_equal(page->use_count, 2);
+
+    /* The first write takes a copy */
+    assert_equal(ptable_cow_fault(dst, addr), E_SUCCESS);
+    assert(PTE_IS_WRITABLE(dst_pte));
+    assert_not_equal(PTE_PFN(dst_pte), page->pfn);
+    assert_equal(page->use_count, 1);
+
+    void * virt_addr = kmap_atomic(PTE_PAGE(dst_pte));
+    assert_filled(virt_addr, PAGE_SIZE, 0x5A);
+    kunmap_atomic(virt_addr);
+
+    /* The last user of the page writes to it in place */
+    assert_equal(ptable_cow_fault(src, addr), E_SUCCESS);
+    assert_equal(PTE_PFN(src_pte), page->pfn);
+    assert(PTE_IS_WRITABLE(src_pte));
+    assert(!TEST_BIT(src_pte->entry, PTE_COW));
+
+    /* Pages that aren't copy-on-write can't be resolved */
+    assert_equal(ptable_cow_fault(src, addr), E_ERROR);
+
+    ptable_unmap_many(dst, addr, 2, 1);
+    ptable_unmap_many(src, addr, 2, 1);
+    ptable_pgd_free(dst);
+    ptable_pgd_free(src);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_protect(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    ptable_test_map(pgd, PTABLE_TEST_ADDR, 4, VM_MAP_WRITE);
+
+    ptable_protect_range(pgd, PTABLE_TEST_ADDR, 3, VM_MAP_READ);
+    assert(!PTE_IS_WRITABLE(ptable_get_pte(pgd, PTABLE_TEST_ADDR)));
+    assert(!PTE_IS_WRITABLE(ptable_get_pte(pgd, PTABLE_TEST_ADDR +
+                                                2 * PAGE_SIZE)));
+    assert(PTE_IS_WRITABLE(ptable_get_pte(pgd, PTABLE_TEST_ADDR +
+                                               3 * PAGE_SIZE)));
+
+    ptable_unmap_many(pgd, PTABLE_TEST_ADDR, 4, 1);
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_scan_accessed(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    ptable_test_map(pgd, PTABLE_TEST_ADDR, 3, 0);
+
+    ptable_get_pte(pgd, PTABLE_TEST_ADDR)->accessed = 1;
+    ptable_get_pte(pgd, PTABLE_TEST_ADDR + 2 * PAGE_SIZE)->accessed = 1;
+
+    assert_equal(ptable_scan_accessed(pgd, PTABLE_TEST_ADDR, 3, 0), 2);
+    assert_equal(ptable_scan_accessed(pgd, PTABLE_TEST_ADDR, 3, 1), 2);
+    assert_equal(ptable_scan_accessed(pgd, PTABLE_TEST_ADDR, 3, 0), 0);
+
+    ptable_unmap_many(pgd, PTABLE_TEST_ADDR, 3, 1);
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Map a newly allocated huge page, returning NULL if huge pages aren't
+ * available */
+static struct page * __ktest ptable_test_map_huge(struct pgd * pgd,
+                                                  void * virt_addr) {
+    struct page * block = page_alloc(HUGE_PAGE_ORDER, PR_KERNEL);
+    if(!block) return NULL;
+
+    if(!SUCCESS(ptable_map_huge(pgd, virt_addr, block, VM_MAP_WRITE))) {
+        page_free(block, HUGE_PAGE_ORDER);
+        return NULL;
+    }
+
+    return block;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_huge_split(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    void * addr = (void*)0x40000000;
+
+    struct page * block = ptable_test_map_huge(pgd, addr);
+    if(!block) {
+        ptable_pgd_free(pgd);
+        return;
+    }
+
+    assert(PDE_IS_HUGE(GET_PDE(pgd, addr)));
+    assert_equal((void*)ptable_get_pte(pgd, addr), NULL);
+
+    /* Unmapping a single page splits the huge page, keeping the others */
+    ptable_unmap_many(pgd, addr + PAGE_SIZE, 1, 1);
+    assert(!PDE_IS_HUGE(GET_PDE(pgd, addr)));
+
+    struct pte * pte = ptable_get_pte(pgd, addr);
+    assert_not_equal((void*)pte, NULL);
+    assert(PTE_EXISTS(pte));
+    assert(PTE_IS_WRITABLE(pte));
+    assert_equal(PTE_PA(pte), PAGE_PA(block));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + PAGE_SIZE)));
+    assert_equal(PTE_PA(ptable_get_pte(pgd, addr + 2 * PAGE_SIZE)),
+                 PAGE_PA(block) + 2 * PAGE_SIZE);
+
+    /* The remaining pages are freed one at a time */
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_huge_unmap(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    void * addr = (void*)0x40000000;
+
+    if(!ptable_test_map_huge(pgd, addr)) {
+        ptable_pgd_free(pgd);
+        return;
+    }
+
+    /* Covering the whole huge page removes it without a split */
+    ptable_protect_range(pgd, addr, PAGE_TABLE_SIZE, VM_MAP_READ);
+    assert(PDE_IS_HUGE(GET_PDE(pgd, addr)));
+    assert(!PDE_IS_WRITABLE(GET_PDE(pgd, addr)));
+
+    ptable_unmap_many(pgd, addr, PAGE_TABLE_SIZE, 1);
+    assert(!PDE_EXISTS(GET_PDE(pgd, addr)));
+
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest ptable_test_nx(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    void * addr = (void*)0x40000000;
+    int nx = paging_nx_enabled() ? 1 : 0;
+
+    struct page * page = page_alloc(0, PR_KERNEL);
+    ptable_map(pgd, addr, PAGE_PA(page), VM_MAP_READ);
+
+    /* Pages without VM_MAP_EXEC are no-execute, where the CPU allows it */
+    struct pte * pte = ptable_get_pte(pgd, addr);
+    assert((TEST_BIT(pte->entry, PTE_NX) ? 1 : 0) == nx);
+
+    /* Changing the protection adds and removes the bit */
+    ptable_protect_range(pgd, addr, 1, VM_MAP_READ | VM_MAP_EXEC);
+    assert(!TEST_BIT(pte->entry, PTE_NX));
+
+    ptable_protect_range(pgd, addr, 1, VM_MAP_READ);
+    assert((TEST_BIT(pte->entry, PTE_NX) ? 1 : 0) == nx);
+
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("ptable-test-map-many", ptable_test_map_many),
+    KTEST_UNIT("ptable-test-walk-skips-empty", ptable_test_walk_skips_empty),
+    KTEST_UNIT("ptable-test-copy-same-pde", ptable_test_copy_same_pde),
+    KTEST_UNIT("ptable-test-copy-cow", ptable_test_copy_cow),
+    KTEST_UNIT("ptable-test-protect", ptable_test_protect),
+    KTEST_UNIT("ptable-test-scan-accessed", ptable_test_scan_accessed),
+    KTEST_UNIT("ptable-test-huge-split", ptable_test_huge_split),
+    KTEST_UNIT("ptable-test-huge-unmap", ptable_test_huge_unmap),
+    KTEST_UNIT("ptable-test-nx", ptable_test_nx),
+};
+
+KTEST_MODULE_DEFINE("ptable", test_units,
+                    ptable_pre_module,
+                    ptable_post_module,
+                    ptable_pre_test,
+                    ptable_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,159 @@
+/*
+ * kernel/test/quicklist.c
+ * Page Quicklist Testing
+ */
+
+#include <rotary/test/quicklist.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define QL_TEST_LOW     2
+#define QL_TEST_HIGH    4
+#define QL_TEST_PATTERN 0x5A
+
+static struct quicklist ql_test __ktest_data;
+static uint32_t ql_test_dtor_calls __ktest_data;
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+static int32_t __ktest quicklist_test_ctor(void * page) {
+    memset(page, QL_TEST_PATTERN, PAGE_SIZE);
+    return E_SUCCESS;
+}
+
+static int32_t __ktest quicklist_test_ctor_fail(void * page) {
+    return E_ERROR;
+}
+
+static void __ktest quicklist_test_dtor(void * page) {
+    ql_test_dtor_calls++;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest quicklist_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest quicklist_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest quicklist_pre_test(ktest_module_t * module) {
+    quicklist_init(&ql_test, "test", QL_TEST_LOW, QL_TEST_HIGH,
+                   quicklist_test_ctor, quicklist_test_dtor);
+    ql_test_dtor_calls = 0;
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest quicklist_post_test(ktest_module_t * module) {
+    quicklist_drain(&ql_test);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest quicklist_test_refill(ktest_unit_t * ktest) {
+    assert_equal(quicklist_refill(&ql_test), QL_TEST_HIGH);
+    assert_equal(ql_test.count, QL_TEST_HIGH);
+
+    /* Nothing is added until the count drops below the low watermark */
+    quicklist_alloc(&ql_test);
+    quicklist_alloc(&ql_test);
+    assert_equal(quicklist_refill(&ql_test), 0);
+    quicklist_alloc(&ql_test);
+    assert_equal(quicklist_refill(&ql_test), QL_TEST_HIGH - 1);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest quicklist_test_alloc(ktest_unit_t * ktest) {
+    quicklist_refill(&ql_test);
+
+    /* Pages are handed out prepared, with the link word cleared */
+    uint8_t * page = quicklist_alloc(&ql_test);
+    assert_not_equal((void*)page, NULL);
+    assert_equal(*(void**)page, NULL);
+    assert_equal((uint32_t)page[sizeof(void*)], QL_TEST_PATTERN);
+    assert_equal((uint32_t)page[PAGE_SIZE - 1], QL_TEST_PATTERN);
+    assert_equal(ql_test.hits, 1);
+    assert_equal(ql_test.count, QL_TEST_HIGH - 1);
+
+    quicklist_free(&ql_test, page);
+    assert_equal(ql_test.count, QL_TEST_HIGH);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest quicklist_test_miss(ktest_unit_t * ktest) {
+    /* An empty quicklist prepares a page on demand */
+    uint8_t * page = quicklist_alloc(&ql_test);
+    assert_not_equal((void*)page, NULL);
+    assert_equal((uint32_t)page[PAGE_SIZE - 1], QL_TEST_PATTERN);
+    assert_equal(ql_test.misses, 1);
+    assert_equal(ql_test.count, 0);
+
+    quicklist_free(&ql_test, page);
+    assert_equal(ql_test.count, 1);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest quicklist_test_free_full(ktest_unit_t * ktest) {
+    void * page = page_alloc_va(0, PR_KERNEL);
+    quicklist_test_ctor(page);
+    quicklist_refill(&ql_test);
+    assert_equal(ql_test.count, QL_TEST_HIGH);
+
+    /* Beyond the high watermark, pages go back to the page allocator */
+    quicklist_free(&ql_test, page);
+    assert_equal(ql_test.count, QL_TEST_HIGH);
+    assert_equal(ql_test_dtor_calls, 1);
+
+    assert_equal(quicklist_drain(&ql_test), QL_TEST_HIGH);
+    assert_equal(ql_test.count, 0);
+    assert_equal(ql_test_dtor_calls, QL_TEST_HIGH + 1);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest quicklist_test_ctor_failure(ktest_unit_t * ktest) {
+    quicklist_init(&ql_test, "test", QL_TEST_LOW, QL_TEST_HIGH,
+                   quicklist_test_ctor_fail, quicklist_test_dtor);
+
+    /* Pages that can't be prepared are never handed out or cached */
+    assert_equal(quicklist_alloc(&ql_test), NULL);
+    assert_equal(quicklist_refill(&ql_test), 0);
+    assert_equal(ql_test.count, 0);
+    assert_equal(ql_test_dtor_calls, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("quicklist-test-refill", quicklist_test_refill),
+    KTEST_UNIT("quicklist-test-alloc", quicklist_test_alloc),
+    KTEST_UNIT("quicklist-test-miss", quicklist_test_miss),
+    KTEST_UNIT("quicklist-test-free-full", quicklist_test_free_full),
+    KTEST_UNIT("quicklist-test-ctor-failure", quicklist_test_ctor_failure),
+};
+
+KTEST_MODULE_DEFINE("quicklist", test_units,
+                    quicklist_pre_module,
+                    quicklist_post_module,
+                    quicklist_pre_test,
+                    quicklist_post_test);
+
+/* ------------------------------------------------------------------------- */
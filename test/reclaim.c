@@ -0,0 +1,133 @@
+/*
+ * kernel/test/reclaim.c
+ * Page Reclaim Testing
+ */
+
+#include <rotary/test/reclaim.h>
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest reclaim_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest reclaim_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest reclaim_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest reclaim_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Create a space with a faulted in, private page at KTEST_USER_ADDR */
+static struct vm_space * __ktest reclaim_test_space() {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+
+    map->start_addr = KTEST_USER_ADDR;
+    map->end_addr   = KTEST_USER_ADDR + PAGE_SIZE;
+    map->flags      = VM_MAP_READ | VM_MAP_WRITE;
+    vm_space_add_map(space, map);
+
+    vm_space_page_fault(space, KTEST_USER_ADDR, VM_FAULT_WRITE);
+    return space;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The entry mapping KTEST_USER_ADDR in a space */
+static struct pte * __ktest reclaim_test_pte(struct vm_space * space) {
+    return ptable_get_pte(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest reclaim_test_lru(ktest_unit_t * ktest) {
+    uint32_t inactive = lru_inactive.count;
+
+    /* New pages join the inactive list */
+    struct vm_space * space = reclaim_test_space();
+    struct page * page = PTE_PAGE(reclaim_test_pte(space));
+    assert(TEST_BIT(page->flags, PF_LRU));
+    assert(!TEST_BIT(page->flags, PF_ACTIVE));
+    assert_equal(lru_inactive.count, inactive + 1);
+
+    uint32_t active = lru_active.count;
+    lru_move(page, 1);
+    assert(TEST_BIT(page->flags, PF_ACTIVE));
+    assert_equal(lru_active.count, active + 1);
+    assert_equal(lru_inactive.count, inactive);
+
+    /* And leave whichever list they're on once unmapped */
+    vm_space_put(space);
+    assert_equal(lru_active.count, active);
+    assert_equal(lru_inactive.count, inactive);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest reclaim_test_referenced(ktest_unit_t * ktest) {
+    struct vm_space * space = reclaim_test_space();
+    struct pte * pte = reclaim_test_pte(space);
+    struct page * page = PTE_PAGE(pte);
+    uint32_t generation = page->last_access + wss_page_age(page);
+
+    /* Age the page past the latest working set scan */
+    page->last_access = generation - 1;
+
+    /* An accessed entry gives the page a second chance, once */
+    pte->entry |= PTE_ACCESSED;
+    assert(reclaim_referenced(page));
+    assert(!TEST_BIT(pte->entry, PTE_ACCESSED));
+    assert(!reclaim_referenced(page));
+
+    /* As does being seen used by the latest scan */
+    page->last_access = generation;
+    assert(reclaim_referenced(page));
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest reclaim_test_watermarks(ktest_unit_t * ktest) {
+    assert(reclaim_wmark_min <= reclaim_wmark_low);
+    assert(reclaim_wmark_low <= reclaim_wmark_high);
+    assert(reclaim_wmark_high < page_total_count());
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("reclaim-test-lru", reclaim_test_lru),
+    KTEST_UNIT("reclaim-test-referenced", reclaim_test_referenced),
+    KTEST_UNIT("reclaim-test-watermarks", reclaim_test_watermarks),
+};
+
+KTEST_MODULE_DEFINE("reclaim", test_units,
+                    reclaim_pre_module,
+                    reclaim_post_module,
+                    reclaim_pre_test,
+                    reclaim_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,158 @@
+/*
+ * kernel/test/rmap.c
+ * Reverse Mapping Testing
+ */
+
+#include <rotary/test/rmap.h>
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest rmap_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest rmap_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest rmap_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest rmap_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Create a space with a single page mapping at KTEST_USER_ADDR */
+static struct vm_space * __ktest rmap_test_space(flags_t flags) {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+
+    map->start_addr = KTEST_USER_ADDR;
+    map->end_addr   = KTEST_USER_ADDR + PAGE_SIZE;
+    map->flags      = flags;
+    vm_space_add_map(space, map);
+    return space;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The page mapped at KTEST_USER_ADDR in a space */
+static struct page * __ktest rmap_test_page(struct vm_space * space) {
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR);
+    return PTE_PAGE(pte);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Count the entries found by rmap_walk() that map the page at the test
+ * address */
+static int32_t __ktest rmap_test_count_fn(struct page * page, struct pte * pte,
+                                          void * virt_addr, void * private) {
+    if(PTE_PAGE(pte) == page && virt_addr == KTEST_USER_ADDR) {
+        (*(uint32_t*)private)++;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest rmap_test_fault(ktest_unit_t * ktest) {
+    struct vm_space * space = rmap_test_space(VM_MAP_READ | VM_MAP_WRITE);
+    assert_equal(vm_space_page_fault(space, KTEST_USER_ADDR, VM_FAULT_WRITE),
+                 E_SUCCESS);
+
+    /* A faulted in page is tracked, and on the LRU lists */
+    struct page * page = rmap_test_page(space);
+    assert(TEST_BIT(page->flags, PF_LRU));
+    assert_equal(rmap_count(page), 1);
+
+    uint32_t walked = 0;
+    assert_equal(rmap_walk(page, rmap_test_count_fn, &walked), E_SUCCESS);
+    assert_equal(walked, 1);
+
+    /* Unmapping the last entry stops tracking it */
+    PAGE_INC_USES(page);
+    vm_space_put(space);
+    assert(!TEST_BIT(page->flags, PF_LRU));
+    assert_equal(rmap_count(page), 0);
+    page_free(page, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest rmap_test_fork(ktest_unit_t * ktest) {
+    struct vm_space * space = rmap_test_space(VM_MAP_READ | VM_MAP_WRITE);
+    assert_equal(vm_space_page_fault(space, KTEST_USER_ADDR, VM_FAULT_WRITE),
+                 E_SUCCESS);
+    struct page * page = rmap_test_page(space);
+
+    /* Sharing the page copy-on-write adds the child's entry */
+    struct vm_space * child = vm_space_fork(space);
+    assert_equal(rmap_count(page), 2);
+
+    /* Once the child copies it, each page has a single entry */
+    assert_equal(vm_space_page_fault(child, KTEST_USER_ADDR,
+                                     VM_FAULT_PRESENT | VM_FAULT_WRITE),
+                 E_SUCCESS);
+    struct page * copy = rmap_test_page(child);
+    assert_not_equal(copy, page);
+    assert_equal(rmap_count(page), 1);
+    assert_equal(rmap_count(copy), 1);
+
+    vm_space_put(child);
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest rmap_test_untracked(ktest_unit_t * ktest) {
+    /* Shared pages are never tracked */
+    struct vm_space * space = rmap_test_space(VM_MAP_READ | VM_MAP_WRITE |
+                                              VM_MAP_SHARED);
+    assert_equal(vm_space_page_fault(space, KTEST_USER_ADDR, VM_FAULT_WRITE),
+                 E_SUCCESS);
+    struct page * page = rmap_test_page(space);
+    assert(!TEST_BIT(page->flags, PF_LRU));
+    assert_equal(rmap_count(page), 0);
+    vm_space_put(space);
+
+    /* Nor is the zero page, mapped by a read of untouched memory */
+    space = rmap_test_space(VM_MAP_READ | VM_MAP_WRITE);
+    assert_equal(vm_space_page_fault(space, KTEST_USER_ADDR, 0), E_SUCCESS);
+    assert_equal(rmap_test_page(space), vm_zero_page);
+    assert_equal(rmap_count(vm_zero_page), 0);
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("rmap-test-fault", rmap_test_fault),
+    KTEST_UNIT("rmap-test-fork", rmap_test_fork),
+    KTEST_UNIT("rmap-test-untracked", rmap_test_untracked),
+};
+
+KTEST_MODULE_DEFINE("rmap", test_units,
+                    rmap_pre_module,
+                    rmap_post_module,
+                    rmap_pre_test,
+                    rmap_post_test);
+
+/* ------------------------------------------------------------------------- */
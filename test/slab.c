@@ -0,0 +1,120 @@
+/*
+ * kernel/test/slab.c
+ * Slab Allocator Testing
+ */
+
+#include <rotary/test/slab.h>
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest slab_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest slab_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest slab_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest slab_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest slab_test_cache_stats(ktest_unit_t * ktest) {
+    slab_cache_t * cache = slab_cache_create("test-stats", 40, 0,
+                                             SLAB_NO_MERGE);
+    assert_not_equal(cache, NULL);
+
+    void * obj1 = slab_malloc(cache, 0);
+    void * obj2 = slab_malloc(cache, 0);
+    assert_equal(cache->active_objects, 2);
+    assert_equal(cache->alloc_total, 2);
+    assert_equal(cache->slab_count, 1);
+    assert_equal(cache->alloc_count, 1U << SLAB_DEFAULT_ORDER);
+    assert(cache->total_objects > 2);
+
+    slab_free(cache, obj1);
+    assert_equal(cache->active_objects, 1);
+    assert_equal(cache->free_total, 1);
+
+    slab_free(cache, obj2);
+    slab_cache_destroy(cache);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest slab_test_cache_merge(ktest_unit_t * ktest) {
+    slab_cache_t * root  = slab_cache_create("test-root", 40, 0, 0);
+    slab_cache_t * alias = slab_cache_create("test-alias", 38, 0, 0);
+    slab_cache_t * other = slab_cache_create("test-other", 40, 0,
+                                             SLAB_NO_MERGE);
+
+    /* Compatible caches share the root, unmergeable caches don't */
+    assert_equal(alias->root, root);
+    assert_equal(root->refcount, 2);
+    assert_equal(other->root, NULL);
+
+    /* Alias allocations come from the root's slabs, with separate stats */
+    void * obj = slab_malloc(alias, 0);
+    assert_not_equal(obj, NULL);
+    assert_equal(slab_cache_has_addr(root, obj), 1);
+    assert_equal(alias->active_objects, 1);
+    assert_equal(root->active_objects, 1);
+    assert_equal(alias->slab_count, 0);
+
+    slab_free(alias, obj);
+    assert_equal(alias->active_objects, 0);
+    assert_equal(root->active_objects, 0);
+
+    slab_cache_destroy(alias);
+    assert_equal(root->refcount, 1);
+    slab_cache_destroy(root);
+    slab_cache_destroy(other);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest slab_test_cache_align(ktest_unit_t * ktest) {
+    slab_cache_t * cache = slab_cache_create("test-align", 24, 64,
+                                             SLAB_NO_MERGE);
+    assert_equal(cache->object_size, 64);
+
+    void * obj = slab_malloc(cache, 0);
+    assert_equal((uintptr_t)obj % 64, 0);
+
+    slab_free(cache, obj);
+    slab_cache_destroy(cache);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("slab-test-cache-stats", slab_test_cache_stats),
+    KTEST_UNIT("slab-test-cache-merge", slab_test_cache_merge),
+    KTEST_UNIT("slab-test-cache-align", slab_test_cache_align),
+};
+
+KTEST_MODULE_DEFINE("slab", test_units,
+                    slab_pre_module,
+                    slab_post_module,
+                    slab_pre_test,
+                    slab_post_test);
+
+/* ------------------------------------------------------------------------- */
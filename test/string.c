@@ -10,22 +10,22 @@
 /* Test Set-up and Clean-up                                                  */
 /* ------------------------------------------------------------------------- */
 
-int32_t string_pre_module(ktest_module_t * module) {
+int32_t __ktest string_pre_module(ktest_module_t * module) {
     /* Any setup before the module tests run */
     return 0;
 }
 
-int32_t string_post_module(ktest_module_t * module) {
+int32_t __ktest string_post_module(ktest_module_t * module) {
     /* Any cleanup after the module tests run */
     return 0;
 }
 
-int32_t string_pre_test(ktest_module_t * module) {
+int32_t __ktest string_pre_test(ktest_module_t * module) {
     /* Any setup before each test */
     return 0;
 }
 
-int32_t string_post_test(ktest_module_t * module) {
+int32_t __ktest string_post_test(ktest_module_t * module) {
     /* Any cleanup after each test */
     return 0;
 }
@@ -34,7 +34,7 @@ int32_t string_post_test(ktest_module_t * module) {
 /* Unit Tests                                                                */
 /* ------------------------------------------------------------------------- */
 
-void string_test_memset(ktest_unit_t * ktest) {
+void __ktest string_test_memset(ktest_unit_t * ktest) {
     char buffer[64];
 
     /* Fill with zero and test */
@@ -51,7 +51,7 @@ void string_test_memset(ktest_unit_t * ktest) {
     assert_filled(buffer + sizeof(buffer) / 2, sizeof(buffer) / 2, 0x00);
 }
 
-void string_test_memcpy(ktest_unit_t * ktest) {
+void __ktest string_test_memcpy(ktest_unit_t * ktest) {
     char src[128];
     char dst[128];
 
@@ -72,7 +72,22 @@ void string_test_memcpy(ktest_unit_t * ktest) {
     assert_filled(dst + sizeof(src) / 2, sizeof(src) / 2, 'A');
 }
 
-void string_test_int_to_str(ktest_unit_t * ktest) {
+void __ktest string_test_memcmp(ktest_unit_t * ktest) {
+    char a[16];
+    char b[16];
+
+    memset(a, 'A', sizeof(a));
+    memset(b, 'A', sizeof(b));
+    assert_equal(memcmp(a, b, sizeof(a)), 0);
+
+    /* The first differing byte decides the order */
+    b[8] = 'B';
+    assert(memcmp(a, b, sizeof(a)) < 0);
+    assert(memcmp(b, a, sizeof(a)) > 0);
+    assert_equal(memcmp(a, b, 8), 0);
+}
+
+void __ktest string_test_int_to_str(ktest_unit_t * ktest) {
     char buffer[32];
     
     /* Test positive number */
@@ -88,7 +103,7 @@ void string_test_int_to_str(ktest_unit_t * ktest) {
     assert_equal(buffer, "-6789");
 }
 
-void string_test_uint_to_str(ktest_unit_t * ktest) {
+void __ktest string_test_uint_to_str(ktest_unit_t * ktest) {
     char buffer[32];
 
     /* Test zero */
@@ -104,7 +119,7 @@ void string_test_uint_to_str(ktest_unit_t * ktest) {
     assert_equal(buffer, "4294967295");
 }
 
-void string_test_int_to_hex_str(ktest_unit_t * ktest) {
+void __ktest string_test_int_to_hex_str(ktest_unit_t * ktest) {
     char buffer[16];
 
     /* Test zero */
@@ -120,7 +135,7 @@ void string_test_int_to_hex_str(ktest_unit_t * ktest) {
     assert_equal(buffer, "ffffffff");
 }
 
-void string_test_fill_buffer(ktest_unit_t * ktest) {
+void __ktest string_test_fill_buffer(ktest_unit_t * ktest) {
     char buffer[20] = {0};
     uint32_t index = 0;
 
@@ -136,7 +151,7 @@ void string_test_fill_buffer(ktest_unit_t * ktest) {
     }
 }
 
-void string_test_sprintf(ktest_unit_t * ktest) {
+void __ktest string_test_sprintf(ktest_unit_t * ktest) {
     char buffer[128];
 
     /* Test simple string without format specifiers */
@@ -166,9 +181,13 @@ void string_test_sprintf(ktest_unit_t * ktest) {
     /* Test combined specifiers */
     sprintf(buffer, "%s %d %u %x %c", "Mix", -5, 123, 0xF, 'Q');
     assert_equal(buffer, "Mix -5 123 f Q");
+
+    /* Test left-justified specifiers, padded with spaces */
+    sprintf(buffer, "[%-6s][%-4d][%-3x]", "ab", 42, 0xF);
+    assert_equal(buffer, "[ab    ][42  ][f  ]");
 }
 
-void string_test_strcmp(ktest_unit_t * ktest) {
+void __ktest string_test_strcmp(ktest_unit_t * ktest) {
     int rv = strcmp("EQUAL", "EQUAL");
     assert_equal(rv, 0);
 
@@ -182,14 +201,28 @@ void string_test_strcmp(ktest_unit_t * ktest) {
     assert_equal(rv, 0);
 }
 
-void string_test_strcpy(ktest_unit_t * ktest) {
+void __ktest string_test_strncmp(ktest_unit_t * ktest) {
+    int rv = strncmp("slabinfo", "slab", 4);
+    assert_equal(rv, 0);
+
+    rv = strncmp("ABC", "ABD", 3);
+    assert(rv < 0);
+
+    rv = strncmp("ABC", "ABD", 2);
+    assert_equal(rv, 0);
+
+    rv = strncmp("AB", "ABC", 3);
+    assert(rv < 0);
+}
+
+void __ktest string_test_strcpy(ktest_unit_t * ktest) {
     char src[] = "Copy this string";
     char dest[64] = {0};
     strcpy(dest, src);
     assert_equal(dest, src);
 }
 
-void string_test_strncpy(ktest_unit_t * ktest) {
+void __ktest string_test_strncpy(ktest_unit_t * ktest) {
     char src[] = "Source";
     char dest[16];
 
@@ -204,13 +237,13 @@ void string_test_strncpy(ktest_unit_t * ktest) {
     assert_equal(dest2, "Sou");
 }
 
-void string_test_strcat(ktest_unit_t * ktest) {
+void __ktest string_test_strcat(ktest_unit_t * ktest) {
     char buffer[64] = "Hello";
     strcat(buffer, " World");
     assert_equal(buffer, "Hello World");
 }
 
-void string_test_strlen(ktest_unit_t * ktest) {
+void __ktest string_test_strlen(ktest_unit_t * ktest) {
     int len = strlen("Test string");
     assert_equal(len, 11);
 
@@ -218,7 +251,7 @@ void string_test_strlen(ktest_unit_t * ktest) {
     assert_equal(len, 0);
 }
 
-void string_test_reverse(ktest_unit_t * ktest) {
+void __ktest string_test_reverse(ktest_unit_t * ktest) {
     char str1[] = "abcdef";
     reverse(str1, 6);
     assert_equal(str1, "fedcba");
@@ -228,7 +261,7 @@ void string_test_reverse(ktest_unit_t * ktest) {
     assert_equal(str2, "a");
 }
 
-void string_test_itoa(ktest_unit_t * ktest) {
+void __ktest string_test_itoa(ktest_unit_t * ktest) {
     char buffer[16];
 
     itoa(0, buffer);
@@ -241,7 +274,7 @@ void string_test_itoa(ktest_unit_t * ktest) {
     assert_equal(buffer, "987654321");
 }
 
-void string_test_atoi(ktest_unit_t * ktest) {
+void __ktest string_test_atoi(ktest_unit_t * ktest) {
     int value = atoi("12345");
     assert_equal(value, 12345);
 
@@ -255,7 +288,7 @@ void string_test_atoi(ktest_unit_t * ktest) {
     assert_equal(value, 0);
 }
 
-void string_test_format_size(ktest_unit_t * ktest) {
+void __ktest string_test_format_size(ktest_unit_t * ktest) {
     char buffer[32];
 
     /* Test for bytes less than 1024 */
@@ -275,15 +308,17 @@ void string_test_format_size(ktest_unit_t * ktest) {
 /* Test Registration                                                         */
 /* ------------------------------------------------------------------------- */
 
-static ktest_unit_t test_units[] = {
+static ktest_unit_t test_units[] __ktest_data = {
     KTEST_UNIT("string-test-memset", string_test_memset),
     KTEST_UNIT("string-test-memcpy", string_test_memcpy),
+    KTEST_UNIT("string-test-memcmp", string_test_memcmp),
     KTEST_UNIT("string-test-int-to-str", string_test_int_to_str),
     KTEST_UNIT("string-test-uint-to-str", string_test_uint_to_str),
     KTEST_UNIT("string-test-int-to-hex-str", string_test_int_to_hex_str),
     KTEST_UNIT("string-test-fill-buffer", string_test_fill_buffer),
     KTEST_UNIT("string-test-sprintf", string_test_sprintf),
     KTEST_UNIT("string-test-strcmp", string_test_strcmp),
+    KTEST_UNIT("string-test-strncmp", string_test_strncmp),
     KTEST_UNIT("string-test-strcpy", string_test_strcpy),
     KTEST_UNIT("string-test-strncpy", string_test_strncpy),
     KTEST_UNIT("string-test-strcat", string_test_strcat),
@@ -0,0 +1,206 @@
+/*
+ * kernel/test/swap.c
+ * Swap Testing
+ */
+
+#include <rotary/test/swap.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define SWAP_TEST_PAGES   16
+#define SWAP_TEST_PATTERN 0x5A
+
+/* The RAM disk swapped to, if swap wasn't already enabled */
+static struct block_device * swap_test_dev __ktest_data;
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest swap_pre_module(ktest_module_t * module) {
+    swap_test_dev = NULL;
+    if(swap_active()) {
+        return E_SUCCESS;
+    }
+
+    swap_test_dev = ramdisk_create("swaptest", SWAP_TEST_PAGES);
+    if(!swap_test_dev) {
+        return E_ERROR;
+    }
+
+    return swap_on(swap_test_dev);
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest swap_post_module(ktest_module_t * module) {
+    if(swap_test_dev) {
+        swap_off();
+        ramdisk_destroy(swap_test_dev);
+    }
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest swap_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest swap_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Create a space with a written, private page at KTEST_USER_ADDR */
+static struct vm_space * __ktest swap_test_space() {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+
+    map->start_addr = KTEST_USER_ADDR;
+    map->end_addr   = KTEST_USER_ADDR + PAGE_SIZE;
+    map->flags      = VM_MAP_READ | VM_MAP_WRITE;
+    vm_space_add_map(space, map);
+
+    vm_space_page_fault(space, KTEST_USER_ADDR, VM_FAULT_WRITE);
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR);
+    if(pte) {
+        void * virt_addr = kmap_atomic(PTE_PAGE(pte));
+        memset(virt_addr, SWAP_TEST_PATTERN, PAGE_SIZE);
+        kunmap_atomic(virt_addr);
+    }
+    return space;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Swap out the page at KTEST_USER_ADDR in a space, returning its slot */
+static uint32_t __ktest swap_test_out(struct vm_space * space) {
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR);
+
+    uint32_t eflags = cpu_irq_save();
+    int32_t rv = swap_out(PTE_PAGE(pte));
+    cpu_irq_restore(eflags);
+
+    pte = swap_get_pte(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR);
+    return SUCCESS(rv) && pte ? PTE_SWAP_SLOT(pte) : SWAP_SLOT_NONE;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest swap_test_slots(ktest_unit_t * ktest) {
+    uint32_t slot = swap_alloc();
+    assert_not_equal(slot, SWAP_SLOT_NONE);
+    assert_equal(swap_slot_uses(slot), 1);
+
+    swap_dup(slot);
+    assert_equal(swap_slot_uses(slot), 2);
+
+    swap_put(slot);
+    swap_put(slot);
+    assert_equal(swap_slot_uses(slot), 0);
+
+    /* The next allocation moves on, rather than reusing the slot freed */
+    uint32_t next = swap_alloc();
+    assert_not_equal(next, SWAP_SLOT_NONE);
+    assert_not_equal(next, slot);
+    swap_put(next);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest swap_test_out_in(ktest_unit_t * ktest) {
+    struct vm_space * space = swap_test_space();
+
+    /* The page is unmapped, and its entry refers to its slot */
+    uint32_t slot = swap_test_out(space);
+    assert_not_equal(slot, SWAP_SLOT_NONE);
+    assert_equal(swap_slot_uses(slot), 1);
+
+    /* Touching it again reads it back into a new page, freeing the slot */
+    assert_equal(vm_space_page_fault(space, KTEST_USER_ADDR, 0), E_SUCCESS);
+    assert_equal(swap_slot_uses(slot), 0);
+
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR);
+    assert(PTE_EXISTS(pte));
+    assert(PTE_IS_WRITABLE(pte));
+    assert_equal(rmap_count(PTE_PAGE(pte)), 1);
+
+    void * virt_addr = kmap_atomic(PTE_PAGE(pte));
+    assert_filled(virt_addr, PAGE_SIZE, SWAP_TEST_PATTERN);
+    kunmap_atomic(virt_addr);
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest swap_test_fork(ktest_unit_t * ktest) {
+    struct vm_space * space = swap_test_space();
+    struct vm_space * child = vm_space_fork(space);
+
+    /* A page shared copy-on-write is swapped out of both spaces */
+    uint32_t slot = swap_test_out(space);
+    assert_not_equal(slot, SWAP_SLOT_NONE);
+    assert_equal(swap_slot_uses(slot), 2);
+    assert_not_equal(swap_get_pte(PHY_TO_VIR(child->pgd), KTEST_USER_ADDR),
+                     NULL);
+
+    /* Each faults in a copy of its own */
+    assert_equal(vm_space_page_fault(child, KTEST_USER_ADDR, VM_FAULT_WRITE),
+                 E_SUCCESS);
+    assert_equal(swap_slot_uses(slot), 1);
+
+    /* Freeing the other space releases the slot */
+    vm_space_put(space);
+    assert_equal(swap_slot_uses(slot), 0);
+
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(child->pgd), KTEST_USER_ADDR);
+    void * virt_addr = kmap_atomic(PTE_PAGE(pte));
+    assert_filled(virt_addr, PAGE_SIZE, SWAP_TEST_PATTERN);
+    kunmap_atomic(virt_addr);
+
+    vm_space_put(child);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest swap_test_shared(ktest_unit_t * ktest) {
+    struct vm_space * space = swap_test_space();
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR);
+    struct page * page = PTE_PAGE(pte);
+
+    /* A page with a use outside its mappings can't be swapped out */
+    PAGE_INC_USES(page);
+    assert_equal(swap_test_out(space), SWAP_SLOT_NONE);
+    assert(PTE_EXISTS(pte));
+    PAGE_DEC_USES(page);
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("swap-test-slots", swap_test_slots),
+    KTEST_UNIT("swap-test-out-in", swap_test_out_in),
+    KTEST_UNIT("swap-test-fork", swap_test_fork),
+    KTEST_UNIT("swap-test-shared", swap_test_shared),
+};
+
+KTEST_MODULE_DEFINE("swap", test_units,
+                    swap_pre_module,
+                    swap_post_module,
+                    swap_pre_test,
+                    swap_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,198 @@
+/*
+ * kernel/test/tlb.c
+ * Batched TLB Invalidation Testing
+ */
+
+#include <rotary/test/tlb.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* A user address at the start of a page table, unused by the test PGDs */
+#define TLB_TEST_ADDR ((void*)0x40000000)
+
+/* Enough pages to fill every page table they take, 4MB */
+#define TLB_TEST_LARGE_PAGES 1024
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest tlb_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest tlb_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest tlb_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest tlb_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Map count newly allocated pages into a PGD from TLB_TEST_ADDR */
+static void __ktest tlb_test_map(struct pgd * pgd, uint32_t count) {
+    for(uint32_t i = 0; i < count; i++) {
+        struct page * page = page_alloc(0, PR_KERNEL);
+        ptable_map(pgd, TLB_TEST_ADDR + i * PAGE_SIZE, PAGE_PA(page),
+                   VM_MAP_WRITE);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest tlb_test_inval_threshold(ktest_unit_t * ktest) {
+    struct tlb_gather tlb;
+    tlb_gather_init(&tlb, paging_kernel_pgd());
+
+    for(uint32_t i = 0; i < TLB_GATHER_INVAL_MAX; i++) {
+        tlb_gather_inval(&tlb, TLB_TEST_ADDR + i * PAGE_SIZE);
+    }
+    assert_equal(tlb.inval_count, TLB_GATHER_INVAL_MAX);
+    assert_equal(tlb.flush_all, 0);
+
+    /* One more address switches to a full flush */
+    tlb_gather_inval(&tlb, TLB_TEST_ADDR);
+    assert_equal(tlb.flush_all, 1);
+
+    tlb_gather_finish(&tlb);
+    assert_equal(tlb.inval_count, 0);
+
+    /* Later batches of the same gather are flushed in full too */
+    tlb_gather_inval(&tlb, TLB_TEST_ADDR);
+    assert_equal(tlb.flush_all, 1);
+    assert_equal(tlb.inval_total, TLB_GATHER_INVAL_MAX + 2);
+    tlb_gather_finish(&tlb);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest tlb_test_unmap_frees_table(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    tlb_test_map(pgd, 4);
+
+    struct pde * pde = GET_PDE(pgd, TLB_TEST_ADDR);
+    struct page * pgt_page = VA_PAGE(PDE_TO_PGT(pde));
+    struct page * page = PA_PAGE(PTE_PA(ptable_get_pte(pgd, TLB_TEST_ADDR)));
+
+    struct tlb_gather tlb;
+    tlb_gather_init(&tlb, pgd);
+    ptable_unmap_range(&tlb, TLB_TEST_ADDR, 4, 1);
+
+    /* Nothing is freed until the batch is finished */
+    assert_equal(page->use_count, 1);
+    assert_equal(tlb.page_count, 5);
+
+    tlb_gather_finish(&tlb);
+    assert_equal(tlb.pages_freed, 5);
+    assert_equal(tlb.tables_freed, 1);
+    assert_equal(page->use_count, 0);
+    assert_equal(pgt_page->use_count, 0);
+    assert(!PDE_EXISTS(pde));
+
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest tlb_test_unmap_partial(ktest_unit_t * ktest) {
+    struct pgd * pgd = ptable_pgd_new();
+    tlb_test_map(pgd, 2);
+
+    /* The table still holds a mapping, so is kept */
+    ptable_unmap_many(pgd, TLB_TEST_ADDR, 1, 1);
+    assert(PDE_EXISTS(GET_PDE(pgd, TLB_TEST_ADDR)));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, TLB_TEST_ADDR)));
+    assert(PTE_EXISTS(ptable_get_pte(pgd, TLB_TEST_ADDR + PAGE_SIZE)));
+
+    ptable_unmap_many(pgd, TLB_TEST_ADDR + PAGE_SIZE, 1, 1);
+    assert(!PDE_EXISTS(GET_PDE(pgd, TLB_TEST_ADDR)));
+
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest tlb_test_unmap_batches(ktest_unit_t * ktest) {
+    uint32_t count = TLB_GATHER_PAGES * 2 + 3;
+    struct pgd * pgd = ptable_pgd_new();
+    tlb_test_map(pgd, count);
+
+    /* Pages beyond a full batch are freed in further batches */
+    struct tlb_gather tlb;
+    tlb_gather_init(&tlb, pgd);
+    ptable_unmap_range(&tlb, TLB_TEST_ADDR, count, 1);
+    assert(tlb.pages_freed >= TLB_GATHER_PAGES * 2);
+
+    tlb_gather_finish(&tlb);
+    assert_equal(tlb.pages_freed, count + 1);
+    assert_equal(tlb.tables_freed, 1);
+
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest tlb_test_unmap_full_flush(ktest_unit_t * ktest) {
+    uint32_t count = TLB_TEST_LARGE_PAGES;
+    struct pgd * pgd = ptable_pgd_new();
+    tlb_test_map(pgd, count);
+
+    /* The PGD must be loaded for its entries to need invalidating at all */
+    uint32_t eflags = cpu_irq_save();
+    void * prev_pgd = paging_current_pgd();
+    paging_load_pgd(VIR_TO_PHY(pgd));
+
+    struct tlb_gather tlb;
+    tlb_gather_init(&tlb, pgd);
+    ptable_unmap_range(&tlb, TLB_TEST_ADDR, count, 1);
+    tlb_gather_finish(&tlb);
+
+    paging_load_pgd(prev_pgd);
+    cpu_irq_restore(eflags);
+
+    /* Only the first batch is invalidated page by page, and every later one
+     * with a single reload */
+    uint32_t batches = (tlb.pages_freed + TLB_GATHER_PAGES - 1) /
+                       TLB_GATHER_PAGES;
+    assert_equal(tlb.pages_freed, count + count / PAGE_TABLE_SIZE);
+    assert_equal(tlb.full_flushes, batches - 1);
+    assert_equal(tlb.flush_all, 1);
+
+    ptable_pgd_free(pgd);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("tlb-test-inval-threshold", tlb_test_inval_threshold),
+    KTEST_UNIT("tlb-test-unmap-frees-table", tlb_test_unmap_frees_table),
+    KTEST_UNIT("tlb-test-unmap-partial", tlb_test_unmap_partial),
+    KTEST_UNIT("tlb-test-unmap-batches", tlb_test_unmap_batches),
+    KTEST_UNIT("tlb-test-unmap-full-flush", tlb_test_unmap_full_flush),
+};
+
+KTEST_MODULE_DEFINE("tlb", test_units,
+                    tlb_pre_module,
+                    tlb_post_module,
+                    tlb_pre_test,
+                    tlb_post_test);
+
+/* ------------------------------------------------------------------------- */
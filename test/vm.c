@@ -9,33 +9,50 @@
 /* Test Set-up and Clean-up                                                  */
 /* ------------------------------------------------------------------------- */
 
-int32_t vm_pre_module(ktest_module_t * module) {
+int32_t __ktest vm_pre_module(ktest_module_t * module) {
     return 0;
 }
 
 /* ------------------------------------------------------------------------- */
 
-int32_t vm_post_module(ktest_module_t * module) {
+int32_t __ktest vm_post_module(ktest_module_t * module) {
     return 0;
 }
 
 /* ------------------------------------------------------------------------- */
 
-int32_t vm_pre_test(ktest_module_t * module) {
+int32_t __ktest vm_pre_test(ktest_module_t * module) {
     return 0;
 }
 
 /* ------------------------------------------------------------------------- */
 
-int32_t vm_post_test(ktest_module_t * module) {
+int32_t __ktest vm_post_test(ktest_module_t * module) {
     return 0;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Add a mapping of pages [first, last) above a fixed address */
+static struct vm_map * __ktest vm_test_add(struct vm_space * space,
+                                           uint32_t first, uint32_t last,
+                                           flags_t flags) {
+    void * addr = (void*)0x40000000;
+    struct vm_map * map = vm_map_new();
+
+    map->start_addr = addr + first * PAGE_SIZE;
+    map->end_addr   = addr + last * PAGE_SIZE;
+    map->flags      = flags;
+    return vm_space_add_map(space, map);
+}
+
 /* ------------------------------------------------------------------------- */
 /* Unit Tests                                                                */
 /* ------------------------------------------------------------------------- */
 
-void vm_test_space_new(ktest_unit_t * ktest) {
+void __ktest vm_test_space_new(ktest_unit_t * ktest) {
     struct vm_space * space = vm_space_new();
     assert_not_equal(space, NULL);
     assert_not_equal(space->pgd, NULL);
@@ -43,31 +60,449 @@ void vm_test_space_new(ktest_unit_t * ktest) {
 
 /* ------------------------------------------------------------------------- */
 
-void vm_test_space_destroy(ktest_unit_t * ktest) {
+void __ktest vm_test_space_destroy(ktest_unit_t * ktest) {
     
 }
 
 /* ------------------------------------------------------------------------- */
 
-void vm_test_space_add_map(ktest_unit_t * ktest) {
+void __ktest vm_test_space_get_put(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    assert_not_equal(space, NULL);
+    assert_equal(space->users, 1);
+
+    assert_equal(vm_space_get(space), space);
+    assert_equal(space->users, 2);
+
+    vm_space_put(space);
+    assert_equal(space->users, 1);
+
+    /* Dropping the final reference destroys the address space */
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_space_fork(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+    void * addr = (void*)0x40000000;
+
+    map->space      = space;
+    map->start_addr = addr;
+    map->end_addr   = addr + 4 * PAGE_SIZE;
+    map->flags      = VM_MAP_READ | VM_MAP_WRITE;
+    vm_space_add_map(space, map);
+
+    assert_equal(vm_space_page_fault(space, addr, VM_FAULT_WRITE),
+                 E_SUCCESS);
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd), addr);
+    assert(PTE_IS_WRITABLE(pte));
+
+    /* The child has its own copy of the mapping, sharing the page */
+    struct vm_space * child = vm_space_fork(space);
+    assert_not_equal(child, NULL);
+    assert_not_equal(child->mappings.next, NULL);
+    assert_not_equal(child->mappings.next, &map->list_node);
+
+    struct pte * child_pte = ptable_get_pte(PHY_TO_VIR(child->pgd), addr);
+    assert(child_pte->entry == pte->entry);
+    assert(!PTE_IS_WRITABLE(pte));
+
+    /* A write by the child copies the page */
+    assert_equal(vm_space_page_fault(child, addr, VM_FAULT_PRESENT |
+                                                  VM_FAULT_WRITE), E_SUCCESS);
+    assert(PTE_IS_WRITABLE(child_pte));
+    assert_not_equal(PTE_PFN(child_pte), PTE_PFN(pte));
+
+    /* A read of a present page is never resolved */
+    assert_equal(vm_space_page_fault(child, addr, VM_FAULT_PRESENT),
+                 E_ERROR);
+
+    vm_space_put(child);
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_fault_around(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * addr = (void*)0x40000000;
+
+    /* The mapping ends part way through the second window */
+    map->space      = space;
+    map->start_addr = addr;
+    map->end_addr   = addr + 20 * PAGE_SIZE;
+    map->flags      = VM_MAP_READ | VM_MAP_WRITE;
+    vm_space_add_map(space, map);
+
+    vm_set_fault_around(16);
+    assert_equal(vm_space_page_fault(space, addr + 5 * PAGE_SIZE, 0),
+                 E_SUCCESS);
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr)));
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr + 15 * PAGE_SIZE)));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 16 * PAGE_SIZE)));
+
+    assert_equal(vm_space_page_fault(space, addr + 16 * PAGE_SIZE, 0),
+                 E_SUCCESS);
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr + 19 * PAGE_SIZE)));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 20 * PAGE_SIZE)));
+
+    /* Without fault-around, only the faulting page is mapped */
+    vm_set_fault_around(0);
+    map->end_addr = addr + 40 * PAGE_SIZE;
+    assert_equal(vm_space_page_fault(space, addr + 32 * PAGE_SIZE, 0),
+                 E_SUCCESS);
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 33 * PAGE_SIZE)));
+
+    vm_set_fault_around(VM_FAULT_AROUND_DEFAULT);
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_zero_page(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * addr = (void*)0x40000000;
+    uint32_t uses = vm_zero_page->use_count;
+
+    map->space      = space;
+    map->start_addr = addr;
+    map->end_addr   = addr + 2 * PAGE_SIZE;
+    map->flags      = VM_MAP_READ | VM_MAP_WRITE;
+    vm_space_add_map(space, map);
 
+    /* A read maps the zero page read-only, allocating nothing */
+    assert_equal(vm_space_page_fault(space, addr, 0), E_SUCCESS);
+    struct pte * pte = ptable_get_pte(pgd, addr);
+    assert_equal(PTE_PAGE(pte), vm_zero_page);
+    assert(!PTE_IS_WRITABLE(pte));
+    assert_equal(vm_zero_page->use_count, uses + 2);
+
+    /* The first write takes a private, zeroed page */
+    assert_equal(vm_space_page_fault(space, addr, VM_FAULT_PRESENT |
+                                                  VM_FAULT_WRITE), E_SUCCESS);
+    assert_not_equal(PTE_PAGE(pte), vm_zero_page);
+    assert(PTE_IS_WRITABLE(pte));
+    assert_equal(vm_zero_page->use_count, uses + 1);
+
+    void * virt_addr = kmap_atomic(PTE_PAGE(pte));
+    assert_clear(virt_addr, PAGE_SIZE);
+    kunmap_atomic(virt_addr);
+
+    /* Tearing down the address space releases the rest of its uses */
+    vm_space_put(space);
+    assert_equal(vm_zero_page->use_count, uses);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void vm_test_space_delete_map(ktest_unit_t * ktest) {
+void __ktest vm_test_populate(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * map = vm_map_new();
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * addr = (void*)0x40000000;
+
+    map->space      = space;
+    map->start_addr = addr + PAGE_SIZE;
+    map->end_addr   = addr + 64 * PAGE_SIZE;
+    map->flags      = VM_MAP_READ | VM_MAP_POPULATE;
+    vm_space_add_map(space, map);
+
+    /* Every page is mapped without a fault, and nothing outside */
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr)));
+    for(uint32_t i = 1; i < 64; i++) {
+        struct pte * pte = ptable_get_pte(pgd, addr + i * PAGE_SIZE);
+        assert(PTE_EXISTS(pte));
+        assert(!PTE_IS_WRITABLE(pte));
+    }
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 64 * PAGE_SIZE)));
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_space_kernel(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_kernel();
+    assert_equal(space->pgd, VIR_TO_PHY(paging_kernel_pgd()));
+    assert_not_equal(space->users, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_space_add_map(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    flags_t rw = VM_MAP_READ | VM_MAP_WRITE;
+
+    /* Mappings are kept in address order, whatever order they're added in */
+    struct vm_map * high = vm_test_add(space, 8, 12, rw);
+    struct vm_map * low  = vm_test_add(space, 0, 2, rw);
+    struct vm_map * ro   = vm_test_add(space, 4, 6, VM_MAP_READ);
+    assert_equal(space->map_count, 3);
+    assert_equal(vm_map_next(low), ro);
+    assert_equal(vm_map_next(ro), high);
+    assert_equal(vm_map_next(high), NULL);
+
+    /* Filling a gap between mappings with the same flags merges all three */
+    assert_equal(vm_test_add(space, 2, 4, rw), low);
+    assert_equal(low->end_addr, ro->start_addr);
+    assert_equal(vm_test_add(space, 6, 8, VM_MAP_READ), ro);
+    assert_equal(space->map_count, 3);
+
+    assert_equal(vm_test_add(space, 12, 16, rw), high);
+    assert_equal(high->end_addr, (void*)0x40000000 + 16 * PAGE_SIZE);
+    assert_equal(space->map_count, 3);
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_space_delete_map(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct vm_map * first  = vm_test_add(space, 0, 2, VM_MAP_READ);
+    struct vm_map * second = vm_test_add(space, 4, 6, VM_MAP_READ);
+
+    /* A deleted mapping is no longer found, even if it was cached */
+    assert_equal(vm_map_find(space, second->start_addr), second);
+    vm_space_delete_map(space, second);
+    vm_map_destroy(second);
+    assert_equal(vm_map_find(space, (void*)0x40000000 + 4 * PAGE_SIZE),
+                 NULL);
+    assert_equal(vm_map_next(first), NULL);
+    assert_equal(space->map_count, 1);
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_map_find(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    void * addr = (void*)0x40000000;
+    struct vm_map * maps[32];
+
+    /* Alternate flags, so that neighbours aren't merged */
+    for(uint32_t i = 0; i < 32; i++) {
+        maps[i] = vm_test_add(space, 2 * i, 2 * i + 1,
+                              i % 2 ? VM_MAP_READ : VM_MAP_READ | VM_MAP_EXEC);
+    }
+    assert_equal(space->map_count, 32);
+    assert(space->map_tree->height <= 7);
+
+    for(uint32_t i = 0; i < 32; i++) {
+        void * start = addr + 2 * i * PAGE_SIZE;
+        assert_equal(vm_map_find(space, start), maps[i]);
+        assert_equal(vm_map_find(space, start + PAGE_SIZE - 1), maps[i]);
+        assert_equal(space->map_cache, maps[i]);
+
+        /* The gap after each mapping is unmapped */
+        assert_equal(vm_map_find(space, start + PAGE_SIZE), NULL);
+    }
+    assert_equal(vm_map_find(space, addr - 1), NULL);
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_space_unmap(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * addr = (void*)0x40000000;
+    struct vm_map * map = vm_test_add(space, 0, 8, VM_MAP_READ | VM_MAP_WRITE);
+
+    /* Fault-around maps every page of the mapping */
+    vm_space_page_fault(space, addr, VM_FAULT_WRITE);
+
+    /* Unmapping the middle splits the mapping in two */
+    assert_equal(vm_space_unmap(space, addr + 2 * PAGE_SIZE,
+                                addr + 5 * PAGE_SIZE), E_SUCCESS);
+    assert_equal(space->map_count, 2);
+    assert_equal(map->end_addr, addr + 2 * PAGE_SIZE);
+
+    struct vm_map * tail = vm_map_next(map);
+    assert_equal(tail->start_addr, addr + 5 * PAGE_SIZE);
+    assert_equal(tail->end_addr, addr + 8 * PAGE_SIZE);
+    assert_equal(tail->flags, map->flags);
+
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr + PAGE_SIZE)));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 2 * PAGE_SIZE)));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 4 * PAGE_SIZE)));
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr + 5 * PAGE_SIZE)));
+    assert_equal(vm_space_page_fault(space, addr + 3 * PAGE_SIZE, 0),
+                 E_ERROR);
+
+    /* A range covering both removes them */
+    assert_equal(vm_space_unmap(space, addr, addr + 8 * PAGE_SIZE),
+                 E_SUCCESS);
+    assert_equal(space->map_count, 0);
+    assert_equal(space->map_tree, NULL);
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_space_protect(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * addr = (void*)0x40000000;
+    struct vm_map * map = vm_test_add(space, 0, 8, VM_MAP_READ | VM_MAP_WRITE);
+
+    vm_space_page_fault(space, addr + 3 * PAGE_SIZE, VM_FAULT_WRITE);
+    assert(PTE_IS_WRITABLE(ptable_get_pte(pgd, addr + 3 * PAGE_SIZE)));
+
+    /* Write protecting the middle splits the mapping in three */
+    assert_equal(vm_space_protect(space, addr + 2 * PAGE_SIZE,
+                                  addr + 4 * PAGE_SIZE, VM_MAP_READ),
+                 E_SUCCESS);
+    assert_equal(space->map_count, 3);
+    assert(!PTE_IS_WRITABLE(ptable_get_pte(pgd, addr + 3 * PAGE_SIZE)));
+
+    struct vm_map * middle = vm_map_find(space, addr + 3 * PAGE_SIZE);
+    assert_equal(middle->flags, VM_MAP_READ);
+    assert_equal(middle->start_addr, addr + 2 * PAGE_SIZE);
+    assert_equal(vm_space_page_fault(space, addr + 3 * PAGE_SIZE,
+                                     VM_FAULT_PRESENT | VM_FAULT_WRITE),
+                 E_ERROR);
+
+    /* Restoring the protection merges them back together */
+    assert_equal(vm_space_protect(space, addr + 2 * PAGE_SIZE,
+                                  addr + 4 * PAGE_SIZE,
+                                  VM_MAP_READ | VM_MAP_WRITE), E_SUCCESS);
+    assert_equal(space->map_count, 1);
+    assert_equal(map->end_addr, addr + 8 * PAGE_SIZE);
+    assert(PTE_IS_WRITABLE(ptable_get_pte(pgd, addr + 3 * PAGE_SIZE)));
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_madvise_hints(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * addr = (void*)0x40000000;
+    vm_test_add(space, 0, 256, VM_MAP_READ | VM_MAP_WRITE);
+
+    /* Each hinted range becomes a mapping of its own */
+    assert_equal(vm_space_madvise(space, addr, addr + 64 * PAGE_SIZE,
+                                  VM_MADV_RANDOM), E_SUCCESS);
+    assert_equal(vm_space_madvise(space, addr + 64 * PAGE_SIZE,
+                                  addr + 192 * PAGE_SIZE,
+                                  VM_MADV_SEQUENTIAL), E_SUCCESS);
+    assert_equal(space->map_count, 3);
+
+    /* Random access maps only the page that faulted */
+    vm_set_fault_around(16);
+    assert_equal(vm_space_page_fault(space, addr + 5 * PAGE_SIZE,
+                                     VM_FAULT_WRITE), E_SUCCESS);
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr + 5 * PAGE_SIZE)));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 4 * PAGE_SIZE)));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 6 * PAGE_SIZE)));
+
+    /* Sequential access maps further ahead, and nothing behind */
+    void * fault_addr = addr + 70 * PAGE_SIZE;
+    uint32_t ahead = 16 * VM_FAULT_AHEAD_FACTOR;
+    assert_equal(vm_space_page_fault(space, fault_addr, VM_FAULT_WRITE),
+                 E_SUCCESS);
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, fault_addr - PAGE_SIZE)));
+    assert(PTE_EXISTS(ptable_get_pte(pgd,
+                                     fault_addr + (ahead - 1) * PAGE_SIZE)));
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, fault_addr + ahead * PAGE_SIZE)));
+
+    /* Clearing the hints merges the mappings back together */
+    assert_equal(vm_space_madvise(space, addr, addr + 256 * PAGE_SIZE,
+                                  VM_MADV_NORMAL), E_SUCCESS);
+    assert_equal(space->map_count, 1);
+
+    assert_equal(vm_space_madvise(space, addr, addr + PAGE_SIZE, 99),
+                 E_ERROR);
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_madvise_willneed(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * addr = (void*)0x40000000;
+    vm_test_add(space, 0, 32, VM_MAP_READ | VM_MAP_WRITE);
+
+    /* The range is mapped up front, without splitting the mapping */
+    assert_equal(vm_space_madvise(space, addr + 4 * PAGE_SIZE,
+                                  addr + 12 * PAGE_SIZE, VM_MADV_WILLNEED),
+                 E_SUCCESS);
+    assert_equal(space->map_count, 1);
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 3 * PAGE_SIZE)));
+    for(uint32_t i = 4; i < 12; i++) {
+        assert(PTE_EXISTS(ptable_get_pte(pgd, addr + i * PAGE_SIZE)));
+    }
+    assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + 12 * PAGE_SIZE)));
+
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest vm_test_madvise_dontneed(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct pgd * pgd = PHY_TO_VIR(space->pgd);
+    void * addr = (void*)0x40000000;
+    vm_test_add(space, 0, 16, VM_MAP_READ | VM_MAP_WRITE | VM_MAP_POPULATE);
+
+    struct pte * pte = ptable_get_pte(pgd, addr + 2 * PAGE_SIZE);
+    assert(PTE_EXISTS(pte));
+    void * virt_addr = kmap_atomic(PTE_PAGE(pte));
+    memset(virt_addr, 0xAB, PAGE_SIZE);
+    kunmap_atomic(virt_addr);
+
+    /* The pages are freed at once, and the mapping is left whole */
+    uint32_t free_pages = page_free_count();
+    assert_equal(vm_space_madvise(space, addr, addr + 8 * PAGE_SIZE,
+                                  VM_MADV_DONTNEED), E_SUCCESS);
+    assert(page_free_count() >= free_pages + 8);
+    assert_equal(space->map_count, 1);
+    for(uint32_t i = 0; i < 8; i++) {
+        assert(!PTE_EXISTS(ptable_get_pte(pgd, addr + i * PAGE_SIZE)));
+    }
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr + 8 * PAGE_SIZE)));
+
+    /* The next touch reads zeroes */
+    assert_equal(vm_space_page_fault(space, addr + 2 * PAGE_SIZE,
+                                     VM_FAULT_WRITE), E_SUCCESS);
+    pte = ptable_get_pte(pgd, addr + 2 * PAGE_SIZE);
+    virt_addr = kmap_atomic(PTE_PAGE(pte));
+    assert_clear(virt_addr, PAGE_SIZE);
+    kunmap_atomic(virt_addr);
+
+    /* Shared memory would lose its contents, so is refused */
+    vm_test_add(space, 32, 40, VM_MAP_READ | VM_MAP_WRITE | VM_MAP_SHARED |
+                               VM_MAP_POPULATE);
+    assert_equal(vm_space_madvise(space, addr, addr + 40 * PAGE_SIZE,
+                                  VM_MADV_DONTNEED), E_ERROR);
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr + 8 * PAGE_SIZE)));
+    assert(PTE_EXISTS(ptable_get_pte(pgd, addr + 32 * PAGE_SIZE)));
 
+    vm_space_put(space);
 }
 
 /* ------------------------------------------------------------------------- */
 
-void vm_test_map_new(ktest_unit_t * ktest) {
+void __ktest vm_test_map_new(ktest_unit_t * ktest) {
 
 }
 
 /* ------------------------------------------------------------------------- */
 
-void vm_test_map_destroy(ktest_unit_t * ktest) {
+void __ktest vm_test_map_destroy(ktest_unit_t * ktest) {
 
 }
 
@@ -75,11 +510,23 @@ void vm_test_map_destroy(ktest_unit_t * ktest) {
 /* Test Registration                                                         */
 /* ------------------------------------------------------------------------- */
 
-static ktest_unit_t test_units[] = {
+static ktest_unit_t test_units[] __ktest_data = {
     KTEST_UNIT("vm-test-space-new", vm_test_space_new),
     KTEST_UNIT("vm-test-space-destroy", vm_test_space_destroy),
+    KTEST_UNIT("vm-test-space-get-put", vm_test_space_get_put),
+    KTEST_UNIT("vm-test-space-fork", vm_test_space_fork),
+    KTEST_UNIT("vm-test-fault-around", vm_test_fault_around),
+    KTEST_UNIT("vm-test-zero-page", vm_test_zero_page),
+    KTEST_UNIT("vm-test-populate", vm_test_populate),
+    KTEST_UNIT("vm-test-space-kernel", vm_test_space_kernel),
     KTEST_UNIT("vm-test-space-add-map", vm_test_space_add_map),
     KTEST_UNIT("vm-test-space-delete-map", vm_test_space_delete_map),
+    KTEST_UNIT("vm-test-map-find", vm_test_map_find),
+    KTEST_UNIT("vm-test-space-unmap", vm_test_space_unmap),
+    KTEST_UNIT("vm-test-space-protect", vm_test_space_protect),
+    KTEST_UNIT("vm-test-madvise-hints", vm_test_madvise_hints),
+    KTEST_UNIT("vm-test-madvise-willneed", vm_test_madvise_willneed),
+    KTEST_UNIT("vm-test-madvise-dontneed", vm_test_madvise_dontneed),
     KTEST_UNIT("vm-test-map-new", vm_test_map_new),
     KTEST_UNIT("vm-test-map-destroy", vm_test_map_destroy),
 };
@@ -0,0 +1,134 @@
+/*
+ * kernel/test/wss.c
+ * Working Set Estimation Testing
+ */
+
+#include <rotary/test/wss.h>
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest wss_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest wss_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest wss_pre_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest wss_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Map count newly allocated pages into a space from KTEST_USER_ADDR */
+static void __ktest wss_test_map(struct vm_space * space, uint32_t count) {
+    for(uint32_t i = 0; i < count; i++) {
+        struct page * page = page_alloc(0, PR_KERNEL);
+        ptable_map(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR + i * PAGE_SIZE,
+                   PAGE_PA(page), VM_MAP_WRITE);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Set bits in the entry mapping the idx'th test page, as the CPU would */
+static struct pte * __ktest wss_test_touch(struct vm_space * space,
+                                           uint32_t idx, uint32_t bits) {
+    struct pte * pte = ptable_get_pte(PHY_TO_VIR(space->pgd),
+                                      KTEST_USER_ADDR + idx * PAGE_SIZE);
+    pte->entry |= bits;
+    return pte;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest wss_test_harvest(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct wss_scan scan;
+    wss_test_map(space, 3);
+
+    struct pte * read  = wss_test_touch(space, 0, PTE_ACCESSED);
+    struct pte * write = wss_test_touch(space, 1, PTE_ACCESSED | PTE_DIRTY);
+    CLEAR_BIT(PTE_PAGE(write)->flags, PF_DIRTY);
+
+    wss_scan_space(space, &scan);
+    assert_equal(scan.rss_pages, 3);
+    assert_equal(scan.dirty_pages, 1);
+    assert_equal(space->rss_pages, 3);
+
+    /* The bits are cleared, with the dirty bit kept on the page */
+    assert(!(read->entry & (PTE_ACCESSED | PTE_DIRTY)));
+    assert(!(write->entry & (PTE_ACCESSED | PTE_DIRTY)));
+    assert(TEST_BIT(PTE_PAGE(write)->flags, PF_DIRTY));
+    assert(!TEST_BIT(PTE_PAGE(read)->flags, PF_DIRTY));
+    assert_equal(wss_page_age(PTE_PAGE(read)), 0);
+
+    /* Nothing was touched since, so nothing is newly dirty */
+    wss_scan_space(space, &scan);
+    assert_equal(scan.dirty_pages, 0);
+
+    ptable_unmap_many(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR, 3, 1);
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest wss_test_aging(ktest_unit_t * ktest) {
+    struct vm_space * space = vm_space_new();
+    struct wss_scan scan;
+    wss_test_map(space, 2);
+
+    wss_test_touch(space, 0, PTE_ACCESSED);
+    struct pte * idle = wss_test_touch(space, 1, PTE_ACCESSED);
+    wss_scan_space(space, &scan);
+    assert_equal(scan.wss_pages, 2);
+
+    /* Only the first page stays in use as the generations pass */
+    for(uint32_t i = 0; i < WSS_WINDOW; i++) {
+        wss_generation++;
+        wss_test_touch(space, 0, PTE_ACCESSED);
+        wss_scan_space(space, &scan);
+    }
+
+    assert_equal(wss_page_age(PTE_PAGE(idle)), WSS_WINDOW);
+    assert_equal(scan.rss_pages, 2);
+    assert_equal(scan.wss_pages, 1);
+    assert_equal(space->wss_pages, 1);
+
+    ptable_unmap_many(PHY_TO_VIR(space->pgd), KTEST_USER_ADDR, 2, 1);
+    vm_space_put(space);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("wss-test-harvest", wss_test_harvest),
+    KTEST_UNIT("wss-test-aging", wss_test_aging),
+};
+
+KTEST_MODULE_DEFINE("wss", test_units,
+                    wss_pre_module,
+                    wss_post_module,
+                    wss_pre_test,
+                    wss_post_test);
+
+/* ------------------------------------------------------------------------- */
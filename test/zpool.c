@@ -0,0 +1,113 @@
+/*
+ * kernel/test/zpool.c
+ * Compressed Object Pool Testing
+ */
+
+#include <rotary/test/zpool.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define ZPOOL_TEST_OBJECTS 64
+
+static struct zpool zpool_test_pool __ktest_data;
+static void * zpool_test_objects[ZPOOL_TEST_OBJECTS] __ktest_data;
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest zpool_pre_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest zpool_post_module(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest zpool_pre_test(ktest_module_t * module) {
+    zpool_init(&zpool_test_pool);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest zpool_post_test(ktest_module_t * module) {
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest zpool_test_pack(ktest_unit_t * ktest) {
+    struct zpool * pool = &zpool_test_pool;
+    uint32_t per_page = ZPOOL_MAX_SIZE / 1024;
+
+    /* Objects of one class share pages, without overlapping */
+    for(uint32_t i = 0; i < ZPOOL_TEST_OBJECTS; i++) {
+        zpool_test_objects[i] = zpool_alloc(pool, 1000);
+        assert_not_equal(zpool_test_objects[i], NULL);
+        memset(zpool_test_objects[i], i, 1000);
+    }
+    assert_equal(pool->objects, ZPOOL_TEST_OBJECTS);
+    assert_equal(pool->pages, (ZPOOL_TEST_OBJECTS + per_page - 1) / per_page);
+
+    for(uint32_t i = 0; i < ZPOOL_TEST_OBJECTS; i++) {
+        assert_filled(zpool_test_objects[i], 1000, i);
+        zpool_free(pool, zpool_test_objects[i], 1000);
+    }
+
+    /* Every page is given back once empty */
+    assert_equal(pool->objects, 0);
+    assert_equal(pool->pages, 0);
+    assert_equal(pool->bytes, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest zpool_test_classes(ktest_unit_t * ktest) {
+    struct zpool * pool = &zpool_test_pool;
+
+    /* Sizes in different classes take different pages */
+    void * small = zpool_alloc(pool, 40);
+    void * large = zpool_alloc(pool, 2000);
+    assert_not_equal(PAGE_ALIGN_DOWN(small), PAGE_ALIGN_DOWN(large));
+    assert_equal(pool->pages, 2);
+
+    /* While sizes that round up to the same class share one */
+    void * other = zpool_alloc(pool, 64);
+    assert_equal(PAGE_ALIGN_DOWN(other), PAGE_ALIGN_DOWN(small));
+
+    /* A freed object is the next one reused */
+    zpool_free(pool, small, 40);
+    assert_equal(zpool_alloc(pool, 50), small);
+
+    assert_equal(zpool_alloc(pool, 0), NULL);
+    assert_equal(zpool_alloc(pool, ZPOOL_MAX_SIZE + 1), NULL);
+
+    zpool_free(pool, small, 50);
+    zpool_free(pool, other, 64);
+    zpool_free(pool, large, 2000);
+    assert_equal(pool->pages, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("zpool-test-pack", zpool_test_pack),
+    KTEST_UNIT("zpool-test-classes", zpool_test_classes),
+};
+
+KTEST_MODULE_DEFINE("zpool", test_units,
+                    zpool_pre_module,
+                    zpool_post_module,
+                    zpool_pre_test,
+                    zpool_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -0,0 +1,166 @@
+/*
+ * kernel/test/zswap.c
+ * Compressed Swap Cache Testing
+ */
+
+#include <rotary/test/zswap.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define ZSWAP_TEST_PAGES 16
+
+/* The RAM disk swapped to, if swap wasn't already enabled */
+static struct block_device * zswap_test_dev __ktest_data;
+
+static struct page * zswap_test_src __ktest_data;
+static struct page * zswap_test_dst __ktest_data;
+
+/* ------------------------------------------------------------------------- */
+/* Test Set-up and Clean-up                                                  */
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest zswap_pre_module(ktest_module_t * module) {
+    zswap_test_dev = NULL;
+    if(swap_active()) {
+        return E_SUCCESS;
+    }
+
+    zswap_test_dev = ramdisk_create("zswaptest", ZSWAP_TEST_PAGES);
+    if(!zswap_test_dev) {
+        return E_ERROR;
+    }
+
+    return swap_on(zswap_test_dev);
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest zswap_post_module(ktest_module_t * module) {
+    if(zswap_test_dev) {
+        swap_off();
+        ramdisk_destroy(zswap_test_dev);
+    }
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest zswap_pre_test(ktest_module_t * module) {
+    zswap_test_src = page_alloc(0, PR_KERNEL);
+    zswap_test_dst = page_alloc(0, PR_KERNEL);
+    return zswap_test_src && zswap_test_dst ? E_SUCCESS : E_ERROR;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int32_t __ktest zswap_post_test(ktest_module_t * module) {
+    page_free(zswap_test_src, 0);
+    page_free(zswap_test_dst, 0);
+    return E_SUCCESS;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Helpers                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* Write the source page to a new slot and read it back into the destination,
+ * returning the slot, which the caller frees */
+static uint32_t __ktest zswap_test_round_trip() {
+    uint32_t slot = swap_alloc();
+    if(slot == SWAP_SLOT_NONE) {
+        return SWAP_SLOT_NONE;
+    }
+
+    memset(PAGE_VA(zswap_test_dst), 0xFF, PAGE_SIZE);
+    if(!SUCCESS(swap_write(slot, zswap_test_src)) ||
+       !SUCCESS(swap_read(slot, zswap_test_dst)) ||
+       memcmp(PAGE_VA(zswap_test_src), PAGE_VA(zswap_test_dst),
+              PAGE_SIZE) != 0) {
+        swap_put(slot);
+        return SWAP_SLOT_NONE;
+    }
+
+    return slot;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Unit Tests                                                                */
+/* ------------------------------------------------------------------------- */
+
+void __ktest zswap_test_same_filled(ktest_unit_t * ktest) {
+    uint32_t pages = zswap_pool.pages;
+    memset(PAGE_VA(zswap_test_src), 0, PAGE_SIZE);
+
+    /* A zero page is held without taking any of the pool */
+    uint32_t slot = zswap_test_round_trip();
+    assert_not_equal(slot, SWAP_SLOT_NONE);
+    assert(zswap_has(slot));
+    assert(zswap_entries[slot].type == ZSWAP_SAME);
+    assert_equal(zswap_pool.pages, pages);
+
+    /* Freeing the slot drops it */
+    swap_put(slot);
+    assert(!zswap_has(slot));
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest zswap_test_compressed(ktest_unit_t * ktest) {
+    uint8_t * src = PAGE_VA(zswap_test_src);
+    for(uint32_t i = 0; i < PAGE_SIZE; i++) {
+        src[i] = "compressed swap "[i % 16] + i / 256;
+    }
+
+    uint32_t slot = zswap_test_round_trip();
+    assert_not_equal(slot, SWAP_SLOT_NONE);
+    assert(zswap_has(slot));
+    assert(zswap_entries[slot].type == ZSWAP_COMPRESSED);
+    assert(zswap_entries[slot].length <= ZSWAP_MAX_SIZE);
+
+    /* The copy is kept for every entry sharing the slot */
+    memset(PAGE_VA(zswap_test_dst), 0, PAGE_SIZE);
+    assert_equal(swap_read(slot, zswap_test_dst), E_SUCCESS);
+    assert_equal(memcmp(src, PAGE_VA(zswap_test_dst), PAGE_SIZE), 0);
+
+    swap_put(slot);
+    assert(!zswap_has(slot));
+}
+
+/* ------------------------------------------------------------------------- */
+
+void __ktest zswap_test_incompressible(ktest_unit_t * ktest) {
+    uint32_t * src = PAGE_VA(zswap_test_src);
+    uint32_t seed = 1;
+
+    for(uint32_t i = 0; i < PAGE_SIZE / sizeof(uint32_t); i++) {
+        seed = seed * 1103515245 + 12345;
+        src[i] = seed;
+    }
+
+    /* zswap refuses the page, so it goes to the device */
+    uint32_t too_large = zswap_stats.too_large;
+    uint32_t slot = zswap_test_round_trip();
+    assert_not_equal(slot, SWAP_SLOT_NONE);
+    assert(!zswap_has(slot));
+    assert_equal(zswap_stats.too_large, too_large + 1);
+
+    swap_put(slot);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Test Registration                                                         */
+/* ------------------------------------------------------------------------- */
+
+static ktest_unit_t test_units[] __ktest_data = {
+    KTEST_UNIT("zswap-test-same-filled", zswap_test_same_filled),
+    KTEST_UNIT("zswap-test-compressed", zswap_test_compressed),
+    KTEST_UNIT("zswap-test-incompressible", zswap_test_incompressible),
+};
+
+KTEST_MODULE_DEFINE("zswap", test_units,
+                    zswap_pre_module,
+                    zswap_post_module,
+                    zswap_pre_test,
+                    zswap_post_test);
+
+/* ------------------------------------------------------------------------- */
@@ -15,3 +15,26 @@ static inline int write(int fd, const void *buf, unsigned int count) {
     );
     return ret;
 }
+
+/* Advice for madvise(), matching the kernel's VM_MADV_* values */
+#define MADV_NORMAL     0
+#define MADV_RANDOM     1
+#define MADV_SEQUENTIAL 2
+#define MADV_WILLNEED   3
+#define MADV_DONTNEED   4
+
+static inline int madvise(void *addr, unsigned int length, int advice) {
+    int ret;
+    asm volatile (
+        "movl $0x05, %%eax\n"
+        "movl %1, %%edi\n"
+        "movl %2, %%esi\n"
+        "movl %3, %%edx\n"
+        "int $0x40\n"
+        "movl %%eax, %0\n"
+        : "=r" (ret)
+        : "r" (addr), "r" (length), "r" (advice)
+        : "eax", "edi", "esi", "edx"
+    );
+    return ret;
+}